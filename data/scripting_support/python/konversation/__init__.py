@@ -7,6 +7,7 @@ public, stable scripting interface.
 
 Modules:
 dbus -- Interact with Konveration's D-Bus API.
+host -- Run as a script host, kept running between calls.
 i18n -- Translation support.
 
 """
@@ -0,0 +1,79 @@
+# -*- coding: utf-8 -*-
+#
+# SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+#
+# SPDX-FileCopyrightText: 2026 Konversation authors
+
+
+"""
+This module provides support for scripts kept running by Konversation as
+script hosts, rather than being started for each call.
+
+A script is kept running if it contains the line
+
+# konversation-script-host
+
+near its beginning. Iterate over events() to get the calls, and answer them
+with the say/raw/info/error functions. The answers are sent to Konversation
+whenever the script waits for the next call.
+
+This module is considered EXPERIMENTAL at this time and not part of the public,
+stable scripting interface.
+
+"""
+
+import sys
+
+__all__ = ('events', 'say', 'raw', 'info', 'error')
+
+# Functions
+
+def events():
+
+    """
+    Yields the calls of the script as (connection, target, arguments) tuples,
+    until Konversation asks the script to exit.
+
+    """
+
+    while True:
+        sys.stdout.flush()
+        line = sys.stdin.readline()
+
+        if not line:
+            return
+
+        fields = line.rstrip('\n').split('\t', 3)
+
+        if fields[0] == 'exec' and len(fields) == 4:
+            yield fields[1], fields[2], fields[3].split()
+
+def say(connection, target, message):
+
+    """Sends a message to the target in the connection."""
+
+    _send('say', connection, target, message)
+
+def raw(connection, command):
+
+    """Sends a raw IRC command to the connection."""
+
+    _send('raw', connection, command)
+
+def info(message):
+
+    """Shows an info message in the active tab in Konversation."""
+
+    _send('info', message)
+
+def error(message):
+
+    """Shows an error message in the active tab in Konversation."""
+
+    _send('error', message)
+
+def _send(*fields):
+
+    """Queues a command, one line each."""
+
+    sys.stdout.write('\t'.join(str(field).replace('\n', ' ') for field in fields) + '\n')
@@ -16,6 +16,7 @@
 #include "viewcontainer.h"
 #include "trayicon.h"
 #include "urlcatcher.h"
+#include "urlcatchermodel.h"
 #include "highlight.h"
 #include "sound.h"
 #include "quickconnectdialog.h"
@@ -46,16 +47,21 @@
 #include <QRegularExpression>
 #include <QDBusConnection>
 #include <QNetworkProxy>
-#include <QStandardItemModel>
+#include <QFile>
 #include <QFileInfo>
 #include <QTextCursor>
 #include <QDesktopServices>
 #include <QCommandLineParser>
 #include <QNetworkInformation>
-#include <QCollator>
+#include <QTimer>
+
+#include <utility>
 
 using namespace Konversation;
 
+/// Delay of saveOptions(), to write the options changed one after another at once.
+static const int SaveOptionsDelay = 500;
+
 Application::Application(int &argc, char **argv)
 : QApplication(argc, argv)
 {
@@ -72,8 +78,19 @@ Application::Application(int &argc, char **argv)
     m_dccTransferManager = nullptr;
     m_notificationHandler = nullptr;
     m_urlModel = nullptr;
+    m_autoReplacerRevision = -1;
     dbusObject = nullptr;
     identDBus = nullptr;
+
+    m_saveOptionsUpdateGUI = false;
+    m_optionsWritten = false;
+    m_nextServerIndex = 0;
+    m_nextChannelIndex = 0;
+
+    m_saveOptionsTimer = new QTimer(this);
+    m_saveOptionsTimer->setSingleShot(true);
+    m_saveOptionsTimer->setInterval(SaveOptionsDelay);
+    connect(m_saveOptionsTimer, &QTimer::timeout, this, &Application::writeOptions);
 }
 
 Application::~Application()
@@ -86,7 +103,14 @@ Application::~Application()
     stashQueueRates();
     Preferences::self()->save(); // FIXME i can't figure out why this isn't in saveOptions --argonel
     KonversationState::self()->save();
-    saveOptions(false);
+    // the views are going away, don't update them
+    m_saveOptionsUpdateGUI = false;
+    writeOptions();
+
+    if (Preferences::self()->urlCatcherPersistent())
+        m_urlModel->save(UrlCatcherModel::storageFileName());
+    else
+        QFile::remove(UrlCatcherModel::storageFileName());
 
     // Delete m_dccTransferManager here as its destructor depends on the main loop being in tact which it
     // won't be if if we wait till Qt starts deleting parent pointers.
@@ -154,6 +178,9 @@ void Application::createMainWindow(AutoConnectMode autoConnectMode, WindowRestor
     connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged, m_connectionManager, &ConnectionManager::onOnlineStateChanged);
 
     m_scriptLauncher = new ScriptLauncher(this);
+    connect(m_scriptLauncher, &ScriptLauncher::scriptSay, this, &Application::dbusSay);
+    connect(m_scriptLauncher, &ScriptLauncher::scriptRaw, this, &Application::dbusRaw);
+    connect(m_scriptLauncher, &ScriptLauncher::scriptInfo, this, &Application::dbusInfo);
 
     // an instance of DccTransferManager needs to be created before GUI class instances' creation.
     m_dccTransferManager = new DCC::TransferManager(this);
@@ -173,7 +200,11 @@ void Application::createMainWindow(AutoConnectMode autoConnectMode, WindowRestor
     // Images object providing LEDs, NickIcons
     m_images = new Images();
 
-    m_urlModel = new QStandardItemModel(0, 3, this);
+    m_urlModel = new UrlCatcherModel(this);
+    updateUrlCatcherLimits();
+
+    if (Preferences::self()->urlCatcherPersistent())
+        m_urlModel->load(UrlCatcherModel::storageFileName());
 
     // Auto-alias scripts.  This adds any missing aliases
     QStringList aliasList(Preferences::self()->aliasList());
@@ -231,9 +262,14 @@ void Application::createMainWindow(AutoConnectMode autoConnectMode, WindowRestor
             return left->sortIndex() < right->sortIndex();
         });
 
+        // One server group per pass of the event loop, the window gets
+        // to show and take input in between.
         for (const auto& server : std::as_const(serversToAutoconnect)) {
-            m_connectionManager->connectTo(Konversation::CreateNewConnection, server->id());
+            m_autoConnectQueue.append(server->id());
         }
+
+        if (!m_autoConnectQueue.isEmpty())
+            QTimer::singleShot(0, this, &Application::autoConnectNext);
     }
 
     if (openServerList) mainWindow->openServerList();
@@ -242,7 +278,7 @@ void Application::createMainWindow(AutoConnectMode autoConnectMode, WindowRestor
 
     // prepare dbus interface
     dbusObject = new Konversation::DBus(this);
-    QDBusConnection::sessionBus().registerObject(QStringLiteral("/irc"), dbusObject, QDBusConnection::ExportNonScriptableSlots);
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/irc"), dbusObject, QDBusConnection::ExportNonScriptableSlots | QDBusConnection::ExportScriptableSignals);
     identDBus = new Konversation::IdentDBus(this);
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/identity"), identDBus, QDBusConnection::ExportNonScriptableSlots);
 
@@ -266,6 +302,7 @@ void Application::createMainWindow(AutoConnectMode autoConnectMode, WindowRestor
     m_notificationHandler = new Konversation::NotificationHandler(this);
 
     connect(this, &Application::appearanceChanged, this, &Application::updateProxySettings);
+    connect(this, &Application::appearanceChanged, this, &Application::updateUrlCatcherLimits);
 }
 
 void Application::newInstance(QCommandLineParser *args)
@@ -319,8 +356,21 @@ void Application::restart()
     mainWindow->quitProgram();
 }
 
+void Application::autoConnectNext()
+{
+    if (m_autoConnectQueue.isEmpty() || !m_connectionManager)
+        return;
+
+    m_connectionManager->connectTo(Konversation::CreateNewConnection, m_autoConnectQueue.takeFirst());
+
+    if (!m_autoConnectQueue.isEmpty())
+        QTimer::singleShot(0, this, &Application::autoConnectNext);
+}
+
 void Application::prepareShutdown()
 {
+    m_autoConnectQueue.clear();
+
     if (mainWindow)
         mainWindow->getViewContainer()->prepareShutdown();
 
@@ -380,6 +430,26 @@ void Application::dbusInfo(const QString& string)
     mainWindow->getViewContainer()->appendToFrontmost(i18n("D-Bus"), string, nullptr);
 }
 
+/// The config groups named "@p prefix N", by N.
+static QMap<int, QString> numberedGroups(const QStringList& groups, QLatin1String prefix)
+{
+    QMap<int, QString> numbered;
+
+    for (const QString& group : groups) {
+        if (!group.startsWith(prefix))
+            continue;
+
+        const QStringView number = QStringView(group).sliced(prefix.size());
+        bool ok = false;
+        const int index = number.toInt(&ok);
+
+        if (ok && !number.isEmpty() && number.front().isDigit())
+            numbered.insert(index, group);
+    }
+
+    return numbered;
+}
+
 void Application::readOptions()
 {
     // read nickname sorting order for channel nick lists
@@ -394,21 +464,16 @@ void Application::readOptions()
         Preferences::self()->setSortOrder(sortOrder);
     }
 
+    // The list of groups is built once, the numbered groups are picked
+    // from it by their number. The config lists them in lexicographic
+    // order, "Identity 10" before "Identity 2".
+    const QStringList configGroups = KSharedConfig::openConfig()->groupList();
+
     // Identity list
-    auto identKeys = QRegularExpression(QStringLiteral("Identity [0-9]+"));
-    // QList::filter(QRegularExpression) appears to return the matched
-    // keys in random order. Additionally, the list is saved in
-    // lexicographic order causing further shuffling.
-    QStringList identityList = KSharedConfig::openConfig()->groupList().filter(identKeys);
+    const QMap<int, QString> identityList = numberedGroups(configGroups, QLatin1String("Identity "));
 
     if (!identityList.isEmpty())
     {
-        // Identity group names aren't localized, but we want to avoid
-        // the "C" locale. en_US is hopefully always available.
-        QCollator coll(QLocale(QStringLiteral("en_US")));
-        coll.setNumericMode(1);
-        std::sort(identityList.begin(), identityList.end(), coll);
-
         Preferences::clearIdentityList();
 
         for (const QString& identityGroup : std::as_const(identityList)) {
@@ -473,8 +538,7 @@ void Application::readOptions()
         m_osd->setPalette(p);
     }
 
-    const QStringList groups = KSharedConfig::openConfig()->groupList().filter(
-                                        QRegularExpression(QStringLiteral("ServerGroup [0-9]+")));
+    const QMap<int, QString> groups = numberedGroups(configGroups, QLatin1String("ServerGroup "));
     QMap<int,QStringList> notifyList;
     QList<int> sgKeys;
     sgKeys.reserve(groups.size());
@@ -715,79 +779,192 @@ void Application::readOptions()
 
 void Application::saveOptions(bool updateGUI)
 {
-    // template:    KConfigGroup  (KSharedConfig::openConfig()->group( ));
-
-    //KConfig* config=KSharedConfig::openConfig();
+    // Options are often changed one after another, write them at once.
+    m_saveOptionsUpdateGUI = m_saveOptionsUpdateGUI || updateGUI;
+    m_saveOptionsTimer->start();
+}
 
-//    Should be handled in NicklistBehaviorConfigController now
-//    config->setGroup("Sort Nicknames");
+Application::ConfigEntries Application::identityEntries(const IdentityPtr& identity)
+{
+    return {
+        { QStringLiteral("Name"), identity->getName() },
+        { QStringLiteral("Ident"), identity->getIdent() },
+        { QStringLiteral("Realname"), identity->getRealName() },
+        { QStringLiteral("Nicknames"), identity->getNicknameList() },
+        { QStringLiteral("AuthType"), identity->getAuthType() },
+        { QStringLiteral("Password"), identity->getAuthPassword() },
+        { QStringLiteral("Bot"), identity->getNickservNickname() },
+        { QStringLiteral("NickservCommand"), identity->getNickservCommand() },
+        { QStringLiteral("SaslAccount"), identity->getSaslAccount() },
+        { QStringLiteral("PemClientCertFile"), identity->getPemClientCertFile().toString() },
+        { QStringLiteral("InsertRememberLineOnAway"), identity->getInsertRememberLineOnAway() },
+        { QStringLiteral("ShowAwayMessage"), identity->getRunAwayCommands() },
+        { QStringLiteral("AwayMessage"), identity->getAwayCommand() },
+        { QStringLiteral("ReturnMessage"), identity->getReturnCommand() },
+        { QStringLiteral("AutomaticAway"), identity->getAutomaticAway() },
+        { QStringLiteral("AwayInactivity"), identity->getAwayInactivity() },
+        { QStringLiteral("AutomaticUnaway"), identity->getAutomaticUnaway() },
+        { QStringLiteral("QuitReason"), identity->getQuitReason() },
+        { QStringLiteral("PartReason"), identity->getPartReason() },
+        { QStringLiteral("KickReason"), identity->getKickReason() },
+        { QStringLiteral("PreShellCommand"), identity->getShellCommand() },
+        { QStringLiteral("Codec"), identity->getCodecName() },
+        { QStringLiteral("AwayReason"), identity->getAwayMessage() },
+        { QStringLiteral("AwayNick"), identity->getAwayNickname() },
+    };
+}
 
-    // Clean up identity list
-    const QStringList identities=KSharedConfig::openConfig()->groupList().filter(
-                                            QRegularExpression(QStringLiteral("Identity [0-9]+")));
-    // remove old identity list from Preferences::file to keep numbering under control
-    for (const QString& identityGroup : identities) {
-        KSharedConfig::openConfig()->deleteGroup(identityGroup);
+Application::ServerGroupEntries Application::serverGroupEntries(const ServerGroupSettingsPtr& serverGroup)
+{
+    ServerGroupEntries entries;
+
+    entries.group = {
+        { QStringLiteral("Name"), serverGroup->name() },
+        { QStringLiteral("Identity"), serverGroup->identity()->getName() },
+        { QStringLiteral("ConnectCommands"), serverGroup->connectCommands() },
+        { QStringLiteral("AutoConnect"), serverGroup->autoConnectEnabled() },
+        { QStringLiteral("EnableNotifications"), serverGroup->enableNotifications() },
+        { QStringLiteral("Expanded"), serverGroup->expanded() },
+        { QStringLiteral("NotifyList"), Preferences::notifyStringByGroupId(serverGroup->id()) },
+    };
+
+    const Konversation::ServerList serverList = serverGroup->serverList();
+    entries.servers.reserve(serverList.size());
+
+    for (const auto& server : serverList) {
+        entries.servers.append({
+            { QStringLiteral("Server"), server.host() },
+            { QStringLiteral("Port"), server.port() },
+            { QStringLiteral("Password"), server.password() },
+            { QStringLiteral("SSLEnabled"), server.SSLEnabled() },
+            { QStringLiteral("BypassProxy"), server.bypassProxy() },
+        });
     }
 
-    const IdentityList identityList = Preferences::identityList();
-    int index = 0;
-
-    for (const auto& identity : identityList) {
-        KConfigGroup cgIdentity(KSharedConfig::openConfig()->group(QStringLiteral("Identity %1").arg(index)));
-
-        cgIdentity.writeEntry("Name",identity->getName());
-        cgIdentity.writeEntry("Ident",identity->getIdent());
-        cgIdentity.writeEntry("Realname",identity->getRealName());
-        cgIdentity.writeEntry("Nicknames",identity->getNicknameList());
-        cgIdentity.writeEntry("AuthType",identity->getAuthType());
-        cgIdentity.writeEntry("Password",identity->getAuthPassword());
-        cgIdentity.writeEntry("Bot",identity->getNickservNickname());
-        cgIdentity.writeEntry("NickservCommand",identity->getNickservCommand());
-        cgIdentity.writeEntry("SaslAccount",identity->getSaslAccount());
-        cgIdentity.writeEntry("PemClientCertFile", identity->getPemClientCertFile().toString());
-        cgIdentity.writeEntry("InsertRememberLineOnAway", identity->getInsertRememberLineOnAway());
-        cgIdentity.writeEntry("ShowAwayMessage",identity->getRunAwayCommands());
-        cgIdentity.writeEntry("AwayMessage",identity->getAwayCommand());
-        cgIdentity.writeEntry("ReturnMessage",identity->getReturnCommand());
-        cgIdentity.writeEntry("AutomaticAway", identity->getAutomaticAway());
-        cgIdentity.writeEntry("AwayInactivity", identity->getAwayInactivity());
-        cgIdentity.writeEntry("AutomaticUnaway", identity->getAutomaticUnaway());
-        cgIdentity.writeEntry("QuitReason",identity->getQuitReason());
-        cgIdentity.writeEntry("PartReason",identity->getPartReason());
-        cgIdentity.writeEntry("KickReason",identity->getKickReason());
-        cgIdentity.writeEntry("PreShellCommand",identity->getShellCommand());
-        cgIdentity.writeEntry("Codec",identity->getCodecName());
-        cgIdentity.writeEntry("AwayReason",identity->getAwayMessage());
-        cgIdentity.writeEntry("AwayNick", identity->getAwayNickname());
-        index++;
-    } // endfor
-
-    // Remove the old servergroups from the config
-    const QStringList serverGroupGroups =
-        KSharedConfig::openConfig()->groupList().filter(QRegularExpression(QStringLiteral("ServerGroup [0-9]+")));
+    const Konversation::ChannelList channelList = serverGroup->channelList();
+    entries.channels.reserve(channelList.size());
 
-    for (const QString& serverGroupGroup : serverGroupGroups) {
-        KSharedConfig::openConfig()->deleteGroup(serverGroupGroup);
+    for (const auto& channel : channelList) {
+        entries.channels.append({
+            { QStringLiteral("Name"), channel.name() },
+            { QStringLiteral("Password"), channel.password() },
+        });
     }
 
-    // Remove the old servers from the config
-    const QStringList serverGroups =
-        KSharedConfig::openConfig()->groupList().filter(QRegularExpression(QStringLiteral("Server [0-9]+")));
+    const Konversation::ChannelList channelHistoryList = serverGroup->channelHistory();
+    entries.channelHistory.reserve(channelHistoryList.size());
 
-    for (const QString& serverGroup : serverGroups) {
-        KSharedConfig::openConfig()->deleteGroup(serverGroup);
+    for (const auto& channel : channelHistoryList) {
+        entries.channelHistory.append({
+            { QStringLiteral("Name"), channel.name() },
+            { QStringLiteral("Password"), channel.password() },
+            { QStringLiteral("EnableNotifications"), channel.enableNotifications() },
+        });
     }
 
-    // Remove the old channels from the config
-    const QStringList channelGroups =
-        KSharedConfig::openConfig()->groupList().filter(QRegularExpression(QStringLiteral("Channel [0-9]+")));
+    return entries;
+}
+
+static void writeEntries(KConfigGroup group, const QMap<QString, QVariant>& entries)
+{
+    for (auto it = entries.begin(), end = entries.end(); it != end; ++it)
+        group.writeEntry(it.key(), it.value());
+}
+
+/// Replaces the entries of the config group @p groupName by @p entries, unless they are the same.
+static void replaceGroup(const QString& groupName, const QMap<QString, QString>& entries)
+{
+    if (KSharedConfig::openConfig()->group(groupName).entryMap() == entries)
+        return;
+
+    KSharedConfig::openConfig()->deleteGroup(groupName);
+    KConfigGroup group(KSharedConfig::openConfig()->group(groupName));
+
+    for (auto it = entries.begin(), end = entries.end(); it != end; ++it)
+        group.writeEntry(it.key(), it.value());
+}
+
+static void deleteGroups(const QString& pattern)
+{
+    const QStringList groups = KSharedConfig::openConfig()->groupList().filter(QRegularExpression(pattern));
+
+    for (const QString& group : groups)
+        KSharedConfig::openConfig()->deleteGroup(group);
+}
+
+void Application::writeServerGroup(int index, int id, const ServerGroupEntries& entries)
+{
+    SavedServerGroup& saved = m_savedServerGroups[id];
+
+    // The names of its old server and channel groups go to the new ones
+    QStringList freeServers = std::exchange(saved.servers, {});
+    QStringList freeChannels = std::exchange(saved.channels, {});
+
+    for (const QString& group : std::as_const(freeServers))
+        KSharedConfig::openConfig()->deleteGroup(group);
+    for (const QString& group : std::as_const(freeChannels))
+        KSharedConfig::openConfig()->deleteGroup(group);
+
+    auto writeGroups = [](const QList<ConfigEntries>& groupEntries, QStringList& freeNames, const QString& prefix, int& nextIndex) {
+        QStringList names;
+        names.reserve(groupEntries.size());
+
+        for (const ConfigEntries& entries : groupEntries) {
+            const QString name = freeNames.isEmpty() ? prefix.arg(nextIndex++) : freeNames.takeFirst();
+            writeEntries(KSharedConfig::openConfig()->group(name), entries);
+            names.append(name);
+        }
+
+        return names;
+    };
+
+    const QStringList servers = writeGroups(entries.servers, freeServers, QStringLiteral("Server %1"), m_nextServerIndex);
+    const QStringList channels = writeGroups(entries.channels, freeChannels, QStringLiteral("Channel %1"), m_nextChannelIndex);
+    const QStringList channelHistory = writeGroups(entries.channelHistory, freeChannels, QStringLiteral("Channel %1"), m_nextChannelIndex);
+
+    KConfigGroup cgServerGroup(KSharedConfig::openConfig()->group(QStringLiteral("ServerGroup %1").arg(index)));
+    writeEntries(cgServerGroup, entries.group);
+    cgServerGroup.writeEntry("ServerList", servers);
+    cgServerGroup.writeEntry("AutoJoinChannels", channels);
+    cgServerGroup.writeEntry("ChannelHistory", channelHistory);
+
+    saved.entries = entries;
+    saved.servers = servers;
+    saved.channels = channels + channelHistory;
+}
 
-    for (const QString& channelGroup : channelGroups) {
-        KSharedConfig::openConfig()->deleteGroup(channelGroup);
+void Application::writeOptions()
+{
+    m_saveOptionsTimer->stop();
+
+    const bool updateGUI = std::exchange(m_saveOptionsUpdateGUI, false);
+
+    // Only what changed since the last write is written. Until the first
+    // one, and when identities or server groups were added, removed or
+    // reordered, their numbered groups are written from scratch.
+
+    // Identities
+    const IdentityList identityList = Preferences::identityList();
+    QList<ConfigEntries> identities;
+    identities.reserve(identityList.size());
+
+    for (const auto& identity : identityList)
+        identities.append(identityEntries(identity));
+
+    const bool rewriteIdentities = !m_optionsWritten || identities.size() != m_savedIdentities.size();
+
+    // remove old identity list from Preferences::file to keep numbering under control
+    if (rewriteIdentities)
+        deleteGroups(QStringLiteral("Identity [0-9]+"));
+
+    for (int index = 0; index < identities.size(); ++index) {
+        if (rewriteIdentities || identities.at(index) != m_savedIdentities.at(index))
+            writeEntries(KSharedConfig::openConfig()->group(QStringLiteral("Identity %1").arg(index)), identities.at(index));
     }
 
-    // Add the new servergroups to the config
+    m_savedIdentities = identities;
+
+    // Server groups
     const Konversation::ServerGroupHash serverGroupHash = Preferences::serverGroupHash();
 
     QMap<int, Konversation::ServerGroupSettingsPtr> sortedServerGroupMap;
@@ -797,91 +974,51 @@ void Application::saveOptions(bool updateGUI)
         sortedServerGroupMap.insert(serverGroup->sortIndex(), serverGroup);
     }
 
-    index = 0;
-    int index2 = 0;
-    int index3 = 0;
-    QStringList servers;
-    QStringList channels;
-    QStringList channelHistory;
+    QList<int> serverGroupOrder;
     QHash<int, int> sgKeys;
+    serverGroupOrder.reserve(sortedServerGroupMap.size());
 
     for (const auto& serverGroup : std::as_const(sortedServerGroupMap)) {
-        const Konversation::ServerList serverList = serverGroup->serverList();
-        servers.clear();
-        servers.reserve(serverList.size());
-
-        sgKeys.insert(serverGroup->id(), index);
-
-        for (const auto& server : serverList) {
-            const QString groupName = QStringLiteral("Server %1").arg(index2);
-            servers.append(groupName);
-            KConfigGroup cgServer(KSharedConfig::openConfig()->group(groupName));
-            cgServer.writeEntry("Server", server.host());
-            cgServer.writeEntry("Port", server.port());
-            cgServer.writeEntry("Password", server.password());
-            cgServer.writeEntry("SSLEnabled", server.SSLEnabled());
-            cgServer.writeEntry("BypassProxy", server.bypassProxy());
-            index2++;
-        }
+        sgKeys.insert(serverGroup->id(), serverGroupOrder.size());
+        serverGroupOrder.append(serverGroup->id());
+    }
 
-        const Konversation::ChannelList channelList = serverGroup->channelList();
-        channels.clear();
-        channels.reserve(channelList.size());
-
-        for (const auto& channel : channelList) {
-            const QString groupName = QStringLiteral("Channel %1").arg(index3);
-            channels.append(groupName);
-            KConfigGroup cgChannel(KSharedConfig::openConfig()->group(groupName));
-            cgChannel.writeEntry("Name", channel.name());
-            cgChannel.writeEntry("Password", channel.password());
-            index3++;
-        }
+    if (!m_optionsWritten || serverGroupOrder != m_savedServerGroupOrder) {
+        // Remove the old servergroups, servers and channels from the config
+        deleteGroups(QStringLiteral("ServerGroup [0-9]+"));
+        deleteGroups(QStringLiteral("Server [0-9]+"));
+        deleteGroups(QStringLiteral("Channel [0-9]+"));
 
-        const Konversation::ChannelList channelHistoryList = serverGroup->channelHistory();
-        channelHistory.clear();
-        channelHistory.reserve(channelHistoryList.size());
-
-        for (const auto& channel : channelHistoryList) {
-            // TODO FIXME: is it just me or is this broken?
-            const QString groupName = QStringLiteral("Channel %1").arg(index3);
-            channelHistory.append(groupName);
-            KConfigGroup cgChannelHistory(KSharedConfig::openConfig()->group(groupName));
-            cgChannelHistory.writeEntry("Name", channel.name());
-            cgChannelHistory.writeEntry("Password", channel.password());
-            cgChannelHistory.writeEntry("EnableNotifications", channel.enableNotifications());
-            index3++;
-        }
+        m_savedServerGroups.clear();
+        m_nextServerIndex = 0;
+        m_nextChannelIndex = 0;
+    }
 
-        QString sgn = QStringLiteral("ServerGroup %1").arg(index);
-        KConfigGroup cgServerGroup(KSharedConfig::openConfig()->group(sgn));
-        cgServerGroup.writeEntry("Name", serverGroup->name());
-        cgServerGroup.writeEntry("Identity", serverGroup->identity()->getName());
-        cgServerGroup.writeEntry("ServerList", servers);
-        cgServerGroup.writeEntry("AutoJoinChannels", channels);
-        cgServerGroup.writeEntry("ConnectCommands", serverGroup->connectCommands());
-        cgServerGroup.writeEntry("AutoConnect", serverGroup->autoConnectEnabled());
-        cgServerGroup.writeEntry("ChannelHistory", channelHistory);
-        cgServerGroup.writeEntry("EnableNotifications", serverGroup->enableNotifications());
-        cgServerGroup.writeEntry("Expanded", serverGroup->expanded());
-        cgServerGroup.writeEntry("NotifyList",Preferences::notifyStringByGroupId(serverGroup->id()));
-        index++;
+    for (const auto& serverGroup : std::as_const(sortedServerGroupMap)) {
+        const ServerGroupEntries entries = serverGroupEntries(serverGroup);
+        const auto saved = m_savedServerGroups.constFind(serverGroup->id());
+
+        if (saved == m_savedServerGroups.constEnd() || saved->entries != entries)
+            writeServerGroup(sgKeys.value(serverGroup->id()), serverGroup->id(), entries);
     }
 
-    KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Server List"));
+    m_savedServerGroupOrder = serverGroupOrder;
+
+    if (KSharedConfig::openConfig()->hasGroup(QStringLiteral("Server List")))
+        KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Server List"));
 
     // Ignore List
-    KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Ignore List"));
-    KConfigGroup cgIgnoreList(KSharedConfig::openConfig()->group(QStringLiteral("Ignore List")));
+    QMap<QString, QString> ignoreEntries;
     QList<Ignore*> ignoreList=Preferences::ignoreList();
     for (int i = 0; i < ignoreList.size(); ++i) {
-        cgIgnoreList.writeEntry(QStringLiteral("Ignore%1").arg(i), QStringLiteral("%1,%2").arg(ignoreList.at(i)->getName()).arg(ignoreList.at(i)->getFlags()));
+        ignoreEntries.insert(QStringLiteral("Ignore%1").arg(i), QStringLiteral("%1,%2").arg(ignoreList.at(i)->getName()).arg(ignoreList.at(i)->getFlags()));
     }
+    replaceGroup(QStringLiteral("Ignore List"), ignoreEntries);
 
     // Channel Encodings
-    // remove all entries once
-    KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Channel Encodings")); // legacy Jun 29, 2009
-    KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Encodings"));
-    KConfigGroup cgEncoding(KSharedConfig::openConfig()->group(QStringLiteral("Encodings")));
+    if (KSharedConfig::openConfig()->hasGroup(QStringLiteral("Channel Encodings")))
+        KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Channel Encodings")); // legacy Jun 29, 2009
+    QMap<QString, QString> encodingEntries;
     const QList<int> encServers = Preferences::channelEncodingsServerGroupIdList();
     //i have no idea these would need to be sorted //encServers.sort();
     for (int encServer : encServers) {
@@ -898,14 +1035,14 @@ void Application::saveOptions(bool updateGUI)
                     key.prepend(QStringLiteral("ServerGroup ") + QString::number(sgKeys.value(encServer)));
                 else
                     key.prepend(sgsp->name());
-                cgEncoding.writeEntry(key, enc);
+                encodingEntries.insert(key, enc);
             }
         }
     }
+    replaceGroup(QStringLiteral("Encodings"), encodingEntries);
 
     // Spell Checking Languages
-    KSharedConfig::openConfig()->deleteGroup(QStringLiteral("Spell Checking Languages"));
-    KConfigGroup cgSpellCheckingLanguages(KSharedConfig::openConfig()->group(QStringLiteral("Spell Checking Languages")));
+    QMap<QString, QString> spellCheckingLanguageEntries;
 
     QHashIterator<Konversation::ServerGroupSettingsPtr, QHash<QString, QString> > i(Preferences::serverGroupSpellCheckingLanguages());
 
@@ -920,7 +1057,7 @@ void Application::saveOptions(bool updateGUI)
             i2.next();
 
             if (sgKeys.contains(i.key()->id()))
-                cgSpellCheckingLanguages.writeEntry(QStringLiteral("ServerGroup ") + QString::number(sgKeys.value(i.key()->id())) + QLatin1Char(' ') + i2.key(), i2.value());
+                spellCheckingLanguageEntries.insert(QStringLiteral("ServerGroup ") + QString::number(sgKeys.value(i.key()->id())) + QLatin1Char(' ') + i2.key(), i2.value());
         }
     }
 
@@ -936,11 +1073,14 @@ void Application::saveOptions(bool updateGUI)
         {
             i4.next();
 
-            cgSpellCheckingLanguages.writeEntry(i3.key() + QLatin1Char(' ') + i4.key(), i4.value());
+            spellCheckingLanguageEntries.insert(i3.key() + QLatin1Char(' ') + i4.key(), i4.value());
         }
     }
+    replaceGroup(QStringLiteral("Spell Checking Languages"), spellCheckingLanguageEntries);
 
+    // nothing is written when nothing changed
     KSharedConfig::openConfig()->sync();
+    m_optionsWritten = true;
 
     if(updateGUI)
         Q_EMIT appearanceChanged();
@@ -994,19 +1134,12 @@ void Application::storeUrl(const QString& origin, const QString& newUrl, const Q
 
     url.replace(QStringLiteral("&amp;"), QStringLiteral("&"));
 
-    const QList<QStandardItem*> existing = m_urlModel->findItems(url, Qt::MatchExactly, 1);
-
-    for (QStandardItem* item : existing) {
-        if (m_urlModel->item(item->row(), 0)->data(Qt::DisplayRole).toString() == origin)
-            m_urlModel->removeRow(item->row());
-    }
-
-    m_urlModel->insertRow(0);
-    m_urlModel->setData(m_urlModel->index(0, 0), origin, Qt::DisplayRole);
-    m_urlModel->setData(m_urlModel->index(0, 1), url, Qt::DisplayRole);
+    m_urlModel->addUrl(origin, url, dateTime);
+}
 
-    auto* dateItem = new UrlDateItem(dateTime);
-    m_urlModel->setItem(0, 2, dateItem);
+void Application::updateUrlCatcherLimits()
+{
+    m_urlModel->setLimits(Preferences::self()->urlCatcherMaxEntries(), Preferences::self()->urlCatcherMaxAge());
 }
 
 void Application::openQuickConnectDialog()
@@ -1055,129 +1188,13 @@ NickInfoPtr Application::getNickInfo(const QString &ircnick, const QString &serv
 // auto replace on input/output
 QPair<QString, int> Application::doAutoreplace(const QString& text, bool output, int cursorPos) const
 {
-    // get autoreplace list
-    const QList<QStringList> autoreplaceList = Preferences::autoreplaceList();
-    // working copy
-    QString line=text;
-
-    // loop through the list of replacement patterns
-    for (const QStringList& definition : autoreplaceList) {
-        // split definition in parts
-        QString regex=definition.at(0);
-        QString direction=definition.at(1);
-        QString pattern=definition.at(2);
-        QString replacement=definition.at(3);
-
-        QString isDirection=output ? QStringLiteral("o") : QStringLiteral("i");
-
-        // only replace if this pattern is for the specific direction or both directions
-        if (direction==isDirection || direction==QStringLiteral("io"))
-        {
-            // regular expression pattern?
-            if (regex== QLatin1Char('1'))
-            {
-                // create regex from pattern
-                const QRegularExpression needleReg(pattern);
-                int index = 0;
-                int newIndex = index;
-
-                do {
-                    QRegularExpressionMatch rmatch;
-                    // find matches
-                    index = line.indexOf(needleReg, index, &rmatch);
-
-                    if (index != -1)
-                    {
-                        // remember captured patterns
-                        const QStringList captures = rmatch.capturedTexts();
-                        QString replaceWith = replacement;
-
-                        replaceWith.replace(QStringLiteral("%%"),QStringLiteral("%\x01")); // escape double %
-                        // replace %0-9 in regex groups
-                        for (int capture=0;capture<captures.count();capture++)
-                        {
-                            QString search = QStringLiteral("%%1").arg(capture);
-                            replaceWith.replace(search, captures[capture]);
-                        }
-                        //Explanation why this is important so we don't forget:
-                        //If somebody has a regex that say has a replacement of url.com/%1/%2 and the
-                        //regex can either match one or two patterns, if the 2nd pattern match is left,
-                        //the url is invalid (url.com/match/%2). This is expected regex behavior I'd assume.
-                        replaceWith.remove(QRegularExpression(QStringLiteral("%[0-9]")));
-
-                        replaceWith.replace(QStringLiteral("%\x01"),QStringLiteral("%")); // return escaped % to normal
-                        // allow for var expansion in autoreplace
-                        replaceWith = Konversation::doVarExpansion(replaceWith);
-                        // replace input with replacement
-                        line.replace(index, captures[0].length(), replaceWith);
-
-                        newIndex = index + replaceWith.length();
-
-                        if (cursorPos > -1 && cursorPos >= index)
-                        {
-                            if (cursorPos < index + captures[0].length())
-                                cursorPos = newIndex;
-                            else
-                            {
-                                if (captures[0].length() > replaceWith.length())
-                                    cursorPos -= captures[0].length() - replaceWith.length();
-                                else
-                                    cursorPos += replaceWith.length() - captures[0].length();
-                            }
-                        }
-
-                        index = newIndex;
-                    }
-                } while (index >= 0 && index < line.length());
-            }
-            else
-            {
-                int index = line.indexOf(pattern);
-                while (index>=0)
-                {
-                    int length,nextLength,patLen,repLen;
-                    patLen=pattern.length();
-
-                    repLen=replacement.length();
-                    length=index;
-                    length+=patLen;
-                    nextLength=length;
-                    //nextlength is used to account for the replacement taking up less space
-                    QChar before,after;
-                    if (index!=0) before = line.at(index-1);
-                    if (line.length() > length) after = line.at(length);
-
-                    if (index==0 || before.isSpace() || before.isPunct())
-                    {
-                        if (line.length() == length || after.isSpace() || after.isPunct())
-                        {
-                            // allow for var expansion in autoreplace
-                            replacement = Konversation::doVarExpansion(replacement);
-                            line.replace(index,patLen,replacement);
-                            nextLength = index+repLen;
-                        }
-                    }
-
-                    if (cursorPos > -1 && cursorPos >= index)
-                    {
-                        if (cursorPos < length)
-                            cursorPos = nextLength;
-                        else
-                        {
-                            if (patLen > repLen)
-                                cursorPos -= patLen - repLen;
-                            else
-                                cursorPos += repLen - patLen;
-                        }
-                    }
-
-                    index = line.indexOf(pattern, nextLength);
-                }
-            }
-        }
+    if (m_autoReplacerRevision != Preferences::autoreplaceListRevision())
+    {
+        m_autoReplacer.setRules(Preferences::autoreplaceList());
+        m_autoReplacerRevision = Preferences::autoreplaceListRevision();
     }
 
-    return QPair<QString, int>(line, cursorPos);
+    return m_autoReplacer.replace(text, output ? Konversation::AutoReplacer::Outgoing : Konversation::AutoReplacer::Incoming, cursorPos);
 }
 
 void Application::doInlineAutoreplace(KTextEdit* textEdit) const
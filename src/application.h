@@ -18,8 +18,12 @@
 #include "osd.h"
 #include "identity.h"
 #include "ircqueue.h"
+#include "autoreplacer.h"
 
 #include <QApplication>
+#include <QHash>
+#include <QMap>
+#include <QVariant>
 
 class ConnectionManager;
 class AwayManager;
@@ -28,10 +32,11 @@ class Server;
 class QuickConnectDialog;
 class Images;
 class ServerGroupSettings;
-class QStandardItemModel;
+class UrlCatcherModel;
 class QCommandLineParser;
 
 class KTextEdit;
+class QTimer;
 
 namespace Konversation
 {
@@ -77,7 +82,7 @@ class Application : public QApplication
         void showQueueTuner(bool);
 
         // URL-Catcher
-        QStandardItemModel* getUrlModel() const { return m_urlModel; }
+        UrlCatcherModel* getUrlModel() const { return m_urlModel; }
 
         Application(int &argc, char **argv);
         ~Application() override;
@@ -113,6 +118,7 @@ class Application : public QApplication
         Images* images() const { return m_images; }
 
         Konversation::NotificationHandler* notificationHandler() const { return m_notificationHandler; }
+        Konversation::DBus* dbus() const { return dbusObject; }
 
         // auto replacement for input or output lines
         QPair<QString, int> doAutoreplace(const QString& text, bool output, int cursorPos = -1) const;
@@ -142,7 +148,10 @@ class Application : public QApplication
         void restart();
 
         void readOptions();
+        /// Writes the options after a short delay, coalescing the calls in between.
         void saveOptions(bool updateGUI=true);
+        /// Writes the options that changed since the last write now.
+        void writeOptions();
 
         void fetchQueueRates(); ///< on Application::readOptions()
         void stashQueueRates(); ///< on application exit
@@ -169,6 +178,7 @@ class Application : public QApplication
         void sendMultiServerCommand(const QString& command, const QString& parameter);
 
         void updateProxySettings();
+        void updateUrlCatcherLimits();
 
         void closeWallet();
 
@@ -179,21 +189,68 @@ class Application : public QApplication
         enum AutoConnectMode { NoAutoConnect, AutoConnect };
         enum WindowRestoreMode { NoWindowRestore, WindowRestore };
         void createMainWindow(AutoConnectMode autoConnectMode, WindowRestoreMode restoreMode);
+        /// Connects the next server group of m_autoConnectQueue.
+        void autoConnectNext();
+
+        /// Values of the entries of a config group, by key.
+        using ConfigEntries = QMap<QString, QVariant>;
+
+        /// A server group as written to the config, without the names of the config groups of its parts.
+        struct ServerGroupEntries
+        {
+            ConfigEntries group;
+            QList<ConfigEntries> servers;
+            QList<ConfigEntries> channels;
+            QList<ConfigEntries> channelHistory;
+
+            bool operator==(const ServerGroupEntries& other) const = default;
+        };
+
+        /// What writeOptions() wrote of a server group last.
+        struct SavedServerGroup
+        {
+            ServerGroupEntries entries;
+            /// Its "Server N" groups.
+            QStringList servers;
+            /// Its "Channel N" groups, of auto-join and history.
+            QStringList channels;
+        };
+
+        static ConfigEntries identityEntries(const IdentityPtr& identity);
+        static ServerGroupEntries serverGroupEntries(const Konversation::ServerGroupSettingsPtr& serverGroup);
+        /// Writes the server group with @p id as "ServerGroup @p index", and its servers and channels.
+        void writeServerGroup(int index, int id, const ServerGroupEntries& entries);
 
     private:
         ConnectionManager* m_connectionManager;
         AwayManager* m_awayManager;
         Konversation::DCC::TransferManager* m_dccTransferManager;
         ScriptLauncher* m_scriptLauncher;
-        QStandardItemModel* m_urlModel;
+        UrlCatcherModel* m_urlModel;
         Konversation::DBus* dbusObject;
         Konversation::IdentDBus* identDBus;
         QPointer<MainWindow> mainWindow;
         OSDWidget* m_osd;
         mutable Konversation::Sound* m_sound;
+        /// Compiled from Preferences::autoreplaceList() when its revision changes.
+        mutable Konversation::AutoReplacer m_autoReplacer;
+        mutable int m_autoReplacerRevision;
         QuickConnectDialog* quickConnectDialog;
         Images* m_images;
         bool m_restartScheduled;
+        /// Ids of the server groups still to connect on startup.
+        QList<int> m_autoConnectQueue;
+
+        QTimer* m_saveOptionsTimer;
+        bool m_saveOptionsUpdateGUI;
+        /// Whether writeOptions() wrote everything once, the saved state below is complete.
+        bool m_optionsWritten;
+        QList<ConfigEntries> m_savedIdentities;
+        /// Ids of the server groups in the order of their config groups.
+        QList<int> m_savedServerGroupOrder;
+        QHash<int, SavedServerGroup> m_savedServerGroups;
+        int m_nextServerIndex;
+        int m_nextChannelIndex;
 
         Konversation::NotificationHandler* m_notificationHandler;
 
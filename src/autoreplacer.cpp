@@ -0,0 +1,213 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "autoreplacer.h"
+
+#include "common.h"
+
+namespace Konversation
+{
+    /// doVarExpansion() only changes "%" codes, spare it the URL parsing if there are none.
+    static QString expandVariables(const QString& text)
+    {
+        return text.contains(QLatin1Char('%')) ? doVarExpansion(text) : text;
+    }
+
+    void AutoReplacer::setRules(const QList<QStringList>& definitions)
+    {
+        m_incomingRules.clear();
+        m_outgoingRules.clear();
+
+        for (const QStringList& definition : definitions)
+        {
+            if (definition.count() < 4)
+                continue;
+
+            const QString& direction = definition.at(1);
+            const bool incoming = (direction == QLatin1String("i") || direction == QLatin1String("io"));
+            const bool outgoing = (direction == QLatin1String("o") || direction == QLatin1String("io"));
+
+            if (!incoming && !outgoing)
+                continue;
+
+            const Rule rule = compile(definition);
+
+            // an empty plain pattern would match forever, an invalid regex never
+            if (rule.isRegex ? !rule.regex.isValid() : rule.pattern.isEmpty())
+                continue;
+
+            if (incoming)
+                m_incomingRules.append(rule);
+            if (outgoing)
+                m_outgoingRules.append(rule);
+        }
+    }
+
+    AutoReplacer::Rule AutoReplacer::compile(const QStringList& definition)
+    {
+        Rule rule;
+        rule.isRegex = (definition.at(0) == QLatin1Char('1'));
+        rule.pattern = definition.at(2);
+        rule.replacement = definition.at(3);
+
+        if (!rule.isRegex)
+            return rule;
+
+        rule.regex.setPattern(rule.pattern);
+        rule.regex.optimize();
+
+        // "%%" is a literal "%", "%0" to "%9" refer to the captures
+        QString literal;
+        const QString& replacement = rule.replacement;
+
+        for (qsizetype pos = 0; pos < replacement.size(); ++pos)
+        {
+            const QChar c = replacement.at(pos);
+
+            if (c == QLatin1Char('%') && pos + 1 < replacement.size())
+            {
+                const QChar next = replacement.at(pos + 1);
+
+                if (next == QLatin1Char('%'))
+                {
+                    literal += c;
+                    ++pos;
+                    continue;
+                }
+
+                if (next >= QLatin1Char('0') && next <= QLatin1Char('9'))
+                {
+                    if (!literal.isEmpty())
+                        rule.replacementTemplate.append(TemplatePart { literal, -1 });
+
+                    rule.replacementTemplate.append(TemplatePart { QString(), next.unicode() - '0' });
+                    literal.clear();
+                    ++pos;
+                    continue;
+                }
+            }
+
+            literal += c;
+        }
+
+        if (!literal.isEmpty())
+            rule.replacementTemplate.append(TemplatePart { literal, -1 });
+
+        return rule;
+    }
+
+    QPair<QString, int> AutoReplacer::replace(const QString& text, Direction direction, int cursorPos) const
+    {
+        const QList<Rule>& rules = (direction == Outgoing) ? m_outgoingRules : m_incomingRules;
+
+        // working copy
+        QString line = text;
+
+        for (const Rule& rule : rules)
+        {
+            if (rule.isRegex)
+                applyRegex(rule, line, cursorPos);
+            else
+                applyPlain(rule, line, cursorPos);
+        }
+
+        return QPair<QString, int>(line, cursorPos);
+    }
+
+    void AutoReplacer::applyRegex(const Rule& rule, QString& line, int& cursorPos)
+    {
+        int index = 0;
+
+        do {
+            const QRegularExpressionMatch match = rule.regex.match(line, index);
+
+            if (!match.hasMatch())
+                break;
+
+            index = match.capturedStart();
+
+            QString replaceWith;
+
+            //Explanation why this is important so we don't forget:
+            //If somebody has a regex that say has a replacement of url.com/%1/%2 and the
+            //regex can either match one or two patterns, if the 2nd pattern match is left,
+            //the url is invalid (url.com/match/%2). This is expected regex behavior I'd assume.
+            //Captures that did not match are null, so they are simply left out.
+            for (const TemplatePart& part : rule.replacementTemplate)
+                replaceWith += (part.capture == -1) ? part.text : match.captured(part.capture);
+
+            // allow for var expansion in autoreplace
+            replaceWith = expandVariables(replaceWith);
+
+            const int matchLength = match.capturedLength();
+
+            // replace input with replacement
+            line.replace(index, matchLength, replaceWith);
+
+            const int newIndex = index + replaceWith.length();
+
+            if (cursorPos > -1 && cursorPos >= index)
+            {
+                if (cursorPos < index + matchLength)
+                    cursorPos = newIndex;
+                else
+                    cursorPos += replaceWith.length() - matchLength;
+            }
+
+            // an empty match replaced by nothing would be found right there again
+            index = (matchLength == 0 && replaceWith.isEmpty()) ? newIndex + 1 : newIndex;
+        } while (index >= 0 && index < line.length());
+    }
+
+    void AutoReplacer::applyPlain(const Rule& rule, QString& line, int& cursorPos)
+    {
+        const int patLen = rule.pattern.length();
+
+        // expanded on the first match only
+        QString replacement;
+        bool expanded = false;
+
+        int index = line.indexOf(rule.pattern);
+
+        while (index >= 0)
+        {
+            if (!expanded)
+            {
+                // allow for var expansion in autoreplace
+                replacement = expandVariables(rule.replacement);
+                expanded = true;
+            }
+
+            const int repLen = replacement.length();
+            const int length = index + patLen;
+            //nextlength is used to account for the replacement taking up less space
+            int nextLength = length;
+
+            QChar before, after;
+            if (index != 0) before = line.at(index - 1);
+            if (line.length() > length) after = line.at(length);
+
+            if (index == 0 || before.isSpace() || before.isPunct())
+            {
+                if (line.length() == length || after.isSpace() || after.isPunct())
+                {
+                    line.replace(index, patLen, replacement);
+                    nextLength = index + repLen;
+                }
+            }
+
+            if (cursorPos > -1 && cursorPos >= index)
+            {
+                if (cursorPos < length)
+                    cursorPos = nextLength;
+                else
+                    cursorPos += repLen - patLen;
+            }
+
+            index = line.indexOf(rule.pattern, nextLength);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef AUTOREPLACER_H
+#define AUTOREPLACER_H
+
+#include <QList>
+#include <QPair>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+namespace Konversation
+{
+    /**
+     * The autoreplace list compiled for matching.
+     *
+     * The definitions are split by direction once, regular expressions are
+     * compiled once and the "%0" - "%9" capture references and "%%" escapes
+     * of their replacements are parsed into templates, so replacing on every
+     * message does no more than the matching and the substitution itself.
+     */
+    class AutoReplacer
+    {
+        public:
+            enum Direction
+            {
+                Incoming,
+                Outgoing
+            };
+
+            /// Compiles the rules in the format of Preferences::autoreplaceList().
+            void setRules(const QList<QStringList>& definitions);
+
+            /**
+             * Applies the rules for @p direction to @p text.
+             * @return the new text and @p cursorPos moved along with the replacements
+             */
+            QPair<QString, int> replace(const QString& text, Direction direction, int cursorPos = -1) const;
+
+        private:
+            /// A literal piece of a replacement, or a reference to a capture.
+            struct TemplatePart
+            {
+                QString text;
+                int capture;
+            };
+
+            struct Rule
+            {
+                bool isRegex;
+                QString pattern;
+                QRegularExpression regex;
+                QString replacement;
+                QList<TemplatePart> replacementTemplate;
+            };
+
+            static Rule compile(const QStringList& definition);
+            static void applyRegex(const Rule& rule, QString& line, int& cursorPos);
+            static void applyPlain(const Rule& rule, QString& line, int& cursorPos);
+
+        private:
+            QList<Rule> m_incomingRules;
+            QList<Rule> m_outgoingRules;
+    };
+}
+
+#endif
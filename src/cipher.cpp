@@ -13,11 +13,16 @@
 
 #include <KLocalizedString>
 
+#include <QtEndian>
+
+#include <array>
 
 namespace Konversation
 {
     QString Cipher::m_runtimeError;
 
+    static const char fishBase64[] = "./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
     Cipher::Cipher()
     {
         m_primeNum = QCA::BigInteger("12745216229761186769575009943944198619149164746831579719941140425076456621824834322853258804883232842877311723249782818608677050956745409379781245497526069657222703636504651898833151008222772087491045206203033063108075098874712912417029101508315117935752962862335062591404043092163187352352197487303798807791605274487594646923");
@@ -44,16 +49,18 @@ namespace Konversation
         if(key.isEmpty())
             return false;
 
-        if(key.mid(0,4).toLower() == "ecb:")
+        QByteArrayView newKey(key);
+
+        if(key.size() >= 4 && qstrnicmp(key.constData(), "ecb:", 4) == 0)
         {
             m_cbc = false;
-            m_key = key.mid(4);
+            newKey = newKey.sliced(4);
         }
         //strip cbc: if included
-        else if(key.mid(0,4).toLower() == "cbc:")
+        else if(key.size() >= 4 && qstrnicmp(key.constData(), "cbc:", 4) == 0)
         {
             m_cbc = true;
-            m_key = key.mid(4);
+            newKey = newKey.sliced(4);
         }
         else
         {
@@ -61,18 +68,39 @@ namespace Konversation
                 m_cbc = true;
             else
                 m_cbc = false;
-            m_key = key;
         }
+
+        // This is called for every line, keep the key schedules unless the key changed
+        if(newKey.compare(m_key) != 0)
+        {
+            m_key = newKey.toByteArray();
+            resetContexts();
+        }
+
         return true;
     }
 
     bool Cipher::setType(const QString &type)
     {
         //TODO check QCA::isSupported()
-        m_type = type;
+        if(type != m_type)
+        {
+            m_type = type;
+            resetContexts();
+        }
+
         return true;
     }
 
+    void Cipher::resetContexts()
+    {
+        for(auto& contexts : m_contexts)
+        {
+            for(auto& context : contexts)
+                context.reset();
+        }
+    }
+
     QByteArray Cipher::decrypt(QByteArray cipherText)
     {
         QByteArray pfx = "(e) ";
@@ -299,34 +327,73 @@ namespace Konversation
         }
         return true;
     }
+
+    /**
+     * Runs @p data through the context of @p mode and @p direction. Setting
+     * up a context means a Blowfish key schedule, which is slow on purpose, so
+     * contexts are kept until the key changes. Lines are whole blocks and are
+     * never finalized, so a context can go on with the next one: ECB has no
+     * state, and CBC lines start with a throwaway IV block, which is all the
+     * chaining value left by the previous line can garble.
+     */
+    bool Cipher::process(Mode mode, bool direction, const QByteArray &data, QByteArray &result)
+    {
+        std::unique_ptr<QCA::Cipher>& context = m_contexts[mode][direction ? 1 : 0];
+
+        if(!context)
+        {
+            context = std::make_unique<QCA::Cipher>(m_type,
+                (mode == CBC) ? QCA::Cipher::CBC : QCA::Cipher::ECB,
+                QCA::Cipher::NoPadding,
+                direction ? QCA::Encode : QCA::Decode,
+                m_key,
+                (mode == CBC) ? QCA::InitializationVector(QByteArray(8, '\0')) : QCA::InitializationVector());
+        }
+
+        result = context->update(QCA::MemoryRegion(data)).toByteArray();
+        bool ok = context->ok();
+
+        // a provider holding back a block has to be finalized, which ends the context
+        if(ok && result.size() != data.size())
+        {
+            result += context->final().toByteArray();
+            ok = context->ok();
+            context.reset();
+        }
+
+        if(!ok)
+            context.reset();
+
+        return ok;
+    }
+
     //THE BELOW WORKS AKA DO NOT TOUCH UNLESS YOU KNOW WHAT YOU'RE DOING
-    QByteArray Cipher::blowfishCBC(QByteArray cipherText, bool direction)
+    QByteArray Cipher::blowfishCBC(const QByteArray &cipherText, bool direction)
     {
-        QCA::Initializer init;
-        QByteArray temp = cipherText;
+        QByteArray temp;
         if(direction)
         {
             // make sure cipherText is an interval of 8 bits. We do this before so that we
             // know there's at least 8 bytes to en/decryption this ensures QCA doesn't fail
-            while((temp.length() % 8) != 0) temp.append('\0');
+            const qsizetype padded = (cipherText.size() + 7) / 8 * 8;
 
-            QCA::InitializationVector iv(8);
-            temp.prepend(iv.toByteArray()); // prefix with 8bits of IV for mircryptions *CUSTOM* cbc implementation
+            // prefix with 8bits of IV for mircryptions *CUSTOM* cbc implementation
+            temp.reserve(8 + padded);
+            temp.append(QCA::InitializationVector(8).toByteArray());
+            temp.append(cipherText);
+            temp.resize(8 + padded, '\0');
         }
         else
         {
-            temp = QByteArray::fromBase64(temp);
+            temp = QByteArray::fromBase64(cipherText);
             //supposedly nescessary if we get a truncated message also allows for decryption of 'crazy'
             //en/decoding clients that use STANDARDIZED PADDING TECHNIQUES
-            while((temp.length() % 8) != 0) temp.append('\0');
+            temp.resize((temp.size() + 7) / 8 * 8, '\0');
         }
 
-        QCA::Direction dir = (direction) ? QCA::Encode : QCA::Decode;
-        QCA::Cipher cipher(m_type, QCA::Cipher::CBC, QCA::Cipher::NoPadding, dir, m_key, QCA::InitializationVector(QByteArray("0")));
-        QByteArray temp2 = cipher.update(QCA::MemoryRegion(temp)).toByteArray();
-        temp2 += cipher.final().toByteArray();
+        QByteArray temp2;
 
-        if(!cipher.ok())
+        if(!process(CBC, direction, temp, temp2))
             return cipherText;
 
         if(direction) //send in base64
@@ -337,32 +404,32 @@ namespace Konversation
         return temp2;
     }
 
-    QByteArray Cipher::blowfishECB(QByteArray cipherText, bool direction)
+    QByteArray Cipher::blowfishECB(const QByteArray &cipherText, bool direction)
     {
-        QCA::Initializer init;
-        QByteArray temp = cipherText;
+        QByteArray temp;
 
         //do padding ourselves
         if(direction)
         {
-            while((temp.length() % 8) != 0) temp.append('\0');
+            const qsizetype padded = (cipherText.size() + 7) / 8 * 8;
+
+            temp.reserve(padded);
+            temp.append(cipherText);
+            temp.resize(padded, '\0');
         }
         else
         {
             // ECB Blowfish encodes in blocks of 12 chars, so anything else is malformed input
-            if ((temp.length() % 12) != 0)
+            if ((cipherText.length() % 12) != 0)
                 return cipherText;
 
-            temp = b64ToByte(temp);
-            while ((temp.length() % 8) != 0) temp.append('\0');
+            // 12 chars decode to 8 bytes, which needs no padding
+            temp = b64ToByte(cipherText);
         }
 
-        QCA::Direction dir = (direction) ? QCA::Encode : QCA::Decode;
-        QCA::Cipher cipher(m_type, QCA::Cipher::ECB, QCA::Cipher::NoPadding, dir, m_key);
-        QByteArray temp2 = cipher.update(QCA::MemoryRegion(temp)).toByteArray();
-        temp2 += cipher.final().toByteArray();
+        QByteArray temp2;
 
-        if (!cipher.ok())
+        if (!process(ECB, direction, temp, temp2))
             return cipherText;
 
         if (direction)
@@ -377,94 +444,62 @@ namespace Konversation
         return temp2;
     }
 
-    //Custom non RFC 2045 compliant Base64 enc/dec code for mircryption / FiSH compatibility
+    //Custom non RFC 2045 compliant Base64 enc/dec code for mircryption / FiSH compatibility.
+    //Every 8 bytes are two big endian words, written right word first as 6 chars each, lowest
+    //6 bits first. The words are signed, so the last char of a word takes its sign along.
     QByteArray Cipher::byteToB64(const QByteArray &text)
     {
-        int left = 0;
-        int right = 0;
-        int k = -1;
-        int v;
-        QString base64 = QStringLiteral("./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ");
-        QByteArray encoded;
-        while (k < (text.length() - 1)) {
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            left = v << 24;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            left += v << 16;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            left += v << 8;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            left += v;
-
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            right = v << 24;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            right += v << 16;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            right += v << 8;
-            k++;
-            v=text.at(k); if (v<0) v+=256;
-            right += v;
-
-            for (int i = 0; i < 6; i++) {
-                encoded.append(base64.at(right & 0x3F).toLatin1());
-                right = right >> 6;
-            }
-            //TODO make sure the .tolatin1 doesn't break anything
+        const qsizetype blocks = text.size() / 8;
+        QByteArray encoded(blocks * 12, Qt::Uninitialized);
+        const auto* in = reinterpret_cast<const uchar*>(text.constData());
+        char* out = encoded.data();
 
-            for (int i = 0; i < 6; i++) {
-                encoded.append(base64.at(left & 0x3F).toLatin1());
-                left = left >> 6;
-            }
+        for (qsizetype block = 0; block < blocks; ++block, in += 8)
+        {
+            qint32 left = qint32(qFromBigEndian<quint32>(in));
+            qint32 right = qint32(qFromBigEndian<quint32>(in + 4));
+
+            for (int i = 0; i < 6; ++i, right >>= 6)
+                *out++ = fishBase64[right & 0x3F];
+
+            for (int i = 0; i < 6; ++i, left >>= 6)
+                *out++ = fishBase64[left & 0x3F];
         }
+
         return encoded;
     }
 
     QByteArray Cipher::b64ToByte(const QByteArray &text)
     {
-        QString base64 = QStringLiteral("./0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ");
-        QByteArray decoded;
-        int k = -1;
-        while (k < (text.length() - 1)) {
-            int right = 0;
-            int left = 0;
-            int v = 0;
-            int w = 0;
-            int z = 0;
-
-            for (int i = 0; i < 6; i++) {
-                k++;
-                v = base64.indexOf(QLatin1Char(text.at(k)));
-                right |= v << (i * 6);
-            }
+        // chars outside of the alphabet are -1, and so set all higher bits of their word
+        static const std::array<qint8, 256> values = [] {
+            std::array<qint8, 256> table;
+            table.fill(-1);
+            for (int i = 0; i < 64; ++i)
+                table[uchar(fishBase64[i])] = qint8(i);
+            return table;
+        }();
+
+        const qsizetype blocks = text.size() / 12;
+        QByteArray decoded(blocks * 8, Qt::Uninitialized);
+        const auto* in = reinterpret_cast<const uchar*>(text.constData());
+        auto* out = reinterpret_cast<uchar*>(decoded.data());
+
+        for (qsizetype block = 0; block < blocks; ++block, in += 12, out += 8)
+        {
+            quint32 right = 0;
+            quint32 left = 0;
 
-            for (int i = 0; i < 6; i++) {
-                k++;
-                v = base64.indexOf(QLatin1Char(text.at(k)));
-                left |= v << (i * 6);
-            }
+            for (int i = 0; i < 6; ++i)
+                right |= quint32(qint32(values[in[i]])) << (i * 6);
 
-            for (int i = 0; i < 4; i++) {
-                w = ((left & (0xFF << ((3 - i) * 8))));
-                z = w >> ((3 - i) * 8);
-                if(z < 0) {z = z + 256;}
-                decoded.append(z);
-            }
+            for (int i = 0; i < 6; ++i)
+                left |= quint32(qint32(values[in[6 + i]])) << (i * 6);
 
-            for (int i = 0; i < 4; i++) {
-                w = ((right & (0xFF << ((3 - i) * 8))));
-                z = w >> ((3 - i) * 8);
-                if(z < 0) {z = z + 256;}
-                decoded.append(z);
-            }
+            qToBigEndian(left, out);
+            qToBigEndian(right, out + 4);
         }
+
         return decoded;
     }
 
@@ -12,6 +12,8 @@
 #include <QIODevice>
 #include <QtCrypto>
 
+#include <memory>
+
 namespace Konversation
 {
     class Cipher
@@ -37,14 +39,20 @@ namespace Konversation
             static QString runtimeError() { return m_runtimeError; }
 
         private:
+            enum Mode { ECB, CBC, ModeCount };
+
             //direction is true for encrypt, false for decrypt
-            QByteArray blowfishCBC(QByteArray cipherText, bool direction);
-            QByteArray blowfishECB(QByteArray cipherText, bool direction);
-            QByteArray b64ToByte(const QByteArray &text);
-            QByteArray byteToB64(const QByteArray &text);
+            QByteArray blowfishCBC(const QByteArray &cipherText, bool direction);
+            QByteArray blowfishECB(const QByteArray &cipherText, bool direction);
+            bool process(Mode mode, bool direction, const QByteArray &data, QByteArray &result);
+            void resetContexts();
+            static QByteArray b64ToByte(const QByteArray &text);
+            static QByteArray byteToB64(const QByteArray &text);
 
         private:
             QCA::Initializer init;
+            /// Set up with m_key on first use, by mode and direction
+            std::unique_ptr<QCA::Cipher> m_contexts[ModeCount][2];
             QByteArray m_key;
             QCA::DHPrivateKey m_tempKey;
             QCA::BigInteger m_primeNum;
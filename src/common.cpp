@@ -145,36 +145,436 @@ namespace Konversation
         return data.channelRanges;
     }
 
+    // The URL and channel scanners below implement what once were the
+    // urlPattern and chanExp regular expressions, giving the same results.
+    // As in PCRE without Unicode properties \s and \w are ASCII only, while
+    // the case insensitive [a-z] also takes the two non-ASCII characters
+    // that fold into it.
+
+    static inline bool isPatternSpace(QChar c)
+    {
+        const char16_t u = c.unicode();
+        return u == ' ' || (u >= '\t' && u <= '\r');
+    }
+
+    static inline bool isPatternDigit(QChar c)
+    {
+        return c.unicode() >= '0' && c.unicode() <= '9';
+    }
+
+    static inline bool isPatternLetter(QChar c)
+    {
+        const char16_t u = c.unicode() | 0x20;
+        return (u >= 'a' && u <= 'z') || c.unicode() == 0x017F || c.unicode() == 0x212A;
+    }
+
+    static inline bool isPatternWordChar(QChar c)
+    {
+        const char16_t u = c.unicode();
+        return ((u | 0x20) >= 'a' && (u | 0x20) <= 'z') || isPatternDigit(c) || u == '_';
+    }
+
+    static inline bool isQuotationMark(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case 0x00AB:
+            case 0x00BB:
+            case 0x201C:
+            case 0x201D:
+            case 0x2018:
+            case 0x2019:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// [^\s()<>]
+    static inline bool isUrlChar(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case '(':
+            case ')':
+            case '<':
+            case '>':
+                return false;
+            default:
+                return !isPatternSpace(c);
+        }
+    }
+
+    /// [^\s`!()\[\]{};:'".,<>?«»“”‘’], which also ends an email address but for '/'
+    static inline bool isUrlEndChar(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case '`': case '!': case '[': case ']': case '{': case '}': case ';': case ':':
+            case '\'': case '"': case '.': case ',': case '?':
+                return false;
+            default:
+                return isUrlChar(c) && !isQuotationMark(c);
+        }
+    }
+
+    /// [a-z0-9.\-]
+    static inline bool isHostChar(QChar c)
+    {
+        return isPatternLetter(c) || isPatternDigit(c) || c == QLatin1Char('.') || c == QLatin1Char('-');
+    }
+
+    /// [a-z0-9.\-+_]
+    static inline bool isEmailLocalChar(QChar c)
+    {
+        return isHostChar(c) || c == QLatin1Char('+') || c == QLatin1Char('_');
+    }
+
+    /// [\w.-]
+    static inline bool isSchemeChar(QChar c)
+    {
+        return isPatternWordChar(c) || c == QLatin1Char('.') || c == QLatin1Char('-');
+    }
+
+    /**
+     * Matches URLs and email addresses at given positions of a text.
+     *
+     * A URL is a prefix (scheme with slashes, "www." or a host name followed
+     * by a slash) followed by a body of non-space characters and balanced
+     * parentheses, ending in a character that is not punctuation. The end
+     * of each part is found with backtracking done by hand, in the same
+     * order a regular expression engine would try. Runs of characters that
+     * several starting positions share are measured only once, which keeps
+     * scanning a whole line linear.
+     */
+    class UrlScanner
+    {
+        public:
+            /// With @p requiredEnd >= 0 only matches ending there are accepted.
+            UrlScanner(QStringView text, qsizetype requiredEnd = -1)
+                : m_text(text)
+                , m_requiredEnd(requiredEnd)
+            {
+            }
+
+            /// Returns the end of the match starting at @p start, or -1.
+            qsizetype matchAt(qsizetype start, bool* hasProtocol);
+
+        private:
+            struct Run
+            {
+                qsizetype start = -1;
+                qsizetype end = -1;
+            };
+
+            struct CachedEnd
+            {
+                qsizetype from = -1;
+                qsizetype end = -1;
+            };
+
+            qsizetype runEnd(Run& run, qsizetype start, bool (*inClass)(QChar)) const;
+            qsizetype matchParentheses(qsizetype pos) const;
+            qsizetype matchBody(qsizetype pos) const;
+            qsizetype matchEmailDomain(qsizetype at) const;
+            qsizetype cached(CachedEnd& cache, qsizetype from, qsizetype (UrlScanner::*match)(qsizetype) const) const;
+            bool accepts(qsizetype end) const { return m_requiredEnd < 0 || end == m_requiredEnd; }
+
+        private:
+            QStringView m_text;
+            qsizetype m_requiredEnd;
+
+            Run m_schemeRun;
+            Run m_hostRun;
+            Run m_localRun;
+            CachedEnd m_schemeBody;
+            CachedEnd m_hostBody;
+            CachedEnd m_emailDomain;
+    };
+
+    qsizetype UrlScanner::runEnd(Run& run, qsizetype start, bool (*inClass)(QChar)) const
+    {
+        // Positions are visited in increasing order, a later start inside
+        // the known run shares its end.
+        if (start < run.start || start >= run.end)
+        {
+            run.start = start;
+            run.end = start;
+
+            while (run.end < m_text.size() && inClass(m_text.at(run.end)))
+                ++run.end;
+        }
+
+        return run.end;
+    }
+
+    qsizetype UrlScanner::cached(CachedEnd& cache, qsizetype from, qsizetype (UrlScanner::*match)(qsizetype) const) const
+    {
+        if (cache.from != from)
+        {
+            cache.from = from;
+            cache.end = (this->*match)(from);
+        }
+
+        return cache.end;
+    }
+
+    /// \(([^\s()<>]+|(\([^\s()<>]+\)))*\) at @p pos, returns its end or -1.
+    qsizetype UrlScanner::matchParentheses(qsizetype pos) const
+    {
+        ++pos;
+
+        while (pos < m_text.size())
+        {
+            const QChar c = m_text.at(pos);
+
+            if (c == QLatin1Char(')'))
+                return pos + 1;
+
+            if (c == QLatin1Char('('))
+            {
+                // one level of nesting, not empty
+                qsizetype inner = pos + 1;
+
+                while (inner < m_text.size() && isUrlChar(m_text.at(inner)))
+                    ++inner;
+
+                if (inner == pos + 1 || inner == m_text.size() || m_text.at(inner) != QLatin1Char(')'))
+                    return -1;
+
+                pos = inner + 1;
+            }
+            else if (isUrlChar(c))
+                ++pos;
+            else
+                return -1;
+        }
+
+        return -1;
+    }
+
+    /**
+     * Matches the body and the last character of a URL at @p pos.
+     * The body takes at least one character, the match ends after the
+     * last position past that which can end a URL.
+     */
+    qsizetype UrlScanner::matchBody(qsizetype pos) const
+    {
+        const qsizetype bodyStart = pos;
+        qsizetype end = -1;
+
+        while (pos < m_text.size())
+        {
+            const QChar c = m_text.at(pos);
+
+            if (c == QLatin1Char('('))
+            {
+                const qsizetype groupEnd = matchParentheses(pos);
+
+                if (groupEnd < 0)
+                    break;
+
+                if (pos > bodyStart && accepts(groupEnd))
+                    end = groupEnd;
+
+                pos = groupEnd;
+            }
+            else if (isUrlChar(c))
+            {
+                if (pos > bodyStart)
+                {
+                    if (c == QLatin1Char('}') && pos + 1 < m_text.size() && m_text.at(pos + 1) == QLatin1Char(']'))
+                    {
+                        if (accepts(pos + 2))
+                            end = pos + 2;
+                    }
+                    else if (isUrlEndChar(c) && accepts(pos + 1))
+                        end = pos + 1;
+                }
+
+                ++pos;
+            }
+            else
+                break;
+        }
+
+        return end;
+    }
+
+    /// [a-z0-9.\-]+[.][a-z]{1,5} and a closing character after the '@' at @p at.
+    qsizetype UrlScanner::matchEmailDomain(qsizetype at) const
+    {
+        qsizetype domainEnd = at + 1;
+
+        while (domainEnd < m_text.size() && isHostChar(m_text.at(domainEnd)))
+            ++domainEnd;
+
+        for (qsizetype dot = domainEnd - 1; dot >= at + 2; --dot)
+        {
+            if (m_text.at(dot) != QLatin1Char('.'))
+                continue;
+
+            int letters = 0;
+
+            while (letters < 5 && dot + 1 + letters < m_text.size() && isPatternLetter(m_text.at(dot + 1 + letters)))
+                ++letters;
+
+            for ( ; letters > 0; --letters)
+            {
+                const qsizetype last = dot + 1 + letters;
+
+                if (last < m_text.size() && isUrlEndChar(m_text.at(last)) && m_text.at(last) != QLatin1Char('/')
+                    && accepts(last + 1))
+                {
+                    return last + 1;
+                }
+            }
+        }
+
+        return -1;
+    }
+
+    qsizetype UrlScanner::matchAt(qsizetype start, bool* hasProtocol)
+    {
+        const qsizetype size = m_text.size();
+        const QChar first = m_text.at(start);
+
+        *hasProtocol = false;
+
+        // \b
+        if (isPatternWordChar(first) == (start > 0 && isPatternWordChar(m_text.at(start - 1))))
+            return -1;
+
+        if (isPatternLetter(first))
+        {
+            // [a-z][\w.-]+:/{1,3}
+            const qsizetype colon = runEnd(m_schemeRun, start + 1, isSchemeChar);
+
+            if (colon > start + 1 && colon + 1 < size && m_text.at(colon) == QLatin1Char(':')
+                && m_text.at(colon + 1) == QLatin1Char('/'))
+            {
+                // Slashes past the first one are valid body characters,
+                // taking them as part of the body covers all three choices.
+                const qsizetype end = cached(m_schemeBody, colon + 2, &UrlScanner::matchBody);
+
+                if (end >= 0)
+                {
+                    *hasProtocol = true;
+                    return end;
+                }
+            }
+
+            // www\d{0,3}[.]
+            if (start + 3 < size && (first.unicode() | 0x20) == 'w' && (m_text.at(start + 1).unicode() | 0x20) == 'w'
+                && (m_text.at(start + 2).unicode() | 0x20) == 'w')
+            {
+                qsizetype dot = start + 3;
+
+                while (dot < size && dot < start + 6 && isPatternDigit(m_text.at(dot)))
+                    ++dot;
+
+                if (dot < size && m_text.at(dot) == QLatin1Char('.'))
+                {
+                    const qsizetype end = matchBody(dot + 1);
+
+                    if (end >= 0)
+                        return end;
+                }
+            }
+        }
+
+        // [a-z0-9.\-]+[.][a-z]{2,4}/
+        if (isHostChar(first))
+        {
+            const qsizetype slash = runEnd(m_hostRun, start, isHostChar);
+
+            if (slash < size && m_text.at(slash) == QLatin1Char('/'))
+            {
+                bool hostOK = false;
+
+                for (int letters = 2; letters <= 4 && !hostOK; ++letters)
+                {
+                    const qsizetype dot = slash - 1 - letters;
+
+                    if (dot < start + 1 || m_text.at(dot) != QLatin1Char('.'))
+                        continue;
+
+                    hostOK = true;
+
+                    for (qsizetype i = dot + 1; i < slash && hostOK; ++i)
+                        hostOK = isPatternLetter(m_text.at(i));
+                }
+
+                if (hostOK)
+                {
+                    const qsizetype end = cached(m_hostBody, slash + 1, &UrlScanner::matchBody);
+
+                    if (end >= 0)
+                        return end;
+                }
+            }
+        }
+
+        // [a-z0-9.\-+_]+@ and the domain
+        if (isEmailLocalChar(first))
+        {
+            const qsizetype at = runEnd(m_localRun, start, isEmailLocalChar);
+
+            if (at < size && m_text.at(at) == QLatin1Char('@'))
+                return cached(m_emailDomain, at, &UrlScanner::matchEmailDomain);
+        }
+
+        return -1;
+    }
+
+    /// Returns whether @p c can start a URL or email address.
+    static inline bool isUrlStartChar(QChar c)
+    {
+        return isEmailLocalChar(c);
+    }
+
     TextUrlData extractUrlData(const QString& text, bool doUrlFixup)
     {
         TextUrlData data;
-        QString htmlText(text);
-        urlPattern.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
 
-        int pos = 0;
-        int urlLen = 0;
+        // Every match has a ':' after its scheme or a '.' in its host.
+        if (!text.contains(QLatin1Char('.')) && !text.contains(QLatin1Char(':')))
+            return data;
+
+        UrlScanner scanner(text);
 
         QString protocol;
         QString href;
 
-        QRegularExpressionMatch rmatch;
-        while ((pos = htmlText.indexOf(urlPattern, pos, &rmatch)) >= 0)
+        qsizetype pos = 0;
+
+        while (pos < text.size())
         {
-            urlLen = rmatch.capturedLength(0);
-            href = htmlText.mid(pos, urlLen);
+            bool hasProtocol = false;
+            qsizetype end = -1;
+
+            for ( ; pos < text.size(); ++pos)
+            {
+                if (isUrlStartChar(text.at(pos)) && (end = scanner.matchAt(pos, &hasProtocol)) >= 0)
+                    break;
+            }
+
+            if (end < 0)
+                break;
+
+            href = text.mid(pos, end - pos);
 
             data.urlRanges << QPair<int, int>(pos, href.length());
-            pos += href.length();
+            pos = end;
 
             if (doUrlFixup)
             {
                 protocol.clear();
-                if (rmatch.captured(2).isEmpty())
+                if (!hasProtocol)
                 {
-                    QString urlPatternCap1(rmatch.captured(1));
-                    if (urlPatternCap1.contains(QLatin1Char('@')))
+                    if (href.contains(QLatin1Char('@')))
                         protocol = QStringLiteral("mailto:");
-                    else if (urlPatternCap1.startsWith(QLatin1String("ftp."), Qt::CaseInsensitive))
+                    else if (href.startsWith(QLatin1String("ftp."), Qt::CaseInsensitive))
                         protocol = QStringLiteral("ftp://");
                     else
                         protocol = QStringLiteral("http://");
@@ -187,28 +587,107 @@ namespace Konversation
         return data;
     }
 
+    /// [^,\s;\)\:\/\(\<\>]
+    static inline bool isChannelChar(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case ',': case ';': case ')': case ':': case '/': case '(': case '<': case '>':
+                return false;
+            default:
+                return !isPatternSpace(c);
+        }
+    }
+
+    /// [^.,\s;\)\:\/\(\"\'\<\>?«»“”‘’]
+    static inline bool isChannelEndChar(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case '.': case '"': case '\'': case '?':
+                return false;
+            default:
+                return isChannelChar(c) && !isQuotationMark(c);
+        }
+    }
+
+    /// Characters that may come right before a channel name, besides spaces.
+    static inline bool isChannelPrefixChar(QChar c)
+    {
+        switch (c.unicode())
+        {
+            case ',': case '\'': case '(': case ':': case '!': case '@': case '%': case '+':
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Matches a channel name at the '#' at @p hash. The text in front of it
+     * is only looked at from @p from on, as after the previous match.
+     * Returns the end of the channel name, or -1.
+     */
+    static qsizetype matchChannel(QStringView text, qsizetype hash, qsizetype from)
+    {
+        bool prefixOK;
+
+        if (hash == 0)
+            prefixOK = (from == 0);
+        else if (hash - 1 < from)
+            prefixOK = false;
+        else
+        {
+            const QChar before = text.at(hash - 1);
+
+            if (isPatternSpace(before) || isChannelPrefixChar(before))
+                prefixOK = true;
+            else if (before == QLatin1Char('"'))
+                prefixOK = (hash == 1) || (hash - 2 >= from && isPatternSpace(text.at(hash - 2)));
+            else
+                prefixOK = false;
+        }
+
+        if (!prefixOK)
+            return -1;
+
+        qsizetype end = hash + 1;
+
+        while (end < text.size() && isChannelChar(text.at(end)))
+            ++end;
+
+        // the name ends with its last character that can end it
+        for ( ; end > hash + 1; --end)
+        {
+            if (isChannelEndChar(text.at(end - 1)))
+                return end;
+        }
+
+        return -1;
+    }
+
     TextChannelData extractChannelData(const QString& text, bool doChannelFixup)
     {
         TextChannelData data;
-        QString ircText(text);
 
-        int pos = 0;
-        int chanLen = 0;
+        qsizetype from = 0;
+        qsizetype hash = text.indexOf(QLatin1Char('#'));
         QString channel;
 
-        QRegularExpressionMatch rmatch;
-        while ((pos = ircText.indexOf(chanExp, pos, &rmatch)) >= 0)
+        while (hash != -1)
         {
-            channel = rmatch.captured(2);
-            chanLen = channel.length();
+            const qsizetype end = matchChannel(text, hash, from);
+
+            if (end < 0)
+            {
+                hash = text.indexOf(QLatin1Char('#'), hash + 1);
+                continue;
+            }
 
-            // we want the pos where #channel starts
-            // indexIn gives us the first match and the first match may be
-            // "#test", " #test" or " \"test", so the first Index is off by some chars
-            pos = rmatch.capturedStart(2);
+            channel = text.mid(hash, end - hash);
 
-            data.channelRanges << QPair<int, int>(pos, chanLen);
-            pos += chanLen;
+            data.channelRanges << QPair<int, int>(hash, channel.length());
+            from = end;
 
             if (doChannelFixup)
             {
@@ -216,16 +695,21 @@ namespace Konversation
                 channel = QString::fromLatin1(QUrl::toPercentEncoding(channel));
                 data.fixedChannels.append(channel);
             }
+
+            hash = text.indexOf(QLatin1Char('#'), end);
         }
         return data;
     }
 
     bool isUrl(const QString& text)
     {
-        QRegularExpression re(urlPattern);
-        re.setPattern(QRegularExpression::anchoredPattern(urlPattern.pattern()));
+        if (text.isEmpty())
+            return false;
+
+        UrlScanner scanner(text, text.size());
+        bool hasProtocol;
 
-        return re.match(text).hasMatch();
+        return scanner.matchAt(0, &hasProtocol) == text.size();
     }
 
     QString extractColorCodes(const QString& _text)
@@ -266,16 +750,18 @@ namespace Konversation
         return copy;
     }
 
-    /// Replace invalid codepoints so the string can be converted to Utf8.
-    /// @param s a reference to the QString to change, a reference so it works with m_inputbuffer.back() in server.cpp
-    /// @retval s reference to the argument
-    QString& sterilizeUnicode(QString& s)
+    /// sterilizeUnicode() starting at @p from.
+    static void sterilizeUnicode(QString& s, qsizetype from)
     {
         // HACK work around undocumented requirement to vet Unicode text sent over DBUS.
         // strips noncharacters, the private use characters are presumably safe
-        for (int i = 0; i < s.length(); ++i)
+        for (qsizetype i = from; i < s.length(); ++i)
         {
             QChar c(s.at(i));
+            // all assigned, spare the common case the category lookup
+            if (c.unicode() < 0x0100)
+                continue;
+
             if (c.category() == QChar::Other_Surrogate)
             {
                 if (!c.isHighSurrogate() || (!(i+1 < s.length()) && !s.at(i+1).isLowSurrogate()))
@@ -302,6 +788,14 @@ namespace Konversation
                 s.replace(i, 1, QChar(0xFFFD));
             }
         }
+    }
+
+    /// Replace invalid codepoints so the string can be converted to Utf8.
+    /// @param s a reference to the QString to change, a reference so it works with m_inputbuffer.back() in server.cpp
+    /// @retval s reference to the argument
+    QString& sterilizeUnicode(QString& s)
+    {
+        sterilizeUnicode(s, 0);
         return s;
     }
 
@@ -323,4 +817,40 @@ namespace Konversation
         return sterilizeUnicode(out);
     }
 
+    bool decodeUtf8Line(const QByteArray& line, QString& text)
+    {
+        const char* data = line.constData();
+        const qsizetype size = line.size();
+        const qsizetype asciiLength = skipAscii(data, 0, size);
+
+        // nothing to guess, validate or sterilize
+        if (asciiLength == size)
+        {
+            text = QString::fromLatin1(line);
+            return true;
+        }
+
+        // The ASCII prefix has no escape sequences and leaves the guess in its
+        // initial state, so guessing from the first other byte on is the same.
+        JapaneseCode jc;
+
+        switch (jc.guess_jp(data + asciiLength, int(size - asciiLength)))
+        {
+            case JapaneseCode::K_SJIS:
+            case JapaneseCode::K_JIS:
+                return false;
+            default:
+                break;
+        }
+
+        if (!isUtf8Sequence(data, asciiLength, size))
+            return false;
+
+        text = QString::fromUtf8(line);
+        // one character per byte of the ASCII prefix
+        sterilizeUnicode(text, asciiLength);
+
+        return true;
+    }
+
 }
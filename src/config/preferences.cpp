@@ -142,11 +142,18 @@ const QList<QStringList> Preferences::autoreplaceList()
 void Preferences::setAutoreplaceList(const QList<QStringList> &newList)
 {
   self()->mAutoreplaceList=newList;
+  ++self()->mAutoreplaceListRevision;
 }
 
 void Preferences::clearAutoreplaceList()
 {
   self()->mAutoreplaceList.clear();
+  ++self()->mAutoreplaceListRevision;
+}
+
+int Preferences::autoreplaceListRevision()
+{
+  return self()->mAutoreplaceListRevision;
 }
 
 // --------------------------- AutoReplace ---------------------------
@@ -91,6 +91,8 @@ class Preferences : public PreferencesBase
         static const QList<QStringList> defaultAutoreplaceList();
         static void setAutoreplaceList(const QList<QStringList> &newList);
         static void clearAutoreplaceList();
+        /// Changes whenever the autoreplace list is set or cleared.
+        static int autoreplaceListRevision();
 
         static void addIdentity(const IdentityPtr &identity);
         static void removeIdentity(const IdentityPtr &identity);
@@ -164,6 +166,7 @@ class Preferences : public PreferencesBase
         QHash<QString, QHash<QString, QString> > mServerSpellCheckingLanguages;
         QStringList mQuickButtonList;
         QList<QStringList> mAutoreplaceList;
+        int mAutoreplaceListRevision = 0;
         QString mSortingOrder;
 };
 
@@ -114,6 +114,8 @@ KonviSettingsDialog::KonviSettingsDialog( QWidget *parent) :
   confChatwindowBehaviour.kcfg_ScrollbackMax->setSuffix(ki18np(" line", " lines"));
   confChatwindowBehaviour.kcfg_AutoWhoNicksLimit->setSuffix(ki18np(" nick", " nicks"));
   confChatwindowBehaviour.kcfg_AutoWhoContinuousInterval->setSuffix(ki18np(" second", " seconds"));
+  confChatwindowBehaviour.kcfg_UrlCatcherMaxEntries->setSuffix(ki18np(" URL", " URLs"));
+  confChatwindowBehaviour.kcfg_UrlCatcherMaxAge->setSuffix(ki18np(" day", " days"));
   konviAddSubPage(behaviorGroup, w, i18n("Chat Window"), QStringLiteral("view-list-text"));
 
   //Behaviour/Nickname List
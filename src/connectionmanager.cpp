@@ -7,6 +7,7 @@
 #include "connectionmanager.h"
 
 #include "connectionsettings.h"
+#include "reconnectscheduler.h"
 #include "serversettings.h"
 #include "servergroupsettings.h"
 #include "config/preferences.h"
@@ -28,6 +29,8 @@ ConnectionManager::ConnectionManager(QObject* parent)
 //    if (Solid::Networking::status() != Solid::Networking::Connected)
 //        m_overrideAutoReconnect = true;
 
+    m_reconnectScheduler = new Konversation::ReconnectScheduler(this);
+
     connect(this, &ConnectionManager::requestReconnect, this, &ConnectionManager::handleReconnect);
 }
 
@@ -153,6 +156,9 @@ void ConnectionManager::connectTo(Konversation::ConnectionFlag flag, ConnectionS
     connect(server, &Server::connectionStateChanged,
             this, &ConnectionManager::handleConnectionStateChange);
 
+    connect(server, &Server::scheduledConnectDue,
+            m_reconnectScheduler, &Konversation::ReconnectScheduler::requestConnect);
+
     connect(server, &Server::awayState, this, &ConnectionManager::connectionChangedAwayState);
 
     connect(server, &Server::nicksNowOnline,
@@ -174,12 +180,15 @@ void ConnectionManager::enlistConnection(int connectionId, Server* server)
 void ConnectionManager::delistConnection(int connectionId)
 {
     m_connectionList.remove(connectionId);
+    m_reconnectScheduler->removeConnection(connectionId);
 
     Q_EMIT connectionListChanged();
 }
 
 void ConnectionManager::handleConnectionStateChange(Server* server, Konversation::ConnectionState state)
 {
+    m_reconnectScheduler->handleConnectionStateChange(server, state);
+
     Q_EMIT connectionChangedState(server, state);
 
     int identityId = server->getIdentity()->id();
@@ -233,6 +242,9 @@ void ConnectionManager::handleReconnect(Server* server)
 
     if (reconnectCount == 0 || settings.reconnectCount() < reconnectCount)
     {
+        const qint64 delay = m_reconnectScheduler->nextDelay(server);
+        const int delaySeconds = int((delay + 500) / 1000);
+
         if (settings.serverGroup() && settings.serverGroup()->serverList().size() > 1)
         {
             Konversation::ServerList serverList = settings.serverGroup()->serverList();
@@ -251,7 +263,7 @@ void ConnectionManager::handleReconnect(Server* server)
                 i18np(
                  "Trying to connect to %2 (port %3) in 1 second.",
                  "Trying to connect to %2 (port %3) in %1 seconds.",
-                 Preferences::self()->reconnectDelay(),
+                 delaySeconds,
                  settings.server().host(),
                  QString::number(settings.server().port())));
         }
@@ -261,13 +273,13 @@ void ConnectionManager::handleReconnect(Server* server)
                 i18np(
                  "Trying to reconnect to %2 (port %3) in 1 second.",
                  "Trying to reconnect to %2 (port %3) in %1 seconds.",
-                 Preferences::self()->reconnectDelay(),
+                 delaySeconds,
                  settings.server().host(),
                  QString::number(settings.server().port())));
         }
 
         server->getConnectionSettings().incrementReconnectCount();
-        server->connectToIRCServerIn(Preferences::self()->reconnectDelay());
+        server->connectToIRCServerIn(int(delay));
     }
     else
     {
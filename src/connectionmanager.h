@@ -16,6 +16,11 @@
 
 class ConnectionSettings;
 
+namespace Konversation
+{
+    class ReconnectScheduler;
+}
+
 class ConnectionManager : public QObject
 {
     Q_OBJECT
@@ -98,6 +103,7 @@ class ConnectionManager : public QObject
         QMap<int, Server*> m_connectionList;
         QSet<uint> m_activeIdentities;
         bool m_overrideAutoReconnect;
+        Konversation::ReconnectScheduler* m_reconnectScheduler;
 
         enum ConnectionDupe { SameServer, SameServerGroup };
 
@@ -11,19 +11,40 @@
 #include "channel.h"
 #include "identity.h"
 #include "server.h"
+#include "pipelinestats.h"
 #include "konversation_log.h"
 
 #include <KLocalizedString>
 
 #include <QDBusConnection>
+#include <QDBusServiceWatcher>
 
 using namespace Konversation;
 
+struct EventName
+{
+    DBus::Event event;
+    const char* name;
+};
+
+static const EventName eventNames[] = {
+    { DBus::MessageEvent, "message" },
+    { DBus::JoinEvent, "join" },
+    { DBus::PartEvent, "part" },
+    { DBus::QuitEvent, "quit" },
+    { DBus::HighlightEvent, "highlight" },
+};
 
 DBus::DBus(QObject *parent) : QObject(parent)
 {
     QDBusConnection bus = QDBusConnection::sessionBus();
     bus.connect(QStringLiteral("org.freedesktop.ScreenSaver"), QStringLiteral("/ScreenSaver"), QStringLiteral("org.freedesktop.ScreenSaver"), QStringLiteral("ActiveChanged"), this, SLOT(changeAwayStatus(bool)));
+
+    m_subscribedEvents = NoEvent;
+    m_subscriberWatcher = new QDBusServiceWatcher(this);
+    m_subscriberWatcher->setConnection(bus);
+    m_subscriberWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(m_subscriberWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &DBus::removeSubscriber);
 }
 
 void DBus::raw(const QString& server,const QString& command)
@@ -110,6 +131,187 @@ QStringList DBus::listJoinedChannels(const QString& serverName)
     return joinedChannels;
 }
 
+QVariantList DBus::snapshot(bool includeNicks)
+{
+    QVariantList connections;
+    const QList<Server*> serverList = Application::instance()->getConnectionManager()->getServerList();
+
+    connections.reserve(serverList.size());
+
+    for (Server* server : serverList)
+    {
+        QVariantList channels;
+
+        for (Channel* channel : server->getChannelList())
+        {
+            if (!channel->isJoined())
+                continue;
+
+            QVariantMap channelMap {
+                { QStringLiteral("name"), channel->getName() },
+                { QStringLiteral("topic"), channel->getTopic() },
+                { QStringLiteral("modes"), channel->getModeList() },
+                { QStringLiteral("nickCount"), channel->numberOfNicks() },
+            };
+
+            if (includeNicks)
+            {
+                QVariantList nicks;
+                const ChannelNickMap* members = server->getJoinedChannelMembers(channel->getName());
+
+                if (members)
+                {
+                    nicks.reserve(members->size());
+
+                    for (const ChannelNickPtr& channelNick : *members)
+                    {
+                        QString modes;
+
+                        if (channelNick->isOwner()) modes += QLatin1Char('q');
+                        if (channelNick->isAdmin()) modes += QLatin1Char('a');
+                        if (channelNick->isOp()) modes += QLatin1Char('o');
+                        if (channelNick->isHalfOp()) modes += QLatin1Char('h');
+                        if (channelNick->hasVoice()) modes += QLatin1Char('v');
+
+                        nicks.append(QVariantMap {
+                            { QStringLiteral("nick"), channelNick->getNickname() },
+                            { QStringLiteral("modes"), modes },
+                            { QStringLiteral("away"), channelNick->getNickInfo()->isAway() },
+                        });
+                    }
+                }
+
+                channelMap.insert(QStringLiteral("nicks"), nicks);
+            }
+
+            channels.append(channelMap);
+        }
+
+        connections.append(QVariantMap {
+            { QStringLiteral("id"), server->connectionId() },
+            { QStringLiteral("name"), server->getDisplayName() },
+            { QStringLiteral("server"), server->getServerName() },
+            { QStringLiteral("nickname"), server->getNickname() },
+            { QStringLiteral("connected"), server->isConnected() },
+            { QStringLiteral("away"), server->isAway() },
+            { QStringLiteral("channels"), channels },
+        });
+    }
+
+    return connections;
+}
+
+int DBus::sendMessages(const QString& serverName, const QString& target, const QStringList& messages)
+{
+    ConnectionManager* connectionManager = Application::instance()->getConnectionManager();
+    Server* server = connectionManager->getServerByName(sterilizeUnicode(serverName), ConnectionManager::MatchByIdThenName);
+
+    if (!server || target.isEmpty())
+        return 0;
+
+    return server->dbusSendMessages(sterilizeUnicode(target), sterilizeUnicode(messages));
+}
+
+static DBus::Events eventsFromNames(const QStringList& names)
+{
+    DBus::Events events = DBus::NoEvent;
+
+    for (const QString& name : names)
+    {
+        for (const EventName& eventName : eventNames)
+        {
+            if (name.compare(QLatin1String(eventName.name), Qt::CaseInsensitive) == 0)
+                events |= eventName.event;
+        }
+    }
+
+    return events;
+}
+
+static QStringList eventsToNames(DBus::Events events)
+{
+    QStringList names;
+
+    for (const EventName& eventName : eventNames)
+    {
+        if (events.testFlag(eventName.event))
+            names.append(QLatin1String(eventName.name));
+    }
+
+    return names;
+}
+
+QStringList DBus::subscribe(const QStringList& events)
+{
+    const QString service = calledFromDBus() ? message().service() : QString();
+
+    return eventsToNames(updateSubscription(service, m_subscribers.value(service) | eventsFromNames(events)));
+}
+
+QStringList DBus::unsubscribe(const QStringList& events)
+{
+    const QString service = calledFromDBus() ? message().service() : QString();
+
+    return eventsToNames(updateSubscription(service, m_subscribers.value(service) & ~eventsFromNames(events)));
+}
+
+DBus::Events DBus::updateSubscription(const QString& service, Events events)
+{
+    if (events == NoEvent)
+    {
+        if (m_subscribers.remove(service) && !service.isEmpty())
+            m_subscriberWatcher->removeWatchedService(service);
+    }
+    else
+    {
+        if (!m_subscribers.contains(service) && !service.isEmpty())
+            m_subscriberWatcher->addWatchedService(service);
+
+        m_subscribers.insert(service, events);
+    }
+
+    m_subscribedEvents = NoEvent;
+    for (Events subscribed : std::as_const(m_subscribers))
+        m_subscribedEvents |= subscribed;
+
+    return events;
+}
+
+void DBus::removeSubscriber(const QString& service)
+{
+    updateSubscription(service, NoEvent);
+}
+
+void DBus::reportMessage(Server* server, const QString& target, const QString& nick, const QString& message, bool action)
+{
+    if (isSubscribed(MessageEvent) && !server->isPlayback())
+        Q_EMIT messageReceived(QString::number(server->connectionId()), target, nick, message, action);
+}
+
+void DBus::reportJoin(Server* server, const QString& channel, const QString& nick)
+{
+    if (isSubscribed(JoinEvent) && !server->isPlayback())
+        Q_EMIT nickJoined(QString::number(server->connectionId()), channel, nick);
+}
+
+void DBus::reportPart(Server* server, const QString& channel, const QString& nick, const QString& reason)
+{
+    if (isSubscribed(PartEvent) && !server->isPlayback())
+        Q_EMIT nickParted(QString::number(server->connectionId()), channel, nick, reason);
+}
+
+void DBus::reportQuit(Server* server, const QString& nick, const QString& reason)
+{
+    if (isSubscribed(QuitEvent) && !server->isPlayback())
+        Q_EMIT nickQuit(QString::number(server->connectionId()), nick, reason);
+}
+
+void DBus::reportHighlight(Server* server, const QString& target, const QString& nick, const QString& message)
+{
+    if (isSubscribed(HighlightEvent) && !server->isPlayback())
+        Q_EMIT highlighted(QString::number(server->connectionId()), target, nick, message);
+}
+
 void DBus::setAway(const QString& awaymessage)
 {
     Application::instance()->getAwayManager()->requestAllAway(sterilizeUnicode(awaymessage));
@@ -199,6 +401,21 @@ QString DBus::getChannelEncoding(const QString& server, const QString& channel)
     return Preferences::channelEncoding(sterilizeUnicode(server), sterilizeUnicode(channel));
 }
 
+QString DBus::pipelineStatistics()
+{
+    return QString::fromUtf8(PipelineStats::toJson());
+}
+
+void DBus::setPipelineStatisticsEnabled(bool enabled)
+{
+    PipelineStats::setEnabled(enabled);
+}
+
+void DBus::resetPipelineStatistics()
+{
+    PipelineStats::reset();
+}
+
 void DBus::changeAwayStatus(bool away)
 {
     Application* konvApp = Application::instance();
@@ -9,7 +9,13 @@
 
 #include "common.h"
 
+#include <QDBusContext>
+#include <QHash>
 #include <QObject>
+#include <QVariant>
+
+class QDBusServiceWatcher;
+class Server;
 
 namespace Konversation
 {
@@ -17,17 +23,38 @@ namespace Konversation
 /**
  * The konversation D-Bus interface class
  */
-class DBus : public QObject
+class DBus : public QObject, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.konversation")
 
     public:
+        /// The events D-Bus clients can subscribe to, see subscribe().
+        enum Event
+        {
+            NoEvent = 0,
+            MessageEvent = 1,
+            JoinEvent = 2,
+            PartEvent = 4,
+            QuitEvent = 8,
+            HighlightEvent = 16
+        };
+        Q_DECLARE_FLAGS(Events, Event)
+
         explicit DBus(QObject *parent = nullptr);
 
         QString getNickname (const QString &server);
         QString getChannelEncoding(const QString& server, const QString& channel);
 
+        bool isSubscribed(Event event) const { return m_subscribedEvents.testFlag(event); }
+
+        /// Emit the D-Bus signal of the event, if anyone subscribed to it.
+        void reportMessage(Server* server, const QString& target, const QString& nick, const QString& message, bool action);
+        void reportJoin(Server* server, const QString& channel, const QString& nick);
+        void reportPart(Server* server, const QString& channel, const QString& nick, const QString& reason);
+        void reportQuit(Server* server, const QString& nick, const QString& reason);
+        void reportHighlight(Server* server, const QString& target, const QString& nick, const QString& message);
+
     Q_SIGNALS:
         void dbusSay(const QString& server,const QString& target,const QString& command);
         void dbusInfo(const QString& string);
@@ -43,6 +70,13 @@ class DBus : public QObject
                        const QString& channel = QString(),
                        bool useSSL = false);
 
+        // Exported, connection is the id as in listConnections(); not for lines played back by a bouncer
+        Q_SCRIPTABLE void messageReceived(const QString& connection, const QString& target, const QString& nick, const QString& message, bool action);
+        Q_SCRIPTABLE void nickJoined(const QString& connection, const QString& channel, const QString& nick);
+        Q_SCRIPTABLE void nickParted(const QString& connection, const QString& channel, const QString& nick, const QString& reason);
+        Q_SCRIPTABLE void nickQuit(const QString& connection, const QString& nick, const QString& reason);
+        Q_SCRIPTABLE void highlighted(const QString& connection, const QString& target, const QString& nick, const QString& message);
+
     public Q_SLOTS:
         void setAway(const QString &awaymessage);
         void setBack();
@@ -61,10 +95,53 @@ class DBus : public QObject
         QStringList listConnectedServers();
         QStringList listJoinedChannels(const QString& server);
 
+        /**
+         * All connections with their joined channels in one call, as maps of
+         * "id", "name", "server", "nickname", "connected", "away" and
+         * "channels". Channels have "name", "topic", "modes" and "nickCount",
+         * and with @p includeNicks "nicks" with "nick", "modes" and "away".
+         */
+        QVariantList snapshot(bool includeNicks);
+
+        /**
+         * Sends @p messages to @p target as if typed without being parsed for
+         * commands, in one batch.
+         *
+         * @return the number of lines queued, 0 if the target was not found
+         */
+        int sendMessages(const QString& server, const QString& target, const QStringList& messages);
+
+        /**
+         * Subscribes the caller to the signals of @p events, any of "message",
+         * "join", "part", "quit" and "highlight". Subscriptions end when the
+         * caller leaves the bus.
+         *
+         * @return the events the caller is subscribed to
+         */
+        QStringList subscribe(const QStringList& events);
+        QStringList unsubscribe(const QStringList& events);
+
+        /// The per-stage timings and queue depths as JSON, see PipelineStats.
+        QString pipelineStatistics();
+        void setPipelineStatisticsEnabled(bool enabled);
+        void resetPipelineStatistics();
+
     private Q_SLOTS:
         void changeAwayStatus(bool away);
+        void removeSubscriber(const QString& service);
+
+    private:
+        /// Sets the events @p service is subscribed to and returns them.
+        Events updateSubscription(const QString& service, Events events);
+
+    private:
+        QHash<QString, Events> m_subscribers;
+        Events m_subscribedEvents;
+        QDBusServiceWatcher* m_subscriberWatcher;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DBus::Events)
+
 class IdentDBus : public QObject
 {
     Q_OBJECT
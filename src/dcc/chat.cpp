@@ -85,6 +85,8 @@ namespace Konversation
                 m_dccSocket->close();
                 m_dccSocket = nullptr;
             }
+
+            m_lineBuffer.clear();
         }
 
         void Chat::start()
@@ -491,28 +493,16 @@ namespace Konversation
 
         void Chat::readData()
         {
-            char *buffer = nullptr;
-            QString line;
-            qint64 available = m_dccSocket->bytesAvailable();
-            if (available < 0)
+            if (m_lineBuffer.readFrom(m_dccSocket) < 0)
             {
                 failed(m_dccSocket->errorString());
                 return;
             }
 
-            while (available > 1 && m_dccSocket->canReadLine())
+            QByteArrayView line;
+            while (m_lineBuffer.nextLine(line))
             {
-                buffer = new char[available + 1];
-                qint64 actual = m_dccSocket->readLine(buffer, available);
-                buffer[actual] = 0;
-                line = m_codec->toUnicode(buffer);
-                delete[] buffer;
-
-                const QStringList &lines = line.split(QLatin1Char('\n'), Qt::SkipEmptyParts);
-                for (const QString &lin : lines) {
-                    Q_EMIT receivedRawLine(lin);
-                }
-                available = m_dccSocket->bytesAvailable();
+                Q_EMIT receivedRawLine(m_codec->toUnicode(line.data(), static_cast<int>(line.size())));
             }
         }
 
@@ -9,6 +9,8 @@
 #ifndef CHAT_H
 #define CHAT_H
 
+#include "linebuffer.h"
+
 #include <QAbstractSocket>
 
 class QTextCodec;
@@ -147,6 +149,8 @@ namespace Konversation
                 QTcpSocket *m_dccSocket;
                 QTcpServer *m_dccServer;
 
+                LineBuffer m_lineBuffer;
+
                 QString m_encoding;
 
                 Status m_chatStatus;
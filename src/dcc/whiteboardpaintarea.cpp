@@ -8,8 +8,10 @@
 
 #include "konversation_log.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include <QImage>
 #include <QPainter>
 #include <QPixmap>
 #include <QResizeEvent>
@@ -20,6 +22,7 @@ namespace Konversation
     namespace DCC
     {
         static const int InvalidLastPos = -32546;
+        static const int ArrowLength = 9;
 
         WhiteBoardPaintArea::WhiteBoardPaintArea(QWidget* parent)
             : QWidget(parent),
@@ -30,8 +33,8 @@ namespace Konversation
               m_backgroundColor(Qt::white),
               m_penWidth(1)
         {
-            m_imagePixmap = new QPixmap(width(), height());
-            m_imagePixmap->fill(Qt::white);
+            m_image = QImage(width(), height(), QImage::Format_RGB32);
+            m_image.fill(Qt::white);
             m_overlayPixmap = new QPixmap(width(), height());
             m_overlayPixmap->fill(Qt::transparent);
 
@@ -43,7 +46,6 @@ namespace Konversation
 
         WhiteBoardPaintArea::~WhiteBoardPaintArea()
         {
-            delete m_imagePixmap;
             delete m_overlayPixmap;
         }
 
@@ -111,7 +113,7 @@ namespace Konversation
 
         void WhiteBoardPaintArea::clear()
         {
-            m_imagePixmap->fill(Qt::white);
+            m_image.fill(Qt::white);
             m_overlayPixmap->fill(Qt::transparent);
             m_mousePressed = false;
             makeLastPosInvalid();
@@ -122,7 +124,7 @@ namespace Konversation
                                            int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::Line));
             tPaint.setBrush(brushColor);
 
@@ -138,108 +140,104 @@ namespace Konversation
                 tPaint.drawLine(xFrom, yFrom, xTo, yTo);
             }
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::drawRectangle(int lineWidth, const QColor& penColor,
                                                 int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::Rectangle));
             tPaint.drawRect(xFrom, yFrom, xTo-xFrom, yTo-yFrom);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::drawFilledRectangle(int lineWidth, const QColor& penColor, const QColor& brushColor,
                                                       int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::FilledRectangle));
             tPaint.setBrush(brushColor);
             drawRect(&tPaint, xFrom, yFrom, xTo, yTo);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::drawEllipse(int lineWidth, const QColor& penColor,
                                               int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::Ellipse));
             tPaint.drawEllipse(xFrom, yFrom, xTo-xFrom, yTo-yFrom);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::drawFilledEllipse(int lineWidth, const QColor& penColor, const QColor& brushColor,
                                                     int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::FilledEllipse));
             tPaint.setBrush(brushColor);
             tPaint.drawEllipse(xFrom, yFrom, xTo-xFrom, yTo-yFrom);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::drawArrow(int lineWidth, const QColor& penColor, int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(penColor, lineWidth, WhiteBoardGlobals::Arrow));
             arrow(&tPaint, xFrom, yFrom, xTo, yTo);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth + 2*ArrowLength));
         }
 
         void WhiteBoardPaintArea::useEraser(int lineWidth, int xFrom, int yFrom, int xTo, int yTo)
         {
             checkImageSize(xFrom, yFrom, xTo, yTo, lineWidth);
-            QPainter tPaint(m_imagePixmap);
+            QPainter tPaint(&m_image);
             tPaint.setPen(getPen(Qt::white, lineWidth, WhiteBoardGlobals::Eraser));
             tPaint.drawLine(xFrom, yFrom, xTo, yTo);
             tPaint.end();
-            update();
+            update(damageRect(xFrom, yFrom, xTo, yTo, lineWidth));
         }
 
         void WhiteBoardPaintArea::useFloodFill (int x, int y, const QColor& color)
         {
             checkImageSize(x, y, 0, 0, 1);
-            floodfill(x, y, color);
-            update();
+            update(floodfill(x, y, color));
         }
 
         void WhiteBoardPaintArea::useBlt(int x1src, int y1src, int x2src, int y2src, int xdest, int ydest)
         {
-            //TODO optimize me
             checkImageSize(x2src, y2src, xdest, ydest, 1);
-            QPixmap copyPix(m_imagePixmap->copy(x1src, y1src, x2src-x1src, y2src-y1src));
-            QPainter tPaint(m_imagePixmap);
-            tPaint.drawPixmap(xdest, ydest, copyPix);
+            const QImage copyImage(m_image.copy(x1src, y1src, x2src-x1src, y2src-y1src));
+            QPainter tPaint(&m_image);
+            tPaint.drawImage(xdest, ydest, copyImage);
             tPaint.end();
-            update();
+            update(QRect(QPoint(xdest, ydest), copyImage.size()));
         }
 
         void WhiteBoardPaintArea::useText(int x1, int y1, const QString& textString)
         {
-            text(m_imagePixmap, QFont(), Qt::black, Qt::white, x1, y1, textString, false, WhiteBoardGlobals::Text);
-            update();
+            update(text(&m_image, QFont(), Qt::black, Qt::white, x1, y1, textString, false, WhiteBoardGlobals::Text));
         }
 
         void WhiteBoardPaintArea::useTextExtended(int x1, int y1, const QFont& font, const QColor& foreGround, const QColor& backGround, const QString& textString)
         {
-            text(m_imagePixmap, font, foreGround, backGround, x1, y1, textString, false, WhiteBoardGlobals::TextExtended);
-            update();
+            update(text(&m_image, font, foreGround, backGround, x1, y1, textString, false, WhiteBoardGlobals::TextExtended));
         }
 
         void WhiteBoardPaintArea::save(const QString& fileName)
         {
-            m_imagePixmap->save(fileName);
+            m_image.save(fileName);
         }
 
         void WhiteBoardPaintArea::paintEvent(QPaintEvent *event)
@@ -250,7 +248,7 @@ namespace Konversation
 
             const auto region = event->region();
             for (const QRect& rect : region) {
-                tPaint.drawPixmap(rect, *m_imagePixmap, rect);
+                tPaint.drawImage(rect, m_image, rect);
 
                 tPaint.drawPixmap(rect, *m_overlayPixmap, rect);
             }
@@ -285,10 +283,10 @@ namespace Konversation
                     makeLastPosInvalid();
                     QCursor oldCur = cursor();
                     setCursor(Qt::WaitCursor);
-                    floodfill(event->pos().x(), event->pos().y(), m_foregroundColor);
+                    const QRect damaged = floodfill(event->pos().x(), event->pos().y(), m_foregroundColor);
                     setCursor(oldCur);
                     Q_EMIT usedFloodFill(event->pos().x(), event->pos().y(), m_foregroundColor);
-                    update();
+                    update(damaged);
                 }
                 else if (m_tool == WhiteBoardGlobals::TextExtended || m_tool == WhiteBoardGlobals::Text)
                 {
@@ -366,7 +364,7 @@ namespace Konversation
                     return;
                 }
 
-                QPainter tPainter(m_imagePixmap);
+                QPainter tPainter(&m_image);
                 tPainter.drawPixmap(0,0, *m_overlayPixmap);
                 tPainter.end();
                 m_overlayPixmap->fill(Qt::transparent);
@@ -513,8 +511,11 @@ namespace Konversation
 
                 case WhiteBoardGlobals::ColorPicker:
                     {
-                        QImage image = m_imagePixmap->toImage();
-                        QColor fgColor(image.pixel(event->pos().x(), event->pos().y()));
+                        if (!m_image.valid(event->pos()))
+                        {
+                            break;
+                        }
+                        QColor fgColor(m_image.pixel(event->pos()));
                         m_foregroundColor = fgColor;
                         Q_EMIT colorPicked(fgColor);
                     }
@@ -600,15 +601,14 @@ namespace Konversation
 
         void WhiteBoardPaintArea::resizeImage(int width, int height)
         {
-            if (m_imagePixmap->height() < height || m_imagePixmap->width() < width)
+            if (m_image.height() < height || m_image.width() < width)
             {
-                QPixmap* oldImg = m_imagePixmap;
-                m_imagePixmap = new QPixmap(width, height);
-                m_imagePixmap->fill(Qt::white);
-                QPainter tPaint(m_imagePixmap);
-                tPaint.drawPixmap(0, 0, *oldImg);
+                QImage newImage(width, height, QImage::Format_RGB32);
+                newImage.fill(Qt::white);
+                QPainter tPaint(&newImage);
+                tPaint.drawImage(0, 0, m_image);
                 tPaint.end();
-                delete oldImg;
+                m_image = newImage;
 
                 QPixmap* oldOverlay = m_overlayPixmap;
                 m_overlayPixmap = new QPixmap(width, height);
@@ -639,78 +639,98 @@ namespace Konversation
             }
         }
 
-        struct StackCoords
+        QRect WhiteBoardPaintArea::damageRect(int xFrom, int yFrom, int xTo, int yTo, int penWidth)
         {
-            int x;
-            int y;
-        };
+            // strokes are centered on the path and caps reach past the end points
+            const int margin = penWidth / 2 + 2;
+            return QRect(QPoint(xFrom, yFrom), QPoint(xTo, yTo)).normalized().adjusted(-margin, -margin, margin, margin);
+        }
 
-        void WhiteBoardPaintArea::floodfill(int x, int y, const QColor& fillColor)
+        QRect WhiteBoardPaintArea::floodfill(int x, int y, const QColor& fillColor)
         {
-            // A recursiv "fast" floodfill *can* cause a stackoverflow
-            // so we use a "slow" stack + extra data.
-            // TODO optimize me, mass QImage::pixel use is slow
-            QImage image = m_imagePixmap->toImage();
-            const int width = image.width();
-            const int height = image.height();
+            // Span based scanline fill working directly on the image rows.
+            // Each seed fills the whole horizontal run of matching pixels
+            // around it, only the start of every matching run in the rows
+            // above and below is pushed as a new seed.
+            const int width = m_image.width();
+            const int height = m_image.height();
             if (x < 0 || y < 0 || x >= width || y >= height)
             {
-                return;
+                return QRect();
             }
-            QRgb originalColor = image.pixel(x,y);
-            QRgb color = fillColor.rgb();
+
+            const QRgb originalColor = reinterpret_cast<const QRgb*>(m_image.constScanLine(y))[x];
+            const QRgb color = fillColor.rgb();
 
             if (color == originalColor)
             {
                 //already filled
-                return;
+                return QRect();
             }
 
-            QStack<StackCoords> tStack;
-            StackCoords t;
-            t.x = x;
-            t.y = y;
+            int minX = x;
+            int maxX = x;
+            int minY = y;
+            int maxY = y;
 
-            tStack.push(t);
+            QStack<QPoint> tStack;
+            tStack.push(QPoint(x, y));
             while (!tStack.isEmpty())
             {
-                StackCoords co = tStack.pop();
-                image.setPixel(co.x, co.y, color);
-
-                StackCoords tLeft;
-                tLeft.x = co.x-1;
-                tLeft.y = co.y;
-                if (tLeft.x >= 0 && image.pixel(tLeft.x, tLeft.y) == originalColor)
+                const QPoint seed = tStack.pop();
+                QRgb* line = reinterpret_cast<QRgb*>(m_image.scanLine(seed.y()));
+                if (line[seed.x()] != originalColor)
                 {
-                    tStack.push(tLeft);
+                    // already covered by an earlier span
+                    continue;
                 }
 
-                StackCoords tRight;
-                tRight.x = co.x+1;
-                tRight.y = co.y;
-                if (tRight.x < width && image.pixel(tRight.x, tRight.y) == originalColor)
+                int left = seed.x();
+                while (left > 0 && line[left-1] == originalColor)
                 {
-                    tStack.push(tRight);
+                    --left;
                 }
-
-                StackCoords tUp;
-                tUp.x = co.x;
-                tUp.y = co.y-1;
-                if (tUp.y >= 0 && image.pixel(tUp.x, tUp.y) == originalColor)
+                int right = seed.x();
+                while (right < width-1 && line[right+1] == originalColor)
                 {
-                    tStack.push(tUp);
+                    ++right;
                 }
 
-                StackCoords tDown;
-                tDown.x = co.x;
-                tDown.y = co.y+1;
-                if (tDown.y < height && image.pixel(tDown.x, tDown.y) == originalColor)
+                std::fill(line + left, line + right + 1, color);
+
+                minX = qMin(minX, left);
+                maxX = qMax(maxX, right);
+                minY = qMin(minY, seed.y());
+                maxY = qMax(maxY, seed.y());
+
+                for (const int neighbourY : { seed.y() - 1, seed.y() + 1 })
                 {
-                    tStack.push(tDown);
+                    if (neighbourY < 0 || neighbourY >= height)
+                    {
+                        continue;
+                    }
+
+                    const QRgb* neighbourLine = reinterpret_cast<const QRgb*>(m_image.constScanLine(neighbourY));
+                    bool inSpan = false;
+                    for (int i = left; i <= right; ++i)
+                    {
+                        if (neighbourLine[i] == originalColor)
+                        {
+                            if (!inSpan)
+                            {
+                                tStack.push(QPoint(i, neighbourY));
+                                inSpan = true;
+                            }
+                        }
+                        else
+                        {
+                            inSpan = false;
+                        }
+                    }
                 }
             }
-            delete m_imagePixmap;
-            m_imagePixmap = new QPixmap(QPixmap::fromImage(image));
+
+            return QRect(QPoint(minX, minY), QPoint(maxX, maxY));
         }
 
         void WhiteBoardPaintArea::arrow(QPainter* painter, int x1, int y1, int x2, int y2)
@@ -758,24 +778,22 @@ namespace Konversation
                 }
             }
 
-            static const int arrowLength = 9;
-
             angle -= M_PI;
             static const qreal radDiff = qreal(2)* M_PI / qreal(360) * 22;
             qreal tRightAngle = angle + radDiff;
-            const int x1Arrow = static_cast<int>(sin(tRightAngle) * arrowLength + x2);
-            const int y1Arrow = static_cast<int>(cos(tRightAngle) * arrowLength + y2);
+            const int x1Arrow = static_cast<int>(sin(tRightAngle) * ArrowLength + x2);
+            const int y1Arrow = static_cast<int>(cos(tRightAngle) * ArrowLength + y2);
 
             qreal tLeftAngle = angle - radDiff;
-            const int x2Arrow = static_cast<int>(sin(tLeftAngle) * arrowLength + x2);
-            const int y2Arrow = static_cast<int>(cos(tLeftAngle) * arrowLength + y2);
+            const int x2Arrow = static_cast<int>(sin(tLeftAngle) * ArrowLength + x2);
+            const int y2Arrow = static_cast<int>(cos(tLeftAngle) * ArrowLength + y2);
 
             painter->drawLine(x1, y1, x2, y2);
             painter->drawLine(x1Arrow, y1Arrow, x2, y2);
             painter->drawLine(x2Arrow, y2Arrow, x2, y2);
         }
 
-        void WhiteBoardPaintArea::text(QPaintDevice* device, const QFont& font, const QColor& foreGround,
+        QRect WhiteBoardPaintArea::text(QPaintDevice* device, const QFont& font, const QColor& foreGround,
                                        const QColor& backGround, int x1, int y1, const QString& textString,
                                        bool drawSelection, Konversation::DCC::WhiteBoardGlobals::WhiteBoardTool tool)
         {
@@ -792,7 +810,7 @@ namespace Konversation
             }
             else
             {
-                device = m_imagePixmap;
+                device = &m_image;
             }
 
             QPainter tPaint(device);
@@ -830,6 +848,9 @@ namespace Konversation
                 tPaint.drawRect(x1-1,y1-1, tSize.width()+1, tSize.height()+1);
             }
             tPaint.end();
+
+            // the text baseline sits at the bottom of tSize, descenders reach below it
+            return QRect(x1-1, y1-1, tSize.width()+2, tSize.height()+tMetrics.descent()+2);
         }
 
         void WhiteBoardPaintArea::finishText()
@@ -840,7 +861,7 @@ namespace Konversation
                 return;
             }
 
-            text(m_imagePixmap, m_font, m_foregroundColor, m_backgroundColor, m_lastPos.x(), m_lastPos.y(), m_writtenText, false, m_tool);
+            text(&m_image, m_font, m_foregroundColor, m_backgroundColor, m_lastPos.x(), m_lastPos.y(), m_writtenText, false, m_tool);
             if (m_tool == WhiteBoardGlobals::TextExtended)
             {
                 Q_EMIT usedTextExtended(m_lastPos.x(), m_lastPos.y(), m_font, m_foregroundColor, m_backgroundColor, m_writtenText);
@@ -10,6 +10,7 @@
 #include <QWidget>
 #include <QPoint>
 #include <QColor>
+#include <QImage>
 #include <QPen>
 
 #include "whiteboardglobals.h"
@@ -100,11 +101,13 @@ namespace Konversation
 
             inline QPen getPen(const QColor& color, int lineWidth, WhiteBoardGlobals::WhiteBoardTool tool);
 
-            inline void floodfill(int x, int y, const QColor& fillColor);
+            inline QRect damageRect(int xFrom, int yFrom, int xTo, int yTo, int penWidth);
+
+            inline QRect floodfill(int x, int y, const QColor& fillColor);
 
             inline void arrow(QPainter* painter, int x1, int y1, int x2, int y2);
 
-            inline void text(QPaintDevice* device, const QFont& font, const QColor& foreGround,
+            inline QRect text(QPaintDevice* device, const QFont& font, const QColor& foreGround,
                              const QColor& backGround, int x1, int y1, const QString& textString, bool drawSelection = true,
                              Konversation::DCC::WhiteBoardGlobals::WhiteBoardTool tool = WhiteBoardGlobals::Text);
             inline void finishText();
@@ -112,7 +115,7 @@ namespace Konversation
             inline void drawRect(QPainter* painter, int xFrom, int yFrom, int xTo, int yTo);
 
         private:
-            QPixmap* m_imagePixmap;
+            QImage m_image;
             QPixmap* m_overlayPixmap;
 
             bool m_mousePressed;
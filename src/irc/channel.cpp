@@ -21,6 +21,7 @@
 #include "topiclabel.h"
 #include "topichistorymodel.h"
 #include "notificationhandler.h"
+#include "pipelinestats.h"
 #include "viewcontainer.h"
 #include "konversation_log.h"
 #include "konversation_state.h"
@@ -443,6 +444,7 @@ void Channel::purgeNicks()
     qDeleteAll(nicknameList);
     nicknameList.clear();
     m_nicknameNickHash.clear();
+    m_nickCompletionIndex.clear();
 
     // Execute this otherwise it may crash trying to access
     // deleted nicks
@@ -554,9 +556,12 @@ void Channel::completeNick()
                 Preferences::self()->nickCompletionMode() == 2)
             { // Shell like completion
                 QStringList found;
-                foundNick = nicknameList.completeNick(pattern, complete, found,
-                                                      (Preferences::self()->nickCompletionMode() == 2),
-                                                      Preferences::self()->nickCompletionCaseSensitive());
+                NickList matches;
+                matches.append(m_nickCompletionIndex.nicksStartingWith(pattern,
+                                                                      (Preferences::self()->nickCompletionMode() == 2),
+                                                                      Preferences::self()->nickCompletionCaseSensitive()));
+                foundNick = matches.completeNick(pattern, complete, found,
+                                                 Preferences::self()->nickCompletionCaseSensitive());
 
                 if(!complete && !found.isEmpty())
                 {
@@ -926,6 +931,8 @@ void Channel::quickButtonClicked(const QString &buttonText)
 
 void Channel::addNickname(ChannelNickPtr channelnick)
 {
+    PipelineTimer timer(PipelineStats::NickModel);
+
     QString nickname = channelnick->loweredNickname();
 
     Nick* nick=nullptr;
@@ -1002,6 +1009,7 @@ void Channel::fastAddNickname(ChannelNickPtr channelnick, Nick *nick)
     }
 
     m_nicknameNickHash.insert (channelnick->loweredNickname(), nick);
+    m_nickCompletionIndex.insert(nick, channelnick->getNickname());
 }
 
 /* Determines whether Nick/Part/Join event should be shown or skipped based on user settings. */
@@ -1066,6 +1074,7 @@ void Channel::nickRenamed(const QString &oldNick, const NickInfo& nickInfo, cons
     {
         m_nicknameNickHash.remove(oldNick.toLower());
         m_nicknameNickHash.insert(newNick.toLower(), nick);
+        m_nickCompletionIndex.insert(nick, newNick);
 
         repositionNick(nick);
     }
@@ -1188,6 +1197,7 @@ void Channel::removeNick(ChannelNickPtr channelNick, const QString &reason, bool
         {
             nicknameList.removeOne(nick);
             m_nicknameNickHash.remove(channelNick->loweredNickname());
+            m_nickCompletionIndex.remove(nick);
             delete nick;
             // Execute this otherwise it may crash trying to access deleted nick
             nicknameListView->executeDelayedItemsLayout();
@@ -1288,6 +1298,7 @@ void Channel::kickNick(ChannelNickPtr channelNick, const QString &kicker, const
         {
             nicknameList.removeOne(nick);
             m_nicknameNickHash.remove(channelNick->loweredNickname());
+            m_nickCompletionIndex.remove(nick);
             delete nick;
         }
     }
@@ -2018,8 +2029,10 @@ void Channel::indicateAway(bool show)
     }
 }
 
-void Channel::showEvent(QShowEvent*)
+void Channel::showEvent(QShowEvent* event)
 {
+    ChatWindow::showEvent(event);
+
     // If the show quick/mode button settings have changed, apply the changes now
     if(quickButtonsChanged)
     {
@@ -2453,6 +2466,8 @@ void Channel::showTopic(bool show)
 
 void Channel::processQueuedNicks(bool flush)
 {
+    PipelineTimer timer(PipelineStats::NickModel);
+
 // This pops nicks from the front of a queue added to by incoming NAMES
 // messages and adds them to the channel nicklist, calling itself via
 // the event loop until the last invocation finds the queue empty and
@@ -2796,67 +2811,38 @@ NickList::NickList() : QList<Nick*>()
 {
 }
 
-QString NickList::completeNick(const QString& pattern, bool& complete, QStringList& found,
-                   bool skipNonAlfaNum, bool caseSensitive) const
+QString NickList::completeNick(const QString& pattern, bool& complete, QStringList& found, bool caseSensitive) const
 {
     found.clear();
-    QString prefix(QLatin1Char('^'));
-    QString newNick;
-    QString prefixCharacter = Preferences::self()->prefixCharacter();
-    NickList foundNicks;
-
-    if(pattern.contains(QRegularExpression(QStringLiteral("^(\\d|\\w)"))) && skipNonAlfaNum)
-    {
-        prefix = QStringLiteral("^([^\\d\\w]|[\\_]){0,}");
-    }
-
-    const QRegularExpression regexp(
-        prefix + QRegularExpression::escape(pattern),
-        caseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
-
-    for (Nick* nick : *this) {
-        newNick = nick->getChannelNick()->getNickname();
-
-        if(!prefix.isEmpty() && newNick.contains(prefixCharacter))
-        {
-            newNick = newNick.section( prefixCharacter,1 );
-        }
-
-        if(newNick.contains(regexp))
-        {
-            foundNicks.append(nick);
-        }
-    }
 
+    NickList foundNicks(*this);
     std::sort(foundNicks.begin(), foundNicks.end(), nickTimestampLessThan);
 
-    found.reserve(found.size() + foundNicks.size());
+    found.reserve(foundNicks.size());
     for (Nick *nick : std::as_const(foundNicks)) {
         found.append(nick->getChannelNick()->getNickname());
     }
 
     if(found.count() > 1)
     {
-        bool ok = true;
-        int patternLength = pattern.length();
-        QString firstNick = found[0];
-        int firstNickLength = firstNick.length();
-        int foundCount = found.count();
+        const Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        const QString& firstNick = found[0];
+        qsizetype prefixLength = firstNick.length();
 
-        while(ok && ((patternLength) < firstNickLength))
+        // narrow down to the prefix all found nicks share
+        for (const QString& nick : std::as_const(found))
         {
-            ++patternLength;
-            QStringList tmp = found.filter(firstNick.left(patternLength), caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+            qsizetype length = 0;
 
-            if(tmp.count() != foundCount)
-            {
-                ok = false;
-                --patternLength;
-            }
+            while (length < prefixLength && length < nick.length()
+                   && QStringView(firstNick).mid(length, 1).compare(QStringView(nick).mid(length, 1), cs) == 0)
+                ++length;
+
+            prefixLength = length;
         }
 
         complete = false;
-        return firstNick.left(patternLength);
+        return firstNick.left(qMax(pattern.length(), prefixLength));
     }
     else if(found.count() == 1)
     {
@@ -14,6 +14,7 @@
 #include "server.h"
 #include "chatwindow.h"
 #include "channelnick.h"
+#include "nickcompletionindex.h"
 
 #if HAVE_QCA2
 #include "cipher.h"
@@ -52,8 +53,8 @@ class NickList : public QList<Nick*>
     public:
         NickList();
 
-        QString completeNick(const QString& pattern, bool& complete, QStringList& found,
-                             bool skipNonAlfaNum, bool caseSensitive) const;
+        /// Completes @p pattern from the nicks in this list, which all start with it.
+        QString completeNick(const QString& pattern, bool& complete, QStringList& found, bool caseSensitive) const;
 
         bool containsNick(const QString& nickname) const;
 
@@ -319,6 +320,7 @@ class Channel : public ChatWindow
 //Members from here to end are not GUI
         bool m_joined;
         NickList nicknameList;
+        NickCompletionIndex m_nickCompletionIndex;
         QTimer userhostTimer;
         int m_nicknameListViewTextChanged;
         QHash<QString, Nick*> m_nicknameNickHash;
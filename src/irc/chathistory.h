@@ -0,0 +1,26 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef CHATHISTORY_H
+#define CHATHISTORY_H
+
+#include <QDateTime>
+#include <QString>
+
+namespace Konversation
+{
+    /// A message of an IRCv3 CHATHISTORY batch.
+    struct HistoryLine
+    {
+        QDateTime time;     ///< server-time, UTC
+        QString msgid;      ///< empty without the message-tags capability
+        QString nick;
+        QString message;
+        bool action = false;
+    };
+}
+
+#endif
@@ -0,0 +1,387 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "connectionracer.h"
+
+#include "konversation_log.h"
+
+#include <KLocalizedString>
+
+#include <QSslSocket>
+
+namespace Konversation
+{
+    /// A racing socket, and what it is racing for.
+    class RaceSocket : public QSslSocket
+    {
+        public:
+            RaceSocket(int target, const QString& serverHost)
+                : m_target(target)
+                , m_serverHost(serverHost)
+            {
+                m_timeout.setSingleShot(true);
+            }
+
+            int target() const { return m_target; }
+            QString serverHost() const { return m_serverHost; }
+            QTimer& timeout() { return m_timeout; }
+
+            using QAbstractSocket::setPeerName;
+            using QAbstractSocket::setSocketError;
+            using QIODevice::setErrorString;
+
+        private:
+            int m_target;
+            QString m_serverHost;
+            QTimer m_timeout;
+    };
+
+    static void dropSocket(QSslSocket* socket)
+    {
+        socket->blockSignals(true);
+        socket->abort();
+        socket->deleteLater();
+    }
+
+    ConnectionRacer::ConnectionRacer(const SocketSetup& socketSetup, QObject* parent)
+        : QObject(parent)
+        , m_socketSetup(socketSetup)
+        , m_lastFailed(nullptr)
+        , m_nextTarget(0)
+        , m_forceEncryption(false)
+        , m_running(false)
+        , m_hostFound(false)
+        , m_triedByName(false)
+    {
+        m_attemptTimer.setSingleShot(true);
+        m_attemptTimer.setInterval(AttemptDelay);
+        connect(&m_attemptTimer, &QTimer::timeout, this, &ConnectionRacer::startNextAttempt);
+
+        m_preferredTimer.setSingleShot(true);
+        m_preferredTimer.setInterval(AttemptDelay);
+        connect(&m_preferredTimer, &QTimer::timeout, this, &ConnectionRacer::startNextAttempt);
+    }
+
+    ConnectionRacer::~ConnectionRacer()
+    {
+        abort();
+    }
+
+    void ConnectionRacer::start(const ServerList& servers, bool forceEncryption, bool resolve)
+    {
+        abort();
+
+        if (servers.isEmpty())
+            return;
+
+        m_forceEncryption = forceEncryption;
+        m_running = true;
+        m_hostFound = false;
+        m_triedByName = false;
+        m_nextTarget = 0;
+
+        for (const ServerSettings& server : servers.mid(0, resolve ? MaxServers : 1))
+        {
+            Target target;
+            target.server = server;
+            m_targets.append(target);
+        }
+
+        if (!resolve)
+        {
+            m_targets.first().resolved = true;
+            m_targets.first().hosts << m_targets.first().server.host();
+            m_triedByName = true;
+
+            startNextAttempt();
+
+            return;
+        }
+
+        m_preferredTimer.start();
+
+        // resolve all of them at once, the lookups may finish in any order
+        for (Target& target : m_targets)
+            target.lookupId = QHostInfo::lookupHost(target.server.host(), this, &ConnectionRacer::lookupFinished);
+    }
+
+    void ConnectionRacer::abort()
+    {
+        m_attemptTimer.stop();
+        m_preferredTimer.stop();
+
+        for (const Target& target : std::as_const(m_targets))
+        {
+            if (!target.resolved)
+                QHostInfo::abortHostLookup(target.lookupId);
+        }
+
+        for (QSslSocket* socket : std::as_const(m_attempts))
+            dropSocket(socket);
+
+        if (m_lastFailed)
+            dropSocket(m_lastFailed);
+
+        m_targets.clear();
+        m_attempts.clear();
+        m_lastFailed = nullptr;
+        m_running = false;
+    }
+
+    QList<QHostAddress> ConnectionRacer::interleaveFamilies(const QList<QHostAddress>& addresses)
+    {
+        if (addresses.isEmpty())
+            return addresses;
+
+        const QAbstractSocket::NetworkLayerProtocol firstFamily = addresses.first().protocol();
+        QList<QHostAddress> first;
+        QList<QHostAddress> second;
+
+        for (const QHostAddress& address : addresses)
+            (address.protocol() == firstFamily ? first : second).append(address);
+
+        QList<QHostAddress> interleaved;
+        interleaved.reserve(addresses.size());
+
+        for (int i = 0; i < first.size() || i < second.size(); ++i)
+        {
+            if (i < first.size())
+                interleaved.append(first.at(i));
+            if (i < second.size())
+                interleaved.append(second.at(i));
+        }
+
+        return interleaved;
+    }
+
+    void ConnectionRacer::lookupFinished(const QHostInfo& hostInfo)
+    {
+        for (int i = 0; i < m_targets.size(); ++i)
+        {
+            Target& target = m_targets[i];
+
+            if (target.lookupId != hostInfo.lookupId())
+                continue;
+
+            target.resolved = true;
+
+            // the system orders the addresses by preference already
+            const QList<QHostAddress> addresses = interleaveFamilies(hostInfo.addresses());
+
+            for (const QHostAddress& address : addresses)
+                target.hosts << address.toString();
+
+            qCDebug(KONVERSATION_LOG) << "Resolved" << target.server.host() << "to" << target.hosts;
+
+            if (!m_hostFound && !target.hosts.isEmpty())
+            {
+                m_hostFound = true;
+                Q_EMIT hostFound();
+            }
+
+            break;
+        }
+
+        startNextAttempt();
+    }
+
+    bool ConnectionRacer::takeCandidate(int& target, QString& host)
+    {
+        // the preferred server gets a head start while it resolves
+        if (!m_targets.first().resolved && m_preferredTimer.isActive())
+            return false;
+
+        // One address of each server in turn, so that a server with many
+        // dead addresses does not take up all of the attempts.
+        for (int n = 0; n < m_targets.size(); ++n)
+        {
+            const int i = (m_nextTarget + n) % m_targets.size();
+
+            if (!m_targets.at(i).resolved || m_targets.at(i).hosts.isEmpty())
+                continue;
+
+            target = i;
+            host = m_targets[i].hosts.takeFirst();
+            m_nextTarget = (i + 1) % m_targets.size();
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ConnectionRacer::isExhausted() const
+    {
+        for (const Target& target : m_targets)
+        {
+            if (!target.resolved || !target.hosts.isEmpty())
+                return false;
+        }
+
+        return true;
+    }
+
+    void ConnectionRacer::startNextAttempt()
+    {
+        if (!m_running || m_attemptTimer.isActive() || m_attempts.size() >= MaxAttempts)
+            return;
+
+        int target = 0;
+        QString host;
+
+        if (takeCandidate(target, host))
+        {
+            startAttempt(target, host);
+
+            // another one if this one is slow
+            m_attemptTimer.start();
+
+            return;
+        }
+
+        if (!m_attempts.isEmpty() || !isExhausted())
+            return;
+
+        if (!m_lastFailed && !m_triedByName)
+        {
+            // nothing resolved; have a socket report why
+            m_triedByName = true;
+            startAttempt(0, m_targets.first().server.host());
+
+            return;
+        }
+
+        QSslSocket* socket = m_lastFailed;
+        m_lastFailed = nullptr;
+        m_targets.clear();
+        m_running = false;
+
+        socket->disconnect(this);
+        socket->blockSignals(false);
+        Q_EMIT failed(socket);
+    }
+
+    void ConnectionRacer::startAttempt(int target, const QString& host)
+    {
+        const ServerSettings server = m_targets.at(target).server;
+        const bool encrypted = m_forceEncryption || server.SSLEnabled();
+
+        auto* socket = new RaceSocket(target, server.host());
+        m_socketSetup(socket, server);
+        m_attempts.append(socket);
+
+        // a dead address would hold its slot until the system gives up on it
+        connect(&socket->timeout(), &QTimer::timeout, this, [this, socket]() { attemptTimedOut(socket); });
+        socket->timeout().start(ConnectTimeout);
+
+        qCDebug(KONVERSATION_LOG) << "Connecting to" << server.host() << "at" << host << "port" << server.port();
+
+        connect(socket, &QAbstractSocket::errorOccurred, this, [this, socket]() { attemptFailed(socket); });
+        connect(socket, &QAbstractSocket::hostFound, this, [this]() {
+            if (!m_hostFound)
+            {
+                m_hostFound = true;
+                Q_EMIT hostFound();
+            }
+        });
+
+        if (encrypted)
+        {
+            connect(socket, &QAbstractSocket::connected, this, [socket]() {
+                // the TLS handshake is yet to start; use the host name rather than the
+                // address, e.g. for the SSL error dialog to remember its decisions by
+                socket->setPeerName(socket->serverHost());
+            });
+            connect(socket, &QSslSocket::encrypted, this, [this, socket]() {
+                const ServerSettings server = release(socket);
+                Q_EMIT connected(socket, server);
+            });
+            connect(socket, QOverload<const QList<QSslError>&>::of(&QSslSocket::sslErrors),
+                    this, [this, socket](const QList<QSslError>& errors) {
+                const ServerSettings server = release(socket);
+                Q_EMIT sslErrors(socket, server, errors);
+            });
+
+            // verify the certificate against the host name, not the address;
+            // QIODevice::Unbuffered, see the connectToHost() call below
+            socket->connectToHostEncrypted(host, server.port(), server.host(),
+                                           (QIODevice::ReadWrite | QIODevice::Unbuffered));
+        }
+        else
+        {
+            connect(socket, &QAbstractSocket::connected, this, [this, socket]() {
+                const ServerSettings server = release(socket);
+                Q_EMIT connected(socket, server);
+            });
+
+            // TODO re-evaluate this, perhaps with a test case
+            // The comment below was added here in October of 2019, but it is a copy of
+            // a kdelibs commit from September 2008, describing Qt4 behavior.
+            // See https://invent.kde.org/unmaintained/kdelibs/-/commit/34a9fb1ca1a9e5442502f5baedffc8880ed8aa21
+            //
+            // From KTcpSocket::connectToHost():
+            // There are enough layers of buffers between us and the network, and there is a quirk
+            // in QIODevice that can make it try to readData() twice per read() call if buffered and
+            // reaData() does not deliver enough data the first time. Like when the other side is
+            // simply not sending any more data...
+            // This can *apparently* lead to long delays sometimes which stalls applications.
+            // Do not want.
+            socket->connectToHost(host, server.port(), (QIODevice::ReadWrite | QIODevice::Unbuffered));
+        }
+    }
+
+    void ConnectionRacer::attemptFailed(QSslSocket* socket)
+    {
+        if (!m_attempts.removeOne(socket))
+            return;
+
+        static_cast<RaceSocket*>(socket)->timeout().stop();
+
+        qCDebug(KONVERSATION_LOG) << "Connecting to" << socket->peerName() << "failed:" << socket->errorString();
+
+        if (m_lastFailed)
+            dropSocket(m_lastFailed);
+
+        socket->blockSignals(true);
+        m_lastFailed = socket;
+
+        // no need to wait for the head start of the failed one to be over
+        m_attemptTimer.stop();
+        startNextAttempt();
+    }
+
+    void ConnectionRacer::attemptTimedOut(QSslSocket* socket)
+    {
+        if (!m_attempts.contains(socket))
+            return;
+
+        auto* raceSocket = static_cast<RaceSocket*>(socket);
+
+        raceSocket->blockSignals(true);
+        raceSocket->abort();
+        raceSocket->setSocketError(QAbstractSocket::SocketTimeoutError);
+        raceSocket->setErrorString(i18n("Connection timed out"));
+
+        attemptFailed(socket);
+    }
+
+    ServerSettings ConnectionRacer::release(QSslSocket* socket)
+    {
+        auto* raceSocket = static_cast<RaceSocket*>(socket);
+        const ServerSettings server = m_targets.at(raceSocket->target()).server;
+
+        raceSocket->timeout().stop();
+        m_attempts.removeOne(socket);
+        socket->disconnect(this);
+
+        // drop the other attempts
+        abort();
+
+        return server;
+    }
+}
+
+#include "moc_connectionracer.cpp"
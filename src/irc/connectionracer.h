@@ -0,0 +1,129 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef CONNECTIONRACER_H
+#define CONNECTIONRACER_H
+
+#include "servergroupsettings.h"
+#include "serversettings.h"
+
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QList>
+#include <QObject>
+#include <QSslError>
+#include <QTimer>
+
+#include <functional>
+
+class QSslSocket;
+
+namespace Konversation
+{
+    /**
+     * Establishes the connection to a server by racing connection attempts
+     * ("Happy Eyeballs", RFC 8305).
+     *
+     * All servers to race are resolved at once. Their addresses are taken
+     * from the servers in turn, the first address of each server before the
+     * second one of any, alternating between IPv6 and IPv4 within a server.
+     * The first server is waited for up to AttemptDelay while it resolves.
+     * Each attempt gets a head start of AttemptDelay before the next one is
+     * started, or less if it fails earlier, and is given up after
+     * ConnectTimeout. The first attempt to be connected, and encrypted if
+     * asked to be, wins and the others are dropped.
+     *
+     * An attempt whose TLS handshake reports errors ends the race as well,
+     * as the decision about the errors is the user's.
+     */
+    class ConnectionRacer : public QObject
+    {
+        Q_OBJECT
+
+        public:
+            /// Attempts running at once.
+            static const int MaxAttempts = 3;
+            /// Head start of an attempt, in milliseconds.
+            static const int AttemptDelay = 250;
+            /// Servers of a server group raced against each other.
+            static const int MaxServers = 3;
+            /// Time an attempt may take before its slot goes to the next one, in milliseconds.
+            static const int ConnectTimeout = 10000;
+
+            /// Sets up a new socket for connecting to a server: proxy, client certificate and so on.
+            using SocketSetup = std::function<void(QSslSocket*, const ServerSettings&)>;
+
+            explicit ConnectionRacer(const SocketSetup& socketSetup, QObject* parent = nullptr);
+            ~ConnectionRacer() override;
+
+            /**
+             * Starts connecting to @p servers, the first one preferred. TLS is
+             * used for the servers that have it enabled, or all of them with
+             * @p forceEncryption. Without @p resolve only the first server is
+             * connected to by its host name, e.g. to leave the lookup to a
+             * proxy.
+             */
+            void start(const ServerList& servers, bool forceEncryption, bool resolve);
+            /// Drops all attempts, without any signal.
+            void abort();
+
+            bool isRunning() const { return m_running; }
+
+            /// @p addresses alternating between the families, starting with the family of the first one.
+            static QList<QHostAddress> interleaveFamilies(const QList<QHostAddress>& addresses);
+
+        Q_SIGNALS:
+            /// The first server was resolved.
+            void hostFound();
+            /// The race was won by @p socket, which is the receiver's now.
+            void connected(QSslSocket* socket, const Konversation::ServerSettings& server);
+            /**
+             * The TLS handshake of @p socket reported @p errors, which have to be
+             * ignored before returning to continue. The socket is the receiver's now.
+             */
+            void sslErrors(QSslSocket* socket, const Konversation::ServerSettings& server, const QList<QSslError>& errors);
+            /// All attempts failed; @p socket is the last one to fail and the receiver's now.
+            void failed(QSslSocket* socket);
+
+        private:
+            struct Target
+            {
+                ServerSettings server;
+                int lookupId = -1;
+                bool resolved = false;
+                /// Addresses, or the host name, not tried yet.
+                QStringList hosts;
+            };
+
+            bool takeCandidate(int& target, QString& host);
+            bool isExhausted() const;
+            void lookupFinished(const QHostInfo& hostInfo);
+            void startNextAttempt();
+            void startAttempt(int target, const QString& host);
+            void attemptFailed(QSslSocket* socket);
+            void attemptTimedOut(QSslSocket* socket);
+            /// Takes @p socket out of the race, which is over.
+            ServerSettings release(QSslSocket* socket);
+
+            SocketSetup m_socketSetup;
+            QList<Target> m_targets;
+            QList<QSslSocket*> m_attempts;
+            QSslSocket* m_lastFailed;
+            QTimer m_attemptTimer;
+            /// Runs while the first server is waited for.
+            QTimer m_preferredTimer;
+            /// The target to take the next address from.
+            int m_nextTarget;
+            bool m_forceEncryption;
+            bool m_running;
+            bool m_hostFound;
+            bool m_triedByName;
+
+            Q_DISABLE_COPY(ConnectionRacer)
+    };
+}
+
+#endif
@@ -0,0 +1,285 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "incomingworker.h"
+
+#include "common.h"
+#include "pipelinestats.h"
+
+#if HAVE_QCA2
+#include "cipher.h"
+#endif
+
+#include <QElapsedTimer>
+#include <QTextCodec>
+
+namespace Konversation
+{
+    IncomingWorker::IncomingWorker()
+        : m_processScheduled(false)
+        , m_linesSignalled(false)
+        , m_generation(0)
+    {
+    }
+
+    IncomingWorker::~IncomingWorker()
+    {
+        #if HAVE_QCA2
+        qDeleteAll(m_ciphers);
+        #endif
+    }
+
+    void IncomingWorker::addData(int generation, const QByteArray& data)
+    {
+        Input input;
+        input.generation = generation;
+        input.data = data;
+
+        push(std::move(input));
+    }
+
+    void IncomingWorker::setSettings(const Settings& settings)
+    {
+        Input input;
+        input.hasSettings = true;
+        input.settings = settings;
+
+        push(std::move(input));
+    }
+
+    void IncomingWorker::push(Input input)
+    {
+        m_input.push(std::move(input));
+
+        // a pass already scheduled takes this one along
+        if (!m_processScheduled.exchange(true, std::memory_order_acq_rel))
+            QMetaObject::invokeMethod(this, &IncomingWorker::process, Qt::QueuedConnection);
+    }
+
+    QList<IncomingWorker::Line> IncomingWorker::takeLines()
+    {
+        // lines done from here on are signalled again
+        m_linesSignalled.exchange(false, std::memory_order_acq_rel);
+
+        QList<Line> lines;
+        Line line;
+
+        while (m_output.pop(line))
+            lines.append(std::move(line));
+
+        return lines;
+    }
+
+    void IncomingWorker::process()
+    {
+        m_processScheduled.exchange(false, std::memory_order_acq_rel);
+
+        bool done = false;
+        Input input;
+
+        while (m_input.pop(input))
+        {
+            if (input.hasSettings)
+            {
+                m_settings = input.settings;
+
+                #if HAVE_QCA2
+                // drop the ciphers of the keys gone
+                for (auto it = m_ciphers.begin(); it != m_ciphers.end();)
+                {
+                    if (m_settings.keys.contains(it.key()))
+                        ++it;
+                    else
+                    {
+                        delete it.value();
+                        it = m_ciphers.erase(it);
+                    }
+                }
+                #endif
+
+                continue;
+            }
+
+            if (input.generation != m_generation)
+            {
+                m_generation = input.generation;
+                m_lineBuffer.clear();
+            }
+
+            m_lineBuffer.append(input.data);
+
+            QByteArrayView view;
+            while (m_lineBuffer.nextLine(view))
+            {
+                Line line;
+
+                if (decodeLine(view.toByteArray(), line))
+                {
+                    m_output.push(std::move(line));
+                    done = true;
+                }
+            }
+        }
+
+        // one wakeup for all the lines of this pass
+        if (done && !m_linesSignalled.exchange(true, std::memory_order_acq_rel))
+            Q_EMIT linesReady();
+    }
+
+    bool IncomingWorker::decodeLine(QByteArray first, Line& line)
+    {
+        QElapsedTimer timer;
+        if (PipelineStats::isEnabled())
+            timer.start();
+
+        // Pre parsing is needed in case encryption/decryption is needed
+        QString senderNick;
+        bool isServerMessage = false;
+        QString channelKey;
+        QTextCodec* codec = m_settings.codec ? m_settings.codec : QTextCodec::codecForMib(106);
+
+        line.generation = m_generation;
+        line.raw = first;
+
+        QStringList lineSplit = codec->toUnicode(first).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+
+        if (lineSplit.count() >= 1)
+        {
+            if (lineSplit[0][0] == QLatin1Char(':'))          // does this message have a prefix?
+            {
+                if(!lineSplit[0].contains(QLatin1Char('!'))) // is this a server(global) message?
+                    isServerMessage = true;
+                else
+                    senderNick = lineSplit[0].mid(1, lineSplit[0].indexOf(QLatin1Char('!'))-1);
+
+                lineSplit.removeFirst();          // remove prefix
+            }
+        }
+
+        if (lineSplit.isEmpty())
+            return false;
+
+        // BEGIN pre-parse to know where the message belongs to
+        QString command = lineSplit[0].toLower();
+        if( isServerMessage )
+        {
+            if( lineSplit.count() >= 3 )
+            {
+                if( command == QLatin1String("332") )            // RPL_TOPIC
+                    channelKey = lineSplit[2];
+                if( command == QLatin1String("372") )            // RPL_MOTD
+                    channelKey = QStringLiteral(":server");
+            }
+        }
+        else                                      // NOT a global message
+        {
+            if( lineSplit.count() >= 2 )
+            {
+                // query
+                if( ( command == QLatin1String("privmsg") ||
+                    command == QLatin1String("notice")  ) &&
+                    lineSplit[1] == m_settings.nickname )
+                {
+                    channelKey = senderNick;
+                }
+                // channel message
+                else if( command == QLatin1String("privmsg") ||
+                    command == QLatin1String("notice")  ||
+                    command == QLatin1String("join")    ||
+                    command == QLatin1String("kick")    ||
+                    command == QLatin1String("part")    ||
+                    command == QLatin1String("topic")   )
+                {
+                    channelKey = lineSplit[1];
+                }
+            }
+        }
+        // END pre-parse to know where the message belongs to
+
+        line.channelKey = channelKey;
+
+        // Decrypt if necessary
+        #if HAVE_QCA2
+        QByteArray cKey = m_settings.keys.value(channelKey.toLower());
+        if(!cKey.isEmpty())
+        {
+            if(command == QLatin1String("privmsg"))
+            {
+                //only send encrypted text to decrypter
+                int index = first.indexOf(":",first.indexOf(":")+1);
+                if(m_settings.identifyMsg) // Workaround braindead Freenode prefixing messages with +
+                    ++index;
+                QByteArray backup = first.mid(0,index+1);
+
+                if (Cipher* cipher = cipherForRecipient(channelKey, cKey))
+                    first = cipher->decrypt(first.mid(index+1));
+
+                first.prepend(backup);
+            }
+            else if(command == QLatin1String("332") || command == QLatin1String("topic"))
+            {
+                //only send encrypted text to decrypter
+                int index = first.indexOf(":",first.indexOf(":")+1);
+                QByteArray backup = first.mid(0,index+1);
+
+                if (Cipher* cipher = cipherForRecipient(channelKey, cKey))
+                    first = cipher->decryptTopic(first.mid(index+1));
+
+                first.prepend(backup);
+            }
+        }
+        #endif
+        QString encoded;
+
+        // Qt uses 0xFDD0 and 0xFDD1 to mark the beginning and end of text frames. Remove
+        // these here to avoid fatal errors encountered in QText* and the event loop pro-
+        // cessing. decodeUtf8Line() does so while decoding.
+        if (!decodeUtf8Line(first, encoded))
+        {
+            // left to the connection, which knows the channel encodings
+            line.undecoded = first;
+        }
+        else if (encoded.isEmpty())
+            return false;
+
+        if (timer.isValid())
+        {
+            line.decodeTime = timer.nsecsElapsed();
+            timer.restart();
+        }
+
+        if (line.undecoded.isEmpty())
+        {
+            line.message = IrcMessage::fromLine(encoded);
+
+            if (timer.isValid())
+                line.parseTime = timer.nsecsElapsed();
+        }
+
+        return true;
+    }
+
+    #if HAVE_QCA2
+    Cipher* IncomingWorker::cipherForRecipient(const QString& recipient, const QByteArray& key)
+    {
+        const QString lowerRecipient = recipient.toLower();
+        Cipher*& cipher = m_ciphers[lowerRecipient];
+
+        // with its mode prefixed, the cipher does not look at the settings for it
+        QByteArray modeKey = key;
+        if (key.size() < 4 || (qstrnicmp(key.constData(), "ecb:", 4) != 0 && qstrnicmp(key.constData(), "cbc:", 4) != 0))
+            modeKey.prepend(m_settings.cbc ? "cbc:" : "ecb:");
+
+        if (!cipher)
+            cipher = new Cipher(modeKey);
+
+        // setKey() keeps the cipher's key schedules while the key stays the same
+        return cipher->setKey(modeKey) ? cipher : nullptr;
+    }
+    #endif
+}
+
+#include "moc_incomingworker.cpp"
@@ -0,0 +1,134 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef KONVERSATION_INCOMINGWORKER_H
+#define KONVERSATION_INCOMINGWORKER_H
+
+#include "ircmessage.h"
+#include "linebuffer.h"
+#include "spscqueue.h"
+#include <config-konversation.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include <atomic>
+
+class QTextCodec;
+
+namespace Konversation
+{
+    class Cipher;
+
+    /**
+     * Turns the data received by a connection into split up lines, on a
+     * thread of its own.
+     *
+     * Only framing the lines, FiSH decryption, decoding and splitting them
+     * up happen on the worker's thread. Reading the socket, and with it TLS,
+     * stays on the connection's thread, which hands the data over with
+     * addData(). The lines come back through takeLines() once linesReady()
+     * is emitted, to be handled on the connection's thread. Both ways go
+     * through lock-free queues, and a wakeup is only posted when the other
+     * side is not awake already.
+     *
+     * The connection runs the thread from connecting until it is
+     * disconnected.
+     *
+     * Lines that are not UTF-8 are handed back undecoded, as the channel
+     * encodings to decode them with are in the connection's settings.
+     */
+    class IncomingWorker : public QObject
+    {
+        Q_OBJECT
+
+        public:
+            /// What the worker needs to know of the connection, copied whenever it changes.
+            struct Settings
+            {
+                /// Of the identity.
+                QTextCodec* codec = nullptr;
+                QString nickname;
+                bool identifyMsg = false;
+                /// Keys by lowercased recipient.
+                QHash<QString, QByteArray> keys;
+                /// Whether keys without an "ecb:" or "cbc:" prefix are for CBC mode.
+                bool cbc = false;
+            };
+
+            struct Line
+            {
+                /// Of the data the line was in, see addData().
+                int generation = 0;
+                /// As received, for the raw log.
+                QByteArray raw;
+                /// Decrypted, but not UTF-8; message is empty then.
+                QByteArray undecoded;
+                /// The channel or query the line belongs to, if known.
+                QString channelKey;
+                IrcMessage message;
+                /// In nanoseconds, -1 if not measured.
+                qint64 decodeTime = -1;
+                qint64 parseTime = -1;
+            };
+
+            IncomingWorker();
+            ~IncomingWorker() override;
+
+            /**
+             * Hands @p data over to be split into lines. A new @p generation,
+             * e.g. for a new connection, drops what is left of the data of
+             * the previous one.
+             */
+            void addData(int generation, const QByteArray& data);
+            /// Applies to the data added from now on.
+            void setSettings(const Settings& settings);
+            /// The lines done since the last call, oldest first.
+            QList<Line> takeLines();
+
+        Q_SIGNALS:
+            /// Lines are there to take; not emitted again until they are taken.
+            void linesReady();
+
+        private:
+            struct Input
+            {
+                int generation = 0;
+                QByteArray data;
+                bool hasSettings = false;
+                Settings settings;
+            };
+
+            void push(Input input);
+            /// On the worker's thread.
+            void process();
+            bool decodeLine(QByteArray first, Line& line);
+
+            #if HAVE_QCA2
+            Cipher* cipherForRecipient(const QString& recipient, const QByteArray& key);
+            #endif
+
+            SpscQueue<Input> m_input;
+            SpscQueue<Line> m_output;
+            std::atomic<bool> m_processScheduled;
+            std::atomic<bool> m_linesSignalled;
+
+            // only touched on the worker's thread
+            Settings m_settings;
+            LineBuffer m_lineBuffer;
+            int m_generation;
+            #if HAVE_QCA2
+            /// Ours, separate from the ones of the channels and queries on the connection's thread.
+            QHash<QString, Cipher*> m_ciphers;
+            #endif
+
+            Q_DISABLE_COPY(IncomingWorker)
+    };
+}
+
+#endif
@@ -17,6 +17,8 @@
 #include "statuspanel.h"
 #include "common.h"
 #include "notificationhandler.h"
+#include "dbus.h"
+#include "pipelinestats.h"
 #include "konversation_log.h"
 #include <config-konversation.h>
 
@@ -41,77 +43,54 @@ void InputFilter::setServer(Server* newServer)
     m_server = newServer;
 }
 
-template<typename T>
-int posOrLen(T chr, const QString& str, int from=0)
-{
-    int p=str.indexOf(QLatin1Char(chr), from);
-    if (p<0)
-        return str.size();
-    return p;
-}
-
-/// "[22:08] >> :thiago!n=thiago@kde/thiago QUIT :Read error: 110 (Connection timed out)"
-/// "[21:47] >> :Zarin!n=x365@kde/developer/lmurray PRIVMSG #plasma :If the decoration doesn't have paint( QPixmap ) it falls back to the old one"
-/// "[21:49] >> :niven.freenode.net 352 argonel #kde-forum i=beezle konversation/developer/argonel irc.freenode.net argonel H :0 Konversation User "
 void InputFilter::parseLine(const QString& line)
 {
-    int start=0;
-    QHash<QString, QString> messageTags;
+    QElapsedTimer parseTimer;
+    if (Konversation::PipelineStats::isEnabled())
+        parseTimer.start();
 
-    if (line[0] == QLatin1Char('@'))
-    {
-        messageTags = parseMessageTags(line, &start);
-    }
+    Konversation::IrcMessage message = Konversation::IrcMessage::fromLine(line);
 
-    QString prefix;
-    int end(posOrLen(' ', line, start));
+    if (parseTimer.isValid())
+        Konversation::PipelineStats::addTime(Konversation::PipelineStats::Parse, parseTimer.nsecsElapsed());
 
-    if (line[start]==QLatin1Char(':'))
-    {
-        prefix = line.mid(start + 1, end - start - 1); //skips the colon and does not include the trailing space
-        start = end + 1;
-        end = posOrLen(' ', line, start);
-    }
+    parseMessage(message);
+}
 
-    //even though the standard is UPPER CASE, someone when through a great deal of trouble to make this lower case...
-    QString command = QString(line.mid(start, end-start)).toLower();
-    start=end+1;
+void InputFilter::parseMessage(Konversation::IrcMessage& message)
+{
+    const QString& prefix = message.prefix;
+    const QString& command = message.command;
+    QStringList& parameterList = message.parameters;
+    const QHash<QString, QString>& messageTags = message.tags;
 
-    int trailing=line.indexOf(QLatin1String(" :"), end);
-    if (trailing >= 0)
-        end=trailing;
-    else
-        end=line.size();
+    Q_ASSERT(m_server); //how could we have gotten a line without a server?
 
-    QStringList parameterList;
+    Konversation::PipelineTimer timer(Konversation::PipelineStats::Dispatch);
 
-    while (start < end)
+    if (command == QLatin1String("batch"))
     {
-        if (line[start]==QLatin1Char(' '))
-            start++;
-        else
-        {
-            int p=line.indexOf(QLatin1Char(' '), start); //easier to have Qt loop for me :)
-            if (p<0)
-                p=end;
-            parameterList << line.mid(start, p-start);
-            start=p+1;
-        }
-    };
+        parseBatch(parameterList);
+        return;
+    }
 
-    /* Quote: "The final colon is specified as a "last argument" designator, and
-     * is always valid before the final argument."
-     * Quote: "The last parameter may be an empty string."
-     * Quote: "After extracting the parameter list, all parameters are equal
-     * whether matched by <middle> or <trailing>. <trailing> is just a
-     * syntactic trick to allow SPACE within the parameter."
-     */
+    // only carries tags, none of which are shown
+    if (command == QLatin1String("tagmsg"))
+        return;
 
-    if (trailing >= 0 ) //<-- trailing == ":" - per above we need the empty string
-        parameterList << line.mid( qMin(trailing+2, line.size()) );
+    if (collectHistory(prefix, command, parameterList, messageTags))
+        return;
 
-    Q_ASSERT(m_server); //how could we have gotten a line without a server?
+    // FAIL CHATHISTORY code [context] :description, the request is over
+    if (command == QLatin1String("fail") && parameterList.value(0) == QLatin1String("CHATHISTORY"))
+    {
+        // the context lies between the code and the description
+        m_server->historyFailed(parameterList.mid(2, parameterList.count() - 3));
+        return;
+    }
 
+    // Played back lines skip notifications and are shown in bulk.
+    m_server->setPlayback(isPlayback(messageTags));
 
     // Server command, if no "!" was found in prefix
     if ((!prefix.contains(QLatin1Char('!'))) && (prefix != m_server->getNickname()))
@@ -197,6 +176,7 @@ void InputFilter::parseClientCommand(const QString &prefix, const QString &comma
                     }
 
                     channel->appendAction(sourceNick, ctcpArgument, messageTags);
+                    konv_app->dbus()->reportMessage(m_server, channel->getName(), sourceNick, ctcpArgument, true);
 
                     if (sourceNick != m_server->getNickname())
                     {
@@ -228,6 +208,7 @@ void InputFilter::parseClientCommand(const QString &prefix, const QString &comma
 
                     // send action to query
                     query->appendAction(sourceNick, ctcpArgument, messageTags);
+                    konv_app->dbus()->reportMessage(m_server, query->getName(), sourceNick, ctcpArgument, true);
 
                     if (sourceNick != m_server->getNickname() && query)
                         konv_app->notificationHandler()->queryMessage(query, sourceNick, ctcpArgument);
@@ -622,6 +603,8 @@ void InputFilter::parseClientCommand(const QString &prefix, const QString &comma
             Channel* channel = m_server->nickJoinsChannel(channelName, sourceNick, sourceHostmask, account, realName, messageTags);
             konv_app->notificationHandler()->join(channel, sourceNick);
         }
+
+        konv_app->dbus()->reportJoin(m_server, channelName, sourceNick);
     }
     else if (command==QStringLiteral("kick") && plHas(2))
     {
@@ -635,6 +618,7 @@ void InputFilter::parseClientCommand(const QString &prefix, const QString &comma
         QString reason(parameterList.value(1));
 
         Channel* channelPtr = m_server->removeNickFromChannel(channel, sourceNick, reason, messageTags);
+        konv_app->dbus()->reportPart(m_server, channel, sourceNick, reason);
 
         if (sourceNick != m_server->getNickname())
         {
@@ -644,6 +628,7 @@ void InputFilter::parseClientCommand(const QString &prefix, const QString &comma
     else if (command==QStringLiteral("quit") && plHas(1))
     {
         m_server->removeNickFromServer(sourceNick, trailing, messageTags);
+        konv_app->dbus()->reportQuit(m_server, sourceNick, trailing);
         if (sourceNick != m_server->getNickname())
         {
             konv_app->notificationHandler()->quit(m_server->getStatusView(), sourceNick);
@@ -1003,6 +988,103 @@ void InputFilter::reset()
 {
     m_automaticRequest.clear();
     m_whoRequestList.clear();
+    m_batches.clear();
+    m_historyBatches.clear();
+}
+
+void InputFilter::parseBatch(const QStringList &parameterList)
+{
+    if (parameterList.isEmpty() || parameterList.first().size() < 2)
+        return;
+
+    const QString reference = parameterList.first().mid(1);
+
+    if (parameterList.first().startsWith(QLatin1Char('+')))
+    {
+        m_batches.insert(reference, parameterList.value(1));
+
+        // BATCH +reference chathistory target
+        if (parameterList.value(1) == QLatin1String("chathistory") && m_server->isHistoryRequested(parameterList.value(2)))
+            m_historyBatches.insert(reference, HistoryBatch { parameterList.value(2), {} });
+    }
+    else
+    {
+        m_batches.remove(reference);
+
+        const auto history = m_historyBatches.constFind(reference);
+
+        if (history != m_historyBatches.constEnd())
+        {
+            const HistoryBatch batch = *history;
+            m_historyBatches.erase(history);
+
+            m_server->historyReceived(batch.target, batch.lines);
+        }
+    }
+}
+
+bool InputFilter::collectHistory(const QString &prefix, const QString &command, const QStringList &parameterList, const QHash<QString, QString> &messageTags)
+{
+    if (m_historyBatches.isEmpty())
+        return false;
+
+    const auto batch = m_historyBatches.find(messageTags.value(QStringLiteral("batch")));
+
+    if (batch == m_historyBatches.end())
+        return false;
+
+    // only messages make it into the scrollback, the rest of the batch is dropped
+    if (command != QLatin1String("privmsg") || parameterList.size() < 2 || !prefix.contains(QLatin1Char('!')))
+        return true;
+
+    Konversation::HistoryLine line;
+    line.time = QDateTime::fromString(messageTags.value(QStringLiteral("time")), Qt::ISODateWithMs);
+    line.msgid = messageTags.value(QStringLiteral("msgid"));
+    line.nick = prefix.section(QLatin1Char('!'), 0, 0);
+    line.message = parameterList.last();
+
+    if (!line.time.isValid())
+        return true;
+
+    if (line.message.startsWith(QLatin1Char('\x01')))
+    {
+        // of the CTCPs only actions are chat
+        if (!line.message.startsWith(QLatin1String("\x01" "ACTION")))
+            return true;
+
+        line.action = true;
+        line.message = line.message.mid(8);
+
+        if (line.message.endsWith(QLatin1Char('\x01')))
+            line.message.chop(1);
+    }
+
+    batch->lines.append(line);
+
+    return true;
+}
+
+bool InputFilter::isPlayback(const QHash<QString, QString> &messageTags) const
+{
+    // clocks of servers and bouncers may be somewhat off
+    static const int clockSkew = 30;
+
+    const auto batch = messageTags.constFind(QStringLiteral("batch"));
+
+    if (batch != messageTags.constEnd())
+    {
+        const QString type = m_batches.value(*batch);
+
+        if (type == QLatin1String("chathistory") || type == QLatin1String("znc.in/playback"))
+            return true;
+    }
+
+    const auto time = messageTags.constFind(QStringLiteral("time"));
+
+    if (time == messageTags.constEnd() || !m_server->connectTime().isValid())
+        return false;
+
+    return QDateTime::fromString(*time, Qt::ISODateWithMs) < m_server->connectTime().addSecs(-clockSkew);
 }
 
 void InputFilter::setAutomaticRequest(const QString& command, const QString& name, bool yes)
@@ -1068,6 +1150,7 @@ void InputFilter::parsePrivMsg(const QString& prefix, QStringList& parameterList
                 }
 
                 channel->append(source, message, messageTags, label);
+                konv_app->dbus()->reportMessage(m_server, channel->getName(), source, message, false);
 
                 if(source != m_server->getNickname())
                 {
@@ -1105,6 +1188,7 @@ void InputFilter::parsePrivMsg(const QString& prefix, QStringList& parameterList
 
             // send action to query
             query->appendQuery(source, message, messageTags);
+            konv_app->dbus()->reportMessage(m_server, queryName, source, message, false);
 
             if(source != m_server->getNickname() && query)
             {
@@ -1123,21 +1207,6 @@ void InputFilter::parsePrivMsg(const QString& prefix, QStringList& parameterList
     }
 }
 
-QHash<QString, QString> InputFilter::parseMessageTags(const QString &line, int *startOfMessage)
-{
-    int index = line.indexOf(QLatin1Char(' '));
-    *startOfMessage = index + 1;
-    const QStringList tags = line.mid(1, index - 1).split(QLatin1Char(';'));
-    QHash<QString, QString> tagHash;
-
-    for (const QString &tag : tags) {
-        QStringList tagList = tag.split(QLatin1Char('='));
-        tagHash.insert(tagList.first(), tagList.last());
-    }
-
-    return tagHash;
-}
-
 void InputFilter::parseNumeric(const QString &prefix, int command, QStringList &parameterList, const QHash<QString, QString> &messageTags)
 {
     //:niven.freenode.net 353 argnl @ #konversation :@argonel psn @argnl bugbot pinotree CIA-13
@@ -1289,6 +1358,15 @@ void InputFilter::parseNumeric(const QString &prefix, int command, QStringList &
                     {
                         m_server->setHasWHOX(true);
                      }
+                    else if (property == QLatin1String("CHATHISTORY"))
+                    {
+                        bool ok = false;
+                        int limit = value.toInt(&ok);
+
+                        // 0 is no limit
+                        if (ok)
+                            m_server->setChatHistoryLimit(limit);
+                    }
                     else
                     {
                         //qCDebug(KONVERSATION_LOG) << "Ignored server-capability: " << property << " with value '" << value << "'";
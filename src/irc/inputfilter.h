@@ -9,7 +9,9 @@
 #ifndef INPUTFILTER_H
 #define INPUTFILTER_H
 
+#include "chathistory.h"
 #include "ignore.h"
+#include "ircmessage.h"
 
 #include <QObject>
 #include <QStringList>
@@ -28,6 +30,8 @@ class InputFilter : public QObject
 
         void setServer(Server* newServer);
         void parseLine(const QString &line);
+        /// Handles a line split up already, e.g. by the IncomingWorker.
+        void parseMessage(Konversation::IrcMessage &message);
 
         void reset();                             // reset AutomaticRequest, WhoRequestList
 
@@ -78,7 +82,12 @@ class InputFilter : public QObject
         void parsePrivMsg(const QString& prefix, QStringList& parameterList, const QHash<QString, QString> &messageTags);
         void parseNumeric(const QString &prefix, int command, QStringList &parameterList, const QHash<QString, QString> &messageTags);
 
-        QHash<QString, QString> parseMessageTags(const QString &line, int *startOfMessage);
+        /// Keeps track of the open batches, IRCv3 "BATCH +reference type" and "BATCH -reference".
+        void parseBatch(const QStringList &parameterList);
+        /// Whether a line is one a bouncer plays back: older than the connection, or in a history batch.
+        bool isPlayback(const QHash<QString, QString> &messageTags) const;
+        /// Collects the lines of a batch of requested history instead of handling them; returns whether it did.
+        bool collectHistory(const QString &prefix, const QString &command, const QStringList &parameterList, const QHash<QString, QString> &messageTags);
 
         bool isAChannel(const QString &check) const;
         bool isIgnore(const QString &pattern, Ignore::Type type) const;
@@ -93,6 +102,18 @@ class InputFilter : public QObject
         /// Used when handling MOTD
         bool m_connecting;
 
+        /// The types of the open batches by their references.
+        QHash<QString, QString> m_batches;
+
+        struct HistoryBatch
+        {
+            QString target;
+            QList<Konversation::HistoryLine> lines;
+        };
+
+        /// The open batches of requested history by their references.
+        QHash<QString, HistoryBatch> m_historyBatches;
+
         Q_DISABLE_COPY(InputFilter)
 };
 
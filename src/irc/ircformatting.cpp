@@ -0,0 +1,221 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "ircformatting.h"
+
+#include "common.h"
+
+namespace Konversation
+{
+    static inline bool isAsciiDigit(QStringView text, qsizetype pos)
+    {
+        return pos < text.size() && text.at(pos).unicode() >= '0' && text.at(pos).unicode() <= '9';
+    }
+
+    /// Reads one or two digits at @p pos, advancing it past them.
+    static int readColorNumber(QStringView text, qsizetype& pos)
+    {
+        int value = text.at(pos++).unicode() - '0';
+
+        if (isAsciiDigit(text, pos))
+            value = value * 10 + (text.at(pos++).unicode() - '0');
+
+        return value;
+    }
+
+    /// Colors beyond the 16 basic ones are shown in the default color.
+    static inline qint8 colorIndex(int value)
+    {
+        return (value < 16) ? static_cast<qint8>(value) : -1;
+    }
+
+    static void appendLinks(IrcFormattedText& result)
+    {
+        TextUrlData urlData = extractUrlData(result.text);
+        TextChannelData channelData = extractChannelData(result.text);
+
+        qsizetype url = 0;
+        qsizetype channel = 0;
+        int linkEnd = 0;
+
+        while (url < urlData.urlRanges.count() || channel < channelData.channelRanges.count())
+        {
+            IrcTextLink link;
+
+            // The link that starts first wins, for "#www.some.url" that is the channel.
+            if (channel == channelData.channelRanges.count()
+                || (url < urlData.urlRanges.count() && urlData.urlRanges.at(url) < channelData.channelRanges.at(channel)))
+            {
+                const QPair<int, int>& range = urlData.urlRanges.at(url);
+                link = IrcTextLink { IrcTextLink::Url, range.first, range.second, urlData.fixedUrls.at(url) };
+                ++url;
+            }
+            else
+            {
+                const QPair<int, int>& range = channelData.channelRanges.at(channel);
+                link = IrcTextLink { IrcTextLink::Channel, range.first, range.second, channelData.fixedChannels.at(channel) };
+                ++channel;
+            }
+
+            if (link.start < linkEnd)
+                continue;
+
+            linkEnd = link.start + link.length;
+            result.links.append(link);
+        }
+    }
+
+    IrcFormattedText parseIrcFormatting(QStringView text, bool allowColors, bool parseLinks)
+    {
+        IrcFormattedText result;
+        result.text.reserve(text.size());
+
+        IrcTextStyle style;
+        IrcTextStyle runStyle;
+        int runStart = 0;
+        bool styleChanged = false;
+
+        unsigned int rtlChars = 0;
+        unsigned int ltrChars = 0;
+
+        for (qsizetype pos = 0; pos < text.size(); ++pos)
+        {
+            const QChar c = text.at(pos);
+
+            switch (c.unicode())
+            {
+                case 0x02: // bold
+                    style.flags ^= IrcTextStyle::Bold;
+                    styleChanged = true;
+                    continue;
+                case 0x1d: // italic
+                    style.flags ^= IrcTextStyle::Italic;
+                    styleChanged = true;
+                    continue;
+                case 0x15: // mirc underline
+                case 0x1f: // kvirc underline
+                    style.flags ^= IrcTextStyle::Underline;
+                    styleChanged = true;
+                    continue;
+                case 0x13: // historic strikethru
+                case 0x1e: // modern strikethru
+                    style.flags ^= IrcTextStyle::StrikeOut;
+                    styleChanged = true;
+                    continue;
+                case 0x11: // monospace
+                    style.flags ^= IrcTextStyle::Monospace;
+                    styleChanged = true;
+                    continue;
+                case 0x0f: // reset to default
+                    style = IrcTextStyle();
+                    styleChanged = true;
+                    continue;
+                case 0x16: // reverse, treated as a color
+                    if (allowColors)
+                    {
+                        style.flags ^= IrcTextStyle::Reverse;
+                        styleChanged = true;
+                    }
+                    continue;
+                case 0x03: // color
+                {
+                    int foreground = -1;
+                    int background = -1;
+
+                    if (isAsciiDigit(text, pos + 1))
+                    {
+                        ++pos;
+                        foreground = readColorNumber(text, pos);
+
+                        // the comma only belongs to the code if a background follows
+                        if (pos < text.size() && text.at(pos) == QLatin1Char(',') && isAsciiDigit(text, pos + 1))
+                        {
+                            ++pos;
+                            background = readColorNumber(text, pos);
+                        }
+
+                        --pos;
+                    }
+
+                    if (!allowColors)
+                        continue;
+
+                    if (foreground == -1)
+                    {
+                        // a bare color code resets both colors
+                        style.foreground = -1;
+                        style.background = -1;
+                    }
+                    else
+                    {
+                        style.foreground = colorIndex(foreground);
+
+                        if (background != -1)
+                            style.background = colorIndex(background);
+                    }
+
+                    styleChanged = true;
+                    continue;
+                }
+                default:
+                    break;
+            }
+
+            if (styleChanged)
+            {
+                styleChanged = false;
+
+                if (style != runStyle)
+                {
+                    if (result.text.size() > runStart)
+                        result.runs.append(IrcTextRun { runStart, static_cast<int>(result.text.size()) - runStart, runStyle });
+
+                    runStart = static_cast<int>(result.text.size());
+                    runStyle = style;
+                }
+            }
+
+            result.text.append(c);
+
+            if (c.unicode() < 0x80)
+            {
+                // of the ASCII characters only letters have a strong direction
+                if (c.isLetter())
+                    ++ltrChars;
+            }
+            else if (!(c.isNumber() || c.isSymbol() || c.isSpace() || c.isPunct() || c.isMark()))
+            {
+                switch (c.direction())
+                {
+                    case QChar::DirL:
+                    case QChar::DirLRO:
+                    case QChar::DirLRE:
+                        ++ltrChars;
+                        break;
+                    case QChar::DirR:
+                    case QChar::DirAL:
+                    case QChar::DirRLO:
+                    case QChar::DirRLE:
+                        ++rtlChars;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        if (result.text.size() > runStart)
+            result.runs.append(IrcTextRun { runStart, static_cast<int>(result.text.size()) - runStart, runStyle });
+
+        if (rtlChars > ltrChars)
+            result.direction = QChar::DirR;
+
+        if (parseLinks && !result.text.isEmpty())
+            appendLinks(result);
+
+        return result;
+    }
+}
@@ -0,0 +1,90 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef IRCFORMATTING_H
+#define IRCFORMATTING_H
+
+#include <QChar>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+namespace Konversation
+{
+    /// Text attributes set by the mIRC formatting codes.
+    struct IrcTextStyle
+    {
+        enum Flag : quint8
+        {
+            Bold = 0x01,
+            Italic = 0x02,
+            Underline = 0x04,
+            StrikeOut = 0x08,
+            Monospace = 0x10,
+            Reverse = 0x20
+        };
+
+        quint8 flags = 0;
+        /// mIRC color index 0-15, or -1 for the default color
+        qint8 foreground = -1;
+        qint8 background = -1;
+
+        bool operator==(const IrcTextStyle& other) const
+        {
+            return flags == other.flags && foreground == other.foreground && background == other.background;
+        }
+        bool operator!=(const IrcTextStyle& other) const { return !(*this == other); }
+    };
+
+    /// A span of IrcFormattedText::text sharing one style.
+    struct IrcTextRun
+    {
+        int start;
+        int length;
+        IrcTextStyle style;
+    };
+
+    /// A clickable span of IrcFormattedText::text.
+    struct IrcTextLink
+    {
+        enum Type
+        {
+            Url,
+            Channel
+        };
+
+        Type type;
+        int start;
+        int length;
+        /// The URL with a protocol added if it had none, or the
+        /// percent encoded channel name
+        QString target;
+    };
+
+    struct IrcFormattedText
+    {
+        /// The text with all formatting codes taken out.
+        QString text;
+        /// Covers all of text, in order. Empty runs are not stored.
+        QList<IrcTextRun> runs;
+        /// In order and not overlapping.
+        QList<IrcTextLink> links;
+        /// QChar::DirR if there are more right-to-left than left-to-right letters
+        QChar::Direction direction = QChar::DirL;
+    };
+
+    /**
+     * Splits IRC text into plain text and runs of formatting in a single pass.
+     *
+     * Bold, italic, underline, strikethrough, monospace, reverse, color and
+     * reset codes are understood. With @p allowColors false the color and
+     * reverse codes are dropped without effect. With @p parseLinks the URLs
+     * and channel names in the plain text are found as well.
+     */
+    IrcFormattedText parseIrcFormatting(QStringView text, bool allowColors, bool parseLinks);
+}
+
+#endif
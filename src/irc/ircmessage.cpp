@@ -0,0 +1,99 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2002 Dario Abatianni <eisfuchs@tigress.com>
+    SPDX-FileCopyrightText: 2004, 2016 Peter Simonsson <peter.simonsson@gmail.com>
+    SPDX-FileCopyrightText: 2006-2008 Eike Hein <hein@kde.org>
+*/
+
+#include "ircmessage.h"
+
+namespace Konversation
+{
+    template<typename T>
+    static int posOrLen(T chr, const QString& str, int from=0)
+    {
+        int p=str.indexOf(QLatin1Char(chr), from);
+        if (p<0)
+            return str.size();
+        return p;
+    }
+
+    static QHash<QString, QString> parseMessageTags(const QString &line, int *startOfMessage)
+    {
+        int index = line.indexOf(QLatin1Char(' '));
+        *startOfMessage = index + 1;
+        const QStringList tags = line.mid(1, index - 1).split(QLatin1Char(';'));
+        QHash<QString, QString> tagHash;
+
+        for (const QString &tag : tags) {
+            QStringList tagList = tag.split(QLatin1Char('='));
+            tagHash.insert(tagList.first(), tagList.last());
+        }
+
+        return tagHash;
+    }
+
+    /// "[22:08] >> :thiago!n=thiago@kde/thiago QUIT :Read error: 110 (Connection timed out)"
+    /// "[21:47] >> :Zarin!n=x365@kde/developer/lmurray PRIVMSG #plasma :If the decoration doesn't have paint( QPixmap ) it falls back to the old one"
+    /// "[21:49] >> :niven.freenode.net 352 argonel #kde-forum i=beezle konversation/developer/argonel irc.freenode.net argonel H :0 Konversation User "
+    IrcMessage IrcMessage::fromLine(const QString& line)
+    {
+        int start=0;
+        QHash<QString, QString> messageTags;
+
+        if (line[0] == QLatin1Char('@'))
+        {
+            messageTags = parseMessageTags(line, &start);
+        }
+
+        QString prefix;
+        int end(posOrLen(' ', line, start));
+
+        if (line[start]==QLatin1Char(':'))
+        {
+            prefix = line.mid(start + 1, end - start - 1); //skips the colon and does not include the trailing space
+            start = end + 1;
+            end = posOrLen(' ', line, start);
+        }
+
+        //even though the standard is UPPER CASE, someone when through a great deal of trouble to make this lower case...
+        QString command = QString(line.mid(start, end-start)).toLower();
+        start=end+1;
+
+        int trailing=line.indexOf(QLatin1String(" :"), end);
+        if (trailing >= 0)
+            end=trailing;
+        else
+            end=line.size();
+
+        QStringList parameterList;
+
+        while (start < end)
+        {
+            if (line[start]==QLatin1Char(' '))
+                start++;
+            else
+            {
+                int p=line.indexOf(QLatin1Char(' '), start); //easier to have Qt loop for me :)
+                if (p<0)
+                    p=end;
+                parameterList << line.mid(start, p-start);
+                start=p+1;
+            }
+        };
+
+        /* Quote: "The final colon is specified as a "last argument" designator, and
+         * is always valid before the final argument."
+         * Quote: "The last parameter may be an empty string."
+         * Quote: "After extracting the parameter list, all parameters are equal
+         * whether matched by <middle> or <trailing>. <trailing> is just a
+         * syntactic trick to allow SPACE within the parameter."
+         */
+
+        if (trailing >= 0 ) //<-- trailing == ":" - per above we need the empty string
+            parameterList << line.mid( qMin(trailing+2, line.size()) );
+
+        return IrcMessage { messageTags, prefix, command, parameterList };
+    }
+}
@@ -0,0 +1,36 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef KONVERSATION_IRCMESSAGE_H
+#define KONVERSATION_IRCMESSAGE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+namespace Konversation
+{
+    /**
+     * A line from the server split into its parts.
+     *
+     * Splitting does not need the connection, so it can happen on any
+     * thread; see IncomingWorker.
+     */
+    struct IrcMessage
+    {
+        QHash<QString, QString> tags;
+        /// Without the leading colon.
+        QString prefix;
+        /// Lowercased.
+        QString command;
+        QStringList parameters;
+
+        /// "@tags :prefix command parameters :trailing" split up.
+        static IrcMessage fromLine(const QString& line);
+    };
+}
+
+#endif
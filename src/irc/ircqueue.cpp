@@ -7,6 +7,7 @@
 #include "ircqueue.h"
 
 #include "server.h"
+#include "pipelinestats.h"
 #include "konversation_log.h"
 
 #include <QTimer>
@@ -134,6 +135,7 @@ void IRCQueue::sent(int, int e, IRCQueue *wq)
 void IRCQueue::enqueue(const QString& line)
 {
     m_pending.append(IRCMessage(line));
+    Konversation::PipelineStats::addQueueDepth(Konversation::PipelineStats::OutputQueue, m_pending.count());
     if (!m_timer->isActive())
         adjustTimer();
 }
@@ -0,0 +1,93 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "linebuffer.h"
+
+#include <QIODevice>
+
+namespace Konversation
+{
+    static inline bool isLineTerminator(char c)
+    {
+        return c == '\n' || c == '\r';
+    }
+
+    qint64 LineBuffer::readFrom(QIODevice *device)
+    {
+        const qint64 available = device->bytesAvailable();
+
+        if (available <= 0)
+            return available;
+
+        compact();
+
+        const qsizetype oldSize = m_buffer.size();
+        m_buffer.resize(oldSize + available);
+
+        const qint64 actual = device->read(m_buffer.data() + oldSize, available);
+        m_buffer.resize(oldSize + qMax<qint64>(actual, 0));
+
+        return actual;
+    }
+
+    void LineBuffer::append(QByteArrayView data)
+    {
+        if (data.isEmpty())
+            return;
+
+        compact();
+        m_buffer.append(data);
+    }
+
+    bool LineBuffer::nextLine(QByteArrayView &line)
+    {
+        const qsizetype size = m_buffer.size();
+        const char *data = m_buffer.constData();
+
+        // since euIRC gets away with sending just \r, bet someone sends \n\r?
+        while (m_start < size && isLineTerminator(data[m_start]))
+            ++m_start;
+
+        for (qsizetype i = qMax(m_start, m_scanned); i < size; ++i)
+        {
+            if (isLineTerminator(data[i]))
+            {
+                line = QByteArrayView(data + m_start, i - m_start);
+                m_start = i + 1;
+                m_scanned = m_start;
+                return true;
+            }
+        }
+
+        m_scanned = size;
+        return false;
+    }
+
+    void LineBuffer::clear()
+    {
+        m_buffer.resize(0);
+        m_start = 0;
+        m_scanned = 0;
+    }
+
+    void LineBuffer::compact()
+    {
+        if (m_start == 0)
+            return;
+
+        // Only move the partial tail line to the front; the buffer keeps its
+        // capacity so steady-state reading does not allocate.
+        if (m_start >= m_buffer.size())
+        {
+            clear();
+            return;
+        }
+
+        m_buffer.remove(0, m_start);
+        m_scanned = qMax<qsizetype>(m_scanned - m_start, 0);
+        m_start = 0;
+    }
+}
@@ -0,0 +1,63 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef KONVERSATION_LINEBUFFER_H
+#define KONVERSATION_LINEBUFFER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+class QIODevice;
+
+namespace Konversation
+{
+    /**
+     * Frames a byte stream into lines terminated by '\n' and/or '\r'.
+     *
+     * Incoming data is read straight into a single reusable buffer, and
+     * complete lines are handed out as views into that buffer, so callers
+     * can decode each line exactly once without an intermediate copy.
+     * Empty lines (e.g. the second half of "\r\n") are skipped.
+     */
+    class LineBuffer
+    {
+        public:
+            LineBuffer() = default;
+
+            /**
+             * Appends everything currently available on @p device.
+             * @return the number of bytes read, or -1 on error.
+             */
+            qint64 readFrom(QIODevice *device);
+
+            /** Appends @p data to the end of the buffer. */
+            void append(QByteArrayView data);
+
+            /**
+             * Extracts the next complete line, without its terminator.
+             * The returned view stays valid until the next call to
+             * readFrom(), append() or clear().
+             * @return false if no complete line is buffered.
+             */
+            bool nextLine(QByteArrayView &line);
+
+            /** Number of buffered bytes not yet handed out as lines. */
+            qsizetype pendingSize() const { return m_buffer.size() - m_start; }
+
+            void clear();
+
+        private:
+            void compact();
+
+        private:
+            QByteArray m_buffer;
+            qsizetype m_start = 0;
+            /// Offset up to which no terminator has been found yet.
+            qsizetype m_scanned = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "nickcompletionindex.h"
+
+#include "preferences.h"
+
+#include <algorithm>
+
+static inline bool isAsciiAlnum(QChar c)
+{
+    const char16_t u = c.unicode();
+
+    return (u >= u'0' && u <= u'9') || (u >= u'a' && u <= u'z') || (u >= u'A' && u <= u'Z');
+}
+
+/// The name without its leading characters other than letters and digits.
+static QString strippedName(const QString& name)
+{
+    qsizetype start = 0;
+
+    while (start < name.size() && !isAsciiAlnum(name.at(start)))
+        ++start;
+
+    return name.mid(start);
+}
+
+void NickCompletionIndex::insertEntry(QList<Entry>& entries, const QString& key, Nick* nick)
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& entry, const QString& key) {
+        return entry.key < key;
+    });
+
+    entries.insert(it, Entry { key, nick });
+}
+
+void NickCompletionIndex::removeEntry(QList<Entry>& entries, const QString& key, Nick* nick)
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& entry, const QString& key) {
+        return entry.key < key;
+    });
+
+    for (; it != entries.end() && it->key == key; ++it)
+    {
+        if (it->nick == nick)
+        {
+            entries.erase(it);
+            return;
+        }
+    }
+}
+
+void NickCompletionIndex::insert(Nick* nick, const QString& nickname)
+{
+    updatePrefixCharacter();
+
+    // a renamed nick is indexed again
+    remove(nick);
+
+    const QString name = completionName(nickname);
+
+    m_names.insert(nick, name);
+    m_nicknames.insert(nick, nickname);
+    insertEntry(m_byName, name.toCaseFolded(), nick);
+    insertEntry(m_byStrippedName, strippedName(name).toCaseFolded(), nick);
+}
+
+void NickCompletionIndex::remove(Nick* nick)
+{
+    const auto it = m_names.constFind(nick);
+
+    if (it == m_names.constEnd())
+        return;
+
+    removeEntry(m_byName, it->toCaseFolded(), nick);
+    removeEntry(m_byStrippedName, strippedName(*it).toCaseFolded(), nick);
+
+    m_names.erase(it);
+    m_nicknames.remove(nick);
+}
+
+void NickCompletionIndex::clear()
+{
+    m_byName.clear();
+    m_byStrippedName.clear();
+    m_names.clear();
+    m_nicknames.clear();
+}
+
+QList<Nick*> NickCompletionIndex::nicksStartingWith(const QString& pattern, bool skipNonAlfaNum, bool caseSensitive)
+{
+    updatePrefixCharacter();
+
+    QList<Nick*> nicks;
+    const Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    // only a pattern starting with a word character skips the leading characters
+    const bool skip = skipNonAlfaNum && !pattern.isEmpty()
+                      && (isAsciiAlnum(pattern.at(0)) || pattern.at(0) == QLatin1Char('_'));
+
+    if (skip && pattern.at(0) == QLatin1Char('_'))
+    {
+        // The underscore is skipped itself, so the pattern may start anywhere
+        // in the leading characters. Rare enough to test every nick.
+        for (auto it = m_names.cbegin(); it != m_names.cend(); ++it)
+        {
+            const QString& name = it.value();
+
+            for (qsizetype start = 0; start <= name.size(); ++start)
+            {
+                if (QStringView(name).sliced(start).startsWith(pattern, cs))
+                {
+                    nicks.append(it.key());
+                    break;
+                }
+
+                if (start == name.size() || isAsciiAlnum(name.at(start)))
+                    break;
+            }
+        }
+
+        return nicks;
+    }
+
+    collect(skip ? m_byStrippedName : m_byName, pattern.toCaseFolded(), pattern, skip, cs, nicks);
+
+    return nicks;
+}
+
+void NickCompletionIndex::collect(const QList<Entry>& entries, const QString& key, const QString& pattern,
+                                  bool stripped, Qt::CaseSensitivity cs, QList<Nick*>& nicks) const
+{
+    auto it = std::lower_bound(entries.cbegin(), entries.cend(), key, [](const Entry& entry, const QString& key) {
+        return entry.key < key;
+    });
+
+    for (; it != entries.cend() && it->key.startsWith(key); ++it)
+    {
+        // the keys are case folded, check the case of the name itself
+        if (cs == Qt::CaseSensitive)
+        {
+            const QString name = stripped ? strippedName(m_names.value(it->nick)) : m_names.value(it->nick);
+
+            if (!name.startsWith(pattern))
+                continue;
+        }
+
+        nicks.append(it->nick);
+    }
+}
+
+QString NickCompletionIndex::completionName(const QString& nickname) const
+{
+    if (!m_prefixCharacter.isEmpty() && nickname.contains(m_prefixCharacter))
+        return nickname.section(m_prefixCharacter, 1);
+
+    return nickname;
+}
+
+void NickCompletionIndex::updatePrefixCharacter()
+{
+    const QString prefixCharacter = Preferences::self()->prefixCharacter();
+
+    if (prefixCharacter == m_prefixCharacter)
+        return;
+
+    m_prefixCharacter = prefixCharacter;
+
+    const QHash<Nick*, QString> nicknames = m_nicknames;
+
+    clear();
+
+    for (auto it = nicknames.cbegin(); it != nicknames.cend(); ++it)
+        insert(it.key(), it.value());
+}
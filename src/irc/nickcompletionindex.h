@@ -0,0 +1,69 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef NICKCOMPLETIONINDEX_H
+#define NICKCOMPLETIONINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class Nick;
+
+/**
+ * The nicks of a channel sorted by their case folded completion names,
+ * so the nicks starting with a prefix are found by binary search instead
+ * of by testing every nick.
+ *
+ * The completion name is the nickname, or the part after the first
+ * prefix character if it contains one. A second array sorted by the names
+ * without their leading non-alphanumeric characters serves the completion
+ * mode that skips those.
+ */
+class NickCompletionIndex
+{
+    public:
+        /// Indexes @p nick, currently called @p nickname, anew.
+        void insert(Nick* nick, const QString& nickname);
+        void remove(Nick* nick);
+        void clear();
+
+        /**
+         * Returns the nicks whose completion name starts with @p pattern,
+         * in no particular order. With @p skipNonAlfaNum and a pattern
+         * starting with a word character, leading characters other than
+         * letters and digits of the names are skipped.
+         */
+        QList<Nick*> nicksStartingWith(const QString& pattern, bool skipNonAlfaNum, bool caseSensitive);
+
+    private:
+        struct Entry
+        {
+            QString key;
+            Nick* nick;
+        };
+
+        static void insertEntry(QList<Entry>& entries, const QString& key, Nick* nick);
+        static void removeEntry(QList<Entry>& entries, const QString& key, Nick* nick);
+        /// Adds the nicks of @p entries whose key starts with @p key.
+        void collect(const QList<Entry>& entries, const QString& key, const QString& pattern,
+                     bool stripped, Qt::CaseSensitivity cs, QList<Nick*>& nicks) const;
+
+        QString completionName(const QString& nickname) const;
+        /// Re-indexes all nicks if the prefix character preference changed.
+        void updatePrefixCharacter();
+
+    private:
+        QList<Entry> m_byName;
+        QList<Entry> m_byStrippedName;
+        /// The completion name each nick is indexed under.
+        QHash<Nick*, QString> m_names;
+        /// The nickname each nick was indexed with.
+        QHash<Nick*, QString> m_nicknames;
+        QString m_prefixCharacter;
+};
+
+#endif
@@ -301,8 +301,10 @@ void Query::indicateAway(bool show)
 }
 
 // fix QTs broken behavior on hidden QListView pages
-void Query::showEvent(QShowEvent*)
+void Query::showEvent(QShowEvent* event)
 {
+    ChatWindow::showEvent(event);
+
     if(awayChanged)
     {
         awayChanged=false;
@@ -0,0 +1,230 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "rawlogbuffer.h"
+
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QRegularExpression>
+
+#include <cstring>
+
+namespace Konversation
+{
+    static const char captureMagic[] = "KVRAWCAP";
+    static const quint32 captureVersion = 1;
+
+    /// The next space separated word of @p line from @p pos on.
+    static QByteArrayView nextWord(const QByteArray& line, qsizetype& pos)
+    {
+        while (pos < line.size() && line.at(pos) == ' ')
+            ++pos;
+
+        const qsizetype start = pos;
+
+        while (pos < line.size() && line.at(pos) != ' ' && line.at(pos) != '\r' && line.at(pos) != '\n')
+            ++pos;
+
+        return QByteArrayView(line).sliced(start, pos - start);
+    }
+
+    void RawLogFilter::setCommands(const QString& commands)
+    {
+        m_commands.clear();
+
+        static const QRegularExpression separators(QStringLiteral("[\\s,]+"));
+        const QStringList list = commands.split(separators, Qt::SkipEmptyParts);
+
+        for (const QString& command : list)
+            m_commands.append(command.toUtf8().toUpper());
+    }
+
+    void RawLogFilter::setTarget(const QString& target)
+    {
+        m_target = target.trimmed().toUtf8().toLower();
+    }
+
+    bool RawLogFilter::matches(const QByteArray& line) const
+    {
+        if (isEmpty())
+            return true;
+
+        qsizetype pos = 0;
+        QByteArrayView word = nextWord(line, pos);
+
+        // message tags and source come before the command
+        if (word.startsWith('@'))
+            word = nextWord(line, pos);
+        if (word.startsWith(':'))
+            word = nextWord(line, pos);
+
+        if (!m_commands.isEmpty())
+        {
+            bool found = false;
+
+            for (const QByteArray& command : m_commands)
+            {
+                if (word.compare(command, Qt::CaseInsensitive) == 0)
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+                return false;
+        }
+
+        if (!m_target.isEmpty())
+        {
+            QByteArrayView target = nextWord(line, pos);
+
+            if (target.startsWith(':'))
+                target = target.sliced(1);
+
+            if (target.compare(m_target, Qt::CaseInsensitive) != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    RawLogBuffer::RawLogBuffer()
+        : m_first(0)
+        , m_count(0)
+        , m_bytes(0)
+    {
+        m_records.resize(MaxRecords);
+        m_captureStream.setVersion(QDataStream::Qt_6_0);
+    }
+
+    RawLogBuffer::~RawLogBuffer()
+    {
+        stopCapture();
+    }
+
+    void RawLogBuffer::append(bool outbound, const QByteArray& message)
+    {
+        append(RawLogRecord { QDateTime::currentMSecsSinceEpoch(), outbound, message });
+    }
+
+    void RawLogBuffer::append(const RawLogRecord& record)
+    {
+        if (m_count == MaxRecords)
+            removeFirst();
+
+        m_records[(m_first + m_count) % MaxRecords] = record;
+        ++m_count;
+        m_bytes += record.message.size();
+
+        while (m_bytes > MaxBytes && m_count > 1)
+            removeFirst();
+
+        if (isCapturing())
+        {
+            m_captureStream << record.time << quint8(record.outbound ? 1 : 0) << record.message;
+
+            if (m_captureStream.status() != QDataStream::Ok)
+                stopCapture();
+        }
+    }
+
+    void RawLogBuffer::removeFirst()
+    {
+        m_bytes -= m_records.at(m_first).message.size();
+        // drop the reference to the line, the slot stays
+        m_records[m_first].message = QByteArray();
+        m_first = (m_first + 1) % MaxRecords;
+        --m_count;
+    }
+
+    void RawLogBuffer::clear()
+    {
+        while (m_count > 0)
+            removeFirst();
+
+        m_first = 0;
+    }
+
+    bool RawLogBuffer::startCapture(const QString& fileName, QString& errorString)
+    {
+        stopCapture();
+
+        m_captureFile.setFileName(fileName);
+
+        if (!m_captureFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            errorString = m_captureFile.errorString();
+            return false;
+        }
+
+        m_captureStream.setDevice(&m_captureFile);
+        m_captureStream.resetStatus();
+        m_captureStream.writeRawData(captureMagic, sizeof(captureMagic) - 1);
+        m_captureStream << captureVersion;
+
+        return true;
+    }
+
+    void RawLogBuffer::stopCapture()
+    {
+        if (!isCapturing())
+            return;
+
+        m_captureStream.setDevice(nullptr);
+        m_captureFile.close();
+    }
+
+    bool RawLogBuffer::readCapture(const QString& fileName, QList<RawLogRecord>& records, QString& errorString)
+    {
+        QFile file(fileName);
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            errorString = file.errorString();
+            return false;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+
+        char magic[sizeof(captureMagic) - 1];
+        quint32 version = 0;
+
+        if (stream.readRawData(magic, sizeof(magic)) != int(sizeof(magic))
+            || std::memcmp(magic, captureMagic, sizeof(magic)) != 0)
+        {
+            errorString = i18n("The file is not a raw log capture.");
+            return false;
+        }
+
+        stream >> version;
+
+        if (version != captureVersion)
+        {
+            errorString = i18n("The raw log capture has the unsupported version %1.", version);
+            return false;
+        }
+
+        while (!stream.atEnd())
+        {
+            RawLogRecord record;
+            quint8 direction = 0;
+
+            stream >> record.time >> direction >> record.message;
+
+            // the capture may have been cut short while it was written
+            if (stream.status() != QDataStream::Ok)
+                break;
+
+            record.outbound = (direction == 1);
+            records.append(record);
+        }
+
+        return true;
+    }
+}
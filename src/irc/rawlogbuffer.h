@@ -0,0 +1,100 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef RAWLOGBUFFER_H
+#define RAWLOGBUFFER_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+namespace Konversation
+{
+    /// A line sent to or received from the server, as recorded by RawLogBuffer.
+    struct RawLogRecord
+    {
+        /// milliseconds since the epoch, UTC
+        qint64 time = 0;
+        bool outbound = false;
+        QByteArray message;
+    };
+
+    /**
+     * Selects raw lines by their command and target, the first parameter.
+     * Empty criteria match every line.
+     */
+    class RawLogFilter
+    {
+        public:
+            /// Sets the commands to match from a list separated by spaces or commas.
+            void setCommands(const QString& commands);
+            void setTarget(const QString& target);
+
+            bool isEmpty() const { return m_commands.isEmpty() && m_target.isEmpty(); }
+            bool matches(const QByteArray& line) const;
+
+        private:
+            /// upper case
+            QList<QByteArray> m_commands;
+            /// lower case
+            QByteArray m_target;
+    };
+
+    /**
+     * The most recent raw lines of a connection in a ring of fixed size,
+     * optionally also streamed to a capture file.
+     *
+     * A capture file starts with the 8 bytes "KVRAWCAP" and a quint32 format
+     * version, followed by one record after another: a qint64 time, a quint8
+     * direction (0 inbound, 1 outbound) and the line as a QByteArray, all in
+     * QDataStream encoding.
+     */
+    class RawLogBuffer
+    {
+        public:
+            static const int MaxRecords = 10000;
+            static const qsizetype MaxBytes = 4 * 1024 * 1024;
+
+            RawLogBuffer();
+            ~RawLogBuffer();
+
+            /// Records @p message with the current time.
+            void append(bool outbound, const QByteArray& message);
+            void append(const RawLogRecord& record);
+
+            int count() const { return m_count; }
+            /// The record @p index, the oldest one being 0.
+            const RawLogRecord& at(int index) const { return m_records.at((m_first + index) % MaxRecords); }
+            void clear();
+
+            bool startCapture(const QString& fileName, QString& errorString);
+            void stopCapture();
+            bool isCapturing() const { return m_captureFile.isOpen(); }
+            QString captureFileName() const { return m_captureFile.fileName(); }
+
+            /// Reads the records of a capture file written by startCapture().
+            static bool readCapture(const QString& fileName, QList<RawLogRecord>& records, QString& errorString);
+
+        private:
+            void removeFirst();
+
+        private:
+            /// MaxRecords slots, m_count of them used from m_first on
+            QList<RawLogRecord> m_records;
+            int m_first;
+            int m_count;
+            qsizetype m_bytes;
+
+            QFile m_captureFile;
+            QDataStream m_captureStream;
+
+            Q_DISABLE_COPY(RawLogBuffer)
+    };
+}
+
+#endif
@@ -31,9 +31,14 @@
 #include "channellistpanel.h"
 #include "scriptlauncher.h"
 #include "serverison.h"
+#include "connectionracer.h"
+#include "incomingworker.h"
+#include "sslcache.h"
 #include "notificationhandler.h"
+#include "pipelinestats.h"
 #include "awaymanager.h"
 #include "ircinput.h"
+#include "ircview.h"
 #include "konversation_log.h"
 
 #include <KLocalizedString>
@@ -46,6 +51,7 @@
 #include <QInputDialog>
 #include <QNetworkProxy>
 #include <QSslKey>
+#include <QThread>
 
 using namespace Konversation;
 
@@ -64,10 +70,28 @@ Server::Server(QObject* parent, ConnectionSettings& settings) : QObject(parent)
 
     m_delayedConnectTimer = new QTimer(this);
     m_delayedConnectTimer->setSingleShot(true);
-    connect(m_delayedConnectTimer, &QTimer::timeout, this, &Server::connectToIRCServer);
+    connect(m_delayedConnectTimer, &QTimer::timeout, this, [this]() { Q_EMIT scheduledConnectDue(this); });
 
     m_reconnectImmediately = false;
 
+    m_connectionRacer = new Konversation::ConnectionRacer([this](QSslSocket* socket, const Konversation::ServerSettings& server) {
+        setupSocket(socket, server);
+    }, this);
+    connect(m_connectionRacer, &Konversation::ConnectionRacer::hostFound, this, &Server::hostFound);
+    connect(m_connectionRacer, &Konversation::ConnectionRacer::connected, this, &Server::raceConnected);
+    connect(m_connectionRacer, &Konversation::ConnectionRacer::sslErrors, this, &Server::raceSslErrors);
+    connect(m_connectionRacer, &Konversation::ConnectionRacer::failed, this, &Server::raceFailed);
+
+    // reading the socket is left to the main thread, everything up to handling the lines is not;
+    // the thread only runs while connecting or connected
+    m_incomingThread = new QThread(this);
+    m_incomingThread->setObjectName(QLatin1String("incoming_") + m_connectionSettings.name());
+    m_incomingWorker = new Konversation::IncomingWorker();
+    m_incomingWorker->moveToThread(m_incomingThread);
+    connect(m_incomingWorker, &Konversation::IncomingWorker::linesReady, this, &Server::incomingLines);
+    m_incomingGeneration = 0;
+    m_incomingSettingsDirty = true;
+
     for (int i=0; i <= Application::instance()->countOfQueues(); i++)
     {
         //QList<int> r=Preferences::queueRate(i);
@@ -76,6 +100,7 @@ Server::Server(QObject* parent, ConnectionSettings& settings) : QObject(parent)
     }
 
     m_processingIncoming = false;
+    m_playback = false;
     m_identifyMsg = false;
     m_capRequested = 0;
     m_capAnswered = 0;
@@ -112,6 +137,7 @@ Server::Server(QObject* parent, ConnectionSettings& settings) : QObject(parent)
     m_modesCount = 3;
     m_sslErrorLock = false;
     m_topicLength = -1;
+    m_chatHistoryLimit = 0;
 
     setObjectName(QLatin1String("server_") + m_connectionSettings.name());
 
@@ -171,6 +197,10 @@ Server::~Server()
         m_socket->deleteLater();
     }
 
+    m_incomingThread->quit();
+    m_incomingThread->wait();
+    delete m_incomingWorker;
+
     delete m_statusView;
 
     closeRawLog();
@@ -456,6 +486,9 @@ void Server::connectToIRCServer()
 
         resetQueues();
 
+        if (!m_incomingThread->isRunning())
+            m_incomingThread->start();
+
         // This is needed to support server groups with mixed SSL and nonSSL servers
         delete m_socket;
         m_socket = nullptr;
@@ -463,71 +496,29 @@ void Server::connectToIRCServer()
             m_nickListModel->setStringList(getIdentity()->getNicknameList());
         resetNickSelection();
 
-        m_socket = new QSslSocket();
-        m_socket->setObjectName(QStringLiteral("serverSocket"));
-
-        connect(m_socket, &QAbstractSocket::errorOccurred,
-                this, &Server::broken);
-
-        connect(m_socket, &QIODevice::readyRead, this, &Server::incoming);
-        connect(m_socket, &QAbstractSocket::disconnected, this, &Server::closed);
-        connect(m_socket, &QAbstractSocket::hostFound, this, &Server::hostFound);
-
         getStatusView()->appendServerMessage(i18n("Info"),i18n("Looking for server %1 (port %2)...",
             getConnectionSettings().server().host(),
             QString::number(getConnectionSettings().server().port())));
 
-        if(getConnectionSettings().server().bypassProxy()) {
-            m_socket->setProxy(QNetworkProxy::NoProxy);
-        }
+        // The other servers of the group race the chosen one, which gets a head start.
+        // A proxy resolves host names itself, so there are no addresses to race through one.
+        Konversation::ServerList servers { getConnectionSettings().server() };
+        const bool useProxy = Preferences::self()->proxyEnabled() && !getConnectionSettings().server().bypassProxy();
 
-        // connect() will do a async lookup too
-        if (getConnectionSettings().server().SSLEnabled()
-            || getIdentity()->getAuthType() == QLatin1String("saslexternal")
-            || getIdentity()->getAuthType() == QLatin1String("pemclientcert"))
+        if (getConnectionSettings().serverGroup() && !Preferences::self()->proxyEnabled())
         {
-            connect(m_socket, &QSslSocket::encrypted, this, &Server::socketConnected);
-            connect(m_socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors),
-                    this, &Server::sslError);
+            const Konversation::ServerList groupServers = getConnectionSettings().serverGroup()->serverList();
+            const int index = groupServers.indexOf(servers.first());
 
-            if (getIdentity()->getAuthType() == QLatin1String("saslexternal")
-                || getIdentity()->getAuthType() == QLatin1String("pemclientcert"))
+            if (index != -1)
             {
-                m_socket->setLocalCertificate(getIdentity()->getPemClientCertFile().toLocalFile());
-                m_socket->setPrivateKey(getIdentity()->getPemClientCertFile().toLocalFile());
-
-                if (m_socket->privateKey().isNull())
-                {
-                    m_socket->setPrivateKey(getIdentity()->getPemClientCertFile().toLocalFile(), QSsl::Ec);
-                }
+                for (int i = 1; i < groupServers.size(); ++i)
+                    servers << groupServers.at((index + i) % groupServers.size());
             }
-
-            m_socket->setProtocol(QSsl::SecureProtocols);
-            // QIODevice::Unbuffered, see m_socket->connectToHost() call below
-            m_socket->connectToHostEncrypted(getConnectionSettings().server().host(),
-                                             getConnectionSettings().server().port(),
-                                             (QIODevice::ReadWrite | QIODevice::Unbuffered));
-        }
-        else
-        {
-            connect(m_socket, &QAbstractSocket::connected, this, &Server::socketConnected);
-            // TODO re-evaluate this, perhaps with a test case
-            // The comment below was added here in October of 2019, but it is a copy of
-            // a kdelibs commit from September 2008, describing Qt4 behavior.
-            // See https://invent.kde.org/unmaintained/kdelibs/-/commit/34a9fb1ca1a9e5442502f5baedffc8880ed8aa21
-            //
-            // From KTcpSocket::connectToHost():
-            // There are enough layers of buffers between us and the network, and there is a quirk
-            // in QIODevice that can make it try to readData() twice per read() call if buffered and
-            // reaData() does not deliver enough data the first time. Like when the other side is
-            // simply not sending any more data...
-            // This can *apparently* lead to long delays sometimes which stalls applications.
-            // Do not want.
-            m_socket->connectToHost(getConnectionSettings().server().host(),
-                                    getConnectionSettings().server().port(),
-                                    (QIODevice::ReadWrite | QIODevice::Unbuffered));
         }
 
+        m_connectionRacer->start(servers, usesClientCertificate(), !useProxy);
+
         // set up the connection details
         setPrefixes(m_serverNickPrefixModes, m_serverNickPrefixes);
         // reset InputFilter (auto request info, /WHO request info)
@@ -537,14 +528,112 @@ void Server::connectToIRCServer()
         qCDebug(KONVERSATION_LOG) << "connectToIRCServer() called while already connected: This should never happen. (" << (isConnecting() << 1) + isConnected() << ')';
 }
 
-void Server::connectToIRCServerIn(uint delay)
+void Server::connectToIRCServerIn(int msecs)
 {
-    m_delayedConnectTimer->setInterval(delay * 1000);
+    m_delayedConnectTimer->setInterval(msecs);
     m_delayedConnectTimer->start();
 
     updateConnectionState(Konversation::SSScheduledToConnect);
 }
 
+bool Server::usesClientCertificate() const
+{
+    return getIdentity()->getAuthType() == QLatin1String("saslexternal")
+        || getIdentity()->getAuthType() == QLatin1String("pemclientcert");
+}
+
+void Server::setupSocket(QSslSocket* socket, const Konversation::ServerSettings& server)
+{
+    socket->setObjectName(QStringLiteral("serverSocket"));
+
+    if (server.bypassProxy()) {
+        socket->setProxy(QNetworkProxy::NoProxy);
+    }
+
+    if (!server.SSLEnabled() && !usesClientCertificate())
+        return;
+
+    QSslConfiguration configuration = socket->sslConfiguration();
+    configuration.setProtocol(QSsl::SecureProtocols);
+
+    if (usesClientCertificate())
+    {
+        QSslCertificate certificate;
+        QSslKey key;
+
+        // parsed once per file rather than on every attempt
+        Konversation::SslCache::clientCertificate(getIdentity()->getPemClientCertFile().toLocalFile(), certificate, key);
+        configuration.setLocalCertificate(certificate);
+        configuration.setPrivateKey(key);
+    }
+
+    // resume the last session with the server instead of a full handshake
+    configuration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    configuration.setSessionTicket(Konversation::SslCache::sessionTicket(server.host(), server.port()));
+    socket->setSslConfiguration(configuration);
+
+    connect(socket, &QSslSocket::newSessionTicketReceived, this, [socket, server]() {
+        // a session whose certificate was only accepted by the user must not skip the check next time
+        if (!socket->sslHandshakeErrors().isEmpty())
+            return;
+
+        const QSslConfiguration configuration = socket->sslConfiguration();
+
+        Konversation::SslCache::setSessionTicket(server.host(), server.port(),
+                                                 configuration.sessionTicket(), configuration.sessionTicketLifeTimeHint());
+    });
+}
+
+void Server::adoptSocket(QSslSocket* socket, const Konversation::ServerSettings& server)
+{
+    delete m_socket;
+    m_socket = socket;
+
+    connect(m_socket, &QAbstractSocket::errorOccurred,
+            this, &Server::broken);
+
+    connect(m_socket, &QIODevice::readyRead, this, &Server::incoming);
+    connect(m_socket, &QAbstractSocket::disconnected, this, &Server::closed);
+
+    if (server.SSLEnabled() || usesClientCertificate())
+    {
+        connect(m_socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors),
+                this, &Server::sslError);
+    }
+
+    if (!(server == getConnectionSettings().server()))
+    {
+        qCDebug(KONVERSATION_LOG) << "Connection race won by" << server.host() << "over" << getConnectionSettings().server().host();
+
+        getConnectionSettings().setServer(server);
+    }
+}
+
+void Server::raceConnected(QSslSocket* socket, const Konversation::ServerSettings& server)
+{
+    adoptSocket(socket, server);
+
+    socketConnected();
+}
+
+void Server::raceSslErrors(QSslSocket* socket, const Konversation::ServerSettings& server, const QList<QSslError>& errors)
+{
+    Konversation::SslCache::removeSessionTicket(server.host(), server.port());
+
+    adoptSocket(socket, server);
+
+    connect(m_socket, &QSslSocket::encrypted, this, &Server::socketConnected);
+
+    handleSslErrors(socket, errors);
+}
+
+void Server::raceFailed(QSslSocket* socket)
+{
+    adoptSocket(socket, getConnectionSettings().server());
+
+    broken(socket->error());
+}
+
 void Server::showSSLDialog()
 {
         //TODO
@@ -696,6 +785,11 @@ void Server::hostFound()
 void Server::socketConnected()
 {
     Q_EMIT sslConnected(this);
+    m_connectTime = QDateTime::currentDateTimeUtc();
+    setPlayback(false);
+    m_chatHistoryLimit = 0;
+    m_historyRequests.clear();
+    m_historyExhausted.clear();
     getConnectionSettings().setReconnectCount(0);
 
     requestAvailableCapabilies();
@@ -914,6 +1008,8 @@ void Server::broken(QAbstractSocket::SocketError error)
 
     resetQueues();
 
+    stopIncoming();
+
     m_notifyTimer.stop();
     m_pingSendTimer.stop();
     m_pingResponseTimer.stop();
@@ -986,8 +1082,11 @@ void Server::sslError(const QList<QSslError> &errors)
     // lest we might end up calling ignoreSslErrors() on a different
     // socket later if m_socket has started pointing at something
     // else.
-    QPointer<QSslSocket> socket = qobject_cast<QSslSocket *>(QObject::sender());
+    handleSslErrors(qobject_cast<QSslSocket *>(QObject::sender()), errors);
+}
 
+void Server::handleSslErrors(QPointer<QSslSocket> socket, const QList<QSslError> &errors)
+{
     m_sslErrorLock = true;
     KSslErrorUiData uiData(socket);
     bool ignoreSslErrors = KIO::SslUi::askIgnoreSslErrors(uiData, KIO::SslUi::RecallAndStoreRules);
@@ -1097,6 +1196,7 @@ QByteArray Server::getKeyForRecipient(const QString& recipient) const
 void Server::setKeyForRecipient(const QString& recipient, const QByteArray& key)
 {
     m_keyHash[recipient.toLower()] = key;
+    m_incomingSettingsDirty = true;
 }
 
 void Server::gotOwnResolvedHostByWelcome(const QHostInfo& res)
@@ -1149,6 +1249,8 @@ void Server::disconnectServer(const QString& quitMessage)
     {
         m_delayedConnectTimer->stop();
         getStatusView()->appendServerMessage(i18n("Info"), i18n("Delayed connect aborted."));
+        // also takes it out of the ReconnectScheduler's queue
+        updateConnectionState(Konversation::SSDeliberatelyDisconnected);
     }
 
     if (isSocketConnected()) quitServer(quitMessage);
@@ -1161,6 +1263,22 @@ void Server::quitServer(const QString& quitMessage)
     // a QUIT).
     updateConnectionState(Konversation::SSDeliberatelyDisconnected);
 
+    if (m_connectionRacer->isRunning())
+    {
+        // nothing to send the QUIT over yet
+        m_connectionRacer->abort();
+        stopIncoming();
+
+        if (m_reconnectImmediately)
+        {
+            m_reconnectImmediately = false;
+
+            QMetaObject::invokeMethod(this, "connectToIRCServer", Qt::QueuedConnection);
+        }
+
+        return;
+    }
+
     if (!m_socket) return;
 
     QString toServer = QStringLiteral("QUIT :");
@@ -1349,199 +1467,209 @@ void Server::processIncomingData()
     if (!m_inputBuffer.isEmpty() && !m_processingIncoming)
     {
         m_processingIncoming = true;
-        QString front(m_inputBuffer.front());
-        m_inputBuffer.pop_front();
-        m_inputFilter.parseLine(front);
+        PipelineStats::addQueueDepth(PipelineStats::InputBuffer, m_inputBuffer.size());
+
+        // Live lines are handled one per event loop pass, played back ones
+        // come by the thousand and go in slices.
+        QElapsedTimer slice;
+        slice.start();
+
+        do
+        {
+            Konversation::IncomingWorker::Line line = m_inputBuffer.takeFirst();
+
+            if (line.undecoded.isEmpty())
+                m_inputFilter.parseMessage(line.message);
+            else
+            {
+                const QString text = decodeIncoming(line.undecoded, line.channelKey);
+
+                if (!text.isEmpty())
+                    m_inputFilter.parseLine(text);
+            }
+        }
+        while (m_playback && !m_inputBuffer.isEmpty() && slice.elapsed() < PlaybackSlice);
+
         m_processingIncoming = false;
 
-        if (!m_inputBuffer.isEmpty()) m_incomingTimer.start(0);
+        if (!m_inputBuffer.isEmpty())
+            m_incomingTimer.start(0);
+        else
+            setPlayback(false);
     }
 }
 
-void Server::incoming()
+void Server::setPlayback(bool playback)
 {
-    //if (getConnectionSettings().server().SSLEnabled())
-    //    Q_EMIT sslConnected(this);
+    if (m_playback == playback)
+        return;
 
+    m_playback = playback;
 
-    //if (len <= 0 && getConnectionSettings().server().SSLEnabled())
-    //    return;
+    if (!playback)
+        Q_EMIT playbackFinished();
+}
 
-    // split buffer to lines
-    QList<QByteArray> bufferLines;
-    while (m_socket->bytesAvailable())
-    {
-        m_lineBuffer += m_socket->readLine();
+void Server::requestHistoryBefore(const QString& target, const QDateTime& before)
+{
+    if (!isConnected() || !m_capabilities.testFlag(ChatHistory) || !before.isValid())
+        return;
 
-        if(m_lineBuffer.endsWith('\n') || m_lineBuffer.endsWith('\r'))
-        {
-            //remove \n blowfish doesn't like it
-            int i = m_lineBuffer.size()-1;
-            while (i >= 0 && (m_lineBuffer[i]=='\n' || m_lineBuffer[i]=='\r')) // since euIRC gets away with sending just \r, bet someone sends \n\r?
-            {
-                i--;
-            }
-            m_lineBuffer.truncate(i+1);
+    const QString lowerTarget = target.toLower();
 
-            if (!m_lineBuffer.isEmpty())
-                bufferLines.append(m_lineBuffer);
+    if (m_historyExhausted.contains(lowerTarget))
+        return;
 
-            m_lineBuffer.clear();
-        }
-    }
+    // a request the server never answered does not block the target for good
+    auto pending = m_historyRequests.constFind(lowerTarget);
 
-    while(!bufferLines.isEmpty())
-    {
-        // Pre parsing is needed in case encryption/decryption is needed
-        // BEGIN set channel encoding if specified
-        QString senderNick;
-        bool isServerMessage = false;
-        QString channelKey;
-        QTextCodec* codec = getIdentity()->getCodec();
-        QByteArray first = bufferLines.first();
+    if (pending != m_historyRequests.constEnd() && !pending->hasExpired(HistoryTimeout))
+        return;
 
-        bufferLines.removeFirst();
+    const int limit = (m_chatHistoryLimit > 0) ? qMin(m_chatHistoryLimit, 100) : 100;
 
-        QStringList lineSplit = codec->toUnicode(first).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    QElapsedTimer requested;
+    requested.start();
 
-        if (lineSplit.count() >= 1)
-        {
-            if (lineSplit[0][0] == QLatin1Char(':'))          // does this message have a prefix?
-            {
-                if(!lineSplit[0].contains(QLatin1Char('!'))) // is this a server(global) message?
-                    isServerMessage = true;
-                else
-                    senderNick = lineSplit[0].mid(1, lineSplit[0].indexOf(QLatin1Char('!'))-1);
+    m_historyRequests.insert(lowerTarget, requested);
+    queue(QStringLiteral("CHATHISTORY BEFORE %1 timestamp=%2 %3")
+              .arg(target, before.toUTC().toString(Qt::ISODateWithMs), QString::number(limit)), LowPriority);
+}
 
-                lineSplit.removeFirst();          // remove prefix
-            }
-        }
+bool Server::isHistoryRequested(const QString& target) const
+{
+    return m_historyRequests.contains(target.toLower());
+}
 
-        if (lineSplit.isEmpty())
-            continue;
+void Server::historyReceived(const QString& target, const QList<Konversation::HistoryLine>& lines)
+{
+    const QString lowerTarget = target.toLower();
 
-        // BEGIN pre-parse to know where the message belongs to
-        QString command = lineSplit[0].toLower();
-        if( isServerMessage )
-        {
-            if( lineSplit.count() >= 3 )
-            {
-                if( command == QLatin1String("332") )            // RPL_TOPIC
-                    channelKey = lineSplit[2];
-                if( command == QLatin1String("372") )            // RPL_MOTD
-                    channelKey = QStringLiteral(":server");
-            }
-        }
-        else                                      // NOT a global message
+    m_historyRequests.remove(lowerTarget);
+
+    if (lines.isEmpty())
+    {
+        m_historyExhausted.insert(lowerTarget);
+        return;
+    }
+
+    ChatWindow* window = getChannelByName(target);
+
+    if (!window)
+        window = getQueryByName(target);
+
+    if (window && window->getTextView())
+        window->getTextView()->prependHistory(lines);
+}
+
+void Server::historyFailed(const QStringList& context)
+{
+    // e.g. "BEFORE #channel", but the context is up to the server
+    QString failed;
+
+    for (const QString& parameter : context)
+    {
+        if (m_historyRequests.contains(parameter.toLower()))
         {
-            if( lineSplit.count() >= 2 )
-            {
-                // query
-                if( ( command == QLatin1String("privmsg") ||
-                    command == QLatin1String("notice")  ) &&
-                    lineSplit[1] == getNickname() )
-                {
-                    channelKey = senderNick;
-                }
-                // channel message
-                else if( command == QLatin1String("privmsg") ||
-                    command == QLatin1String("notice")  ||
-                    command == QLatin1String("join")    ||
-                    command == QLatin1String("kick")    ||
-                    command == QLatin1String("part")    ||
-                    command == QLatin1String("topic")   )
-                {
-                    channelKey = lineSplit[1];
-                }
-            }
+            failed = parameter.toLower();
+            break;
         }
-        // END pre-parse to know where the message belongs to
-        // Decrypt if necessary
+    }
 
-        //send to raw log before decryption
-        if (m_rawLog)
-            m_rawLog->appendRaw(RawLog::Inbound, first);
+    // without a target only a single pending request is known to have failed
+    if (failed.isEmpty() && m_historyRequests.size() == 1)
+        failed = m_historyRequests.constBegin().key();
 
-        #if HAVE_QCA2
-        QByteArray cKey = getKeyForRecipient(channelKey);
-        if(!cKey.isEmpty())
-        {
-            if(command == QLatin1String("privmsg"))
-            {
-                //only send encrypted text to decrypter
-                int index = first.indexOf(":",first.indexOf(":")+1);
-                if(this->identifyMsgEnabled()) // Workaround braindead Freenode prefixing messages with +
-                    ++index;
-                QByteArray backup = first.mid(0,index+1);
-
-                if(getChannelByName(channelKey) && getChannelByName(channelKey)->getCipher()->setKey(cKey))
-                    first = getChannelByName(channelKey)->getCipher()->decrypt(first.mid(index+1));
-                else if(getQueryByName(channelKey) && getQueryByName(channelKey)->getCipher()->setKey(cKey))
-                    first = getQueryByName(channelKey)->getCipher()->decrypt(first.mid(index+1));
-
-                first.prepend(backup);
-            }
-            else if(command == QLatin1String("332") || command == QLatin1String("topic"))
-            {
-                //only send encrypted text to decrypter
-                int index = first.indexOf(":",first.indexOf(":")+1);
-                QByteArray backup = first.mid(0,index+1);
+    if (failed.isEmpty())
+        return;
 
-                if(getChannelByName(channelKey) && getChannelByName(channelKey)->getCipher()->setKey(cKey))
-                    first = getChannelByName(channelKey)->getCipher()->decryptTopic(first.mid(index+1));
-                else if(getQueryByName(channelKey) && getQueryByName(channelKey)->getCipher()->setKey(cKey))
-                    first = getQueryByName(channelKey)->getCipher()->decryptTopic(first.mid(index+1));
+    m_historyRequests.remove(failed);
+    m_historyExhausted.insert(failed);
+}
 
-                first.prepend(backup);
-            }
-        }
-        #endif
-        bool isUtf8 = Konversation::isUtf8(first);
+void Server::incoming()
+{
+    // changes to the identity and the preferences are not announced, look for them here
+    const bool cbc = Preferences::self()->encryptionType();
 
-        QString encoded;
+    if (m_incomingSettingsDirty || m_incomingSettings.codec != getIdentity()->getCodec() || m_incomingSettings.cbc != cbc)
+        updateIncomingSettings();
 
-        if (isUtf8)
-            encoded = QString::fromUtf8(first);
-        else
-        {
-            // check setting
-            QString channelEncoding;
-            if( !channelKey.isEmpty() )
-            {
-                if(getServerGroup())
-                    channelEncoding = Preferences::channelEncoding(getServerGroup()->id(), channelKey);
-                else
-                    channelEncoding = Preferences::channelEncoding(getDisplayName(), channelKey);
-            }
-            // END set channel encoding if specified
+    // framing, decryption, decoding and parsing happen on the worker's thread
+    const QByteArray data = m_socket->readAll();
+
+    if (!data.isEmpty())
+        m_incomingWorker->addData(m_incomingGeneration, data);
+}
 
-            if( !channelEncoding.isEmpty() )
-                codec = Konversation::IRCCharsets::self()->codecForName(channelEncoding);
+void Server::updateIncomingSettings()
+{
+    m_incomingSettings.codec = getIdentity()->getCodec();
+    m_incomingSettings.nickname = getNickname();
+    m_incomingSettings.identifyMsg = m_identifyMsg;
+    m_incomingSettings.keys = m_keyHash;
+    m_incomingSettings.cbc = Preferences::self()->encryptionType();
+    m_incomingSettingsDirty = false;
 
-            // if channel encoding is utf-8 and the string is definitely not utf-8
-            // then try latin-1
-            if (codec->mibEnum() == 106)
-                codec = QTextCodec::codecForMib( 4 /* iso-8859-1 */ );
+    m_incomingWorker->setSettings(m_incomingSettings);
+}
 
-            encoded = codec->toUnicode(first);
-        }
+void Server::incomingLines()
+{
+    const QList<Konversation::IncomingWorker::Line> lines = m_incomingWorker->takeLines();
+
+    for (const Konversation::IncomingWorker::Line& line : lines)
+    {
+        // of a connection gone
+        if (line.generation != m_incomingGeneration)
+            continue;
 
-        // Qt uses 0xFDD0 and 0xFDD1 to mark the beginning and end of text frames. Remove
-        // these here to avoid fatal errors encountered in QText* and the event loop pro-
-        // cessing.
-        sterilizeUnicode(encoded);
+        //send to raw log before decryption
+        if (m_rawLog)
+            m_rawLog->appendRaw(RawLog::Inbound, line.raw);
 
-        if (!encoded.isEmpty())
-            m_inputBuffer << encoded;
+        if (line.decodeTime >= 0)
+            PipelineStats::addTime(PipelineStats::Decode, line.decodeTime);
+        if (line.parseTime >= 0)
+            PipelineStats::addTime(PipelineStats::Parse, line.parseTime);
 
-        //FIXME: This has nothing to do with bytes, and it's not raw received bytes either. Bogus number.
-        //m_bytesReceived+=m_inputBuffer.back().length();
+        m_inputBuffer << line;
     }
 
-    if( !m_incomingTimer.isActive() && !m_processingIncoming )
+    if( !m_inputBuffer.isEmpty() && !m_incomingTimer.isActive() && !m_processingIncoming )
         m_incomingTimer.start(0);
 }
 
+QString Server::decodeIncoming(const QByteArray& line, const QString& channelKey) const
+{
+    QTextCodec* codec = getIdentity()->getCodec();
+
+    // check setting
+    QString channelEncoding;
+    if( !channelKey.isEmpty() )
+    {
+        if(getServerGroup())
+            channelEncoding = Preferences::channelEncoding(getServerGroup()->id(), channelKey);
+        else
+            channelEncoding = Preferences::channelEncoding(getDisplayName(), channelKey);
+    }
+    // END set channel encoding if specified
+
+    if( !channelEncoding.isEmpty() )
+        codec = Konversation::IRCCharsets::self()->codecForName(channelEncoding);
+
+    // if channel encoding is utf-8 and the string is definitely not utf-8
+    // then try latin-1
+    if (codec->mibEnum() == 106)
+        codec = QTextCodec::codecForMib( 4 /* iso-8859-1 */ );
+
+    QString encoded = codec->toUnicode(line);
+
+    sterilizeUnicode(encoded);
+
+    return encoded;
+}
+
 /** Calculate how long this message premable will be.
 
     This is necessary because the irc server will clip messages so that the
@@ -1664,10 +1792,8 @@ int Server::_send_internal(QString outputLine)
                 {
                     QString target = outputLineSplit.at(1);
 
-                    if(getChannelByName(target) && getChannelByName(target)->getCipher()->setKey(cipherKey))
-                        getChannelByName(target)->getCipher()->encrypt(payload);
-                    else if(getQueryByName(target) && getQueryByName(target)->getCipher()->setKey(cipherKey))
-                        getQueryByName(target)->getCipher()->encrypt(payload);
+                    if (Konversation::Cipher* cipher = getCipherForRecipient(target, cipherKey))
+                        cipher->encrypt(payload);
 
                     encoded = outputLineSplit.at(0).toLatin1();
                     qCDebug(KONVERSATION_LOG) << payload << "\n" << payload.data();
@@ -1739,10 +1865,19 @@ void Server::resetQueues()
 {
     m_incomingTimer.stop();
     m_inputBuffer.clear();
+    // drops what the worker has of the connection
+    ++m_incomingGeneration;
     for (int i=0; i <= Application::instance()->countOfQueues(); i++)
         m_queues[i]->reset();
 }
 
+void Server::stopIncoming()
+{
+    // what the worker still has is of the connection gone, and dropped by the next
+    m_incomingThread->quit();
+    m_incomingThread->wait();
+}
+
 //this could flood you off, but you're leaving anyway...
 void Server::flushQueues()
 {
@@ -1809,6 +1944,65 @@ void Server::dbusSay(const QString& target,const QString& command)
     }
 }
 
+int Server::dbusSendMessages(const QString& target, const QStringList& messages)
+{
+    if (!isConnected())
+        return 0;
+
+    Channel* channel = nullptr;
+    Query* query = nullptr;
+
+    if (isAChannel(target))
+    {
+        channel = getChannelByName(target);
+
+        if (!channel || !channel->isJoined())
+            return 0;
+    }
+    else
+    {
+        query = getQueryByName(target);
+
+        if (!query)
+            query = addQuery(obtainNickInfo(target), true);
+
+        if (!query)
+            return 0;
+    }
+
+    // Plain text, so no command, alias or variable parsing, and all
+    // lines go to the queue at once
+    static const QRegularExpression newLines(QStringLiteral("[\r\n]+"));
+    const int preLength = getPreLength(QStringLiteral("PRIVMSG"), target);
+    const QString prefix = QLatin1String("PRIVMSG ") + target + QLatin1String(" :");
+    QStringList toServer;
+
+    for (const QString& message : messages)
+    {
+        const QStringList lines = message.split(newLines, Qt::SkipEmptyParts);
+
+        for (const QString& line : lines)
+        {
+            const QStringList parts = m_outputFilter->splitForEncoding(target, line, preLength);
+
+            for (const QString& part : parts)
+            {
+                if (channel)
+                    channel->append(getNickname(), part);
+                else
+                    query->appendQuery(getNickname(), part);
+
+                toServer.append(prefix + part);
+            }
+        }
+    }
+
+    if (!queueList(toServer))
+        return 0;
+
+    return toServer.count();
+}
+
 void Server::dbusInfo(const QString& string)
 {
     appendMessageToFrontmost(i18n("D-Bus"),string);
@@ -1977,6 +2171,9 @@ bool Server::isNickOnline(const QString &nickname) const
 
 QString Server::getOwnIpByNetworkInterface() const
 {
+    if (!m_socket)
+        return QString();
+
     return m_socket->localAddress().toString();
 }
 
@@ -3035,6 +3232,8 @@ void Server::queueNicks(const QString& channelName, const QStringList& nicknameL
 // Returns the NickInfo for the nickname.
 ChannelNickPtr Server::addNickToJoinedChannelsList(const QString& channelName, const QString& nickname)
 {
+    PipelineTimer timer(PipelineStats::NickModel);
+
     bool doChannelJoinedSignal = false;
     bool doWatchedNickChangedSignal = false;
     bool doChannelMembersChangedSignal = false;
@@ -3248,6 +3447,8 @@ bool Server::deleteNickIfUnlisted(const QString &nickname)
  */
 void Server::removeChannelNick(const QString& channelName, const QString& nickname)
 {
+    PipelineTimer timer(PipelineStats::NickModel);
+
     bool doSignal = false;
     bool joined = false;
     QString lcChannelName = channelName.toLower();
@@ -3392,6 +3593,8 @@ void Server::removeJoinedChannel(const QString& channelName)
 // Returns pointer to the NickInfo object or 0 if nick not found.
 void Server::renameNickInfo(NickInfoPtr nickInfo, const QString& newname)
 {
+    PipelineTimer timer(PipelineStats::NickModel);
+
     if (nickInfo)
     {
         // Get existing lowercase nickname and rename nickname in the NickInfo object.
@@ -3571,6 +3774,7 @@ void Server::renameNick(const QString &nickname, const QString &newNick, const Q
     {
         setKeyForRecipient(newNick, userKey);
         m_keyHash.remove(nickname.toLower());
+        m_incomingSettingsDirty = true;
     }
     #endif
 
@@ -3638,6 +3842,7 @@ void Server::setNickname(const QString &newNickname)
 {
     m_nickname = newNickname;
     m_loweredNickname = newNickname.toLower();
+    m_incomingSettingsDirty = true;
     if (!m_nickListModel->stringList().contains(newNickname)) {
         m_nickListModel->insertRows(m_nickListModel->rowCount(), 1);
         m_nickListModel->setData(m_nickListModel->index(m_nickListModel->rowCount() -1 , 0), newNickname, Qt::DisplayRole);
@@ -4175,6 +4380,7 @@ void Server::startAwayTimer()
 void Server::enableIdentifyMsg(bool enabled)
 {
     m_identifyMsg = enabled;
+    m_incomingSettingsDirty = true;
 }
 
 bool Server::identifyMsgEnabled()
@@ -4257,6 +4463,22 @@ void Server::updateEncoding()
 }
 
 #if HAVE_QCA2
+Konversation::Cipher* Server::getCipherForRecipient(const QString& recipient, const QByteArray& key) const
+{
+    Konversation::Cipher* cipher = nullptr;
+
+    if (Channel* channel = getChannelByName(recipient))
+        cipher = channel->getCipher();
+    else if (Query* query = getQueryByName(recipient))
+        cipher = query->getCipher();
+
+    // setKey() keeps the cipher's key schedules while the key stays the same
+    if (cipher && cipher->setKey(key))
+        return cipher;
+
+    return nullptr;
+}
+
 void Server::initKeyExchange(const QString &receiver)
 {
     Query* query;
@@ -4408,6 +4630,16 @@ void Server::sendChannelNickChangedSignals()
 
 void Server::involuntaryQuit()
 {
+    if (m_connectionState == Konversation::SSConnecting && !m_socket)
+    {
+        // still racing, there is no socket to quit over yet
+        m_connectionRacer->abort();
+        stopIncoming();
+        updateConnectionState(Konversation::SSInvoluntarilyDisconnected);
+
+        return;
+    }
+
     if((m_connectionState == Konversation::SSConnected || m_connectionState == Konversation::SSConnecting) &&
        (m_socket->peerAddress() != QHostAddress(QHostAddress::LocalHost) && m_socket->peerAddress() != QHostAddress(QHostAddress::LocalHostIPv6)))
     {
@@ -4418,8 +4650,9 @@ void Server::involuntaryQuit()
 
 void Server::reconnectInvoluntary()
 {
+    // Through the ReconnectScheduler, as all connections come back at once
     if(m_connectionState == Konversation::SSInvoluntarilyDisconnected)
-        reconnectServer();
+        connectToIRCServerIn(0);
 }
 
 void Server::initCapablityNames()
@@ -4436,6 +4669,10 @@ void Server::initCapablityNames()
         { QStringLiteral("znc.in/self-message"),    SelfMessage },
         { QStringLiteral("chghost"),                ChgHost },
         { QStringLiteral("cap-notify"),             CapNofify },
+        { QStringLiteral("batch"),                  Batch },
+        { QStringLiteral("draft/chathistory"),      ChatHistory },
+        { QStringLiteral("chathistory"),            ChatHistory },
+        { QStringLiteral("message-tags"),           MessageTags },
     };
 }
 
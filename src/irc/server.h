@@ -12,6 +12,7 @@
 #define SERVER_H
 
 #include "common.h"
+#include "chathistory.h"
 #include "channelnick.h"
 #include "inputfilter.h"
 #include "outputfilter.h"
@@ -21,15 +22,18 @@
 #include "connectionsettings.h"
 #include "statuspanel.h"
 #include "invitedialog.h"
+#include "incomingworker.h"
 #include <config-konversation.h>
 
 #if HAVE_QCA2
 #include "cipher.h"
 #endif
 
+#include <QDateTime>
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QPointer>
+#include <QSet>
 
 #include <QHostInfo>
 #include <QSslSocket>
@@ -40,6 +44,7 @@
 
 class QAbstractItemModel;
 class QStringListModel;
+class QThread;
 class Channel;
 class Query;
 class Identity;
@@ -58,6 +63,8 @@ namespace Konversation
         class Transfer;
         class Chat;
     }
+
+    class ConnectionRacer;
 }
 
 class Server : public QObject
@@ -103,6 +110,9 @@ class Server : public QObject
             SelfMessage = 0x100,
             ChgHost = 0x200,
             CapNofify = 0x400,
+            Batch = 0x800,
+            ChatHistory = 0x1000,
+            MessageTags = 0x2000,
         };
         Q_DECLARE_FLAGS(CapabilityFlags, CapabilityFlag)
 
@@ -198,6 +208,7 @@ class Server : public QObject
 
         void dbusRaw(const QString& command);
         void dbusSay(const QString& target,const QString& command);
+        int dbusSendMessages(const QString& target, const QStringList& messages);
         void dbusInfo(const QString& string);
         void ctcpReply(const QString& receiver, const QString& text);
 
@@ -228,6 +239,26 @@ class Server : public QObject
         QString getOwnIpByServerMessage() const;
 
         bool isAway() const { return m_away; }
+
+        /// Whether the line being handled is one a bouncer plays back, see InputFilter.
+        bool isPlayback() const { return m_playback; }
+        /// Ending playback emits playbackFinished().
+        void setPlayback(bool playback);
+        /// When the socket connected, in UTC.
+        QDateTime connectTime() const { return m_connectTime; }
+
+        /// Maximum of lines per CHATHISTORY request the server allows, 0 if it has none.
+        void setChatHistoryLimit(int limit) { m_chatHistoryLimit = limit; }
+        /**
+         * Asks the server for the lines of @p target before @p before, unless a request
+         * for it is pending already or the server has no older ones.
+         */
+        void requestHistoryBefore(const QString& target, const QDateTime& before);
+        bool isHistoryRequested(const QString& target) const;
+        /// The reply to requestHistoryBefore(), oldest line first; hands the lines to the view of @p target.
+        void historyReceived(const QString& target, const QList<Konversation::HistoryLine>& lines);
+        /// The server refused a CHATHISTORY request, don't ask it again for the target named in @p context.
+        void historyFailed(const QStringList& context);
         void setAway(bool away, const QHash<QString, QString> &messageTags);
         QString awayTime() const;
 
@@ -409,6 +440,7 @@ class Server : public QObject
     // IRCQueueManager
         bool validQueue(QueuePriority priority); ///< is this queue index valid?
         void resetQueues(); ///< Tell all of the queues to reset
+        void stopIncoming(); ///< Stop the incoming thread until the next connection attempt
 
         /** Forces the queued data to be sent in sequence of age, without pause.
 
@@ -472,6 +504,10 @@ class Server : public QObject
         void sslConnected(Server* server);
 
         void connectionStateChanged(Server* server, Konversation::ConnectionState state);
+        /// The delay of connectToIRCServerIn() is over, see ReconnectScheduler.
+        void scheduledConnectDue(Server* server);
+        /// The played back lines handled so far are done, views may show theirs now.
+        void playbackFinished();
 
         void showView(ChatWindow* view);
         void addDccPanel();
@@ -479,7 +515,7 @@ class Server : public QObject
 
     public Q_SLOTS:
         void connectToIRCServer();
-        void connectToIRCServerIn(uint delay);
+        void connectToIRCServerIn(int msecs);
 
         /** Adds line to queue if non-empty. */
         bool queue(const QString& line, QueuePriority priority=StandardPriority);
@@ -538,6 +574,8 @@ class Server : public QObject
         void pongReceived();
 
         #if HAVE_QCA2
+        /// The cipher of the channel or query @p recipient, set to @p key, or nullptr.
+        Konversation::Cipher* getCipherForRecipient(const QString& recipient, const QByteArray& key) const;
         void initKeyExchange(const QString &receiver);
         void parseInitKeyX(const QString &sender, const QString &pubKey);
         void parseFinishKeyX(const QString &sender, const QString &pubKey);
@@ -570,6 +608,8 @@ class Server : public QObject
         void socketConnected();
         void startAwayTimer();
         void incoming();
+        /// Takes the lines the IncomingWorker is done with.
+        void incomingLines();
         void processIncomingData();
         /// Sends the QString to the socket. No longer has any internal concept of queueing
         void toServer(const QString&, IRCQueue *);
@@ -580,6 +620,9 @@ class Server : public QObject
          * @param reason The reason why this failed.  This is already translated, ready to show the user.
          */
         void sslError(const QList<QSslError>&);
+        void raceConnected(QSslSocket* socket, const Konversation::ServerSettings& server);
+        void raceSslErrors(QSslSocket* socket, const Konversation::ServerSettings& server, const QList<QSslError>& errors);
+        void raceFailed(QSslSocket* socket);
         void connectionEstablished(const QString& ownHost);
         void notifyResponse(const QString& nicksOnline);
 
@@ -641,8 +684,22 @@ class Server : public QObject
         /// Connect to the signals used in this class.
         void connectSignals();
 
+        /// Whether the identity authenticates with a client certificate, which needs TLS.
+        bool usesClientCertificate() const;
+        /// Sets up a new socket for connecting to @p server.
+        void setupSocket(QSslSocket* socket, const Konversation::ServerSettings& server);
+        /// Makes @p socket the connection to @p server, the one the connection race ended with.
+        void adoptSocket(QSslSocket* socket, const Konversation::ServerSettings& server);
+        /// Asks the user whether to ignore the SSL @p errors of @p socket.
+        void handleSslErrors(QPointer<QSslSocket> socket, const QList<QSslError>& errors);
+
         int _send_internal(QString outputline); ///< Guts of old send, isn't a slot.
 
+        /// Hands what the IncomingWorker needs to know of the connection over to it.
+        void updateIncomingSettings();
+        /// Decodes a line that is not UTF-8, by the encoding of @p channelKey or the identity.
+        QString decodeIncoming(const QByteArray& line, const QString& channelKey) const;
+
         /** Adds a nickname to the unjoinedChannels list.
          *  Creates new NickInfo if necessary.
          *  If needed, moves the channel from the joined list to the unjoined list.
@@ -750,6 +807,10 @@ class Server : public QObject
     private:
         // constants
         static const int BUFFER_LEN=513;
+        /// Milliseconds of played back lines handled before the event loop gets a turn.
+        static const int PlaybackSlice=20;
+        /// Milliseconds after which a CHATHISTORY request without an answer may be sent again.
+        static const int HistoryTimeout=30000;
 
         unsigned int m_completeQueryPosition;
         QList<int> m_nickIndices;
@@ -772,14 +833,23 @@ class Server : public QObject
         QStringList m_autoJoinCommands;
 
         QSslSocket *m_socket;
+        /// Establishes the connection; m_socket is set once it is done.
+        Konversation::ConnectionRacer* m_connectionRacer;
 
         QTimer m_incomingTimer;
         QTimer m_notifyTimer;
         QStringList m_notifyCache;                  // List of users found with ISON
         int m_currentLag;
 
-        QStringList m_inputBuffer;
-        QByteArray m_lineBuffer;
+        QList<Konversation::IncomingWorker::Line> m_inputBuffer;
+
+        QThread* m_incomingThread;
+        Konversation::IncomingWorker* m_incomingWorker;
+        /// Increased for each connection, the worker's lines of the previous ones are dropped.
+        int m_incomingGeneration;
+        /// As last handed to the worker.
+        Konversation::IncomingWorker::Settings m_incomingSettings;
+        bool m_incomingSettingsDirty;
 
         QList<IRCQueue *> m_queues;
         // Stats used in QueueTuner
@@ -832,6 +902,12 @@ class Server : public QObject
 
         int m_topicLength;
 
+        int m_chatHistoryLimit;
+        /// Lowercased targets with a CHATHISTORY request pending, and since when.
+        QHash<QString, QElapsedTimer> m_historyRequests;
+        /// Lowercased targets the server has no more history of.
+        QSet<QString> m_historyExhausted;
+
         // Blowfish key map
         QHash<QString, QByteArray> m_keyHash;
 
@@ -841,6 +917,8 @@ class Server : public QObject
 
         /// Used to lock incomingTimer while processing message.
         bool m_processingIncoming;
+        bool m_playback;
+        QDateTime m_connectTime;
 
         /// Measures the lag between PING and PONG
         QElapsedTimer m_lagTime;
@@ -0,0 +1,90 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef KONVERSATION_SPSCQUEUE_H
+#define KONVERSATION_SPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace Konversation
+{
+    /**
+     * An unbounded queue for handing values from one thread to another,
+     * without locking.
+     *
+     * Only one thread may push() and only one thread may pop(), which may
+     * be a different one. The queue is a list of nodes headed by a node
+     * whose value has been taken already; the producer only touches the
+     * tail and the consumer only the head, so they meet at a single atomic
+     * pointer.
+     */
+    template<typename T>
+    class SpscQueue
+    {
+        public:
+            SpscQueue()
+                : m_head(new Node)
+                , m_tail(m_head)
+            {
+            }
+
+            ~SpscQueue()
+            {
+                while (m_head)
+                {
+                    Node* next = m_head->next.load(std::memory_order_relaxed);
+                    delete m_head;
+                    m_head = next;
+                }
+            }
+
+            /// Producer side.
+            void push(T value)
+            {
+                Node* node = new Node;
+                node->value = std::move(value);
+
+                // publishes the value along with the node
+                m_tail->next.store(node, std::memory_order_release);
+                m_tail = node;
+            }
+
+            /// Consumer side; returns false if there is nothing to take.
+            bool pop(T& value)
+            {
+                Node* next = m_head->next.load(std::memory_order_acquire);
+
+                if (!next)
+                    return false;
+
+                value = std::move(next->value);
+
+                // the taken node heads the queue from now on
+                delete m_head;
+                m_head = next;
+
+                return true;
+            }
+
+        private:
+            struct Node
+            {
+                std::atomic<Node*> next { nullptr };
+                T value;
+            };
+
+            /// Consumer's.
+            Node* m_head;
+            /// Producer's.
+            Node* m_tail;
+
+            SpscQueue(const SpscQueue&) = delete;
+            SpscQueue& operator=(const SpscQueue&) = delete;
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "sslcache.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace Konversation
+{
+    QString SslCache::sessionKey(const QString& host, quint16 port)
+    {
+        return host.toLower() + QLatin1Char(':') + QString::number(port);
+    }
+
+    QByteArray SslCache::sessionTicket(const QString& host, quint16 port)
+    {
+        const auto it = s_sessionTickets.constFind(sessionKey(host, port));
+
+        if (it == s_sessionTickets.constEnd())
+            return QByteArray();
+
+        if (it->expiry <= QDateTime::currentDateTimeUtc())
+        {
+            s_sessionTickets.erase(it);
+            return QByteArray();
+        }
+
+        return it->ticket;
+    }
+
+    void SslCache::setSessionTicket(const QString& host, quint16 port, const QByteArray& ticket, int lifetimeHint)
+    {
+        if (ticket.isEmpty())
+        {
+            removeSessionTicket(host, port);
+            return;
+        }
+
+        // RFC 8446 caps the lifetime of a ticket at seven days
+        const int lifetime = (lifetimeHint > 0) ? qMin(lifetimeHint, 7 * 24 * 3600) : 24 * 3600;
+
+        s_sessionTickets.insert(sessionKey(host, port), SessionTicket { ticket, QDateTime::currentDateTimeUtc().addSecs(lifetime) });
+    }
+
+    void SslCache::removeSessionTicket(const QString& host, quint16 port)
+    {
+        s_sessionTickets.remove(sessionKey(host, port));
+    }
+
+    bool SslCache::clientCertificate(const QString& fileName, QSslCertificate& certificate, QSslKey& key)
+    {
+        const QFileInfo info(fileName);
+        ClientCertificate& cached = s_clientCertificates[fileName];
+
+        if (cached.size != info.size() || cached.lastModified != info.lastModified())
+        {
+            cached = ClientCertificate();
+
+            QFile file(fileName);
+
+            if (file.open(QIODevice::ReadOnly))
+            {
+                const QByteArray pem = file.readAll();
+                const QList<QSslCertificate> certificates = QSslCertificate::fromData(pem, QSsl::Pem);
+
+                if (!certificates.isEmpty())
+                    cached.certificate = certificates.first();
+
+                cached.key = QSslKey(pem, QSsl::Rsa, QSsl::Pem);
+
+                if (cached.key.isNull())
+                    cached.key = QSslKey(pem, QSsl::Ec, QSsl::Pem);
+            }
+
+            // a missing file is looked at again next time
+            if (!cached.certificate.isNull())
+            {
+                cached.lastModified = info.lastModified();
+                cached.size = info.size();
+            }
+        }
+
+        certificate = cached.certificate;
+        key = cached.key;
+
+        return !certificate.isNull();
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef SSLCACHE_H
+#define SSLCACHE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QString>
+
+namespace Konversation
+{
+    /**
+     * What reconnecting over TLS can reuse from earlier connections: the
+     * session tickets of the servers, for resuming sessions instead of full
+     * handshakes, and the client certificates of the identities, parsed
+     * once rather than on every attempt.
+     *
+     * Only used from the main thread.
+     */
+    class SslCache
+    {
+        public:
+            /// The session ticket to resume a session with @p host with, if any still valid.
+            static QByteArray sessionTicket(const QString& host, quint16 port);
+            /// Keeps @p ticket for @p lifetimeHint seconds, or a day if the server gave no hint.
+            static void setSessionTicket(const QString& host, quint16 port, const QByteArray& ticket, int lifetimeHint);
+            static void removeSessionTicket(const QString& host, quint16 port);
+
+            /**
+             * The certificate and private key in the PEM file @p fileName. The
+             * file is read again only once it changes.
+             *
+             * @return false if the file has no certificate
+             */
+            static bool clientCertificate(const QString& fileName, QSslCertificate& certificate, QSslKey& key);
+
+        private:
+            struct SessionTicket
+            {
+                QByteArray ticket;
+                QDateTime expiry;
+            };
+
+            struct ClientCertificate
+            {
+                QDateTime lastModified;
+                qint64 size = -1;
+                QSslCertificate certificate;
+                QSslKey key;
+            };
+
+            static QString sessionKey(const QString& host, quint16 port);
+
+            static inline QHash<QString, SessionTicket> s_sessionTickets;
+            static inline QHash<QString, ClientCertificate> s_clientCertificates;
+    };
+}
+
+#endif
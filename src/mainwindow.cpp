@@ -17,6 +17,7 @@
 #include "trayicon.h"
 #include "serverlistdialog.h"
 #include "identitydialog.h"
+#include "pipelinestatsdialog.h"
 #include "notificationhandler.h"
 #include "irccharsets.h"
 #include "connectionmanager.h"
@@ -64,6 +65,7 @@ MainWindow::MainWindow() : KXmlGuiWindow(nullptr)
     m_hasDirtySettings = false;
     m_closeOnQuitAction = false;
     m_serverListDialog = nullptr;
+    m_pipelineStatsDialog = nullptr;
     m_trayIcon = nullptr;
     m_settingsDialog = nullptr;
 
@@ -229,6 +231,13 @@ MainWindow::MainWindow() : KXmlGuiWindow(nullptr)
     connect(action, &QAction::triggered, m_viewContainer, &ViewContainer::addUrlCatcher);
     actionCollection()->addAction(QStringLiteral("open_url_catcher"), action);
 
+    action=new QAction(this);
+    action->setText(i18n("&Pipeline Statistics"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("view-statistics")));
+    action->setStatusTip(i18n("Show how long handling incoming lines takes, stage by stage"));
+    connect(action, &QAction::triggered, this, &MainWindow::openPipelineStats);
+    actionCollection()->addAction(QStringLiteral("open_pipeline_statistics"), action);
+
     if (KAuthorized::authorize(QStringLiteral("shell_access")))
     {
         action=new QAction(this);
@@ -491,6 +500,14 @@ MainWindow::MainWindow() : KXmlGuiWindow(nullptr)
     action = KStandardAction::findPrev(m_viewContainer, &ViewContainer::findPrevText, actionCollection());
     action->setEnabled(false);
 
+    action=new QAction(this);
+    action->setText(i18n("Find in &All Tabs..."));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("edit-find")));
+    actionCollection()->setDefaultShortcut(action,QKeySequence(QStringLiteral("Ctrl+Shift+F")));
+    action->setStatusTip(i18n("Search for text in the scrollback of all tabs"));
+    connect(action, &QAction::triggered, m_viewContainer, &ViewContainer::findTextInAllViews);
+    actionCollection()->addAction(QStringLiteral("find_all_tabs"), action);
+
     action=new QAction(this);
     action->setText(i18n("&IRC Color..."));
     action->setIcon(QIcon::fromTheme(QStringLiteral("format-text-color")));
@@ -901,6 +918,15 @@ void MainWindow::openQuickConnectDialog()
 }
 
 
+void MainWindow::openPipelineStats()
+{
+    if (!m_pipelineStatsDialog)
+        m_pipelineStatsDialog = new Konversation::PipelineStatsDialog(this);
+
+    m_pipelineStatsDialog->show();
+    m_pipelineStatsDialog->raise();
+}
+
 void MainWindow::openIdentitiesDialog()
 {
     QPointer<Konversation::IdentityDialog> dlg = new Konversation::IdentityDialog(this);
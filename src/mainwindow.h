@@ -28,6 +28,7 @@ class ViewContainer;
 
 namespace Konversation
 {
+    class PipelineStatsDialog;
     class ServerListDialog;
     class TrayIcon;
     class StatusBar;
@@ -104,6 +105,7 @@ class MainWindow : public KXmlGuiWindow
         void openPrefsDialog();
         void openKeyBindings();
         void openQuickConnectDialog();
+        void openPipelineStats();
 
         // it seems that moc does not honor #ifs in compile so we create an
         // empty slot in our .cpp file rather than #if this slot out
@@ -127,6 +129,7 @@ class MainWindow : public KXmlGuiWindow
 
         KonviSettingsDialog *m_settingsDialog;
         Konversation::ServerListDialog* m_serverListDialog;
+        Konversation::PipelineStatsDialog* m_pipelineStatsDialog;
 
         /** @see settingsChangedSlot() */
         bool m_hasDirtySettings;
@@ -22,6 +22,12 @@
 
 namespace Konversation
 {
+    /// Lines a bouncer plays back are old news and notify nobody.
+    static bool notificationsEnabled(ChatWindow* chatWin)
+    {
+        return chatWin && chatWin->notificationsEnabled()
+            && !(chatWin->getServer() && chatWin->getServer()->isPlayback());
+    }
 
     NotificationHandler::NotificationHandler(Application* parent)
         : QObject(parent)
@@ -35,7 +41,7 @@ namespace Konversation
 
     void NotificationHandler::message(ChatWindow* chatWin, const QString& fromNick, const QString& message)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -90,7 +96,7 @@ namespace Konversation
 
     void NotificationHandler::nick(ChatWindow* chatWin, const QString& fromNick, const QString& message)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -141,7 +147,7 @@ namespace Konversation
     void NotificationHandler::queryMessage(ChatWindow* chatWin,
                                            const QString& fromNick, const QString& message)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -190,7 +196,7 @@ namespace Konversation
 
     void NotificationHandler::startTrayNotification(ChatWindow* chatWin)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (!chatWin->getServer() || (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer()->isAway()))
@@ -203,7 +209,7 @@ namespace Konversation
 
     void NotificationHandler::join(ChatWindow* chatWin, const QString& nick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -222,7 +228,7 @@ namespace Konversation
 
     void NotificationHandler::part(ChatWindow* chatWin, const QString& nick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -241,7 +247,7 @@ namespace Konversation
 
     void NotificationHandler::quit(ChatWindow* chatWin, const QString& nick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -252,7 +258,7 @@ namespace Konversation
 
     void NotificationHandler::nickChange(ChatWindow* chatWin, const QString& oldNick, const QString& newNick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -263,7 +269,7 @@ namespace Konversation
 
     void NotificationHandler::dccIncoming(ChatWindow* chatWin, const QString& fromNick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -274,7 +280,7 @@ namespace Konversation
 
     void NotificationHandler::dccError(ChatWindow* chatWin, const QString& error)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -285,7 +291,7 @@ namespace Konversation
 
     void NotificationHandler::dccTransferDone(ChatWindow* chatWin, const QString& file, DCC::Transfer* transfer)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -308,7 +314,7 @@ namespace Konversation
 
     void NotificationHandler::mode(ChatWindow* chatWin, const QString& nick, const QString& subject, const QString& change)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -322,7 +328,7 @@ namespace Konversation
 
     void NotificationHandler::query(ChatWindow* chatWin, const QString& fromNick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -368,7 +374,7 @@ namespace Konversation
 
     void NotificationHandler::kick(ChatWindow* chatWin, const QString& channel,const QString& nick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -383,7 +389,7 @@ namespace Konversation
 
     void NotificationHandler::dccChat(ChatWindow* chatWin, const QString& nick)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -398,7 +404,7 @@ namespace Konversation
 
     void NotificationHandler::highlight(ChatWindow* chatWin, const QString& fromNick, const QString& message)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
@@ -436,7 +442,7 @@ namespace Konversation
 
     void NotificationHandler::connectionFailure(ChatWindow* chatWin, const QString& server)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         auto *ev=new KNotification(QStringLiteral("connectionFailure"));
@@ -448,7 +454,7 @@ namespace Konversation
 
     void NotificationHandler::channelJoin(ChatWindow* chatWin, const QString& channel)
     {
-        if (!chatWin || !chatWin->notificationsEnabled())
+        if (!notificationsEnabled(chatWin))
             return;
 
         if (Preferences::self()->disableNotifyWhileAway() && chatWin->getServer() && chatWin->getServer()->isAway())
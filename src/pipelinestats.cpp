@@ -0,0 +1,158 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "pipelinestats.h"
+
+#include <KLocalizedString>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms>
+
+namespace Konversation
+{
+    void PipelineStats::Histogram::add(quint64 value)
+    {
+        ++count;
+        total += value;
+        max = qMax(max, value);
+
+        // bucket n holds the values below 2^n
+        const int bucket = (value == 0) ? 0 : 64 - qCountLeadingZeroBits(value);
+        ++buckets[qMin(bucket, BucketCount - 1)];
+    }
+
+    quint64 PipelineStats::Histogram::quantile(double fraction) const
+    {
+        if (count == 0)
+            return 0;
+
+        const quint64 rank = qMax(quint64(1), quint64(fraction * count + 0.5));
+        quint64 seen = 0;
+
+        for (int bucket = 0; bucket < BucketCount; ++bucket)
+        {
+            seen += buckets[bucket];
+
+            // the last bucket has no upper bound
+            if (seen >= rank)
+                return (bucket == BucketCount - 1) ? max : qMin(max, (quint64(1) << bucket) - 1);
+        }
+
+        return max;
+    }
+
+    void PipelineStats::setEnabled(bool enabled)
+    {
+        s_enabled = enabled;
+    }
+
+    void PipelineStats::reset()
+    {
+        for (Histogram& histogram : s_stages)
+            histogram = Histogram();
+        for (Histogram& histogram : s_queues)
+            histogram = Histogram();
+    }
+
+    QString PipelineStats::stageId(Stage stage)
+    {
+        switch (stage)
+        {
+            case Decode:    return QStringLiteral("decode");
+            case Parse:     return QStringLiteral("parse");
+            case Dispatch:  return QStringLiteral("dispatch");
+            case NickModel: return QStringLiteral("nickModel");
+            case Highlight: return QStringLiteral("highlight");
+            case Html:      return QStringLiteral("html");
+            case Layout:    return QStringLiteral("layout");
+            case Logging:   return QStringLiteral("logging");
+            case StageCount: break;
+        }
+
+        return QString();
+    }
+
+    QString PipelineStats::queueId(Queue queue)
+    {
+        switch (queue)
+        {
+            case InputBuffer: return QStringLiteral("inputBuffer");
+            case OutputQueue: return QStringLiteral("outputQueue");
+            case QueueCount: break;
+        }
+
+        return QString();
+    }
+
+    QString PipelineStats::stageName(Stage stage)
+    {
+        switch (stage)
+        {
+            case Decode:    return i18nc("@item pipeline stage", "Decoding");
+            case Parse:     return i18nc("@item pipeline stage", "Parsing");
+            case Dispatch:  return i18nc("@item pipeline stage", "Handling");
+            case NickModel: return i18nc("@item pipeline stage", "Nick updates");
+            case Highlight: return i18nc("@item pipeline stage", "Highlight matching");
+            case Html:      return i18nc("@item pipeline stage", "HTML generation");
+            case Layout:    return i18nc("@item pipeline stage", "Layout");
+            case Logging:   return i18nc("@item pipeline stage", "Logging");
+            case StageCount: break;
+        }
+
+        return QString();
+    }
+
+    QString PipelineStats::queueName(Queue queue)
+    {
+        switch (queue)
+        {
+            case InputBuffer: return i18nc("@item queue", "Received lines");
+            case OutputQueue: return i18nc("@item queue", "Lines to send");
+            case QueueCount: break;
+        }
+
+        return QString();
+    }
+
+    static QJsonObject histogramToJson(const PipelineStats::Histogram& histogram)
+    {
+        QJsonArray buckets;
+
+        for (quint64 bucket : histogram.buckets)
+            buckets.append(double(bucket));
+
+        return QJsonObject {
+            { QStringLiteral("count"), double(histogram.count) },
+            { QStringLiteral("total"), double(histogram.total) },
+            { QStringLiteral("mean"), histogram.count ? double(histogram.total) / histogram.count : 0.0 },
+            { QStringLiteral("max"), double(histogram.max) },
+            { QStringLiteral("p50"), double(histogram.quantile(0.5)) },
+            { QStringLiteral("p99"), double(histogram.quantile(0.99)) },
+            { QStringLiteral("buckets"), buckets },
+        };
+    }
+
+    QByteArray PipelineStats::toJson()
+    {
+        QJsonObject stages;
+        for (int stage = 0; stage < StageCount; ++stage)
+            stages.insert(stageId(Stage(stage)), histogramToJson(s_stages[stage]));
+
+        QJsonObject queues;
+        for (int queue = 0; queue < QueueCount; ++queue)
+            queues.insert(queueId(Queue(queue)), histogramToJson(s_queues[queue]));
+
+        const QJsonObject root {
+            { QStringLiteral("enabled"), isEnabled() },
+            { QStringLiteral("stages"), stages },
+            { QStringLiteral("queues"), queues },
+        };
+
+        return QJsonDocument(root).toJson();
+    }
+}
@@ -0,0 +1,148 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef PIPELINESTATS_H
+#define PIPELINESTATS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+
+#include <atomic>
+
+namespace Konversation
+{
+    /**
+     * Counters and histograms of the stages a line goes through, from being
+     * received to being shown and logged, and of the depths of the queues in
+     * between. Off by default; when off, recording costs a branch.
+     *
+     * Everything is recorded in the main thread; the IncomingWorker measures
+     * its stages and hands the times over along with the lines.
+     *
+     * The stages exclude each other: time spent in a stage nested in
+     * another, e.g. the nick model being updated while a line is handled,
+     * counts for the inner stage only, so the totals add up.
+     */
+    class PipelineStats
+    {
+        public:
+            enum Stage
+            {
+                Decode,     ///< IncomingWorker, decrypting and decoding, per line
+                Parse,      ///< splitting a line into tags, prefix, command and parameters
+                Dispatch,   ///< handling a parsed line, less the stages below
+                NickModel,  ///< updating the nicks of channels on joins, parts, quits and renames
+                Highlight,  ///< matching the highlight list
+                Html,       ///< turning IRC text into HTML
+                Layout,     ///< inserting lines into the document
+                Logging,    ///< writing the log files
+                StageCount
+            };
+
+            enum Queue
+            {
+                InputBuffer,    ///< received lines not parsed yet
+                OutputQueue,    ///< lines waiting in an IRCQueue to be sent
+                QueueCount
+            };
+
+            /// Power of two buckets, of nanoseconds for stages.
+            static const int BucketCount = 32;
+
+            struct Histogram
+            {
+                quint64 count = 0;
+                quint64 total = 0;
+                quint64 max = 0;
+                quint64 buckets[BucketCount] = {};
+
+                void add(quint64 value);
+                /// An upper bound of the @p fraction quantile, at most the maximum.
+                quint64 quantile(double fraction) const;
+            };
+
+            /// May be asked from any thread.
+            static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+            static void setEnabled(bool enabled);
+            static void reset();
+
+            static void addTime(Stage stage, qint64 nsecs)
+            {
+                s_stages[stage].add(quint64(nsecs));
+            }
+
+            static void addQueueDepth(Queue queue, qsizetype depth)
+            {
+                if (isEnabled())
+                    s_queues[queue].add(quint64(depth));
+            }
+
+            static const Histogram& stage(Stage stage) { return s_stages[stage]; }
+            static const Histogram& queue(Queue queue) { return s_queues[queue]; }
+
+            /// Identifiers as used in the JSON.
+            static QString stageId(Stage stage);
+            static QString queueId(Queue queue);
+            static QString stageName(Stage stage);
+            static QString queueName(Queue queue);
+
+            /// All counters and histograms, in nanoseconds where they are times.
+            static QByteArray toJson();
+
+        private:
+            static inline std::atomic<bool> s_enabled = false;
+            static inline Histogram s_stages[StageCount];
+            static inline Histogram s_queues[QueueCount];
+    };
+
+    /**
+     * Adds the time from its construction to its destruction to @p stage, if
+     * enabled, less the time of the timers constructed in between.
+     */
+    class PipelineTimer
+    {
+        public:
+            explicit PipelineTimer(PipelineStats::Stage stage)
+                : m_stage(stage)
+            {
+                if (PipelineStats::isEnabled())
+                {
+                    m_outer = s_current;
+                    s_current = this;
+                    m_timer.start();
+                }
+            }
+
+            ~PipelineTimer()
+            {
+                if (!m_timer.isValid())
+                    return;
+
+                const qint64 elapsed = m_timer.nsecsElapsed();
+                PipelineStats::addTime(m_stage, elapsed - m_nested);
+
+                if (m_outer)
+                    m_outer->m_nested += elapsed;
+
+                s_current = m_outer;
+            }
+
+        private:
+            PipelineStats::Stage m_stage;
+            QElapsedTimer m_timer;
+            /// The timer this one is nested in.
+            PipelineTimer* m_outer = nullptr;
+            /// Time of the timers nested in this one, in nanoseconds.
+            qint64 m_nested = 0;
+
+            static inline thread_local PipelineTimer* s_current = nullptr;
+
+            Q_DISABLE_COPY(PipelineTimer)
+    };
+}
+
+#endif
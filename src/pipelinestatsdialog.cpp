@@ -0,0 +1,168 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "pipelinestatsdialog.h"
+
+#include "pipelinestats.h"
+
+#include <KLocalizedString>
+#include <KMessageBox>
+
+#include <QApplication>
+#include <QCheckBox>
+#include <QClipboard>
+#include <QDialogButtonBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace Konversation
+{
+    enum StatsColumns
+    {
+        NameColumn,
+        CountColumn,
+        MeanColumn,
+        MedianColumn,
+        P99Column,
+        MaxColumn
+    };
+
+    static QString formatDuration(double nsecs)
+    {
+        if (nsecs < 1000)
+            return i18nc("@item nanoseconds", "%1 ns", QString::number(nsecs, 'f', 0));
+        if (nsecs < 1000000)
+            return i18nc("@item microseconds", "%1 µs", QString::number(nsecs / 1000, 'f', 1));
+
+        return i18nc("@item milliseconds", "%1 ms", QString::number(nsecs / 1000000, 'f', 2));
+    }
+
+    static void setHistogram(QTreeWidgetItem* item, const PipelineStats::Histogram& histogram, bool isTime)
+    {
+        const double mean = histogram.count ? double(histogram.total) / histogram.count : 0.0;
+        auto format = [isTime](double value) {
+            return isTime ? formatDuration(value) : QString::number(value, 'f', value < 10 ? 1 : 0);
+        };
+
+        item->setText(CountColumn, QString::number(histogram.count));
+        item->setText(MeanColumn, format(mean));
+        item->setText(MedianColumn, format(histogram.quantile(0.5)));
+        item->setText(P99Column, format(histogram.quantile(0.99)));
+        item->setText(MaxColumn, format(histogram.max));
+    }
+
+    PipelineStatsDialog::PipelineStatsDialog(QWidget* parent)
+        : QDialog(parent)
+    {
+        setWindowTitle(i18n("Pipeline Statistics"));
+        setModal(false);
+
+        auto* mainLayout = new QVBoxLayout(this);
+
+        m_enabled = new QCheckBox(i18n("Record timings"), this);
+        m_enabled->setToolTip(i18n("Measure how long each stage of handling a line takes. Costs a little time itself."));
+        m_enabled->setChecked(PipelineStats::isEnabled());
+        connect(m_enabled, &QCheckBox::toggled, this, [](bool enabled) { PipelineStats::setEnabled(enabled); });
+        mainLayout->addWidget(m_enabled);
+
+        m_stats = new QTreeWidget(this);
+        m_stats->setHeaderLabels({ i18n("Stage"), i18n("Count"), i18n("Mean"), i18n("Median"),
+                                   i18nc("@title:column 99th percentile", "99%"), i18n("Maximum") });
+        m_stats->setUniformRowHeights(true);
+        m_stats->setAllColumnsShowFocus(true);
+        m_stats->header()->setSectionResizeMode(NameColumn, QHeaderView::ResizeToContents);
+        mainLayout->addWidget(m_stats);
+
+        m_stagesItem = new QTreeWidgetItem(m_stats, { i18n("Time per line") });
+        for (int stage = 0; stage < PipelineStats::StageCount; ++stage)
+            new QTreeWidgetItem(m_stagesItem, { PipelineStats::stageName(PipelineStats::Stage(stage)) });
+
+        m_queuesItem = new QTreeWidgetItem(m_stats, { i18n("Queue depth") });
+        for (int queue = 0; queue < PipelineStats::QueueCount; ++queue)
+            new QTreeWidgetItem(m_queuesItem, { PipelineStats::queueName(PipelineStats::Queue(queue)) });
+
+        m_stats->expandAll();
+
+        auto* buttonBox = new QDialogButtonBox(QDialogButtonBox::Reset | QDialogButtonBox::Save | QDialogButtonBox::Close, this);
+        QPushButton* copyButton = buttonBox->addButton(i18n("Copy as JSON"), QDialogButtonBox::ActionRole);
+        copyButton->setIcon(QIcon::fromTheme(QStringLiteral("edit-copy")));
+        connect(copyButton, &QPushButton::clicked, this, &PipelineStatsDialog::copyJson);
+        connect(buttonBox->button(QDialogButtonBox::Reset), &QPushButton::clicked, this, &PipelineStatsDialog::reset);
+        connect(buttonBox->button(QDialogButtonBox::Save), &QPushButton::clicked, this, &PipelineStatsDialog::saveJson);
+        connect(buttonBox, &QDialogButtonBox::rejected, this, &PipelineStatsDialog::reject);
+        mainLayout->addWidget(buttonBox);
+
+        m_timer = new QTimer(this);
+        m_timer->setInterval(1000);
+        connect(m_timer, &QTimer::timeout, this, &PipelineStatsDialog::refresh);
+
+        resize(700, 380);
+    }
+
+    PipelineStatsDialog::~PipelineStatsDialog()
+    {
+    }
+
+    void PipelineStatsDialog::showEvent(QShowEvent* event)
+    {
+        refresh();
+        m_timer->start();
+
+        QDialog::showEvent(event);
+    }
+
+    void PipelineStatsDialog::hideEvent(QHideEvent* event)
+    {
+        m_timer->stop();
+
+        QDialog::hideEvent(event);
+    }
+
+    void PipelineStatsDialog::refresh()
+    {
+        // may have been switched over D-Bus
+        const QSignalBlocker blocker(m_enabled);
+        m_enabled->setChecked(PipelineStats::isEnabled());
+
+        for (int stage = 0; stage < PipelineStats::StageCount; ++stage)
+            setHistogram(m_stagesItem->child(stage), PipelineStats::stage(PipelineStats::Stage(stage)), true);
+
+        for (int queue = 0; queue < PipelineStats::QueueCount; ++queue)
+            setHistogram(m_queuesItem->child(queue), PipelineStats::queue(PipelineStats::Queue(queue)), false);
+    }
+
+    void PipelineStatsDialog::reset()
+    {
+        PipelineStats::reset();
+        refresh();
+    }
+
+    void PipelineStatsDialog::copyJson()
+    {
+        QApplication::clipboard()->setText(QString::fromUtf8(PipelineStats::toJson()));
+    }
+
+    void PipelineStatsDialog::saveJson()
+    {
+        const QString fileName = QFileDialog::getSaveFileName(this, i18n("Save Pipeline Statistics"),
+                                                              QString(), i18n("JSON files (*.json)"));
+
+        if (fileName.isEmpty())
+            return;
+
+        QFile file(fileName);
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(PipelineStats::toJson()) < 0)
+            KMessageBox::error(this, i18n("The statistics could not be saved: %1", file.errorString()));
+    }
+}
+
+#include "moc_pipelinestatsdialog.cpp"
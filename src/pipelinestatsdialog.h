@@ -0,0 +1,52 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef PIPELINESTATSDIALOG_H
+#define PIPELINESTATSDIALOG_H
+
+#include <QDialog>
+
+class QCheckBox;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Konversation
+{
+    /**
+     * Shows the PipelineStats, refreshed every second, and lets them be
+     * switched on, reset and saved as JSON.
+     */
+    class PipelineStatsDialog : public QDialog
+    {
+        Q_OBJECT
+
+        public:
+            explicit PipelineStatsDialog(QWidget* parent = nullptr);
+            ~PipelineStatsDialog() override;
+
+        protected:
+            void showEvent(QShowEvent* event) override;
+            void hideEvent(QHideEvent* event) override;
+
+        private Q_SLOTS:
+            void refresh();
+            void reset();
+            void copyJson();
+            void saveJson();
+
+        private:
+            QCheckBox* m_enabled;
+            QTreeWidget* m_stats;
+            QTreeWidgetItem* m_stagesItem;
+            QTreeWidgetItem* m_queuesItem;
+            QTimer* m_timer;
+
+            Q_DISABLE_COPY(PipelineStatsDialog)
+    };
+}
+
+#endif
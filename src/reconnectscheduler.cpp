@@ -0,0 +1,140 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "reconnectscheduler.h"
+
+#include "server.h"
+#include "statuspanel.h"
+#include "config/preferences.h"
+
+#include <KLocalizedString>
+
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include <algorithm>
+#include <climits>
+
+namespace Konversation
+{
+    /// Auto-connect networks first, then by their order in the server list.
+    static bool hasPriorityOver(const Server* server, const Server* other)
+    {
+        const ServerGroupSettingsPtr group = server->getConnectionSettings().serverGroup();
+        const ServerGroupSettingsPtr otherGroup = other->getConnectionSettings().serverGroup();
+
+        const bool autoConnect = group && group->autoConnectEnabled();
+        const bool otherAutoConnect = otherGroup && otherGroup->autoConnectEnabled();
+
+        if (autoConnect != otherAutoConnect)
+            return autoConnect;
+
+        const int sortIndex = group ? group->sortIndex() : INT_MAX;
+        const int otherSortIndex = otherGroup ? otherGroup->sortIndex() : INT_MAX;
+
+        if (sortIndex != otherSortIndex)
+            return sortIndex < otherSortIndex;
+
+        return server->connectionId() < other->connectionId();
+    }
+
+    ReconnectScheduler::ReconnectScheduler(QObject* parent)
+        : QObject(parent)
+    {
+        // Connections due at the same time are sorted before any of them goes
+        m_processTimer = new QTimer(this);
+        m_processTimer->setSingleShot(true);
+        m_processTimer->setInterval(0);
+        connect(m_processTimer, &QTimer::timeout, this, &ReconnectScheduler::processQueue);
+    }
+
+    ReconnectScheduler::~ReconnectScheduler()
+    {
+    }
+
+    qint64 ReconnectScheduler::backoffDelay(uint baseDelay, uint pass, double jitter)
+    {
+        const qint64 base = qint64(baseDelay) * 1000;
+        const qint64 limit = qMax(base, qint64(MaxBackoff) * 1000);
+        const qint64 delay = qMin(limit, base << qMin(pass, 16u));
+
+        return delay + qint64(delay * qBound(-1.0, jitter, 1.0) / 4);
+    }
+
+    qint64 ReconnectScheduler::nextDelay(Server* server)
+    {
+        const ConnectionSettings& settings = server->getConnectionSettings();
+        const uint servers = settings.serverGroup() ? qMax(1, int(settings.serverGroup()->serverList().size())) : 1;
+        const uint attempt = m_attempts[server->connectionId()]++;
+        const double jitter = QRandomGenerator::global()->bounded(2.0) - 1.0;
+
+        return backoffDelay(Preferences::self()->reconnectDelay(), attempt / servers, jitter);
+    }
+
+    void ReconnectScheduler::requestConnect(Server* server)
+    {
+        if (!server || m_waiting.contains(server))
+            return;
+
+        if (m_connecting.size() >= MaxConcurrentConnects)
+        {
+            server->getStatusView()->appendServerMessage(i18n("Info"),
+                i18np("Waiting for 1 other connection to be established first.",
+                      "Waiting for %1 other connections to be established first.",
+                      m_connecting.size()));
+        }
+
+        m_waiting.append(server);
+        m_processTimer->start();
+    }
+
+    void ReconnectScheduler::handleConnectionStateChange(Server* server, Konversation::ConnectionState state)
+    {
+        const int connectionId = server->connectionId();
+
+        if (state == Konversation::SSConnecting)
+        {
+            m_connecting.insert(connectionId);
+            return;
+        }
+
+        if (state == Konversation::SSConnected)
+            m_attempts.remove(connectionId);
+
+        if (m_connecting.remove(connectionId) && !m_waiting.isEmpty())
+            m_processTimer->start();
+    }
+
+    void ReconnectScheduler::removeConnection(int connectionId)
+    {
+        m_attempts.remove(connectionId);
+
+        if (m_connecting.remove(connectionId) && !m_waiting.isEmpty())
+            m_processTimer->start();
+    }
+
+    void ReconnectScheduler::processQueue()
+    {
+        // Connections deleted, aborted or connected by hand meanwhile
+        m_waiting.removeIf([](const QPointer<Server>& server) {
+            return !server || !server->isScheduledToConnect();
+        });
+
+        std::stable_sort(m_waiting.begin(), m_waiting.end(), [](const QPointer<Server>& a, const QPointer<Server>& b) {
+            return hasPriorityOver(a, b);
+        });
+
+        while (!m_waiting.isEmpty() && m_connecting.size() < MaxConcurrentConnects)
+        {
+            Server* server = m_waiting.takeFirst();
+
+            // enters m_connecting through handleConnectionStateChange()
+            server->connectToIRCServer();
+        }
+    }
+}
+
+#include "moc_reconnectscheduler.cpp"
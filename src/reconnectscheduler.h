@@ -0,0 +1,82 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef RECONNECTSCHEDULER_H
+#define RECONNECTSCHEDULER_H
+
+#include "common.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+
+class QTimer;
+class Server;
+
+namespace Konversation
+{
+    /**
+     * Decides when dropped connections try again, and how many may connect
+     * at once.
+     *
+     * The delay grows exponentially with the attempts of a connection. One
+     * pass over the servers of a server group counts as one attempt. Jitter
+     * spreads the delays of connections that dropped together.
+     *
+     * Connections that are due wait while MaxConcurrentConnects others are
+     * connecting, and then go in order of priority: auto-connect networks
+     * first, then in the order of the server list.
+     */
+    class ReconnectScheduler : public QObject
+    {
+        Q_OBJECT
+
+        public:
+            explicit ReconnectScheduler(QObject* parent = nullptr);
+            ~ReconnectScheduler() override;
+
+            /// Connections that may be connecting, up to being registered, at once.
+            static const int MaxConcurrentConnects = 3;
+            /// The longest delay in seconds the backoff grows to, unless the configured one is longer.
+            static const uint MaxBackoff = 300;
+
+            /// The delay in milliseconds before the next attempt of @p server, which it counts.
+            qint64 nextDelay(Server* server);
+
+            /**
+             * @p baseDelay seconds, doubled for each of @p pass and limited to
+             * MaxBackoff, then changed by @p jitter times a quarter of itself.
+             *
+             * @param jitter from -1 to 1
+             * @return the delay in milliseconds
+             */
+            static qint64 backoffDelay(uint baseDelay, uint pass, double jitter);
+
+        public Q_SLOTS:
+            /// Connects @p server once fewer than MaxConcurrentConnects connections are connecting.
+            void requestConnect(Server* server);
+
+            void handleConnectionStateChange(Server* server, Konversation::ConnectionState state);
+            void removeConnection(int connectionId);
+
+        private Q_SLOTS:
+            void processQueue();
+
+        private:
+            QList<QPointer<Server>> m_waiting;
+            /// Connection ids of the connections that are connecting
+            QSet<int> m_connecting;
+            /// Attempts since the last successful connection, by connection id
+            QHash<int, uint> m_attempts;
+            QTimer* m_processTimer;
+
+            Q_DISABLE_COPY(ReconnectScheduler)
+    };
+}
+
+#endif
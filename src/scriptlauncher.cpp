@@ -9,15 +9,31 @@
 #include "channel.h"
 #include "application.h"
 #include "server.h"
+#include "common.h"
+#include "konversation_log.h"
 
+#include <QFile>
 #include <QFileInfo>
+#include <QTimer>
 
+#include <KLocalizedString>
 #include <KProcess>
 #include <QStandardPaths>
 
+#include <memory>
+
 #include "konvi_qdbus.h"
 
+using namespace Konversation;
+
+/// Scripts to be kept running as hosts carry this near their beginning.
+static const char hostMarker[] = "konversation-script-host";
+static const int hostMarkerRange = 1024;
+/// Time given to the hosts to exit on their own on shutdown, in milliseconds.
+static const int hostExitTimeout = 500;
+
 ScriptLauncher::ScriptLauncher(QObject* parent) : QObject(parent)
+    , m_flushScheduled(false)
 {
     qputenv("KONVERSATION_LANG", QLocale().name().toLatin1());
     if (!qEnvironmentVariableIsSet("KONVERSATION_DBUS_BIN"))
@@ -31,6 +47,23 @@ ScriptLauncher::ScriptLauncher(QObject* parent) : QObject(parent)
 
 ScriptLauncher::~ScriptLauncher()
 {
+    // end of input asks the hosts to exit
+    for (const Host& host : std::as_const(m_hosts))
+    {
+        host.process->disconnect(this);
+        host.process->closeWriteChannel();
+    }
+
+    for (const Host& host : std::as_const(m_hosts))
+    {
+        if (!host.process->waitForFinished(hostExitTimeout))
+        {
+            host.process->kill();
+            host.process->waitForFinished(hostExitTimeout);
+        }
+
+        delete host.process;
+    }
 }
 
 QString ScriptLauncher::scriptPath(const QString& script)
@@ -48,6 +81,28 @@ void ScriptLauncher::launchScript(int connectionId, const QString& target, const
     QString script(parameterList.takeFirst());
     QString path = scriptPath(script);
 
+    const bool isHost = !path.isEmpty() && isHostScript(path);
+    QByteArray unsent;
+
+    // an edited script is started anew, one that is no host anymore not at all
+    auto running = m_hosts.constFind(path);
+
+    if (running != m_hosts.constEnd() && (!isHost || running->modified != m_hostMarkers.value(path).modified))
+        unsent = retireHost(path);
+
+    if (isHost)
+    {
+        Host* scriptHost = host(script, path);
+        scriptHost->pending += unsent;
+
+        const QString event = QStringLiteral("exec\t%1\t%2\t%3\n").arg(QString::number(connectionId), target, parameterList.join(QLatin1Char(' ')));
+        scriptHost->pending += event.toUtf8();
+
+        scheduleFlush();
+
+        return;
+    }
+
     parameterList.prepend(target);
     parameterList.prepend(QString::number(connectionId));
 
@@ -66,4 +121,258 @@ void ScriptLauncher::launchScript(int connectionId, const QString& target, const
     }
 }
 
+/// The whole lines of @p partial and @p output, keeping the rest in @p partial.
+static QList<QByteArray> takeLines(QByteArray& partial, const QByteArray& output)
+{
+    // handle whatever arrived at once, but only whole lines
+    QByteArray data = partial + output;
+    const int end = data.lastIndexOf('\n');
+
+    if (end < 0)
+    {
+        partial = data;
+        return {};
+    }
+
+    partial = data.mid(end + 1);
+    data.truncate(end);
+
+    return data.split('\n');
+}
+
+bool ScriptLauncher::isHostScript(const QString& path)
+{
+    const QFileInfo fileInfo(path);
+    const QDateTime modified = fileInfo.lastModified();
+
+    auto it = m_hostMarkers.constFind(path);
+
+    if (it != m_hostMarkers.constEnd() && it->modified == modified)
+        return it->isHost;
+
+    QFile file(path);
+    HostMarker marker;
+    marker.modified = modified;
+
+    if (file.open(QIODevice::ReadOnly))
+        marker.isHost = file.read(hostMarkerRange).contains(hostMarker);
+
+    m_hostMarkers.insert(path, marker);
+
+    return marker.isHost;
+}
+
+ScriptLauncher::Host* ScriptLauncher::host(const QString& name, const QString& path)
+{
+    auto it = m_hosts.find(path);
+
+    if (it != m_hosts.end())
+        return &it.value();
+
+    auto* process = new KProcess(this);
+    process->setWorkingDirectory(QFileInfo(path).path());
+    process->setProgram(path);
+    process->setEnv(QStringLiteral("KONVERSATION_SCRIPT_HOST"), QStringLiteral("1"));
+    // errors of the script go where ours go
+    process->setOutputChannelMode(KProcess::OnlyStdoutChannel);
+
+    connect(process, &QProcess::started, this, &ScriptLauncher::flushHosts);
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, path]() { readHost(path); });
+    connect(process, &QProcess::finished, this, [this, path](int exitCode, QProcess::ExitStatus exitStatus) {
+        hostFinished(path, exitStatus == QProcess::CrashExit || exitCode != 0);
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, path](QProcess::ProcessError error) {
+        // the other errors are followed by finished(), if at all
+        if (error == QProcess::FailedToStart)
+            hostFinished(path, true);
+    });
+
+    Host scriptHost;
+    scriptHost.name = name;
+    scriptHost.process = process;
+    scriptHost.modified = m_hostMarkers.value(path).modified;
+
+    it = m_hosts.insert(path, scriptHost);
+
+    return &it.value();
+}
+
+QByteArray ScriptLauncher::retireHost(const QString& path)
+{
+    const Host host = m_hosts.take(path);
+    KProcess* process = host.process;
+    const QString name = host.name;
+    QByteArray unsent = host.pending;
+
+    qCDebug(KONVERSATION_LOG) << "Restarting script host" << path;
+
+    process->disconnect(this);
+
+    if (process->state() == QProcess::Running && !unsent.isEmpty())
+    {
+        process->write(unsent);
+        unsent.clear();
+    }
+
+    // the answers to the calls it has got still count
+    auto partial = std::make_shared<QByteArray>(host.partial);
+
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, process, name, partial]() {
+        const QList<QByteArray> lines = takeLines(*partial, process->readAllStandardOutput());
+
+        for (const QByteArray& line : lines)
+            handleHostLine(name, QString::fromUtf8(line));
+    });
+    connect(process, &QProcess::finished, process, &QObject::deleteLater);
+    connect(process, &QProcess::errorOccurred, process, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            process->deleteLater();
+    });
+
+    if (process->state() == QProcess::NotRunning)
+        process->deleteLater();
+    else
+    {
+        process->closeWriteChannel();
+        QTimer::singleShot(hostExitTimeout, process, &KProcess::kill);
+    }
+
+    return unsent;
+}
+
+void ScriptLauncher::scheduleFlush()
+{
+    if (m_flushScheduled)
+        return;
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, &ScriptLauncher::flushHosts);
+}
+
+void ScriptLauncher::flushHosts()
+{
+    m_flushScheduled = false;
+
+    QStringList unstarted;
+
+    for (auto it = m_hosts.begin(); it != m_hosts.end(); ++it)
+    {
+        if (!it->started)
+        {
+            it->started = true;
+            unstarted << it.key();
+            continue;
+        }
+
+        // still starting ones are flushed once started
+        if (it->pending.isEmpty() || it->process->state() != QProcess::Running)
+            continue;
+
+        it->process->write(it->pending);
+        it->pending.clear();
+    }
+
+    // failing to start removes the host right away
+    for (const QString& path : std::as_const(unstarted))
+    {
+        auto it = m_hosts.constFind(path);
+
+        if (it == m_hosts.constEnd())
+            continue;
+
+        qCDebug(KONVERSATION_LOG) << "Starting script host" << path;
+
+        it->process->start();
+    }
+}
+
+void ScriptLauncher::readHost(const QString& path)
+{
+    auto it = m_hosts.find(path);
+
+    if (it == m_hosts.end())
+        return;
+
+    const QString name = it->name;
+    const QList<QByteArray> lines = takeLines(it->partial, it->process->readAllStandardOutput());
+
+    // handling a line may end up here again, "it" is not to be used anymore
+    for (const QByteArray& line : lines)
+        handleHostLine(name, QString::fromUtf8(line));
+}
+
+void ScriptLauncher::handleHostLine(const QString& name, const QString& hostLine)
+{
+    QString line = hostLine;
+
+    // of a host writing CRLF
+    if (line.endsWith(QLatin1Char('\r')))
+        line.chop(1);
+
+    const QString command = line.section(QLatin1Char('\t'), 0, 0);
+
+    // Carriage returns left would end the line sent to the server early, and
+    // start another one; cleaned up like DBus::say() does.
+    if (command == QLatin1String("say"))
+    {
+        QString connection = line.section(QLatin1Char('\t'), 1, 1);
+        QString target = line.section(QLatin1Char('\t'), 2, 2);
+        QString text = sterilizeUnicode(line.section(QLatin1Char('\t'), 3));
+
+        text.replace(QLatin1Char('\r'), QStringLiteral("\\r"));
+        target.remove(QLatin1Char('\r'));
+        connection.remove(QLatin1Char('\r'));
+
+        if (!connection.isEmpty() && !target.isEmpty() && !text.isEmpty())
+            Q_EMIT scriptSay(connection, target, text);
+    }
+    else if (command == QLatin1String("raw"))
+    {
+        QString connection = line.section(QLatin1Char('\t'), 1, 1);
+        QString text = sterilizeUnicode(line.section(QLatin1Char('\t'), 2));
+
+        text.remove(QLatin1Char('\r'));
+        connection.remove(QLatin1Char('\r'));
+
+        if (!connection.isEmpty() && !text.isEmpty())
+            Q_EMIT scriptRaw(connection, text);
+    }
+    else if (command == QLatin1String("info"))
+        Q_EMIT scriptInfo(sterilizeUnicode(line.section(QLatin1Char('\t'), 1)));
+    else if (command == QLatin1String("error"))
+        Q_EMIT scriptInfo(i18n("Error: %1", sterilizeUnicode(line.section(QLatin1Char('\t'), 1))));
+    else if (!line.isEmpty())
+        qCDebug(KONVERSATION_LOG) << "Unknown command from script host" << name << ":" << line;
+}
+
+void ScriptLauncher::hostFinished(const QString& path, bool crashed)
+{
+    const Host host = m_hosts.take(path);
+
+    if (!host.process)
+        return;
+
+    qCDebug(KONVERSATION_LOG) << "Script host" << path << "exited:" << host.process->errorString();
+
+    host.process->disconnect(this);
+    host.process->deleteLater();
+
+    // started again by the next call
+    if (crashed)
+    {
+        if (!QFileInfo::exists(path))
+            Q_EMIT scriptNotFound(host.name);
+        else
+            Q_EMIT scriptExecutionError(host.name);
+    }
+    else if (!host.pending.isEmpty())
+    {
+        // exited before getting these calls, they go to a new one
+        qCDebug(KONVERSATION_LOG) << "Restarting script host" << path << "for the calls it did not get";
+
+        this->host(host.name, path)->pending = host.pending;
+        scheduleFlush();
+    }
+}
+
 #include "moc_scriptlauncher.cpp"
@@ -5,11 +5,24 @@
     SPDX-FileCopyrightText: 2004 Peter Simonsson <psn@linux.se>
 */
 
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
 
 #ifndef SCRIPTLAUNCHER_H
 #define SCRIPTLAUNCHER_H
 
+class KProcess;
+
+/**
+ * Runs the scripts called with /exec.
+ *
+ * A script is started once per call, unless it contains the marker
+ * "konversation-script-host" near its beginning. Such a script is kept
+ * running as a host: it is started on its first call, gets each call as a
+ * line on its standard input and answers with lines on its standard output,
+ * rather than through D-Bus. See data/scripts/README for the protocol.
+ */
 class ScriptLauncher : public QObject
 {
     Q_OBJECT
@@ -27,7 +40,49 @@ class ScriptLauncher : public QObject
         void scriptNotFound(const QString& name);
         void scriptExecutionError(const QString& name);
 
+        /// Commands of the script hosts, like their D-Bus counterparts.
+        void scriptSay(const QString& connection, const QString& target, const QString& text);
+        void scriptRaw(const QString& connection, const QString& command);
+        void scriptInfo(const QString& text);
+
     private:
+        struct Host
+        {
+            QString name;
+            KProcess* process = nullptr;
+            /// Events not written yet; written all at once when control returns to the event loop.
+            QByteArray pending;
+            /// Output short of a full line.
+            QByteArray partial;
+            /// Of the script the process runs.
+            QDateTime modified;
+            /// Started on the next flush, so that no failure to start is reported while calling it.
+            bool started = false;
+        };
+
+        struct HostMarker
+        {
+            QDateTime modified;
+            bool isHost = false;
+        };
+
+        bool isHostScript(const QString& path);
+        /// The host of the script at @p path, created but not started yet if there is none.
+        Host* host(const QString& name, const QString& path);
+        /// Lets the host of @p path exit after the calls it has; returns the calls it did not get.
+        QByteArray retireHost(const QString& path);
+        /// Flushes the hosts once control returns to the event loop.
+        void scheduleFlush();
+        void flushHosts();
+        void readHost(const QString& path);
+        void handleHostLine(const QString& name, const QString& line);
+        void hostFinished(const QString& path, bool crashed);
+
+        QHash<QString, Host> m_hosts;
+        /// Whether the scripts are hosts, by path; looked at again once modified.
+        QHash<QString, HostMarker> m_hostMarkers;
+        bool m_flushScheduled;
+
         Q_DISABLE_COPY(ScriptLauncher)
 };
 
@@ -31,6 +31,17 @@
 #define UTF8_6Bytes(c) ( k6BytesLeadByte == ((c) & kLeft7BitsMask))
 #define UTF8_ValidTrialByte(c) ( kTrialByte == ((c) & kLeft2BitsMask))
 
+#include <QtGlobal>
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace Konversation {
 
 bool isUtf8(const QByteArray& text)
@@ -140,4 +151,142 @@ bool isUtf8(const QByteArray& text)
     return true;
 }
 
+/// Returns the position of the first byte from @p from on that is not ASCII
+/// or is an escape character, which may start a JIS sequence, or @p size.
+static qsizetype skipAscii(const char* data, qsizetype from, qsizetype size)
+{
+    qsizetype i = from;
+
+#if defined(__AVX2__)
+    const __m256i escape256 = _mm256_set1_epi8(0x1B);
+
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const uint mask = uint(_mm256_movemask_epi8(chunk))
+                        | uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, escape256)));
+
+        if (mask)
+            return i + qCountTrailingZeroBits(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i escape = _mm_set1_epi8(0x1B);
+
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const uint mask = uint(_mm_movemask_epi8(chunk))
+                        | uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, escape)));
+
+        if (mask)
+            return i + qCountTrailingZeroBits(mask);
+    }
+#else
+    // eight bytes at a time, the bytewise loop below finds the exact position
+    for (; i + 8 <= size; i += 8)
+    {
+        quint64 word;
+        std::memcpy(&word, data + i, sizeof(word));
+
+        const quint64 escapes = word ^ Q_UINT64_C(0x1B1B1B1B1B1B1B1B);
+        const quint64 zeroBytes = (escapes - Q_UINT64_C(0x0101010101010101)) & ~escapes;
+
+        if ((word | zeroBytes) & Q_UINT64_C(0x8080808080808080))
+            break;
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        const uchar c = data[i];
+
+        if (c >= 0x80 || c == 0x1B)
+            break;
+    }
+
+    return i;
+}
+
+/// The byte sequence check of isUtf8() from @p from on, skipping runs of ASCII.
+static bool isUtf8Sequence(const char* data, qsizetype from, qsizetype size)
+{
+    qsizetype clen = 0;
+
+    for (qsizetype i = from; i < size; i += clen)
+    {
+        const uchar c = data[i];
+
+        if(UTF8_1Byte(c))
+        {
+            clen = skipAscii(data, i + 1, size) - i;
+            continue;
+        }
+        else if(UTF8_2Bytes(c))
+        {
+            clen = 2;
+
+            if( (i + clen) > size)
+                return false;
+
+            if(0 ==  (c & 0x1E ))
+                return false;
+        }
+        else if(UTF8_3Bytes(c))
+        {
+            clen = 3;
+
+            if( (i + clen) > size)
+                return false;
+
+            if((0xED == c) && (0xA0 == (data[i+1] & 0xA0 ) ))
+                return false;
+
+            if((0 ==  (c & 0x0F )) && (0 ==  (data[i+1] & 0x20 ) ))
+                return false;
+        }
+        else if(UTF8_4Bytes(c))
+        {
+            clen = 4;
+
+            if( (i + clen) > size)
+                return false;
+
+            if((0 ==  (c & 0x07 )) && (0 ==  (data[i+1] & 0x30 )) )
+                return false;
+        }
+        else if(UTF8_5Bytes(c))
+        {
+            clen = 5;
+
+            if( (i + clen) > size)
+                return false;
+
+            if((0 ==  (c & 0x03 )) && (0 ==  (data[i+1] & 0x38 )) )
+                return false;
+        }
+        else if(UTF8_6Bytes(c))
+        {
+            clen = 6;
+
+            if( (i + clen) > size)
+                return false;
+
+            if((0 ==  (c & 0x01 )) && (0 ==  (data[i+1] & 0x3E )) )
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+
+        for(qsizetype j = 1; j<clen ;++j)
+        {
+            if(! UTF8_ValidTrialByte(data[i+j]))
+                return false;
+        }
+    }
+    return true;
+}
+
 }
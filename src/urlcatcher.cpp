@@ -6,6 +6,7 @@
 
 #include "urlcatcher.h"
 #include "application.h"
+#include "urlcatchermodel.h"
 
 #include <QClipboard>
 #include <QTreeView>
@@ -21,23 +22,6 @@
 #include <KMessageBox>
 #include <KToolBar>
 
-UrlDateItem::UrlDateItem(const QDateTime& dateTime)
-{
-    setData(dateTime);
-}
-
-UrlDateItem::~UrlDateItem()
-{
-}
-
-QVariant UrlDateItem::data(int role) const
-{
-    if (role == Qt::DisplayRole)
-        return QLocale().toString(QStandardItem::data().toDateTime(), QLocale::ShortFormat);
-
-    return QStandardItem::data(role);
-}
-
 UrlSortFilterProxyModel::UrlSortFilterProxyModel(QObject* parent) : QSortFilterProxyModel(parent)
 {
 }
@@ -55,8 +39,8 @@ bool UrlSortFilterProxyModel::lessThan(const QModelIndex& left, const QModelInde
 {
     if (sortColumn() == 2)
     {
-        QVariant leftData = sourceModel()->data(left, Qt::UserRole + 1);
-        QVariant rightData = sourceModel()->data(right, Qt::UserRole + 1);
+        QVariant leftData = sourceModel()->data(left, UrlCatcherModel::DateTimeRole);
+        QVariant rightData = sourceModel()->data(right, UrlCatcherModel::DateTimeRole);
 
         return leftData.toDateTime() < rightData.toDateTime();
     }
@@ -164,15 +148,10 @@ void UrlCatcher::setupUrlTree()
     connect(m_urlTree, &QTreeView::doubleClicked, this, &UrlCatcher::openUrl);
 
     Application* konvApp = Application::instance();
-    QStandardItemModel* urlModel = konvApp->getUrlModel();
-    auto* item = new QStandardItem(i18n("From"));
-    urlModel->setHorizontalHeaderItem(0, item);
-    item = new QStandardItem(i18n("URL"));
-    urlModel->setHorizontalHeaderItem(1, item);
-    item = new QStandardItem(i18n("Date"));
-    urlModel->setHorizontalHeaderItem(2, item);
-    connect(urlModel, &QStandardItemModel::rowsInserted, this, &UrlCatcher::updateListActionStates);
-    connect(urlModel, &QStandardItemModel::rowsRemoved, this, &UrlCatcher::updateListActionStates);
+    UrlCatcherModel* urlModel = konvApp->getUrlModel();
+    connect(urlModel, &UrlCatcherModel::rowsInserted, this, &UrlCatcher::updateListActionStates);
+    connect(urlModel, &UrlCatcherModel::rowsRemoved, this, &UrlCatcher::updateListActionStates);
+    connect(urlModel, &UrlCatcherModel::modelReset, this, &UrlCatcher::updateListActionStates);
 
     auto* proxyModel = new UrlSortFilterProxyModel(this);
     proxyModel->setSourceModel(urlModel);
@@ -316,10 +295,11 @@ void UrlCatcher::deleteSelectedUrls()
 {
     QList<QPersistentModelIndex> selectedIndices;
 
-    const auto nonPersistentSelectedIndices = m_urlTree->selectionModel()->selectedIndexes();
+    auto* proxy = qobject_cast<QSortFilterProxyModel*>(m_urlTree->model());
+    const auto nonPersistentSelectedIndices = m_urlTree->selectionModel()->selectedRows();
     selectedIndices.reserve(nonPersistentSelectedIndices.size());
     for (const QModelIndex& index : nonPersistentSelectedIndices)
-        selectedIndices << index;
+        selectedIndices << proxy->mapToSource(index);
 
     Application* konvApp = Application::instance();
 
@@ -335,7 +315,7 @@ void UrlCatcher::saveUrlModel()
     if (!target.isEmpty())
     {
         Application* konvApp = Application::instance();
-        QStandardItemModel* urlModel = konvApp->getUrlModel();
+        UrlCatcherModel* urlModel = konvApp->getUrlModel();
 
         int nickColumnWidth = 0;
 
@@ -376,7 +356,7 @@ void UrlCatcher::saveUrlModel()
 void UrlCatcher::clearUrlModel()
 {
     Application* konvApp = Application::instance();
-    QStandardItemModel* urlModel = konvApp->getUrlModel();
+    UrlCatcherModel* urlModel = konvApp->getUrlModel();
 
     urlModel->removeRows(0, urlModel->rowCount());
 }
@@ -390,7 +370,7 @@ bool UrlCatcher::event(QEvent* event)
 {
     if (event->type() == QEvent::LocaleChange) {
         Application* konvApp = Application::instance();
-        QStandardItemModel* urlModel = konvApp->getUrlModel();
+        UrlCatcherModel* urlModel = konvApp->getUrlModel();
 
         m_urlTree->dataChanged(urlModel->index(0, 0), urlModel->index(urlModel->rowCount() - 1, 2));
     }
@@ -8,7 +8,6 @@
 #define URLCATCHER_H
 
 #include <QSortFilterProxyModel>
-#include <QStandardItem>
 
 #include "chatwindow.h"
 
@@ -19,19 +18,6 @@ class QMenu;
 class KToolBar;
 
 
-class UrlDateItem : public QStandardItem
-{
-    public:
-        explicit UrlDateItem(const QDateTime& dateTime);
-        ~UrlDateItem() override;
-
-        QVariant data(int role) const override;
-
-  private:
-        Q_DISABLE_COPY(UrlDateItem)
-};
-
-
 class UrlSortFilterProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
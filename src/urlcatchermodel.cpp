@@ -0,0 +1,387 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "urlcatchermodel.h"
+
+#include "konversation_log.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+#include <bit>
+
+
+static const quint32 UrlListMagic = 0x4b55524c; // "KURL"
+static const quint32 UrlListVersion = 1;
+
+UrlCatcherModel::UrlCatcherModel(QObject* parent)
+    : QAbstractTableModel(parent)
+    , m_liveTree(1, 0)
+    , m_liveCount(0)
+    , m_nextSerial(0)
+    , m_maxEntries(0)
+    , m_maxAgeDays(0)
+{
+}
+
+UrlCatcherModel::~UrlCatcherModel()
+{
+}
+
+QString UrlCatcherModel::storageFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QLatin1String("/urlcatcher.dat");
+}
+
+void UrlCatcherModel::addUrl(const QString& origin, const QString& url, const QDateTime& dateTime)
+{
+    const UrlKey key(origin, url);
+
+    const auto it = m_index.constFind(key);
+
+    if (it != m_index.constEnd())
+    {
+        const qsizetype existing = indexOfSerial(it.value());
+
+        if (existing >= 0)
+        {
+            const int row = rowForIndex(existing);
+
+            if (row == 0)
+            {
+                // Already the most recent entry, just refresh its time.
+                m_entries[existing].dateTime = dateTime;
+                Q_EMIT dataChanged(index(0, DateColumn), index(0, DateColumn));
+
+                return;
+            }
+
+            removeRowRange(row, row);
+        }
+    }
+
+    beginInsertRows(QModelIndex(), 0, 0);
+
+    appendEntry(UrlEntry { origin, url, dateTime, m_nextSerial, false });
+    m_index.insert(key, m_nextSerial);
+    ++m_nextSerial;
+
+    endInsertRows();
+
+    prune();
+}
+
+void UrlCatcherModel::setLimits(int maxEntries, int maxAgeDays)
+{
+    m_maxEntries = qMax(maxEntries, 0);
+    m_maxAgeDays = qMax(maxAgeDays, 0);
+
+    prune();
+}
+
+bool UrlCatcherModel::load(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+
+    if (magic != UrlListMagic || version != UrlListVersion)
+    {
+        qCWarning(KONVERSATION_LOG) << "Ignoring URL list with unknown format:" << fileName;
+        return false;
+    }
+
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    qint32 count;
+    stream >> count;
+
+    QList<UrlEntry> entries;
+    entries.reserve(qMax(count, 0));
+
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        UrlEntry entry;
+        entry.removed = false;
+        stream >> entry.origin >> entry.url >> entry.dateTime;
+        entries.append(entry);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        qCWarning(KONVERSATION_LOG) << "Ignoring truncated URL list:" << fileName;
+        return false;
+    }
+
+    beginResetModel();
+
+    m_entries = entries;
+    compact();
+
+    m_index.clear();
+    m_index.reserve(m_entries.count());
+
+    for (UrlEntry& entry : m_entries)
+    {
+        entry.serial = m_nextSerial++;
+        // Should there be duplicates the newest entry wins the index.
+        m_index.insert(UrlKey(entry.origin, entry.url), entry.serial);
+    }
+
+    endResetModel();
+
+    prune();
+
+    return true;
+}
+
+bool UrlCatcherModel::save(const QString& fileName) const
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+
+    stream << UrlListMagic << UrlListVersion;
+
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << static_cast<qint32>(m_liveCount);
+
+    for (const UrlEntry& entry : m_entries)
+    {
+        if (!entry.removed)
+            stream << entry.origin << entry.url << entry.dateTime;
+    }
+
+    return file.commit();
+}
+
+qsizetype UrlCatcherModel::indexOfSerial(quint64 serial) const
+{
+    // Serials grow monotonically with the storage order.
+    const auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), serial,
+        [](const UrlEntry& entry, quint64 value) { return entry.serial < value; });
+
+    if (it == m_entries.constEnd() || it->serial != serial)
+        return -1;
+
+    return it - m_entries.constBegin();
+}
+
+qsizetype UrlCatcherModel::liveBefore(qsizetype index) const
+{
+    qsizetype live = 0;
+
+    for (qsizetype i = index; i > 0; i -= i & -i)
+        live += m_liveTree.at(i);
+
+    return live;
+}
+
+qsizetype UrlCatcherModel::nthLive(qsizetype rank) const
+{
+    const qsizetype size = m_entries.count();
+
+    qsizetype position = 0;
+    qsizetype remaining = rank + 1;
+
+    // Descend the tree, skipping every subtree holding fewer live entries
+    // than are still to be passed.
+    for (qsizetype step = std::bit_floor(static_cast<quint64>(size)); step > 0; step /= 2)
+    {
+        if (position + step <= size && m_liveTree.at(position + step) < remaining)
+        {
+            position += step;
+            remaining -= m_liveTree.at(position);
+        }
+    }
+
+    return position;
+}
+
+void UrlCatcherModel::appendEntry(const UrlEntry& entry)
+{
+    m_entries.append(entry);
+
+    // The new tree node covers the positions (position - lowest, position].
+    const qsizetype position = m_entries.count();
+    const qsizetype lowest = position & -position;
+
+    m_liveTree.append(1 + liveBefore(position - 1) - liveBefore(position - lowest));
+    ++m_liveCount;
+}
+
+void UrlCatcherModel::removeRowRange(int first, int last)
+{
+    beginRemoveRows(QModelIndex(), first, last);
+
+    // Resolve all rows before marking any, marking shifts the rows below.
+    QList<qsizetype> positions;
+    positions.reserve(last - first + 1);
+
+    for (int row = first; row <= last; ++row)
+        positions.append(indexForRow(row));
+
+    for (const qsizetype position : std::as_const(positions))
+    {
+        UrlEntry& entry = m_entries[position];
+        const UrlKey key(entry.origin, entry.url);
+
+        if (m_index.value(key) == entry.serial)
+            m_index.remove(key);
+
+        entry.removed = true;
+        entry.origin.clear();
+        entry.url.clear();
+
+        for (qsizetype i = position + 1; i < m_liveTree.count(); i += i & -i)
+            --m_liveTree[i];
+    }
+
+    m_liveCount -= positions.count();
+
+    endRemoveRows();
+
+    if (m_entries.count() - m_liveCount > m_liveCount)
+        compact();
+}
+
+void UrlCatcherModel::compact()
+{
+    // Rows are unaffected, the live entries keep their order.
+    m_entries.removeIf([](const UrlEntry& entry) { return entry.removed; });
+    m_liveCount = m_entries.count();
+
+    m_liveTree.fill(0, m_liveCount + 1);
+
+    for (qsizetype i = 1; i <= m_liveCount; ++i)
+    {
+        ++m_liveTree[i];
+
+        const qsizetype parent = i + (i & -i);
+
+        if (parent <= m_liveCount)
+            m_liveTree[parent] += m_liveTree.at(i);
+    }
+}
+
+void UrlCatcherModel::prune()
+{
+    qsizetype excess = 0;
+
+    if (m_maxEntries > 0 && m_liveCount > m_maxEntries)
+        excess = m_liveCount - m_maxEntries;
+
+    if (m_maxAgeDays > 0)
+    {
+        const QDateTime cutoff = QDateTime::currentDateTime().addDays(-m_maxAgeDays);
+
+        while (excess < m_liveCount && m_entries.at(nthLive(excess)).dateTime < cutoff)
+            ++excess;
+    }
+
+    // The oldest entries are the last rows.
+    if (excess > 0)
+        removeRowRange(static_cast<int>(m_liveCount - excess), static_cast<int>(m_liveCount - 1));
+}
+
+QVariant UrlCatcherModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_liveCount)
+        return QVariant();
+
+    const UrlEntry& entry = m_entries.at(indexForRow(index.row()));
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (index.column())
+        {
+            case OriginColumn:
+                return entry.origin;
+            case UrlColumn:
+                return entry.url;
+            case DateColumn:
+                return QLocale().toString(entry.dateTime, QLocale::ShortFormat);
+        }
+    }
+    else if (role == DateTimeRole && index.column() == DateColumn)
+        return QVariant(entry.dateTime);
+
+    return QVariant();
+}
+
+QVariant UrlCatcherModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QVariant();
+
+    switch (section)
+    {
+        case OriginColumn:
+            return i18n("From");
+        case UrlColumn:
+            return i18n("URL");
+        case DateColumn:
+            return i18n("Date");
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags UrlCatcherModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+}
+
+int UrlCatcherModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return ColumnCount;
+}
+
+int UrlCatcherModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>(m_liveCount);
+}
+
+bool UrlCatcherModel::removeRows(int row, int count, const QModelIndex& parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > m_liveCount)
+        return false;
+
+    removeRowRange(row, row + count - 1);
+
+    return true;
+}
+
+#include "moc_urlcatchermodel.cpp"
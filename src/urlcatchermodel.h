@@ -0,0 +1,112 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef URLCATCHERMODEL_H
+#define URLCATCHERMODEL_H
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+
+/**
+ * The list of URLs caught in any of the chat windows.
+ *
+ * Entries are stored oldest first, so new URLs are appended in O(1), and
+ * presented newest first (row 0 is the most recent URL). A hash index on
+ * (origin, url) finds duplicates without scanning the list. The list can
+ * be capped by entry count and by age, oldest entries are dropped first.
+ *
+ * Removed entries are only marked as such and dropped from the storage
+ * once they outnumber the live ones. A binary indexed tree over the live
+ * flags maps rows to storage positions in O(log n).
+ */
+class UrlCatcherModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+    public:
+        enum Column
+        {
+            OriginColumn = 0,
+            UrlColumn,
+            DateColumn,
+            ColumnCount
+        };
+
+        /// Role holding the QDateTime of an entry, used for sorting.
+        static constexpr int DateTimeRole = Qt::UserRole + 1;
+
+        explicit UrlCatcherModel(QObject* parent = nullptr);
+        ~UrlCatcherModel() override;
+
+        void addUrl(const QString& origin, const QString& url, const QDateTime& dateTime);
+
+        /**
+         * @param maxEntries maximum number of entries kept, 0 for no limit
+         * @param maxAgeDays maximum age of entries in days, 0 for no limit
+         */
+        void setLimits(int maxEntries, int maxAgeDays);
+
+        bool load(const QString& fileName);
+        bool save(const QString& fileName) const;
+
+        /// Location of the URL list when it is kept across sessions.
+        static QString storageFileName();
+
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+        QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+        Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+        int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+
+        bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+
+    private:
+        struct UrlEntry
+        {
+            QString origin;
+            QString url;
+            QDateTime dateTime;
+            quint64 serial;
+            bool removed;
+        };
+
+        using UrlKey = QPair<QString, QString>;
+
+        int rowForIndex(qsizetype index) const { return static_cast<int>(m_liveCount - 1 - liveBefore(index)); }
+        qsizetype indexForRow(int row) const { return nthLive(m_liveCount - 1 - row); }
+        qsizetype indexOfSerial(quint64 serial) const;
+
+        /// Number of live entries stored before @p index.
+        qsizetype liveBefore(qsizetype index) const;
+        /// Storage position of the live entry with the given rank, oldest first.
+        qsizetype nthLive(qsizetype rank) const;
+
+        void appendEntry(const UrlEntry& entry);
+        void removeRowRange(int first, int last);
+        void compact();
+        void prune();
+
+    private:
+        QList<UrlEntry> m_entries;
+        /// Binary indexed tree of the live flags, 1-based.
+        QList<qsizetype> m_liveTree;
+        qsizetype m_liveCount;
+
+        QHash<UrlKey, quint64> m_index;
+        quint64 m_nextSerial;
+
+        int m_maxEntries;
+        int m_maxAgeDays;
+
+        Q_DISABLE_COPY(UrlCatcherModel)
+};
+
+#endif
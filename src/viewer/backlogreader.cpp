@@ -0,0 +1,103 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "backlogreader.h"
+
+#include <QByteArrayView>
+#include <QFile>
+
+#include <algorithm>
+
+namespace Konversation
+{
+    /**
+     * Collects chat lines from the end of @p data, newest first.
+     * @p fromStart tells whether @p data begins at the start of the file,
+     * otherwise its first line may be cut off and is never used.
+     * @return false if more data in front of @p data is needed
+     */
+    static bool scanBackwards(QByteArrayView data, bool fromStart, int maxLines, QList<BacklogLine>& lines)
+    {
+        lines.clear();
+
+        qsizetype end = data.size();
+
+        // skip the terminator of the last line
+        if (end > 0 && data.at(end - 1) == '\n')
+            --end;
+
+        while (lines.count() < maxLines)
+        {
+            const qsizetype newline = (end > 0) ? data.lastIndexOf('\n', end - 1) : -1;
+
+            if (newline < 0 && !fromStart)
+                return false;
+
+            const qsizetype start = newline + 1;
+            QByteArrayView line = data.sliced(start, end - start);
+
+            if (line.endsWith('\r'))
+                line.chop(1);
+
+            // if a tab character is present in the line, meaning it is a valid chatline
+            const qsizetype tabIndex = line.indexOf('\t');
+            if (tabIndex != -1)
+            {
+                // Logfile is in utf8 so we don't need to do encoding stuff here
+                lines.append(BacklogLine { QString::fromUtf8(line.first(tabIndex)),
+                                           QString::fromUtf8(line.sliced(tabIndex + 1)) });
+            }
+
+            if (newline < 0)
+                break;
+
+            end = newline;
+        }
+
+        return true;
+    }
+
+    QList<BacklogLine> readBacklog(QFile& file, int maxLines, qint64 end)
+    {
+        QList<BacklogLine> lines;
+
+        const qint64 size = (end < 0) ? file.size() : qMin(end, file.size());
+
+        if (maxLines <= 0 || size <= 0)
+            return lines;
+
+        if (uchar* mapped = file.map(0, size))
+        {
+            scanBackwards(QByteArrayView(mapped, size), true, maxLines, lines);
+            file.unmap(mapped);
+        }
+        else
+        {
+            // Mapping is not supported by every file system, read growing
+            // windows from the end of the file instead.
+            qint64 window = 64 * 1024;
+
+            while (true)
+            {
+                window = qMin(window, size);
+
+                if (!file.seek(size - window))
+                    break;
+
+                const QByteArray tail = file.read(window);
+
+                if (scanBackwards(tail, window == size, maxLines, lines) || window == size)
+                    break;
+
+                window *= 4;
+            }
+        }
+
+        std::reverse(lines.begin(), lines.end());
+
+        return lines;
+    }
+}
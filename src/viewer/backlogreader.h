@@ -0,0 +1,36 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef BACKLOGREADER_H
+#define BACKLOGREADER_H
+
+#include <QList>
+#include <QString>
+
+class QFile;
+
+namespace Konversation
+{
+    /// A chat line from a log file, split at the first tab character.
+    struct BacklogLine
+    {
+        QString firstColumn;
+        QString message;
+    };
+
+    /**
+     * Reads the last @p maxLines chat lines of an open log file, of its
+     * first @p end bytes if given.
+     *
+     * The file is memory-mapped and scanned backwards from its end, so only
+     * the tail that is actually shown gets touched and decoded. Lines without
+     * a tab character (e.g. the "Logfile started" intro) are not chat lines
+     * and are skipped. The result is in file order.
+     */
+    QList<BacklogLine> readBacklog(QFile& file, int maxLines, qint64 end = -1);
+}
+
+#endif
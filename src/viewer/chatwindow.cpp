@@ -14,6 +14,7 @@
 #include "server.h"
 #include "application.h"
 #include "logfilereader.h"
+#include "pipelinestats.h"
 #include "viewcontainer.h"
 #include "konversation_log.h"
 
@@ -26,6 +27,8 @@
 #include <QScrollBar>
 #include <QLocale>
 
+#include <utility>
+
 
 ChatWindow::ChatWindow(QWidget* parent) : QWidget(parent)
 {
@@ -267,10 +270,10 @@ void ChatWindow::setTextView(IRCView* newView)
     connect(textView, &IRCView::clearStatusBarTempText, this, &ChatWindow::clearStatusBarTempText);
 }
 
-void ChatWindow::appendRaw(const QString& message, bool self)
+void ChatWindow::appendRaw(const QString& message, bool self, const QHash<QString, QString> &messageTags)
 {
     if(!textView) return;
-    textView->appendRaw(message, self);
+    textView->appendRaw(message, self, messageTags);
 }
 
 void ChatWindow::appendLog(const QString& message)
@@ -319,6 +322,16 @@ void ChatWindow::appendBacklogMessage(const QString& firstColumn,const QString&
     textView->appendBacklogMessage(firstColumn,Konversation::sterilizeUnicode(message));
 }
 
+void ChatWindow::insertBacklog(QList<Konversation::BacklogLine> lines)
+{
+    if(!textView) return ;
+
+    for (Konversation::BacklogLine& line : lines)
+        Konversation::sterilizeUnicode(line.message);
+
+    textView->prependBacklogMessages(lines);
+}
+
 void ChatWindow::clear()
 {
     if (!textView) return;
@@ -387,111 +400,44 @@ void ChatWindow::setLogfileName(const QString& name)
             cdIntoLogPath();
             // Show last log lines. This idea was stole ... um ... inspired by PMP :)
             // Don't do this for the server status windows, though
-            if((getType() != Status) && logfile.open(QIODevice::ReadOnly))
+            if((getType() != Status) && logfile.exists())
             {
-                qint64 filePosition;
-
-                QTextStream backlog(&logfile);
-                backlog.setAutoDetectUnicode(true);
-
-                QStringList firstColumns;
-                QStringList messages;
-                int offset = 0;
-                qint64 lastPacketHeadPosition = backlog.device()->size();
-                const unsigned int packetSize = 4096;
-                while(messages.count() < Preferences::self()->backlogLines() && backlog.device()->size() > packetSize * offset)
-                {
-                    QStringList firstColumnsInPacket;
-                    QStringList messagesInPacket;
-
-                    // packetSize * offset < size <= packetSize * ( offset + 1 )
-
-                    // Check if the log is bigger than packetSize * ( offset + 1 )
-                    if(backlog.device()->size() > packetSize * ( offset + 1 ))
-                    {
-                        // Set file pointer to the packet size above the offset
-                        backlog.seek(backlog.device()->size() - packetSize * ( offset + 1 ));
-                        // Skip first line, since it may be incomplete
-                        backlog.readLine();
-                    }
-                    else
-                    {
-                        // Set file pointer to the head
-
-                        // Qt 4.5 Doc: Note that when using a QTextStream on a
-                        // QFile, calling reset() on the QFile will not have the
-                        // expected result because QTextStream buffers the  file.
-                        // Use the QTextStream::seek() function instead.
-                        // backlog.device()->reset();
-                        backlog.seek( 0 );
-                    }
-
-                    // remember actual file position to check for deadlocks
-                    filePosition = backlog.pos();
-
-                    qint64 currentPacketHeadPosition = filePosition;
-
-                    // Loop until end of file reached
-                    while(!backlog.atEnd() && filePosition < lastPacketHeadPosition)
-                    {
-                        const QString backlogFileLine = backlog.readLine();
-
-                        // check for deadlocks
-                        if(backlog.pos() == filePosition)
-                        {
-                            backlog.seek(filePosition + 1);
-                        }
-
-                        // if a tab character is present in the line, meaning it is a valid chatline
-                        const int tabIndex = backlogFileLine.indexOf(QLatin1Char('\t'));
-                        if (tabIndex != -1) {
-                            // extract first column from log
-                            const QString backlogFirst = backlogFileLine.left(tabIndex);
-                            // cut first column from line
-                            const QString backlogLine = backlogFileLine.mid(tabIndex + 1);
-                            // Logfile is in utf8 so we don't need to do encoding stuff here
-                            // append backlog with time and first column to text view
-                            firstColumnsInPacket << backlogFirst;
-                            messagesInPacket << backlogLine;
-                        }
-
-                        // remember actual file position to check for deadlocks
-                        filePosition = backlog.pos();
-                    } // while
-
-                    // remember the position not to read the same lines again
-                    lastPacketHeadPosition = currentPacketHeadPosition;
-                    ++offset;
-
-                    firstColumns = firstColumnsInPacket + firstColumns;
-                    messages = messagesInPacket + messages;
-                }
-                backlog.setDevice(nullptr);
-                logfile.close();
-
-                // trim
-                int surplus = messages.count() - Preferences::self()->backlogLines();
-                // "surplus" can be a minus value. (when the backlog is too short)
-                if(surplus > 0)
-                {
-                    for(int i = 0 ; i < surplus ; ++i)
-                    {
-                        firstColumns.pop_front();
-                        messages.pop_front();
-                    }
-                }
-
-                QStringList::Iterator itFirstColumn = firstColumns.begin();
-                QStringList::Iterator itMessage = messages.begin();
-                for( ; itFirstColumn != firstColumns.end() ; ++itFirstColumn, ++itMessage )
-                    appendBacklogMessage(*itFirstColumn, *itMessage);
+                // Views opened in the background, e.g. by auto-join, read it when they
+                // are first shown; lines logged in the meantime are in the view already.
+                m_backlogEnd = logfile.size();
+
+                if (isVisible())
+                    loadBacklog();
             }
         } // if(Preferences::showBacklog())
     }
 }
 
+void ChatWindow::loadBacklog()
+{
+    const qint64 end = std::exchange(m_backlogEnd, -1);
+
+    if (end <= 0 || !logfile.open(QIODevice::ReadOnly))
+        return;
+
+    const QList<Konversation::BacklogLine> backlog = Konversation::readBacklog(logfile, Preferences::self()->backlogLines(), end);
+    logfile.close();
+
+    insertBacklog(backlog);
+}
+
+void ChatWindow::showEvent(QShowEvent* event)
+{
+    if (m_backlogEnd >= 0)
+        loadBacklog();
+
+    QWidget::showEvent(event);
+}
+
 void ChatWindow::logText(const QString& text)
 {
+    Konversation::PipelineTimer timer(Konversation::PipelineStats::Logging);
+
     if(log())
     {
         // "cd" into log path or create path, if it's not there
@@ -10,6 +10,7 @@
 
 #include "identity.h"
 #include "common.h"
+#include "backlogreader.h"
 
 #include <QFile>
 #include <QWidget>
@@ -81,7 +82,7 @@ class ChatWindow : public QWidget
         virtual void sendText(const QString& /*text*/) {}
 
         virtual void append(const QString& nickname,const QString& message, const QHash<QString, QString> &messageTags, const QString& label = QString());
-        virtual void appendRaw(const QString& message, bool self = false);
+        virtual void appendRaw(const QString& message, bool self = false, const QHash<QString, QString> &messageTags = QHash<QString, QString>());
         virtual void appendLog(const QString& message);
         virtual void appendQuery(const QString& nickname,const QString& message, const QHash<QString, QString> &messageTags = QHash<QString, QString>(), bool inChannel = false);
         virtual void appendAction(const QString& nickname,const QString& message, const QHash<QString, QString> &messageTags = QHash<QString, QString>());
@@ -89,6 +90,8 @@ class ChatWindow : public QWidget
         virtual void appendCommandMessage(const QString& command, const QString& message, const QHash<QString, QString> &messageTags = QHash<QString, QString>(),
             bool parseURL = true, bool self = false);
         virtual void appendBacklogMessage(const QString& firstColumn,const QString& message);
+        /// Inserts a whole block of backlog lines above the lines of the view at once.
+        void insertBacklog(QList<Konversation::BacklogLine> lines);
 
         void clear();
 
@@ -181,6 +184,8 @@ class ChatWindow : public QWidget
 
     protected:
         void childEvent(QChildEvent* event) override;
+        /// Loads the backlog on the first show. Reimplementations have to call it.
+        void showEvent(QShowEvent* event) override;
 
         /** Some children may handle the name themselves, and not want this public.
          *  Increase the visibility in the subclass if you want outsiders to call this.
@@ -195,6 +200,8 @@ class ChatWindow : public QWidget
         void setLogfileName(const QString& name);
         void setChannelEncodingSupported(bool enabled);
         void cdIntoLogPath();
+        /// Reads the backlog, up to m_backlogEnd, into the view.
+        void loadBacklog();
 
         int spacing();
         int margin();
@@ -222,6 +229,9 @@ class ChatWindow : public QWidget
 
         Server* m_server;
         QFile logfile;
+        /// Size of the log file when the view was opened, the backlog is read up to there
+        /// when the view is first shown; -1 if there is none to read.
+        qint64 m_backlogEnd = -1;
         WindowType type;
 
         bool m_isTopLevelView;
@@ -17,7 +17,10 @@
 #include "highlight.h"
 #include "sound.h"
 #include "notificationhandler.h"
+#include "dbus.h"
 #include "konversation_log.h"
+#include "ircformatting.h"
+#include "pipelinestats.h"
 
 #include <KStandardShortcut>
 #include <KUrlMimeData>
@@ -27,11 +30,49 @@
 #include <QScrollBar>
 #include <QTextBlock>
 #include <QPainter>
+#include <QRegularExpression>
 #include <QTextDocumentFragment>
 #include <QMimeData>
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 using namespace Konversation;
 
+/// Number of lines a hidden view collects before they are inserted anyway.
+static const int PendingLinesLimit = 500;
+/// Line time of the lines whose time is unknown, such as the backlog.
+static const qint64 UnknownLineTime = -1;
+
+/// When a backlog line was logged, from its "[date] [time] nick" column as
+/// ChatWindow::logText() writes it, in ms since the epoch; 0 if unknown.
+static qint64 backlogLineTime(const QString& firstColumn)
+{
+    static const QRegularExpression columns(QStringLiteral("^\\[([^\\]]*)\\] \\[([^\\]]*)\\]"));
+    const QRegularExpressionMatch match = columns.match(firstColumn);
+
+    if (!match.hasMatch())
+        return 0;
+
+    const QLocale locale;
+    const QDate date = locale.toDate(match.captured(1), QLocale::LongFormat);
+    QTime time = locale.toTime(match.captured(2), QLocale::LongFormat);
+
+    if (!time.isValid())
+    {
+        // not every time zone name parses back, go without it
+        QString format = locale.timeFormat(QLocale::LongFormat);
+        format.remove(QRegularExpression(QStringLiteral("\\s*t+")));
+        time = locale.toTime(match.captured(2).section(QLatin1Char(' '), 0, -2), format);
+    }
+
+    if (!date.isValid() || !time.isValid())
+        return 0;
+
+    return QDateTime(date, time).toMSecsSinceEpoch();
+}
+
 class ScrollBarPin
 {
         QPointer<QScrollBar> m_bar;
@@ -101,6 +142,8 @@ IRCView::IRCView(QWidget* parent) : QTextBrowser(parent), m_rememberLine(nullptr
     m_server = nullptr;
     m_fontSizeDelta = 0;
     m_showDate = false;
+    m_searchedLines = 0;
+    m_lineTime = 0;
 
     setAcceptDrops(false);
 
@@ -138,6 +181,11 @@ IRCView::IRCView(QWidget* parent) : QTextBrowser(parent), m_rememberLine(nullptr
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 
     setContextMenuOptions(IrcContextMenus::ShowTitle | IrcContextMenus::ShowFindAction, true);
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        if (value == verticalScrollBar()->minimum() && value < verticalScrollBar()->maximum())
+            requestHistory();
+    });
 }
 
 IRCView::~IRCView()
@@ -181,7 +229,18 @@ void IRCView::setServer(Server* newServer)
     if (m_server == newServer)
         return;
 
+    if (m_server)
+        disconnect(m_server, &Server::playbackFinished, this, nullptr);
+
     m_server = newServer;
+
+    if (m_server)
+    {
+        connect(m_server, &Server::playbackFinished, this, [this]() {
+            if (isVisible())
+                flushPendingLines();
+        });
+    }
 }
 
 void IRCView::setChatWin(ChatWindow* chatWin)
@@ -209,8 +268,12 @@ bool IRCView::search(const QString& pattern, QTextDocument::FindFlags flags, boo
     if (pattern.isEmpty())
         return true;
 
+    flushPendingLines();
+
     m_pattern       = pattern;
     m_searchFlags = flags;
+    m_searchMatches = m_scrollbackIndex.search(pattern, flags);
+    m_searchedLines = m_scrollbackIndex.endLine();
 
     if (!fromCursor)
         moveCursor(QTextCursor::End);
@@ -227,7 +290,131 @@ bool IRCView::searchNext(bool reversed)
     if(!reversed)
         flags |= QTextDocument::FindBackward;
 
-    return find(m_pattern, flags);
+    const bool backward = flags.testFlag(QTextDocument::FindBackward);
+
+    // pick up the lines appended since the last search
+    if (m_searchedLines < m_scrollbackIndex.endLine())
+    {
+        m_searchMatches += m_scrollbackIndex.search(m_pattern, m_searchFlags, m_searchedLines);
+        m_searchedLines = m_scrollbackIndex.endLine();
+    }
+
+    // First look in the rest of the current line...
+    const QTextCursor cursor = textCursor();
+    const int from = backward ? cursor.selectionStart() : cursor.selectionEnd();
+    const QTextBlock block = document()->findBlock(from);
+
+    if (selectMatch(block, from - block.position(), flags))
+        return true;
+
+    // ...then only in the lines the index found, instead of scanning the whole document.
+    QTextBlock textBlock = block;
+
+    while (textBlock.isValid() && textBlock.userState() < 0)
+        textBlock = textBlock.previous();
+
+    const int current = textBlock.isValid() ? textBlock.userState() : -1;
+
+    if (backward)
+    {
+        const int last = (textBlock == block) ? current - 1 : current;
+        auto it = std::upper_bound(m_searchMatches.cbegin(), m_searchMatches.cend(), last);
+
+        while (it != m_searchMatches.cbegin())
+        {
+            const QTextBlock match = blockForLine(*--it);
+
+            if (match.isValid() && selectMatch(match, match.length() - 1, flags))
+                return true;
+        }
+    }
+    else
+    {
+        for (auto it = std::upper_bound(m_searchMatches.cbegin(), m_searchMatches.cend(), current); it != m_searchMatches.cend(); ++it)
+        {
+            const QTextBlock match = blockForLine(*it);
+
+            if (match.isValid() && selectMatch(match, 0, flags))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool IRCView::selectMatch(const QTextBlock& block, qsizetype from, QTextDocument::FindFlags flags)
+{
+    const qsizetype pos = ScrollbackIndex::indexIn(block.text(), m_pattern, flags, from);
+
+    if (pos == -1)
+        return false;
+
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + pos);
+    cursor.setPosition(block.position() + pos + m_pattern.size(), QTextCursor::KeepAnchor);
+
+    setTextCursor(cursor);
+    ensureCursorVisible();
+
+    return true;
+}
+
+const ScrollbackIndex& IRCView::scrollbackIndex()
+{
+    flushPendingLines();
+
+    return m_scrollbackIndex;
+}
+
+bool IRCView::showLine(int lineId, const QString& pattern, QTextDocument::FindFlags flags)
+{
+    flushPendingLines();
+
+    const QTextBlock block = blockForLine(lineId);
+
+    if (!block.isValid())
+        return false;
+
+    m_pattern = pattern;
+    m_searchFlags = flags;
+
+    // let searchNext() look for the matches again
+    m_searchMatches.clear();
+    m_searchedLines = m_scrollbackIndex.firstLine();
+
+    if (!selectMatch(block, 0, flags & ~QTextDocument::FindBackward))
+    {
+        setTextCursor(QTextCursor(block));
+        ensureCursorVisible();
+    }
+
+    return true;
+}
+
+QTextBlock IRCView::blockForLine(int lineId) const
+{
+    // Line ids grow with the block numbers, the marker lines in between
+    // have none.
+    int low = 0;
+    int high = document()->blockCount() - 1;
+
+    while (low <= high)
+    {
+        const int middle = low + (high - low) / 2;
+        QTextBlock block = document()->findBlockByNumber(middle);
+
+        while (block.isValid() && block.userState() < 0)
+            block = block.next();
+
+        if (!block.isValid() || block.blockNumber() > high || block.userState() > lineId)
+            high = middle - 1;
+        else if (block.userState() < lineId)
+            low = block.blockNumber() + 1;
+        else
+            return block;
+    }
+
+    return QTextBlock();
 }
 
 class IrcViewMimeData : public QMimeData
@@ -413,7 +600,13 @@ void IRCView::cullMarkedLine(int, int, int) //slot
     QTextBlock prime = document()->firstBlock();
 
     if (prime.length() == 1 && document()->blockCount() == 1) //the entire document was wiped. was a signal such a burden? apparently..
+    {
         wipeLineParagraphs();
+        m_pendingLines.clear();
+        m_scrollbackIndex.clear();
+        m_searchMatches.clear();
+        m_searchedLines = m_scrollbackIndex.endLine();
+    }
 }
 
 void IRCView::insertMarkerLine() //slot
@@ -444,6 +637,10 @@ void IRCView::cancelRememberLine() //slot
 
 bool IRCView::lastBlockIsLine(int select)
 {
+    // the last line is a text line still waiting to be inserted
+    if (!m_pendingLines.isEmpty())
+        return false;
+
     Burr *b = dynamic_cast<Burr*>(document()->lastBlock().userData());
 
     int state = -1;
@@ -484,8 +681,15 @@ void IRCView::voidLineBlock(const QTextBlock &rem)
 {
     QTextCursor c(rem);
 
+    // The previous block takes over the user state of the removed one, keep its line id.
+    QTextBlock previous = rem.previous();
+    const int lineId = previous.userState();
+
     c.select(QTextCursor::BlockUnderCursor);
     c.removeSelectedText();
+
+    if (previous.isValid())
+        previous.setUserState(lineId);
 }
 
 void IRCView::clearLines()
@@ -509,6 +713,8 @@ bool IRCView::hasLines()
 
 Burr* IRCView::appendLine(IRCView::ObjectFormats type)
 {
+    flushPendingLines();
+
     ScrollBarPin barpin(verticalScrollBar());
     SelectionPin selpin(this);
 
@@ -661,6 +867,7 @@ void IRCView::append(const QString& nick, const QString& message, const QHash<QS
     QString channelColor = Preferences::self()->color(Preferences::ChannelMessage).name();
 
     m_tabNotification = Konversation::tnfNormal;
+    setLineTime(messageTags);
 
     QString nickLine = createNickLine(nick, channelColor);
 
@@ -684,7 +891,7 @@ void IRCView::append(const QString& nick, const QString& message, const QHash<QS
     doAppend(line, rtl);
 }
 
-void IRCView::appendRaw(const QString& message, bool self)
+void IRCView::appendRaw(const QString& message, bool self, const QHash<QString, QString> &messageTags)
 {
     QColor color = self ? Preferences::self()->color(Preferences::ChannelMessage)
         : Preferences::self()->color(Preferences::ServerMessage);
@@ -698,7 +905,7 @@ void IRCView::appendRaw(const QString& message, bool self)
 
     QString line;
     if (dateRtlDirection()) line += LRM;
-    line += (timeStamp(QHash<QString, QString>(), false) + QLatin1String(" <font color=\"") + color.name() + QLatin1String("\">") + message + QLatin1String("</font>"));
+    line += (timeStamp(messageTags, false) + QLatin1String(" <font color=\"") + color.name() + QLatin1String("\">") + message + QLatin1String("</font>"));
 
     doAppend(line, false, self);
 }
@@ -721,6 +928,7 @@ void IRCView::appendQuery(const QString& nick, const QString& message, const QHa
     QString queryColor=Preferences::self()->color(Preferences::QueryMessage).name();
 
     m_tabNotification = Konversation::tnfPrivate;
+    setLineTime(messageTags);
 
     QString nickLine = createNickLine(nick, queryColor, true, inChannel);
 
@@ -759,6 +967,8 @@ void IRCView::appendAction(const QString& nick, const QString& message, const QH
 {
     QString actionColor = Preferences::self()->color(Preferences::ActionMessage).name();
 
+    setLineTime(messageTags);
+
     QString line;
 
     QString nickLine = createNickLine(nick, actionColor, false);
@@ -767,8 +977,14 @@ void IRCView::appendAction(const QString& nick, const QString& message, const QH
     {
         // No text to check direction. Better to check last line, if it's RTL,
         // treat it as that.
-        QTextCursor formatCursor(document()->lastBlock());
-        bool rtl = (formatCursor.blockFormat().alignment().testFlag(Qt::AlignRight));
+        bool rtl;
+        if (!m_pendingLines.isEmpty())
+            rtl = m_pendingLines.last().rtl;
+        else
+        {
+            QTextCursor formatCursor(document()->lastBlock());
+            rtl = (formatCursor.blockFormat().alignment().testFlag(Qt::AlignRight));
+        }
 
         line = formatFinalLine(rtl, actionColor, QString(), nickLine, QStringLiteral(" * "), QString());
         line = line.arg(timeStamp(messageTags, rtl), nick);
@@ -863,12 +1079,226 @@ void IRCView::appendCommandMessage(const QString& type, const QString& message,
 }
 
 void IRCView::appendBacklogMessage(const QString& firstColumn,const QString& rawMessage)
+{
+    m_tabNotification = Konversation::tnfNone;
+
+    bool rtl;
+    const QString line = formatBacklogMessage(firstColumn, rawMessage, &rtl);
+    const qint64 time = backlogLineTime(firstColumn);
+
+    m_lineTime = time ? time : UnknownLineTime;
+    doAppend(line, rtl);
+}
+
+void IRCView::appendBacklogMessages(const QList<Konversation::BacklogLine>& lines)
+{
+    if (lines.isEmpty())
+        return;
+
+    m_tabNotification = Konversation::tnfNone;
+
+    // Group all insertions into one edit block, the document only updates
+    // its layout once at the end instead of after every line.
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+
+    for (const Konversation::BacklogLine& backlogLine : lines)
+    {
+        bool rtl;
+        const QString line = formatBacklogMessage(backlogLine.firstColumn, backlogLine.message, &rtl);
+        const qint64 time = backlogLineTime(backlogLine.firstColumn);
+
+        m_lineTime = time ? time : UnknownLineTime;
+        doAppend(line, rtl);
+    }
+
+    cursor.endEditBlock();
+}
+
+void IRCView::prependHistory(const QList<Konversation::HistoryLine>& lines)
+{
+    flushPendingLines();
+
+    // Drop what is shown already: the server may have sent lines from the
+    // time of the oldest one or after it, or the same lines twice.
+    const QDateTime oldest = oldestLineTime();
+    QList<Konversation::HistoryLine> newLines;
+    QSet<QString> msgids;
+    newLines.reserve(lines.size());
+
+    if (!oldest.isValid() && m_scrollbackIndex.firstLine() < m_scrollbackIndex.endLine())
+        return;
+
+    for (const Konversation::HistoryLine& line : lines)
+    {
+        if (oldest.isValid() && line.time >= oldest)
+            continue;
+
+        if (!line.msgid.isEmpty())
+        {
+            if (msgids.contains(line.msgid))
+                continue;
+
+            msgids.insert(line.msgid);
+        }
+
+        newLines.append(line);
+    }
+
+    std::stable_sort(newLines.begin(), newLines.end(), [](const Konversation::HistoryLine& a, const Konversation::HistoryLine& b) {
+        return a.time < b.time;
+    });
+
+    // the newest of them, as many as the scrollback limit allows
+    newLines.remove(0, qMax<qsizetype>(0, newLines.count() - roomAtTop()));
+
+    if (newLines.isEmpty())
+        return;
+
+    QList<PendingLine> formatted;
+    formatted.reserve(newLines.count());
+
+    for (const Konversation::HistoryLine& line : std::as_const(newLines))
+    {
+        const QDateTime time = line.time.toLocalTime();
+        const QString timeColumn = QStringLiteral("[%1] [%2]").arg(QLocale().toString(time.date(), QLocale::LongFormat),
+                                                                 QLocale().toString(time.time(), QLocale::LongFormat));
+        bool rtl;
+        const QString html = line.action
+            ? formatBacklogMessage(timeColumn + QLatin1String(" *"), line.nick + QLatin1Char(' ') + line.message, &rtl)
+            : formatBacklogMessage(timeColumn + QLatin1String(" <") + line.nick + QLatin1Char('>'), line.message, &rtl);
+
+        formatted.append(PendingLine { html, rtl, line.time.toMSecsSinceEpoch() });
+    }
+
+    indexPrepended(insertAtTop(formatted), formatted);
+}
+
+void IRCView::prependBacklogMessages(const QList<Konversation::BacklogLine>& lines)
+{
+    if (lines.isEmpty())
+        return;
+
+    flushPendingLines();
+
+    if (document()->isEmpty())
+    {
+        appendBacklogMessages(lines);
+        return;
+    }
+
+    // the newest of them, as many as the scrollback limit allows
+    const qsizetype count = qMin<qsizetype>(lines.count(), roomAtTop());
+
+    if (count == 0)
+        return;
+
+    QList<PendingLine> formatted;
+    formatted.reserve(count);
+
+    for (const Konversation::BacklogLine& backlogLine : lines.last(count))
+    {
+        bool rtl;
+        const QString line = formatBacklogMessage(backlogLine.firstColumn, backlogLine.message, &rtl);
+
+        formatted.append(PendingLine { line, rtl, backlogLineTime(backlogLine.firstColumn) });
+    }
+
+    indexPrepended(insertAtTop(formatted), formatted);
+}
+
+void IRCView::indexPrepended(int firstNew, const QList<PendingLine>& lines)
+{
+    // bottom up, each new line gets an id below the one after it
+    QTextBlock block = document()->findBlockByNumber(firstNew + static_cast<int>(lines.count()) - 1);
+
+    for (qsizetype i = lines.count() - 1; i >= 0 && block.isValid(); --i, block = block.previous())
+        block.setUserState(m_scrollbackIndex.prepend(block.text(), lines.at(i).time));
+
+    // let searchNext() look for the matches again
+    m_searchMatches.clear();
+    m_searchedLines = m_scrollbackIndex.firstLine();
+}
+
+int IRCView::roomAtTop() const
+{
+    const int scrollMax = Preferences::self()->scrollbackMax();
+
+    if (scrollMax <= 0)
+        return std::numeric_limits<int>::max();
+
+    return qMax(0, scrollMax - document()->blockCount());
+}
+
+int IRCView::insertAtTop(const QList<PendingLine>& lines)
+{
+    // The marker and date lines at the top keep their place, their blocks belong to their Burrs.
+    QTextBlock first = document()->firstBlock();
+
+    while (first.next().isValid() && first.userData())
+        first = first.next();
+
+    const bool wasEmpty = document()->isEmpty();
+    const int firstNumber = first.blockNumber();
+    const int firstState = first.userState();
+    const QTextBlockFormat firstFormat = first.blockFormat();
+    const qreal firstTop = document()->documentLayout()->blockBoundingRect(first).top();
+
+    // One edit above the first line, only the new blocks are laid out.
+    QTextCursor cursor(first);
+    cursor.beginEditBlock();
+
+    for (int i = 0; i < lines.count(); ++i)
+    {
+        QString html = lines.at(i).html;
+
+        html.remove(QLatin1Char('\n'));
+        cursor.insertHtml(html);
+
+        // an empty document has a block for the last line already
+        if (!wasEmpty || i < lines.count() - 1)
+            cursor.insertBlock();
+    }
+
+    // Splitting a block leaves its state with the part before the cursor,
+    // give the new blocks none and the old first block its own back.
+    QTextBlock block = document()->findBlockByNumber(firstNumber);
+
+    for (int i = 0; i < lines.count() && block.isValid(); ++i, block = block.next())
+    {
+        QTextCursor formatCursor(block);
+        QTextBlockFormat format = formatCursor.blockFormat();
+
+        format.setAlignment(Qt::AlignAbsolute|(lines.at(i).rtl ? Qt::AlignRight : Qt::AlignLeft));
+        formatCursor.setBlockFormat(format);
+        block.setUserState(None);
+    }
+
+    if (!wasEmpty && block.isValid())
+    {
+        QTextCursor(block).setBlockFormat(firstFormat);
+        block.setUserState(firstState);
+    }
+
+    cursor.endEditBlock();
+
+    // keep the lines that were shown in place
+    if (!wasEmpty && block.isValid())
+    {
+        const qreal shift = document()->documentLayout()->blockBoundingRect(block).top() - firstTop;
+        verticalScrollBar()->setValue(verticalScrollBar()->value() + qRound(shift));
+    }
+
+    return firstNumber;
+}
+
+QString IRCView::formatBacklogMessage(const QString& firstColumn, const QString& rawMessage, bool* rtlOut)
 {
     QString time;
     QString message = rawMessage;
     QString nick = firstColumn;
     QString backlogColor = Preferences::self()->color(Preferences::BacklogMessage).name();
-    m_tabNotification = Konversation::tnfNone;
 
     //The format in Chatwindow::logText is not configurable, so as long as nobody allows square brackets in a date/time format....
     const int eot = nick.lastIndexOf(QLatin1Char(' '));
@@ -918,11 +1348,20 @@ void IRCView::appendBacklogMessage(const QString& firstColumn,const QString& raw
     line +=  QLatin1String(" %3</font>");
     line = line.arg(time, nick, text);
 
-    doAppend(line, rtl);
+    *rtlOut = rtl;
+
+    return line;
 }
 
 void IRCView::doAppend(const QString& newLine, bool rtl, bool self)
 {
+    qint64 time = std::exchange(m_lineTime, 0);
+
+    if (time == 0)
+        time = QDateTime::currentMSecsSinceEpoch();
+    else if (time == UnknownLineTime)
+        time = 0;
+
     if (m_rememberLineDirtyBit)
         appendRememberLine();
 
@@ -945,7 +1384,21 @@ void IRCView::doAppend(const QString& newLine, bool rtl, bool self)
         m_showDate = false;
     }
 
-    doRawAppend(newLine, rtl);
+    if (isVisible() && !isPlayback())
+        doRawAppend(newLine, rtl, time);
+    else
+    {
+        // Nobody looks at the view, or a bouncer plays back a lot of lines
+        // that go in at once, don't spend time on layout now.
+        m_pendingLines.append(PendingLine { newLine, rtl, time });
+
+        // the oldest lines would be culled from the scrollback right away
+        if (scrollMax != 0 && m_pendingLines.count() > scrollMax)
+            m_pendingLines.removeFirst();
+
+        if (m_pendingLines.count() >= PendingLinesLimit)
+            flushPendingLines();
+    }
 
     //FIXME: Disable auto-text for DCC Chats since we don't have a server to parse wildcards.
     if (!m_autoTextToSend.isEmpty() && m_server)
@@ -966,8 +1419,34 @@ void IRCView::doAppend(const QString& newLine, bool rtl, bool self)
         Q_EMIT clearStatusBarTempText();
 }
 
-void IRCView::doRawAppend(const QString& newLine, bool rtl)
+void IRCView::doRawAppend(const QString& newLine, bool rtl, qint64 time)
+{
+    flushPendingLines();
+    insertBlock(newLine, rtl, time);
+}
+
+void IRCView::flushPendingLines()
+{
+    if (m_pendingLines.isEmpty())
+        return;
+
+    const QList<PendingLine> lines = std::exchange(m_pendingLines, {});
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+
+    for (const PendingLine& line : lines)
+        insertBlock(line.html, line.rtl, line.time);
+
+    cursor.endEditBlock();
+
+    syncScrollbackIndex();
+}
+
+void IRCView::insertBlock(const QString& newLine, bool rtl, qint64 time)
 {
+    PipelineTimer timer(PipelineStats::Layout);
     SelectionPin selpin(this); // HACK stop selection at end from growing
     QString line(newLine);
 
@@ -980,6 +1459,74 @@ void IRCView::doRawAppend(const QString& newLine, bool rtl)
 
     format.setAlignment(Qt::AlignAbsolute|(rtl ? Qt::AlignRight : Qt::AlignLeft));
     formatCursor.setBlockFormat(format);
+
+    QTextBlock block = document()->lastBlock();
+    block.setUserState(m_scrollbackIndex.append(block.text(), time));
+
+    syncScrollbackIndex();
+}
+
+void IRCView::syncScrollbackIndex()
+{
+    const int maximumBlockCount = document()->maximumBlockCount();
+
+    if (maximumBlockCount <= 0 || document()->blockCount() < maximumBlockCount)
+        return;
+
+    // The document dropped its oldest blocks, when a block is removed the
+    // next one keeps its own user state, so the first line id is accurate.
+    QTextBlock block = document()->firstBlock();
+
+    while (block.isValid() && block.userState() < 0)
+        block = block.next();
+
+    if (block.isValid())
+        m_scrollbackIndex.removeLinesBefore(block.userState());
+}
+
+bool IRCView::isPlayback() const
+{
+    return m_server && m_server->isPlayback();
+}
+
+void IRCView::setLineTime(const QHash<QString, QString>& messageTags)
+{
+    const QDateTime time = QDateTime::fromString(messageTags.value(QStringLiteral("time")), Qt::ISODate);
+
+    m_lineTime = time.isValid() ? time.toMSecsSinceEpoch() : 0;
+}
+
+QDateTime IRCView::oldestLineTime() const
+{
+    if (m_scrollbackIndex.firstLine() >= m_scrollbackIndex.endLine())
+        return QDateTime();
+
+    const qint64 time = m_scrollbackIndex.lineTime(m_scrollbackIndex.firstLine());
+
+    return time > 0 ? QDateTime::fromMSecsSinceEpoch(time) : QDateTime();
+}
+
+void IRCView::requestHistory()
+{
+    if (!m_server || !m_chatWin)
+        return;
+
+    if (m_chatWin->getType() != ChatWindow::Channel && m_chatWin->getType() != ChatWindow::Query)
+        return;
+
+    flushPendingLines();
+
+    // the scrollback is full, older lines would not be kept
+    if (roomAtTop() == 0)
+        return;
+
+    const QDateTime before = oldestLineTime();
+
+    // the history would overlap lines of unknown time, e.g. of a log in an unknown format
+    if (!before.isValid() && m_scrollbackIndex.firstLine() < m_scrollbackIndex.endLine())
+        return;
+
+    m_server->requestHistoryBefore(m_chatWin->getName(), before.isValid() ? before : QDateTime::currentDateTime());
 }
 
 QString IRCView::timeStamp(QHash<QString, QString> messageTags, bool rtl)
@@ -1089,14 +1636,8 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
         filteredLine[0] = QLatin1Char('\xA0');
     }
 
-    // TODO: Use QStyleSheet::escape() here
-    // Replace all < with &lt;
-    filteredLine.replace(QLatin1Char('<'), QLatin1String("\x0blt;"));
-    // Replace all > with &gt;
-    filteredLine.replace(QLatin1Char('>'), QLatin1String("\x0bgt;"));
-
     if (filteredLine.contains(QLatin1Char('\x07'))) {
-        if (Preferences::self()->beep())
+        if (Preferences::self()->beep() && !isPlayback())
         {
             qApp->beep();
         }
@@ -1104,7 +1645,10 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
         filteredLine.remove(QLatin1Char('\x07'));
     }
 
-    filteredLine = ircTextToHtml(filteredLine,  parseURL, defaultColor, whoSent, true, direction);
+    {
+        PipelineTimer timer(PipelineStats::Html);
+        filteredLine = ircTextToHtml(filteredLine, parseURL, defaultColor, whoSent, direction);
+    }
 
     // Highlight
     QString ownNick;
@@ -1120,6 +1664,7 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
 
     if(doHighlight && (whoSent != ownNick) && !self)
     {
+        PipelineTimer timer(PipelineStats::Highlight);
         QString highlightColor;
 
         if (Preferences::self()->highlightNick() &&
@@ -1181,14 +1726,16 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
                 if (matchedHighlight->getNotify()) {
                     m_tabNotification = Konversation::tnfHighlight;
 
-                    if (Preferences::self()->highlightSoundsEnabled() && m_chatWin->notificationsEnabled())
+                    if (Preferences::self()->highlightSoundsEnabled() && m_chatWin->notificationsEnabled() && !isPlayback())
                     {
                         konvApp->sound()->play(matchedHighlight->getSoundURL());
                     }
 
                     konvApp->notificationHandler()->highlight(m_chatWin, whoSent, line);
                 }
-                m_autoTextToSend = matchedHighlight->getAutoText();
+                // answering old lines would confuse everyone
+                if (!isPlayback())
+                    m_autoTextToSend = matchedHighlight->getAutoText();
 
                 // replace %0 - %9 in regex groups
                 for (int capture = 0; capture < captures.count(); capture++)
@@ -1202,6 +1749,9 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
         // apply found highlight color to line
         if (!highlightColor.isEmpty())
         {
+            if (m_server)
+                konvApp->dbus()->reportHighlight(m_server, m_chatWin->getName(), whoSent, line);
+
             filteredLine = QLatin1String("<font color=\"") + highlightColor + QLatin1String("\">") + filteredLine +
                 QLatin1String("</font>");
         }
@@ -1216,822 +1766,172 @@ QString IRCView::filter(const QString& line, const QString& defaultColor, const
     return filteredLine;
 }
 
-QString IRCView::ircTextToHtml(const QString& text, bool parseURL, const QString& defaultColor,
-                               const QString& whoSent, bool closeAllTags, QChar::Direction* direction)
+/// Appends @p text HTML escaped. Of a pair of spaces the second one is made
+/// non-breaking, so QTextEdit does not collapse them while lines still wrap.
+static void appendEscapedText(QString& html, QStringView text, QChar& lastChar)
 {
-    TextHtmlData data;
-    data.defaultColor = defaultColor;
-    QString htmlText(text);
-
-    bool allowColors = Preferences::self()->allowColorCodes();
-    QString linkColor = Preferences::self()->color(Preferences::Hyperlink).name();
-
-    unsigned int rtl_chars = 0;
-    unsigned int ltr_chars = 0;
-
-    QString fromNick;
-    TextUrlData urlData;
-    TextChannelData channelData;
-    if (parseURL)
+    for (const QChar c : text)
     {
-        QString strippedText(removeIrcMarkup(htmlText));
-        urlData = extractUrlData(strippedText);
-        if (!urlData.urlRanges.isEmpty())
+        switch (c.unicode())
         {
-            // we detected the urls on a clean richtext-char-less text
-            // to make 100% sure we get the correct urls, but as a result
-            // we have to map them back to the original url
-            adjustUrlRanges(urlData.urlRanges, urlData.fixedUrls, htmlText, strippedText);
-
-            //Only set fromNick if we actually have a url,
-            //yes this is a ultra-minor-optimization
-            if (whoSent.isEmpty())
-                fromNick = m_chatWin->getName();
-            else
-                fromNick = whoSent;
-        }
-
-        channelData = extractChannelData(strippedText);
-        adjustUrlRanges(channelData.channelRanges, channelData.fixedChannels , htmlText, strippedText);
-    }
-    else
-    {
-        // Change & to &amp; to prevent html entities to do strange things to the text
-        htmlText.replace(QLatin1Char('&'), QLatin1String("&amp;"));
-        htmlText.replace(QLatin1Char('\x0b'), QLatin1String("&"));
-    }
-
-    int linkPos = -1;
-    int linkOffset = 0;
-    bool doChannel = false;
-    if (parseURL)
-    {
-        //get next recent channel or link pos
-        if (!urlData.urlRanges.isEmpty() && !channelData.channelRanges.isEmpty())
-        {
-            if (urlData.urlRanges.first() < channelData.channelRanges.first())
-            {
-                doChannel = false;
-                linkPos = urlData.urlRanges.first().first;
-            }
-            else
-            {
-                doChannel = true;
-                linkPos = channelData.channelRanges.first().first;
-            }
-        }
-        else if (!urlData.urlRanges.isEmpty() && channelData.channelRanges.isEmpty())
-        {
-            doChannel = false;
-            linkPos = urlData.urlRanges.first().first;
-        }
-        else if (urlData.urlRanges.isEmpty() && !channelData.channelRanges.isEmpty())
-        {
-            doChannel = true;
-            linkPos = channelData.channelRanges.first().first;
-        }
-        else
-        {
-            linkPos = -1;
-        }
-    }
-
-    // Remember last char for pair of spaces situation, see default in switch (htmlText.at(pos)...
-    QChar lastChar;
-    int offset;
-    for (int pos = 0; pos < htmlText.length(); ++pos)
-    {
-        //check for next relevant url or channel link to insert
-        if (parseURL && pos == linkPos+linkOffset)
-        {
-            if (doChannel)
-            {
-                QString fixedChannel = channelData.fixedChannels.takeFirst();
-                const QPair<int, int>& range = channelData.channelRanges.takeFirst();
-
-                QString oldChannel = htmlText.mid(pos, range.second);
-                QString strippedChannel = removeIrcMarkup(oldChannel);
-                QString colorCodes = extractColorCodes(oldChannel);
-
-                QString link(QLatin1String(R"(%1<a href="#%2" style="color:)") + linkColor + QLatin1String("\">%3</a>%4%5"));
-
-                link = link.arg(closeTags(&data), fixedChannel, strippedChannel, openTags(&data, 0), colorCodes);
-                htmlText.replace(pos, oldChannel.length(), link);
-
-                pos += link.length() - colorCodes.length() - 1;
-                linkOffset += link.length() - oldChannel.length();
-            }
-            else
-            {
-                QString fixedUrl = urlData.fixedUrls.takeFirst();
-                const QPair<int, int>& range = urlData.urlRanges.takeFirst();
-
-                QString oldUrl = htmlText.mid(pos, range.second);
-                QString strippedUrl = removeIrcMarkup(oldUrl);
-
-                QString closeTagsString(closeTags(&data));
-                QString colorCodes = extractColorCodes(oldUrl);
-                colorCodes = removeDuplicateCodes(colorCodes, &data, allowColors);
-
-                QString link(QLatin1String(R"(%1<a href="%2" style="color:)") + linkColor + QLatin1String("\">%3</a>%4%5"));
-
-                link = link.arg(closeTagsString, fixedUrl, strippedUrl, openTags(&data, 0), colorCodes);
-                htmlText.replace(pos, oldUrl.length(), link);
-
-                //url catcher
-                QMetaObject::invokeMethod(Application::instance(), "storeUrl", Qt::QueuedConnection,
-                                          Q_ARG(QString, fromNick), Q_ARG(QString, fixedUrl), Q_ARG(QDateTime, QDateTime::currentDateTime()));
-
-                pos += link.length() - colorCodes.length() - 1;
-                linkOffset += link.length() - oldUrl.length();
-            }
-
-            bool invalidNextLink = false;
-            do
-            {
-
-                if (!urlData.urlRanges.isEmpty() && !channelData.channelRanges.isEmpty())
-                {
-                    if (urlData.urlRanges.first() < channelData.channelRanges.first())
-                    {
-                        doChannel = false;
-                        linkPos = urlData.urlRanges.first().first;
-                    }
-                    else
-                    {
-                        doChannel = true;
-                        linkPos = channelData.channelRanges.first().first;
-                    }
-                }
-                else if (!urlData.urlRanges.isEmpty() && channelData.channelRanges.isEmpty())
-                {
-                    doChannel = false;
-                    linkPos = urlData.urlRanges.first().first;
-                }
-                else if (urlData.urlRanges.isEmpty() && !channelData.channelRanges.isEmpty())
-                {
-                    doChannel = true;
-                    linkPos = channelData.channelRanges.first().first;
-                }
-                else
-                {
-                    linkPos = -1;
-                }
-
-                //for cases like "#www.some.url" we get first channel
-                //and also url, the channel->clickable-channel replace we are
-                //already after the url, so just forget it, as a clickable
-                //channel is correct in this case
-                if (linkPos > -1 && linkPos+linkOffset < pos)
-                {
-                    invalidNextLink = true;
-                    if (doChannel)
-                    {
-                        channelData.channelRanges.removeFirst();
-                        channelData.fixedChannels.removeFirst();
-                    }
-                    else
-                    {
-                        urlData.urlRanges.removeFirst();
-                        urlData.fixedUrls.removeFirst();
-                    }
-                }
-                else
-                {
-                    invalidNextLink = false;
-                }
-            } while (invalidNextLink);
-
-            continue;
-        }
-
-
-        switch (htmlText.at(pos).toLatin1())
-        {
-            case '\x02': //bold
-                offset = defaultHtmlReplace(htmlText, &data, pos, QStringLiteral("b"));
-                pos += offset -1;
-                linkOffset += offset -1;
-                break;
-            case '\x1d': //italic
-                offset = defaultHtmlReplace(htmlText, &data, pos, QStringLiteral("i"));
-                pos += offset -1;
-                linkOffset += offset -1;
-                break;
-            case '\x15': //mirc underline
-            case '\x1f': //kvirc underline
-                offset = defaultHtmlReplace(htmlText, &data, pos, QStringLiteral("u"));
-                pos += offset -1;
-                linkOffset += offset -1;
+            case '<':
+                html += QLatin1String("&lt;");
                 break;
-            case '\x13': //historic strikethru
-            case '\x1e': //modern strikethru
-                offset = defaultHtmlReplace(htmlText, &data, pos, QStringLiteral("s"));
-                pos += offset -1;
-                linkOffset += offset -1;
+            case '>':
+                html += QLatin1String("&gt;");
                 break;
-            case '\x11': //monospace
-                offset = defaultHtmlReplace(htmlText, &data, pos, QStringLiteral("tt"));
-                pos += offset -1;
-                linkOffset += offset -1;
-                break;
-            case '\x03': //color
-                {
-                    QString fgColor, bgColor;
-                    bool fgOK = true, bgOK = true;
-                    QString colorMatch(getColors(htmlText, pos, fgColor, bgColor, &fgOK, &bgOK));
-
-                    if (!allowColors)
-                    {
-                        htmlText.remove(pos, colorMatch.length());
-                        pos -= 1;
-                        linkOffset -= colorMatch.length();
-                        break;
-                    }
-                    QString colorString;
-                    // check for color reset conditions
-                    //TODO check if \x11 \017 is really valid here
-                    if (colorMatch == QLatin1String("\x03") || colorMatch == QLatin1String("\x11") ||
-                        (fgColor.isEmpty() && bgColor.isEmpty()) || (!fgOK && !bgOK))
-                    {
-                        //in reverse mode, just reset both colors
-                        //color tags are already closed before the reverse start
-                        if (data.reverse)
-                        {
-                            data.lastFgColor.clear();
-                            data.lastBgColor.clear();
-                        }
-                        else
-                        {
-                            if (data.openHtmlTags.contains(QStringLiteral("font")) &&
-                                data.openHtmlTags.contains(QStringLiteral("span")))
-                            {
-                                colorString += closeToTagString(&data, QStringLiteral("span"));
-                                data.lastBgColor.clear();
-                                colorString += closeToTagString(&data, QStringLiteral("font"));
-                                data.lastFgColor.clear();
-                            }
-                            else if (data.openHtmlTags.contains(QStringLiteral("font")))
-                            {
-                                colorString += closeToTagString(&data, QStringLiteral("font"));
-                                data.lastFgColor.clear();
-                            }
-                        }
-                        htmlText.replace(pos, colorMatch.length(), colorString);
-
-                        pos += colorString.length() - 1;
-                        linkOffset += colorString.length() -colorMatch.length();
-                        break;
-                    }
-
-                    if (!fgOK)
-                    {
-                        fgColor = defaultColor;
-                    }
-                    if (!bgOK)
-                    {
-                        bgColor = fontColorOpenTag(Preferences::self()->color(Preferences::TextViewBackground).name());
-                    }
-
-                    // if we are in reverse mode, just remember the new colors
-                    if (data.reverse)
-                    {
-                        if (!fgColor.isEmpty())
-                        {
-                            data.lastFgColor = fgColor;
-                            if (!bgColor.isEmpty())
-                            {
-                                data.lastBgColor = bgColor;
-                            }
-                        }
-                    }
-                    // do we have a new fgColor?
-                    // NOTE: there is no new bgColor is there is no fgColor
-                    else if (!fgColor.isEmpty())
-                    {
-                        if (data.openHtmlTags.contains(QStringLiteral("font")) &&
-                            data.openHtmlTags.contains(QStringLiteral("span")))
-                        {
-                            colorString += closeToTagString(&data, QStringLiteral("span"));
-                            colorString += closeToTagString(&data, QStringLiteral("font"));
-                        }
-                        else if (data.openHtmlTags.contains(QStringLiteral("font")))
-                        {
-                            colorString += closeToTagString(&data, QStringLiteral("font"));
-                        }
-                        data.lastFgColor = fgColor;
-                        if (!bgColor.isEmpty())
-                            data.lastBgColor = bgColor;
-
-                        if (!data.lastFgColor.isEmpty())
-                        {
-                            colorString += fontColorOpenTag(data.lastFgColor);
-                            data.openHtmlTags.append(QStringLiteral("font"));
-                            if (!data.lastBgColor.isEmpty())
-                            {
-                                colorString += spanColorOpenTag(data.lastBgColor);
-                                data.openHtmlTags.append(QStringLiteral("span"));
-                            }
-                        }
-                    }
-                    htmlText.replace(pos, colorMatch.length(), colorString);
-
-                    pos += colorString.length() - 1;
-                    linkOffset += colorString.length() -colorMatch.length();
-                }
-                break;
-            case '\x0f': //reset to default
-                {
-                    QString closeText;
-                    while (!data.openHtmlTags.isEmpty())
-                    {
-                        closeText += QLatin1String("</") + data.openHtmlTags.takeLast() + QLatin1Char('>');
-                    }
-                    data.lastBgColor.clear();
-                    data.lastFgColor.clear();
-                    data.reverse = false;
-                    htmlText.replace(pos, 1, closeText);
-
-                    pos += closeText.length() - 1;
-                    linkOffset += closeText.length() - 1;
-                }
+            case '&':
+                html += QLatin1String("&amp;");
                 break;
-            case '\x16': //reverse
+            case ' ':
+                if (lastChar == QLatin1Char(' '))
                 {
-                    // treat inverse as color and block it if colors are not allowed
-                    if (!allowColors)
-                    {
-                        htmlText.remove(pos, 1);
-                        pos -= 1;
-                        linkOffset -= 1;
-                        break;
-                    }
-
-                    QString colorString;
-
-                    // close current color strings and open reverse tags
-                    if (!data.reverse)
-                    {
-                        if (data.openHtmlTags.contains(QStringLiteral("span")))
-                        {
-                            colorString += closeToTagString(&data, QStringLiteral("span"));
-                        }
-                        if (data.openHtmlTags.contains(QStringLiteral("font")))
-                        {
-                            colorString += closeToTagString(&data, QStringLiteral("font"));
-                        }
-                        data.reverse = true;
-                        colorString += fontColorOpenTag(Preferences::self()->color(Preferences::TextViewBackground).name());
-                        data.openHtmlTags.append(QStringLiteral("font"));
-                        colorString += spanColorOpenTag(defaultColor);
-                        data.openHtmlTags.append(QStringLiteral("span"));
-                    }
-                    else
-                    {
-                        // if reset reverse, close reverse and set old fore- and
-                        // back-groundcolor if set in data
-                        colorString += closeToTagString(&data, QStringLiteral("span"));
-                        colorString += closeToTagString(&data, QStringLiteral("font"));
-                        data.reverse = false;
-                        if (!data.lastFgColor.isEmpty())
-                        {
-                            colorString += fontColorOpenTag(data.lastFgColor);
-                            data.openHtmlTags.append(QStringLiteral("font"));
-                            if (!data.lastBgColor.isEmpty())
-                            {
-                                colorString += spanColorOpenTag(data.lastBgColor);
-                                data.openHtmlTags.append(QStringLiteral("span"));
-                            }
-                        }
-                    }
-                    htmlText.replace(pos, 1, colorString);
-                    pos += colorString.length() -1;
-                    linkOffset += colorString.length() -1;
+                    html += QLatin1Char('\xA0');
+                    lastChar = QLatin1Char('\xA0');
+                    continue;
                 }
+                html += c;
                 break;
             default:
-                {
-                    const QChar& dirChar = htmlText.at(pos);
-
-                    // Replace pairs of spaces with "<space>&nbsp;" to preserve some semblance of text wrapping
-                    //filteredLine.replace("  ", " \xA0");
-                    // This used to work like above. But just for normal text like "test    test"
-                    // It got replaced as "test \xA0 \xA0test" and QTextEdit showed 4 spaces.
-                    // In case of color/italic/bold codes we don't necessary get a real pair of spaces
-                    // just "test<html> <html> <html> <html> test" and QTextEdit shows it as 1 space.
-                    // Now if we remember the last char, to ignore html tags, and check if current and last ones are spaces
-                    // we replace the current one with \xA0 (a forced space) and get
-                    // "test<html> <html>\xA0<html> <html>\xA0test", which QTextEdit correctly shows as 4 spaces.
-                    //NOTE: replacing all spaces with forced spaces will break text wrapping
-                    if (dirChar == QLatin1Char(' ') &&
-                        !lastChar.isNull() && lastChar == QLatin1Char(' ')) {
-                        htmlText[pos] = QLatin1Char('\xA0');
-                        lastChar = QLatin1Char('\xA0');
-                    }
-                    else
-                    {
-                        lastChar = dirChar;
-                    }
-
-                    if (!(dirChar.isNumber() || dirChar.isSymbol() ||
-                        dirChar.isSpace()  || dirChar.isPunct()  ||
-                        dirChar.isMark()))
-                    {
-                        switch(dirChar.direction())
-                        {
-                            case QChar::DirL:
-                            case QChar::DirLRO:
-                            case QChar::DirLRE:
-                                ltr_chars++;
-                                break;
-                            case QChar::DirR:
-                            case QChar::DirAL:
-                            case QChar::DirRLO:
-                            case QChar::DirRLE:
-                                rtl_chars++;
-                                break;
-                            default:
-                                break;
-                        }
-                    }
-                }
+                html += c;
         }
-    }
 
-    if (direction)
-    {
-        // in case we found no right or left direction chars both
-        // values are 0, but rtl_chars > ltr_chars is still false and QChar::DirL
-        // is returned as default.
-        if (rtl_chars > ltr_chars)
-            *direction = QChar::DirR;
-        else
-            *direction = QChar::DirL;
+        lastChar = c;
     }
-
-    if (parseURL)
-    {
-        // Change & to &amp; to prevent html entities to do strange things to the text
-        htmlText.replace(QLatin1Char('&'), QLatin1String("&amp;"));
-        htmlText.replace(QLatin1Char('\x0b'), QLatin1String("&"));
-    }
-
-    if (closeAllTags)
-    {
-        htmlText += closeTags(&data);
-    }
-
-    return htmlText;
 }
 
-int IRCView::defaultHtmlReplace(QString& htmlText, TextHtmlData* data, int pos, const QString& tag)
+static void appendStyledText(QString& html, QStringView text, const Konversation::IrcTextStyle& style,
+                             const QString& defaultColor, QChar& lastChar)
 {
-    QString replace;
-    if (data->openHtmlTags.contains(tag))
-    {
-        replace = closeToTagString(data, tag);
-    }
-    else
-    {
-        data->openHtmlTags.append(tag);
-        replace = QLatin1Char('<') + tag + QLatin1Char('>');
-    }
-    htmlText.replace(pos, 1, replace);
-    return replace.length();
-}
+    using Konversation::IrcTextStyle;
 
-QString IRCView::closeToTagString(TextHtmlData* data, const QString& _tag)
-{
-    QString ret;
-    QString tag;
-    int i = data->openHtmlTags.count() - 1;
-    //close all tags to _tag
-    for ( ; i >= 0 ; --i)
+    if (style == IrcTextStyle())
     {
-        tag = data->openHtmlTags.at(i);
-        ret += QLatin1String("</") + tag + QLatin1Char('>');
-        if (tag == _tag)
-        {
-            data->openHtmlTags.removeAt(i);
-            break;
-        }
+        appendEscapedText(html, text, lastChar);
+        return;
     }
 
-    // reopen relevant tags
-    if (i > -1)
-        ret += openTags(data, i);
+    QString fgColor;
+    QString bgColor;
 
-    return ret;
-}
-
-QString IRCView::openTags(TextHtmlData* data, int from)
-{
-    QString ret, tag;
-    int i = from > -1 ? from : 0;
-
-    for ( ;  i < data->openHtmlTags.count(); ++i)
+    if (style.flags & IrcTextStyle::Reverse)
     {
-        tag = data->openHtmlTags.at(i);
-        if (tag == QLatin1String("font"))
-        {
-            if (data->reverse)
-            {
-                ret += fontColorOpenTag(Preferences::self()->color(Preferences::TextViewBackground).name());
-            }
-            else
-            {
-                ret += fontColorOpenTag(data->lastFgColor);
-            }
-        }
-        else if (tag == QLatin1String("span"))
-        {
-            if (data->reverse)
-            {
-                ret += spanColorOpenTag(data->defaultColor);
-            }
-            else
-            {
-                ret += spanColorOpenTag(data->lastBgColor);
-            }
-        }
-        else
-        {
-            ret += QLatin1Char('<') + tag + QLatin1Char('>');
-        }
+        fgColor = Preferences::self()->color(Preferences::TextViewBackground).name();
+        bgColor = defaultColor;
     }
-    return ret;
-}
-
-QString IRCView::closeTags(TextHtmlData* data)
-{
-    QString ret;
-    QListIterator< QString > i(data->openHtmlTags);
-    i.toBack();
-    while (i.hasPrevious())
+    else
     {
-        ret += QLatin1String("</") + i.previous() + QLatin1Char('>');
+        if (style.foreground != -1)
+            fgColor = Preferences::self()->ircColorCode(style.foreground).name();
+        if (style.background != -1)
+            bgColor = Preferences::self()->ircColorCode(style.background).name();
     }
-    return ret;
-}
 
-QString IRCView::fontColorOpenTag(const QString& fgColor)
-{
-    return QLatin1String("<font color=\"") + fgColor + QLatin1String("\">");
-}
-
-QString IRCView::spanColorOpenTag(const QString& bgColor)
-{
-    return QLatin1String("<span style=\"background-color:") + bgColor + QLatin1String("\">");
+    if (!fgColor.isEmpty())
+        html += QLatin1String("<font color=\"") + fgColor + QLatin1String("\">");
+    if (!bgColor.isEmpty())
+        html += QLatin1String("<span style=\"background-color:") + bgColor + QLatin1String("\">");
+    if (style.flags & IrcTextStyle::Bold)
+        html += QLatin1String("<b>");
+    if (style.flags & IrcTextStyle::Italic)
+        html += QLatin1String("<i>");
+    if (style.flags & IrcTextStyle::Underline)
+        html += QLatin1String("<u>");
+    if (style.flags & IrcTextStyle::StrikeOut)
+        html += QLatin1String("<s>");
+    if (style.flags & IrcTextStyle::Monospace)
+        html += QLatin1String("<tt>");
+
+    appendEscapedText(html, text, lastChar);
+
+    if (style.flags & IrcTextStyle::Monospace)
+        html += QLatin1String("</tt>");
+    if (style.flags & IrcTextStyle::StrikeOut)
+        html += QLatin1String("</s>");
+    if (style.flags & IrcTextStyle::Underline)
+        html += QLatin1String("</u>");
+    if (style.flags & IrcTextStyle::Italic)
+        html += QLatin1String("</i>");
+    if (style.flags & IrcTextStyle::Bold)
+        html += QLatin1String("</b>");
+    if (!bgColor.isEmpty())
+        html += QLatin1String("</span>");
+    if (!fgColor.isEmpty())
+        html += QLatin1String("</font>");
 }
 
-QString IRCView::removeDuplicateCodes(const QString& codes, TextHtmlData* data, bool allowColors)
+QString IRCView::ircTextToHtml(const QString& text, bool parseURL, const QString& defaultColor,
+                               const QString& whoSent, QChar::Direction* direction)
 {
-    int pos = 0;
-    QString ret;
-    while (pos < codes.length())
-    {
-        switch (codes.at(pos).toLatin1())
-        {
-            case '\x02': //bold
-                defaultRemoveDuplicateHandling(data, QStringLiteral("b"));
-                ++pos;
-                break;
-            case '\x1d': //italic
-                defaultRemoveDuplicateHandling(data, QStringLiteral("i"));
-                ++pos;
-                break;
-            case '\x15': //mirc underline
-            case '\x1f': //kvirc underline
-                defaultRemoveDuplicateHandling(data, QStringLiteral("u"));
-                ++pos;
-                break;
-            case '\x13': //historic strikethru
-            case '\x1e': //modern strikethru
-                defaultRemoveDuplicateHandling(data, QStringLiteral("s"));
-                ++pos;
-                break;
-            case '\x11': //monospace
-                defaultRemoveDuplicateHandling(data, QStringLiteral("tt"));
-                ++pos;
-                break;
-            case '\x0f': //reset to default
-                data->openHtmlTags.clear();
-                data->lastBgColor.clear();
-                data->lastFgColor.clear();
-                data->reverse = false;
-                ++pos;
-                break;
+    using Konversation::IrcTextLink;
+    using Konversation::IrcTextRun;
 
-            case '\x16': //reverse
-                if (!allowColors)
-                {
-                    pos += 1;
-                    continue;
-                }
-
-                if (data->reverse)
-                {
-                    data->openHtmlTags.removeOne(QStringLiteral("span"));
-                    data->openHtmlTags.removeOne(QStringLiteral("font"));
-                    data->reverse = false;
-                    if (!data->lastFgColor.isEmpty())
-                    {
-                        data->openHtmlTags.append(QStringLiteral("font"));
-                        if (!data->lastBgColor.isEmpty())
-                        {
-                            data->openHtmlTags.append(QStringLiteral("span"));
-                        }
-                    }
-                }
-                else
-                {
-                    data->openHtmlTags.removeOne(QStringLiteral("span"));
-                    data->openHtmlTags.removeOne(QStringLiteral("font"));
-                    data->reverse = true;
-                    data->openHtmlTags.append(QStringLiteral("font"));
-                    data->openHtmlTags.append(QStringLiteral("span"));
-                }
-                ++pos;
-                break;
-            case '\x03': //color
-                {
-                    QString fgColor, bgColor;
-                    bool fgOK = true, bgOK = true;
-                    QString colorMatch(getColors(codes, pos, fgColor, bgColor, &fgOK, &bgOK));
-
-                    if (!allowColors)
-                    {
-                        pos += colorMatch.length();
-                        continue;
-                    }
-
-                    // check for color reset conditions
-                    //TODO check if \x11 \017 is really valid here
-                    if (colorMatch == QLatin1String("\x03") || colorMatch == QLatin1String("\x11") ||
-                        (fgColor.isEmpty() && bgColor.isEmpty()) || (!fgOK && !bgOK))
-                    {
-                        if (!data->lastBgColor.isEmpty())
-                        {
-                            data->lastBgColor.clear();
-                            data->openHtmlTags.removeOne(QStringLiteral("span"));
-                        }
-                        if (!data->lastFgColor.isEmpty())
-                        {
-                            data->lastFgColor.clear();
-                            data->openHtmlTags.removeOne(QStringLiteral("font"));
-                        }
-                        pos += colorMatch.length();
-                        break;
-                    }
+    const Konversation::IrcFormattedText formatted =
+        Konversation::parseIrcFormatting(text, Preferences::self()->allowColorCodes(), parseURL);
 
-                    if (!fgOK)
-                    {
-                        fgColor = data->defaultColor;
-                    }
-                    if (!bgOK)
-                    {
-                        bgColor = fontColorOpenTag(Preferences::self()->color(Preferences::TextViewBackground).name());
-                    }
+    if (direction)
+        *direction = formatted.direction;
 
-                    if (!fgColor.isEmpty())
-                    {
-                        data->lastFgColor = fgColor;
-                        data->openHtmlTags.append(QStringLiteral("font"));
-                        if (!bgColor.isEmpty())
-                        {
-                            data->lastBgColor = bgColor;
-                            data->openHtmlTags.append(QStringLiteral("span"));
-                        }
-                    }
+    QString linkColor;
+    QString fromNick;
 
-                    pos += colorMatch.length();
-                }
-                break;
-            default:
-//                 qCDebug(KONVERSATION_LOG) << "unsupported duplicate code:" << QString::number(codes.at(pos).toLatin1(), 16);
-                ret += codes.at(pos);
-                ++pos;
-        }
+    if (!formatted.links.isEmpty())
+    {
+        linkColor = Preferences::self()->color(Preferences::Hyperlink).name();
+        fromNick = whoSent.isEmpty() ? m_chatWin->getName() : whoSent;
     }
 
-    return ret;
-}
+    const QStringView plainText(formatted.text);
 
-void IRCView::defaultRemoveDuplicateHandling(TextHtmlData* data, const QString& tag)
-{
-    if (data->openHtmlTags.contains(tag))
-    {
-        data->openHtmlTags.removeOne(tag);
-    }
-    else
-    {
-        data->openHtmlTags.append(tag);
-    }
-}
+    QString htmlText;
+    htmlText.reserve(plainText.size() + formatted.runs.size() * 48 + formatted.links.size() * 64);
 
-void IRCView::adjustUrlRanges(QList< QPair<int, int> >& urlRanges, const QStringList& fixedUrls,  QString& richtext, const QString& strippedText)
-{
-    Q_UNUSED(fixedUrls)
+    // Remember last char for pair of spaces situation, see appendEscapedText()
+    QChar lastChar;
+    qsizetype nextLink = 0;
+    int linkEnd = 0;
 
-    int start = 0, j;
-    int i = 0;
-    QString url;
-    int htmlTextLength = richtext.length(), urlCount = urlRanges.count();
-    for (int x = 0; x < urlCount; ++x)
+    for (const IrcTextRun& run : formatted.runs)
     {
-        if (x == 0)
-            i = urlRanges.first().first;
+        const int runEnd = run.start + run.length;
+        int pos = qMax(run.start, linkEnd);
 
-        j = 0;
-        const QPair<int, int>& range = urlRanges.at(x);
-        url = strippedText.mid(range.first, range.second);
-        for ( ; i < htmlTextLength; ++i)
+        while (pos < runEnd)
         {
-            if (richtext.at(i) == url.at(j))
+            if (nextLink == formatted.links.count() || formatted.links.at(nextLink).start >= runEnd)
             {
-                if (j == 0)
-                    start = i;
-                ++j;
-                if (j == url.length())
-                {
-                    urlRanges[x].first = start;
-                    urlRanges[x].second = i - start + 1;
-                    break;
-                }
+                appendStyledText(htmlText, plainText.sliced(pos, runEnd - pos), run.style, defaultColor, lastChar);
+                pos = runEnd;
+                continue;
             }
-            else
-            {
-                QRegularExpressionMatch match = colorRegExp.match(richtext, i, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
-                if (match.hasMatch())
-                {
-                    // forward to the last matched position
-                    i += match.capturedLength() - 1;
-                }
-                else
-                {
-                    j = 0;
-                }
-            }
-        }
-    }
-}
 
-QString IRCView::getColors(const QString& text, int start, QString& _fgColor, QString& _bgColor, bool* fgValueOK, bool* bgValueOK)
-{
-    static const QRegularExpression ircColorRegExp(QStringLiteral("(\003([0-9]{2}|[0-9]|)(,([0-9]{2}|[0-9]|)|,|)|\017)"));
+            const IrcTextLink& link = formatted.links.at(nextLink++);
 
-    const QRegularExpressionMatch match = ircColorRegExp.match(text, start);
-    if (!match.hasMatch()) {
-        return QString{};
-    }
+            if (link.start > pos)
+                appendStyledText(htmlText, plainText.sliced(pos, link.start - pos), run.style, defaultColor, lastChar);
 
-    const QString ret(match.captured(0));
+            // links are shown without the formatting around them
+            htmlText += QLatin1String("<a href=\"");
+            if (link.type == IrcTextLink::Channel)
+                htmlText += QLatin1Char('#');
+            htmlText += link.target.toHtmlEscaped() + QLatin1String("\" style=\"color:") + linkColor + QLatin1String("\">");
+            QChar linkLastChar;
+            appendEscapedText(htmlText, plainText.sliced(link.start, link.length), linkLastChar);
+            htmlText += QLatin1String("</a>");
 
-    const QString fgColor(match.captured(2));
-    if (!fgColor.isEmpty())
-    {
-        int foregroundColor = fgColor.toInt();
-        if (foregroundColor > -1 && foregroundColor < 16)
-        {
-            _fgColor = Preferences::self()->ircColorCode(foregroundColor).name();
-            if (fgValueOK)
-                *fgValueOK = true;
-        }
-        else
-        {
-            if (fgValueOK)
-                *fgValueOK = false;
-        }
-    }
-    else
-    {
-        if (fgValueOK)
-            *fgValueOK = true;
-    }
+            if (link.type == IrcTextLink::Url)
+            {
+                //url catcher
+                QMetaObject::invokeMethod(Application::instance(), "storeUrl", Qt::QueuedConnection,
+                                          Q_ARG(QString, fromNick), Q_ARG(QString, link.target), Q_ARG(QDateTime, QDateTime::currentDateTime()));
+            }
 
-    const QString bgColor(match.captured(4));
-    if (!bgColor.isEmpty())
-    {
-        int backgroundColor = bgColor.toInt();
-        if (backgroundColor > -1 && backgroundColor < 16)
-        {
-            _bgColor = Preferences::self()->ircColorCode(backgroundColor).name();
-            if (bgValueOK)
-                *bgValueOK = true;
-        }
-        else
-        {
-            if (bgValueOK)
-                *bgValueOK = false;
+            linkEnd = link.start + link.length;
+            pos = linkEnd;
         }
     }
-    else
-    {
-        if (bgValueOK)
-            *bgValueOK = true;
-    }
 
-    return ret;
+    return htmlText;
 }
 
 void IRCView::resizeEvent(QResizeEvent *event)
@@ -2040,6 +1940,13 @@ void IRCView::resizeEvent(QResizeEvent *event)
     QTextBrowser::resizeEvent(event);
 }
 
+void IRCView::showEvent(QShowEvent* event)
+{
+    flushPendingLines();
+
+    QTextBrowser::showEvent(event);
+}
+
 void IRCView::mouseMoveEvent(QMouseEvent* ev)
 {
     if (m_mousePressedOnUrl && (m_mousePressPosition - ev->pos()).manhattanLength() > QApplication::startDragDistance())
@@ -2100,6 +2007,11 @@ void IRCView::wheelEvent(QWheelEvent *ev)
         if(ev->angleDelta().y() < 0) decreaseFontSize();
         if(ev->angleDelta().y() > 0) increaseFontSize();
     }
+    else if (ev->angleDelta().y() > 0 && verticalScrollBar()->value() == verticalScrollBar()->minimum())
+    {
+        // there is nothing to scroll to, for the scroll bar to notice
+        requestHistory();
+    }
 
     QTextBrowser::wheelEvent(ev);
 }
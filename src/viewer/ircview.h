@@ -10,7 +10,10 @@
 #define IRCVIEW_H
 
 #include "common.h"
+#include "backlogreader.h"
+#include "chathistory.h"
 #include "irccontextmenus.h"
+#include "scrollbackindex.h"
 
 #include <QAbstractTextDocumentLayout>
 #include <QFontDatabase>
@@ -18,6 +21,7 @@
 #include <QTextBrowser>
 #include <QUrl>
 #include <QDateTime>
+#include <QSet>
 
 
 class Server;
@@ -39,23 +43,6 @@ class IrcViewMarkerLine: public QObject, public QTextObjectInterface
         Q_DISABLE_COPY(IrcViewMarkerLine)
 };
 
-/// Helper struct which remembers the openHtmlTags, the fore and
-/// background color, if the reverse char is set and the defaultcolor (for reverse)
-/// while the ircrichtext -> html generation is in progress
-struct TextHtmlData
-{
-    TextHtmlData()
-        : reverse(false)
-    {
-    }
-
-    QList<QString> openHtmlTags;
-    QString lastFgColor;
-    QString lastBgColor;
-    bool reverse;
-    QString defaultColor;
-};
-
 class IRCView : public QTextBrowser
 {
     Q_OBJECT
@@ -72,6 +59,14 @@ class IRCView : public QTextBrowser
         bool search(const QString& pattern, QTextDocument::FindFlags flags, bool fromCursor);
         bool searchNext(bool reversed = false);
 
+        /// The index of the text of every line, brought up to date with the
+        /// lines still waiting to be inserted while the view is hidden.
+        const Konversation::ScrollbackIndex& scrollbackIndex();
+
+        /// Scrolls to the line @p lineId of scrollbackIndex() and selects the
+        /// first match of @p pattern in it, which searchNext() continues from.
+        bool showLine(int lineId, const QString& pattern, QTextDocument::FindFlags flags);
+
         //! FIXME maybe we should create some sort of palette of our own?
         QColor highlightColor() { return m_highlightColor; }
 
@@ -100,6 +95,7 @@ class IRCView : public QTextBrowser
         void dropEvent(QDropEvent* e) override;
 
         void resizeEvent(QResizeEvent *event) override;
+        void showEvent(QShowEvent* event) override;
         void mouseReleaseEvent(QMouseEvent* ev) override;
         void mousePressEvent(QMouseEvent* ev) override;
         void mouseMoveEvent(QMouseEvent* ev) override;
@@ -183,7 +179,7 @@ class IRCView : public QTextBrowser
     public Q_SLOTS:
         //! FIXME enum { Raw, Query, Query+Action, Channel+Action, Server Message, Command Message, Backlog message } this looks more like a tuple
         void append(const QString& nick, const QString& message, const QHash<QString, QString> &messageTags = QHash<QString, QString>(), const QString& label = QString());
-        void appendRaw(const QString& message, bool self = false);
+        void appendRaw(const QString& message, bool self = false, const QHash<QString, QString> &messageTags = QHash<QString, QString>());
         void appendLog(const QString& message);
 
         void appendQuery(const QString& nick, const QString& message, const QHash<QString, QString> &messageTags, bool inChannel = false);
@@ -194,14 +190,66 @@ class IRCView : public QTextBrowser
         void appendServerMessage(const QString& type, const QString& message, const QHash<QString, QString> &messageTags = QHash<QString, QString>(), bool parseURL = true);
         void appendCommandMessage(const QString& command, const QString& message, const QHash<QString, QString> &messageTags, bool parseURL=true, bool self=false);
         void appendBacklogMessage(const QString& firstColumn, const QString& message);
+        /// Appends all lines in a single document edit, so the view is laid out only once.
+        void appendBacklogMessages(const QList<Konversation::BacklogLine>& lines);
+        /// Inserts lines fetched with CHATHISTORY above the oldest one, in one edit.
+        void prependHistory(const QList<Konversation::HistoryLine>& lines);
+        /// Inserts backlog lines above the lines shown, in one edit.
+        void prependBacklogMessages(const QList<Konversation::BacklogLine>& lines);
 
     private:
+        QString formatBacklogMessage(const QString& firstColumn, const QString& message, bool* rtl);
         void appendAction(const QString& nick, const QString& message, const QHash<QString, QString> &messageTags);
 
         /// Appends a new line without any scrollback or notification checks
-        void doRawAppend(const QString& newLine, bool rtl);
+        void doRawAppend(const QString& newLine, bool rtl, qint64 time = 0);
         void doAppend(const QString& line, bool rtl, bool self=false);
 
+        /// Inserts a formatted line, sent at @p time in ms since the epoch, into the document and the scrollback index.
+        void insertBlock(const QString& newLine, bool rtl, qint64 time = 0);
+        /// Drops the lines the document culled from the scrollback index.
+        void syncScrollbackIndex();
+        /// The block of a line of the scrollback index, invalid if it is gone.
+        QTextBlock blockForLine(int lineId) const;
+        /// Inserts the lines that arrived while the view was hidden, in one edit.
+        void flushPendingLines();
+        /// Whether the line being appended is played back by a bouncer.
+        bool isPlayback() const;
+        /// Sets the time of the next line from the time tag of @p messageTags.
+        void setLineTime(const QHash<QString, QString>& messageTags);
+
+        /// Asks the server for the lines before the oldest one, when scrolled to the top.
+        void requestHistory();
+        /// When the oldest line was sent, invalid if there is none or its time is unknown.
+        QDateTime oldestLineTime() const;
+
+        /// A formatted line waiting to be inserted into the document.
+        struct PendingLine
+        {
+            QString html;
+            bool rtl;
+            qint64 time;
+        };
+
+        /**
+         * Inserts @p lines above the first line, below the marker lines at the top,
+         * in one edit and without moving the lines shown. The new blocks have no
+         * user state. Returns the block number of the first one.
+         */
+        int insertAtTop(const QList<PendingLine>& lines);
+        /// Indexes @p lines, inserted at the top from block @p firstNew on.
+        void indexPrepended(int firstNew, const QList<PendingLine>& lines);
+        /// Number of lines that still fit above the others within the scrollback limit.
+        int roomAtTop() const;
+
+        /// The time of the line being appended, in ms since the epoch; 0 is now.
+        qint64 m_lineTime;
+
+        /// While the view is hidden, or during playback, its lines are collected here instead
+        /// of being laid out in the document, until it is shown, playback is over or
+        /// PendingLinesLimit is reached.
+        QList<PendingLine> m_pendingLines;
+
     public Q_SLOTS:
         /// Emits the doSearch signal.
         void findText();
@@ -227,57 +275,7 @@ class IRCView : public QTextBrowser
 
         /// Returns a string where all irc-richtext chars are replaced with proper
         /// html tags and all urls are parsed if parseURL is true
-        inline QString ircTextToHtml(const QString& text, bool parseURL, const QString& defaultColor, const QString& whoSent, bool closeAllTags = true, QChar::Direction* direction = nullptr);
-
-        /// Returns a string that closes all open html tags to <parm>tag</parm>
-        /// The closed tag is removed from opentagList in data
-        inline QString closeToTagString(TextHtmlData* data, const QString& tag);
-
-        /// Returns a html open span line with given backgroundcolor style
-        inline QString spanColorOpenTag(const QString& bgColor);
-
-        /// Returns a html open font line with given foregroundcolor
-        inline QString fontColorOpenTag(const QString& fgColor);
-
-        /// Insert a string that closes as open html tags to <parm>tag</parm> and reopen the remaining ones.
-        /// For the next example I will use [b] as boldchar and [i] as italic char
-        /// If are currently working on text like
-        /// "aa<b>bb<i>cc[b]dd[i]ee"
-        /// it would generate for the next [b], "</i></b><i>".
-        /// <i> is reopened as it is still relevant
-        /// Returns the Length of the inserted String
-        inline int defaultHtmlReplace(QString& htmlText, TextHtmlData* data, int pos, const QString& tag);
-
-        /// Returns a string that opens all tags starting from index <parm>from</parm>
-        inline QString openTags(TextHtmlData* data, int from = 0);
-
-        /// Returns a string that closes all open tags
-        /// but does not remove them from the opentaglist in data
-        inline QString closeTags(TextHtmlData* data);
-
-        /// This function looks in <parm>codes</parm> which tags it open/closes
-        /// and appends/removes them from opentagList in <parm>data</parm>.
-        /// This way we avoid pointless empty tags after the url like "<b></b>"
-        /// The returned string consists of all codes that this function could not deal with,
-        /// which is the best case empty.
-        QString removeDuplicateCodes(const QString& codes, TextHtmlData* data, bool allowColors);
-
-        /// Helperfunction for removeDuplicateCodes, for dealing with simple irc richtext
-        /// chars as bold, italic, underline and strikethrou.
-        /// The default behaivor is to look if the <parm>tag</parm> is already in the
-        /// opentagList in <parm>data</parm> and remove it if in case if is in, or
-        /// append it in case it is not.
-        inline void defaultRemoveDuplicateHandling(TextHtmlData* data, const QString& tag);
-
-        /// Changes the ranges in <parm>urlRanges</parm>, that are found in
-        /// <parm>strippedText</parm>, to match in <parm>richText</parm>.
-        /// This is needed for cases were the url is tainted by ircrichtext chars
-        inline void adjustUrlRanges(QList< QPair< int, int > >& urlRanges, const QStringList& fixedUrls, QString& richtext, const QString& strippedText);
-
-        /// Parses the colors in <parm>text</parm> starting from <parm>start</parm>
-        /// and returns them in the given fg and bg string, as well as information
-        /// if the values are valid
-        static QString getColors(const QString& text, int start, QString& _fgColor, QString& _bgColor, bool* invalidFgVal, bool* invalidBgValue);
+        QString ircTextToHtml(const QString& text, bool parseURL, const QString& defaultColor, const QString& whoSent, QChar::Direction* direction = nullptr);
 
         QChar::Direction basicDirection(const QString &string);
 
@@ -299,6 +297,14 @@ class IRCView : public QTextBrowser
         //// Search
         QTextDocument::FindFlags m_searchFlags;
         QString m_pattern;
+        /// Selects the match of m_pattern in @p block found from @p from on, see ScrollbackIndex::indexIn()
+        bool selectMatch(const QTextBlock& block, qsizetype from, QTextDocument::FindFlags flags);
+
+        /// Each text block has the id of its line in here as its user state.
+        Konversation::ScrollbackIndex m_scrollbackIndex;
+        /// Lines of the index matching m_pattern, among those below m_searchedLines.
+        QList<int> m_searchMatches;
+        int m_searchedLines;
 
         //used in ::filter
         QColor m_highlightColor;
@@ -0,0 +1,291 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "logfileindex.h"
+
+#include <QByteArrayMatcher>
+#include <QDate>
+#include <QLocale>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Konversation
+{
+    LogFileIndex::~LogFileIndex()
+    {
+        close();
+    }
+
+    bool LogFileIndex::open(const QString& fileName)
+    {
+        close();
+
+        m_file.setFileName(fileName);
+
+        if (!m_file.open(QIODevice::ReadOnly))
+            return false;
+
+        m_size = m_file.size();
+
+        if (m_size > 0)
+        {
+            m_map = m_file.map(0, m_size);
+
+            if (m_map)
+                m_data = reinterpret_cast<const char*>(m_map);
+            else
+            {
+                m_buffer = m_file.readAll();
+                m_data = m_buffer.constData();
+                m_size = m_buffer.size();
+            }
+        }
+
+        return true;
+    }
+
+    void LogFileIndex::close()
+    {
+        if (m_map)
+            m_file.unmap(m_map);
+
+        m_file.close();
+
+        m_map = nullptr;
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+
+        m_lineIndex = LineIndex();
+        m_hasLineIndex = false;
+    }
+
+    qint64 LogFileIndex::lineStart(qint64 offset) const
+    {
+        offset = qBound<qint64>(0, offset, m_size);
+
+        return QByteArrayView(m_data, offset).lastIndexOf('\n') + 1;
+    }
+
+    qint64 LogFileIndex::nextLineStart(qint64 offset) const
+    {
+        const auto* newline = static_cast<const char*>(memchr(m_data + offset, '\n', m_size - offset));
+
+        return newline ? newline - m_data + 1 : m_size;
+    }
+
+    qint64 LogFileIndex::linesBefore(qint64 offset, int count) const
+    {
+        // scans backward, so the last lines of a log are found without reading the rest
+        for (int i = 0; i < count && offset > 0; ++i)
+            offset = lineStart(offset - 1);
+
+        return offset;
+    }
+
+    qint64 LogFileIndex::linesAfter(qint64 offset, int count) const
+    {
+        for (int i = 0; i < count && offset < m_size; ++i)
+            offset = nextLineStart(offset);
+
+        return offset;
+    }
+
+    QStringList LogFileIndex::lines(qint64 offset, int count, QList<qint64>* offsets) const
+    {
+        QStringList result;
+
+        while (result.count() < count && offset < m_size)
+        {
+            const qint64 next = nextLineStart(offset);
+            qint64 end = next;
+
+            if (end > offset && m_data[end - 1] == '\n')
+                --end;
+            if (end > offset && m_data[end - 1] == '\r')
+                --end;
+
+            // Logfile is in utf8 so we don't need to do encoding stuff here
+            result << QString::fromUtf8(m_data + offset, end - offset);
+
+            if (offsets)
+                offsets->append(offset);
+
+            offset = next;
+        }
+
+        return result;
+    }
+
+    QDate LogFileIndex::dateOfLine(qint64 offset) const
+    {
+        const QStringList text = lines(offset, 1);
+
+        if (text.isEmpty() || !text.first().startsWith(QLatin1Char('[')))
+            return QDate();
+
+        // The format in ChatWindow::logText is "[date] [time] ..."
+        const int close = text.first().indexOf(QLatin1Char(']'));
+
+        if (close == -1)
+            return QDate();
+
+        return QLocale().toDate(text.first().mid(1, close - 1), QLocale::LongFormat);
+    }
+
+    qint64 LogFileIndex::firstLineOnOrAfter(const QDate& date) const
+    {
+        // Only probe this many lines for a timestamp, e.g. to get past the
+        // "Logfile started" intro.
+        static const int maxProbe = 32;
+
+        // both are line starts, bisected by bytes as the lines are not counted
+        qint64 low = 0;
+        qint64 high = m_size;
+
+        while (low < high)
+        {
+            const qint64 middle = lineStart(low + (high - low) / 2);
+
+            qint64 probe = middle;
+            QDate found;
+
+            for (int i = 0; probe < high && i < maxProbe; ++i)
+            {
+                found = dateOfLine(probe);
+
+                if (found.isValid())
+                    break;
+
+                probe = nextLineStart(probe);
+            }
+
+            // lines without a timestamp belong to the ones after them
+            if (probe >= high || (found.isValid() && found >= date))
+                high = middle;
+            else
+                low = nextLineStart(found.isValid() ? probe : middle);
+        }
+
+        return low;
+    }
+
+    void LogFileIndex::setLineIndex(const LineIndex& index)
+    {
+        m_lineIndex = index;
+        m_hasLineIndex = true;
+    }
+
+    qint64 LogFileIndex::lineCount() const
+    {
+        return m_hasLineIndex ? m_lineIndex.lineCount : -1;
+    }
+
+    qint64 LogFileIndex::lineAtOffset(qint64 offset) const
+    {
+        if (!m_hasLineIndex)
+            return -1;
+
+        if (m_size == 0)
+            return 0;
+
+        offset = qBound<qint64>(0, offset, m_size);
+
+        const QList<qint64>& checkpoints = m_lineIndex.checkpoints;
+        const auto it = std::upper_bound(checkpoints.cbegin(), checkpoints.cend(), offset) - 1;
+
+        qint64 line = (it - checkpoints.cbegin()) * IndexStride;
+        qint64 start = *it;
+
+        while (true)
+        {
+            const qint64 next = nextLineStart(start);
+
+            if (next > offset || next >= m_size)
+                break;
+
+            start = next;
+            ++line;
+        }
+
+        return line;
+    }
+
+    LogFileIndex::LineIndex LogFileIndex::buildIndex(QByteArrayView data, const std::atomic_bool& cancel)
+    {
+        LineIndex index;
+        index.checkpoints.append(0);
+
+        const char* begin = data.data();
+        const qsizetype size = data.size();
+        qsizetype offset = 0;
+
+        while (offset < size)
+        {
+            // a line ends with a newline, or with the file
+            const auto* newline = static_cast<const char*>(memchr(begin + offset, '\n', size - offset));
+
+            ++index.lineCount;
+
+            if (!newline)
+                break;
+
+            offset = newline - begin + 1;
+
+            if (offset < size && index.lineCount % IndexStride == 0)
+            {
+                index.checkpoints.append(offset);
+
+                if (index.checkpoints.size() % 1024 == 0 && cancel.load(std::memory_order_relaxed))
+                    break;
+            }
+        }
+
+        return index;
+    }
+
+    QList<qint64> LogFileIndex::search(QByteArrayView data, const QByteArray& needle, const std::atomic_bool& cancel)
+    {
+        QList<qint64> result;
+
+        if (needle.isEmpty())
+            return result;
+
+        // Search in chunks to notice cancellation even without any hits.
+        static const qsizetype chunkSize = 16 * 1024 * 1024;
+
+        const QByteArrayMatcher matcher(needle);
+        qsizetype from = 0;
+
+        while (from < data.size() && !cancel.load(std::memory_order_relaxed))
+        {
+            const qsizetype chunkEnd = qMin(data.size(), from + chunkSize + needle.size() - 1);
+            const qsizetype hit = matcher.indexIn(data.first(chunkEnd), from);
+
+            if (hit < 0)
+            {
+                if (chunkEnd == data.size())
+                    break;
+
+                from += chunkSize;
+                continue;
+            }
+
+            result.append(data.first(hit).lastIndexOf('\n') + 1);
+
+            // one result per line
+            const qsizetype lineEnd = data.indexOf('\n', hit);
+
+            if (lineEnd < 0)
+                break;
+
+            from = lineEnd + 1;
+        }
+
+        return result;
+    }
+}
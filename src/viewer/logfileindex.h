@@ -0,0 +1,122 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef LOGFILEINDEX_H
+#define LOGFILEINDEX_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+#include <atomic>
+
+class QDate;
+
+namespace Konversation
+{
+    /**
+     * Random access to the lines of a log file of any size.
+     *
+     * The file is memory-mapped and lines are addressed by the offsets they
+     * start at, which are found by scanning from a known offset, e.g. back
+     * from the end of the file for its last lines. Line numbers need the
+     * whole file to be indexed, which is left to a worker thread, see
+     * buildIndex(). To keep the index small for multi-gigabyte logs only
+     * every IndexStride-th line offset is stored.
+     */
+    class LogFileIndex
+    {
+        public:
+            /// Offsets of lines 0, IndexStride, 2 * IndexStride, ... and the number of lines.
+            struct LineIndex
+            {
+                QList<qint64> checkpoints;
+                qint64 lineCount = 0;
+            };
+
+            LogFileIndex() = default;
+            ~LogFileIndex();
+
+            bool open(const QString& fileName);
+            void close();
+
+            bool isOpen() const { return m_file.isOpen(); }
+
+            /// The mapped file content. Stays valid until close().
+            QByteArrayView data() const { return QByteArrayView(m_data, m_size); }
+            qint64 size() const { return m_size; }
+
+            /// Start offset of the line containing the byte at @p offset.
+            qint64 lineStart(qint64 offset) const;
+
+            /// Start offset of the line after the one starting at @p offset, size() for the last one.
+            qint64 nextLineStart(qint64 offset) const;
+
+            /// Start offset of the line @p count lines before the one starting at @p offset, at most 0.
+            qint64 linesBefore(qint64 offset, int count) const;
+
+            /// Start offset of the line @p count lines after the one starting at @p offset, at most size().
+            qint64 linesAfter(qint64 offset, int count) const;
+
+            /**
+             * Decodes up to @p count lines starting with the one at @p offset,
+             * storing their start offsets in @p offsets if given.
+             */
+            QStringList lines(qint64 offset, int count, QList<qint64>* offsets = nullptr) const;
+
+            /**
+             * Finds the first line logged on or after @p date, based on the
+             * timestamps written by ChatWindow::logText().
+             * @return the offset of the line, or size() if there is none
+             */
+            qint64 firstLineOnOrAfter(const QDate& date) const;
+
+            /// Whether setLineIndex() was given the index of the file.
+            bool hasLineIndex() const { return m_hasLineIndex; }
+            void setLineIndex(const LineIndex& index);
+
+            /// Number of lines, -1 without the line index.
+            qint64 lineCount() const;
+
+            /// Number of the line containing the byte at @p offset, -1 without the line index.
+            qint64 lineAtOffset(qint64 offset) const;
+
+            /**
+             * Indexes the lines of @p data. Meant to be run on a worker
+             * thread over data(), stops early once @p cancel is set.
+             */
+            static LineIndex buildIndex(QByteArrayView data, const std::atomic_bool& cancel);
+
+            /**
+             * Returns the offsets of the lines in @p data that contain
+             * @p needle, matching case. Meant to be run on a worker thread
+             * over data(), stops early once @p cancel is set.
+             */
+            static QList<qint64> search(QByteArrayView data, const QByteArray& needle, const std::atomic_bool& cancel);
+
+        private:
+            QDate dateOfLine(qint64 offset) const;
+
+        private:
+            static const qint64 IndexStride = 64;
+
+            QFile m_file;
+            uchar* m_map = nullptr;
+            /// Used instead of the mapping if the file can't be mapped.
+            QByteArray m_buffer;
+            const char* m_data = nullptr;
+            qint64 m_size = 0;
+
+            LineIndex m_lineIndex;
+            bool m_hasLineIndex = false;
+
+            Q_DISABLE_COPY(LogFileIndex)
+    };
+}
+
+#endif
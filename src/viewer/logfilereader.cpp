@@ -9,12 +9,14 @@
 #include "ircview.h"
 #include "ircviewbox.h"
 
+#include <QAbstractTextDocumentLayout>
+#include <QDateEdit>
 #include <QFile>
-#include <QPushButton>
 #include <QLabel>
-#include <QSpinBox>
-#include <QTextCodec>
-#include <QKeyEvent>
+#include <QLineEdit>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QThread>
 
 #include <KToolBar>
 #include <KMessageBox>
@@ -23,8 +25,21 @@
 #include <KIO/CopyJob>
 #include <KJobUiDelegate>
 
+#include <algorithm>
+
+
+// Number of lines kept in the view, and by how many it moves when paging.
+static const int WindowLines = 1000;
+static const int PageLines = 500;
 
 LogfileReader::LogfileReader(QWidget* parent, const QString& log, const QString& caption) : ChatWindow(parent)
+    , m_endOffset(0)
+    , m_paging(false)
+    , m_countThread(nullptr)
+    , m_cancelCount(false)
+    , m_searchThread(nullptr)
+    , m_cancelSearch(false)
+    , m_currentResult(-1)
 {
     setType(ChatWindow::LogFileReader);
     setName(i18n("Logfile of %1", caption));
@@ -39,22 +54,34 @@ LogfileReader::LogfileReader(QWidget* parent, const QString& log, const QString&
     toolBar->addAction(QIcon::fromTheme(QStringLiteral("view-refresh")), i18n("Reload"), this, &LogfileReader::updateView);
     toolBar->addAction(QIcon::fromTheme(QStringLiteral("edit-delete")), i18n("Clear Logfile"), this, &LogfileReader::clearLog);
 
-    toolBar->addWidget(new QLabel(i18n("Show last:"),toolBar));
-    sizeSpin = new QSpinBox(toolBar);
-    sizeSpin->setMinimum(10);
-    sizeSpin->setMaximum(1000);
-    sizeSpin->setSingleStep(10);
-    sizeSpin->setObjectName(QStringLiteral("logfile_size_spinbox"));
-    sizeSpin->setWhatsThis(i18n("Use this box to set the maximum size of the log file. This setting does not take effect until you restart Konversation. Each log file may have a separate setting."));
-    sizeSpin->setValue(Preferences::self()->logfileBufferSize());
-    sizeSpin->setSuffix(i18n(" KB"));
-    sizeSpin->installEventFilter(this);
-    toolBar->addWidget(sizeSpin);
-    connect(sizeSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &LogfileReader::storeBufferSize);
+    toolBar->addSeparator();
+
+    toolBar->addWidget(new QLabel(i18n("Go to date:"),toolBar));
+    dateEdit = new QDateEdit(QDate::currentDate(), toolBar);
+    dateEdit->setCalendarPopup(true);
+    dateEdit->setObjectName(QStringLiteral("logfile_date_edit"));
+    dateEdit->setWhatsThis(i18n("Use this box to jump to the first message logged on or after the selected date."));
+    toolBar->addWidget(dateEdit);
+    toolBar->addAction(QIcon::fromTheme(QStringLiteral("go-jump")), i18n("Go"), this, &LogfileReader::jumpToDate);
+
+    toolBar->addSeparator();
+
+    searchLine = new QLineEdit(toolBar);
+    searchLine->setClearButtonEnabled(true);
+    searchLine->setPlaceholderText(i18n("Search whole logfile"));
+    searchLine->setWhatsThis(i18n("Searches the whole log file, not only the part shown below, matching case. Press Enter again to go to the next match."));
+    toolBar->addWidget(searchLine);
+    connect(searchLine, &QLineEdit::returnPressed, this, &LogfileReader::startSearch);
+
+    toolBar->addSeparator();
+
+    positionLabel = new QLabel(toolBar);
+    toolBar->addWidget(positionLabel);
 
     auto* ircBox = new IRCViewBox(this);
     setTextView(ircBox->ircView());
     getTextView()->setWhatsThis(i18n("The messages in the log file are displayed here. The oldest messages are at the top and the most recent are at the bottom."));
+    connect(getTextView()->verticalScrollBar(), &QScrollBar::valueChanged, this, &LogfileReader::checkScrollPosition);
 
     updateView();
     ircBox->ircView()->setFocusPolicy(Qt::StrongFocus);
@@ -68,67 +95,260 @@ LogfileReader::LogfileReader(QWidget* parent, const QString& log, const QString&
 
 LogfileReader::~LogfileReader()
 {
+    cancelSearch();
+    cancelCount();
 }
 
-bool LogfileReader::eventFilter(QObject* watched, QEvent* e)
+void LogfileReader::updateView()
 {
-    if (e->type() == QEvent::KeyPress)
+    cancelSearch();
+    cancelCount();
+    m_searchResults.clear();
+    m_currentResult = -1;
+
+    if (!m_log.open(fileName))
     {
-        auto* ke = static_cast<QKeyEvent*>(e);
+        getTextView()->clear();
+        m_lineOffsets.clear();
+        m_endOffset = 0;
+        positionLabel->clear();
+
+        return;
+    }
+
+    // start with the most recent lines, found backward from the end
+    showLines(m_log.linesBefore(m_log.size(), WindowLines));
+
+    // The mapping stays valid until the next updateView() or clearLog(),
+    // both cancel and wait for the count first.
+    const QByteArrayView data = m_log.data();
+
+    m_countThread = QThread::create([this, data]() {
+        m_lineIndex = Konversation::LogFileIndex::buildIndex(data, m_cancelCount);
+    });
+
+    connect(m_countThread, &QThread::finished, this, &LogfileReader::countFinished);
+
+    m_countThread->start(QThread::LowPriority);
+}
+
+void LogfileReader::showLines(qint64 first, qint64 anchor, bool anchorAtBottom)
+{
+    m_paging = true;
+
+    IRCView* view = getTextView();
+    view->clear();
+
+    m_lineOffsets.clear();
+
+    const QStringList lines = m_log.lines(first, WindowLines, &m_lineOffsets);
+
+    m_endOffset = m_lineOffsets.isEmpty() ? first : m_log.nextLineStart(m_lineOffsets.last());
+
+    // Insert the whole page in one edit, so it is laid out only once.
+    QTextCursor cursor(view->document());
+    cursor.beginEditBlock();
+
+    for (const QString& line : lines)
+        view->appendLog(line.toHtmlEscaped());
 
-        if (ke->key() == Qt::Key_Return || ke->key() == Qt::Key_Enter)
-        {
-            updateView();
+    cursor.endEditBlock();
 
-            return true;
-        }
+    QScrollBar* scrollBar = view->verticalScrollBar();
+
+    const int anchorLine = shownLine(anchor);
+
+    if (anchorLine >= 0)
+    {
+        const QTextBlock block = view->document()->findBlockByNumber(anchorLine);
+        const QRectF rect = view->document()->documentLayout()->blockBoundingRect(block);
+
+        if (anchorAtBottom)
+            scrollBar->setValue(static_cast<int>(rect.bottom()) - view->viewport()->height());
         else
-            return false;
+            scrollBar->setValue(static_cast<int>(rect.top()));
     }
+    else
+        scrollBar->setValue(scrollBar->maximum());
+
+    updatePosition();
 
-    return ChatWindow::eventFilter(watched, e);
+    m_paging = false;
 }
 
-void LogfileReader::storeBufferSize(int kb)
+int LogfileReader::shownLine(qint64 offset) const
 {
-    Preferences::self()->setLogfileBufferSize(kb);
+    const auto it = std::lower_bound(m_lineOffsets.cbegin(), m_lineOffsets.cend(), offset);
+
+    if (it == m_lineOffsets.cend() || *it != offset)
+        return -1;
+
+    return static_cast<int>(it - m_lineOffsets.cbegin());
 }
 
-void LogfileReader::updateView()
+void LogfileReader::updatePosition()
+{
+    if (m_lineOffsets.isEmpty())
+    {
+        positionLabel->clear();
+
+        return;
+    }
+
+    const qint64 firstLine = m_log.lineAtOffset(m_lineOffsets.first());
+
+    // line numbers are known once the count thread is done
+    if (firstLine < 0)
+        positionLabel->setText(i18np("1 line of ?", "%1 lines of ?", m_lineOffsets.count()));
+    else
+        positionLabel->setText(i18n("Lines %1 to %2 of %3", firstLine + 1, firstLine + m_lineOffsets.count(), m_log.lineCount()));
+}
+
+void LogfileReader::checkScrollPosition(int value)
 {
-    // get maximum size of logfile to display
-    qint64 pos = Q_INT64_C(1024) * sizeSpin->value();
-    getTextView()->clear();
+    if (m_paging)
+        return;
+
+    if (m_lineOffsets.isEmpty())
+        return;
 
-    QFile file(fileName);
+    QScrollBar* scrollBar = getTextView()->verticalScrollBar();
+    const qint64 firstOffset = m_lineOffsets.first();
 
-    if(file.open(QIODevice::ReadOnly))
+    if (value == scrollBar->minimum() && firstOffset > 0)
+    {
+        // page in older lines, keeping the current first line in place
+        showLines(m_log.linesBefore(firstOffset, PageLines), firstOffset);
+    }
+    else if (value == scrollBar->maximum() && m_endOffset < m_log.size())
     {
-        QTextStream stream(&file);
-        stream.setAutoDetectUnicode(true);
-
-        // Set file pointer to <pos> bytes from the end
-        if(stream.device()->size() > pos)
-        {
-            stream.device()->seek(stream.device()->size() - pos);
-        }
-        // Skip first line, since it may be incomplete
-        // NOTE: we always skip the first line(in the log), but the
-        //       first line is just a '\n', so it's ok
-        stream.readLine();
-        QString str;
-
-        while(!stream.atEnd())
-        {
-            str = stream.readLine().toHtmlEscaped();
-            getTextView()->appendLog(str);
-        }
-
-        stream.setDevice(nullptr);
-        file.close();
+        // page in newer lines, keeping the current last line in place
+        showLines(m_log.linesAfter(firstOffset, PageLines), m_lineOffsets.last(), true);
     }
 }
 
+void LogfileReader::jumpToDate()
+{
+    if (m_log.size() == 0)
+        return;
+
+    qint64 offset = m_log.firstLineOnOrAfter(dateEdit->date());
+
+    if (offset >= m_log.size())
+        offset = m_log.lineStart(m_log.size() - 1);
+
+    showLines(m_log.linesBefore(offset, PageLines / 2), offset);
+}
+
+void LogfileReader::startSearch()
+{
+    const QByteArray text = searchLine->text().toUtf8();
+
+    if (text.isEmpty() || !m_log.isOpen())
+        return;
+
+    if (text == m_searchText && !m_searchThread && !m_searchResults.isEmpty())
+    {
+        showSearchResult((m_currentResult + 1) % m_searchResults.count());
+
+        return;
+    }
+
+    cancelSearch();
+
+    m_searchText = text;
+    m_searchResults.clear();
+    m_currentResult = -1;
+
+    positionLabel->setText(i18n("Searching..."));
+
+    // The mapping stays valid until the next updateView() or clearLog(),
+    // both cancel and wait for the search first.
+    const QByteArrayView data = m_log.data();
+
+    m_searchThread = QThread::create([this, data, text]() {
+        m_searchResults = Konversation::LogFileIndex::search(data, text, m_cancelSearch);
+    });
+
+    connect(m_searchThread, &QThread::finished, this, &LogfileReader::searchFinished);
+
+    m_searchThread->start(QThread::LowPriority);
+}
+
+void LogfileReader::searchFinished()
+{
+    m_searchThread->deleteLater();
+    m_searchThread = nullptr;
+
+    if (m_searchResults.isEmpty())
+        positionLabel->setText(i18n("No matches"));
+    else
+        showSearchResult(0);
+}
+
+void LogfileReader::countFinished()
+{
+    m_countThread->deleteLater();
+    m_countThread = nullptr;
+
+    m_log.setLineIndex(m_lineIndex);
+    m_lineIndex = Konversation::LogFileIndex::LineIndex();
+
+    // leaves the search's state alone
+    if (m_searchText.isEmpty())
+        updatePosition();
+}
+
+void LogfileReader::showSearchResult(int result)
+{
+    m_currentResult = result;
+
+    const qint64 offset = m_searchResults.at(result);
+
+    showLines(m_log.linesBefore(offset, PageLines / 2), offset);
+
+    // matching case like the search of the whole file
+    IRCView* view = getTextView();
+    view->setTextCursor(QTextCursor(view->document()->findBlockByNumber(shownLine(offset))));
+    view->find(searchLine->text(), QTextDocument::FindCaseSensitively);
+
+    positionLabel->setText(i18n("Match %1 of %2", result + 1, m_searchResults.count()));
+}
+
+void LogfileReader::cancelSearch()
+{
+    if (m_searchThread)
+    {
+        disconnect(m_searchThread, nullptr, this, nullptr);
+
+        m_cancelSearch = true;
+        m_searchThread->wait();
+
+        delete m_searchThread;
+        m_searchThread = nullptr;
+    }
+
+    m_cancelSearch = false;
+    m_searchText.clear();
+}
+
+void LogfileReader::cancelCount()
+{
+    if (m_countThread)
+    {
+        disconnect(m_countThread, nullptr, this, nullptr);
+
+        m_cancelCount = true;
+        m_countThread->wait();
+
+        delete m_countThread;
+        m_countThread = nullptr;
+    }
+
+    m_cancelCount = false;
+    m_lineIndex = Konversation::LogFileIndex::LineIndex();
+}
+
 void LogfileReader::clearLog()
 {
     if(KMessageBox::warningContinueCancel(this,
@@ -138,6 +358,9 @@ void LogfileReader::clearLog()
         KStandardGuiItem::cancel(),
         QStringLiteral("ClearLogfileQuestion"))==KMessageBox::Continue)
     {
+        cancelSearch();
+        cancelCount();
+        m_log.close();
         QFile::remove(fileName);
         updateView();
     }
@@ -8,15 +8,25 @@
 #define LOGFILEREADER_H
 
 #include "chatwindow.h"
+#include "logfileindex.h"
 
 #include <KIO/Job>
 
-class QSpinBox;
+#include <atomic>
+
+class QDateEdit;
+class QLabel;
+class QLineEdit;
+class QThread;
 
 class KToolBar;
 
 /**
  * Shows the content of a log file
+ *
+ * Only a window of lines is kept in the view, further lines are paged in
+ * when scrolling past its top or bottom. Counting the lines and searching
+ * cover the whole file and run on worker threads.
  */
 class LogfileReader : public ChatWindow
 {
@@ -30,25 +40,54 @@ class LogfileReader : public ChatWindow
         virtual bool closeYourself() { closeLog(); return true; }
         bool searchView() const override;
 
-        bool eventFilter(QObject* watched, QEvent* e) override;
-
     protected:
         /** Called from ChatWindow adjustFocus */
         void childAdjustFocus() override;
 
     private Q_SLOTS:
         void updateView();
-        void storeBufferSize(int kb);
+        void checkScrollPosition(int value);
+        void jumpToDate();
+        void startSearch();
+        void searchFinished();
+        void countFinished();
         void clearLog();
         void saveLog();
         void closeLog();
         void copyResult(KJob* job);
 
+    private:
+        /// Shows the lines starting at offset @p first, keeping the line at @p anchor at the same place if it is shown.
+        void showLines(qint64 first, qint64 anchor = -1, bool anchorAtBottom = false);
+        /// Index in the view of the line starting at @p offset, -1 if not shown.
+        int shownLine(qint64 offset) const;
+        void updatePosition();
+        void showSearchResult(int result);
+        void cancelSearch();
+        void cancelCount();
+
     private:
         KToolBar* toolBar;
-        QSpinBox* sizeSpin;
+        QDateEdit* dateEdit;
+        QLineEdit* searchLine;
+        QLabel* positionLabel;
         QString fileName;
 
+        Konversation::LogFileIndex m_log;
+        QList<qint64> m_lineOffsets; ///< of the lines shown
+        qint64 m_endOffset; ///< after the last line shown
+        bool m_paging;
+
+        QThread* m_countThread;
+        std::atomic_bool m_cancelCount;
+        Konversation::LogFileIndex::LineIndex m_lineIndex; ///< handed over by the count thread
+
+        QThread* m_searchThread;
+        std::atomic_bool m_cancelSearch;
+        QByteArray m_searchText;
+        QList<qint64> m_searchResults; ///< line offsets
+        int m_currentResult;
+
         Q_DISABLE_COPY(LogfileReader)
 };
 
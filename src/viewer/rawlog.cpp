@@ -11,12 +11,56 @@
 #include "server.h"
 #include "application.h"
 
+#include <KMessageBox>
+
+#include <QDateTime>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimeZone>
+
 
 RawLog::RawLog(QWidget* parent) : ChatWindow(parent)
 {
     setName(i18n("Raw Log"));
     setType(ChatWindow::RawLog);
     m_isTopLevelView = false;
+    m_renderPending = false;
+
+    auto* filterBox = new QWidget(this);
+    auto* filterBoxLayout = new QHBoxLayout(filterBox);
+    filterBoxLayout->setSpacing(spacing());
+    filterBoxLayout->setContentsMargins(0, 0, 0, 0);
+
+    m_commandFilter = new QLineEdit(filterBox);
+    m_commandFilter->setClearButtonEnabled(true);
+    m_commandFilter->setPlaceholderText(i18n("e.g. PRIVMSG, NOTICE"));
+    m_commandFilter->setToolTip(i18n("Show only lines with one of these commands"));
+    auto* commandLabel = new QLabel(i18n("Commands:"), filterBox);
+    commandLabel->setBuddy(m_commandFilter);
+    filterBoxLayout->addWidget(commandLabel);
+    filterBoxLayout->addWidget(m_commandFilter, 2);
+
+    m_targetFilter = new QLineEdit(filterBox);
+    m_targetFilter->setClearButtonEnabled(true);
+    m_targetFilter->setPlaceholderText(i18n("e.g. #konversation"));
+    m_targetFilter->setToolTip(i18n("Show only lines for this channel or nick"));
+    auto* targetLabel = new QLabel(i18n("Target:"), filterBox);
+    targetLabel->setBuddy(m_targetFilter);
+    filterBoxLayout->addWidget(targetLabel);
+    filterBoxLayout->addWidget(m_targetFilter, 1);
+
+    m_captureButton = new QPushButton(QIcon::fromTheme(QStringLiteral("media-record")), i18n("Capture to File..."), filterBox);
+    m_captureButton->setCheckable(true);
+    m_captureButton->setToolTip(i18n("Also write all lines to a capture file, for later replay"));
+    filterBoxLayout->addWidget(m_captureButton);
+
+    connect(m_commandFilter, &QLineEdit::textChanged, this, &RawLog::updateFilter);
+    connect(m_targetFilter, &QLineEdit::textChanged, this, &RawLog::updateFilter);
+    connect(m_captureButton, &QPushButton::toggled, this, &RawLog::toggleCapture);
+
     auto* ircBox = new IRCViewBox(this);
     setTextView(ircBox->ircView());               // Server will be set later in setServer()
 
@@ -31,6 +75,14 @@ void RawLog::childAdjustFocus()
 {
 }
 
+void RawLog::showEvent(QShowEvent* event)
+{
+    if (m_renderPending)
+        render();
+
+    ChatWindow::showEvent(event);
+}
+
 void RawLog::morphNotification()
 {
     activateTabNotification(Konversation::tnfSystem);
@@ -106,15 +158,96 @@ void RawLog::appendRaw(RawLog::MessageDirection dir, const QByteArray& message)
     if (!getTextView() || message.isEmpty())
         return;
 
+    m_buffer.append(dir == RawLog::Outbound, message);
+
+    // rendered when shown
+    if (!isVisible())
+    {
+        m_renderPending = true;
+        return;
+    }
+
+    appendRecord(m_buffer.at(m_buffer.count() - 1));
+}
+
+void RawLog::appendRecord(const Konversation::RawLogRecord& record)
+{
+    if (!m_filter.matches(record.message))
+        return;
+
     static const QLatin1String in("&gt;&gt; ");
     static const QLatin1String out("&lt;&lt; ");
-    QString output = toPercentEncoding(message, (dir == RawLog::Inbound ? in : out));
+    QString output = toPercentEncoding(record.message, (record.outbound ? out : in));
 
     // Whatever the original line inbound ending was is too much effort to conserve, but its nice
     // to see the actual line endings, so we'll fake it here
     output.append(QLatin1String("%0A"));
 
-    appendRaw(output, dir == RawLog::Outbound);
+    // the time it was recorded, not rendered
+    const QHash<QString, QString> messageTags {
+        { QStringLiteral("time"), QDateTime::fromMSecsSinceEpoch(record.time, QTimeZone::UTC).toString(Qt::ISODateWithMs) }
+    };
+
+    appendRaw(output, record.outbound, messageTags);
+}
+
+void RawLog::render()
+{
+    m_renderPending = false;
+
+    clear();
+
+    // the most recent lines passing the filter
+    int first = m_buffer.count();
+    int found = 0;
+
+    while (first > 0 && found < RenderLimit)
+    {
+        --first;
+
+        if (m_filter.matches(m_buffer.at(first).message))
+            ++found;
+    }
+
+    for (int i = first; i < m_buffer.count(); ++i)
+        appendRecord(m_buffer.at(i));
+}
+
+void RawLog::updateFilter()
+{
+    m_filter.setCommands(m_commandFilter->text());
+    m_filter.setTarget(m_targetFilter->text());
+
+    if (isVisible())
+        render();
+    else
+        m_renderPending = true;
+}
+
+void RawLog::toggleCapture(bool capture)
+{
+    if (!capture)
+    {
+        m_buffer.stopCapture();
+        m_captureButton->setToolTip(i18n("Also write all lines to a capture file, for later replay"));
+        return;
+    }
+
+    const QString fileName = QFileDialog::getSaveFileName(window(), i18n("Capture Raw Log"));
+    QString errorString;
+
+    if (fileName.isEmpty() || !m_buffer.startCapture(fileName, errorString))
+    {
+        if (!fileName.isEmpty())
+            KMessageBox::error(this, i18n("The capture file could not be opened: %1", errorString));
+
+        // without emitting toggled() again
+        const QSignalBlocker blocker(m_captureButton);
+        m_captureButton->setChecked(false);
+        return;
+    }
+
+    m_captureButton->setToolTip(i18n("Capturing to %1", fileName));
 }
 
 #include "moc_rawlog.cpp"
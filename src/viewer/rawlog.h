@@ -8,9 +8,16 @@
 #define RAWLOG_H
 
 #include "chatwindow.h"
+#include "rawlogbuffer.h"
+
+class QLineEdit;
+class QPushButton;
 
 /**
  * Provides a view to the raw protocol
+ *
+ * The lines are recorded in a ring buffer and only the most recent ones
+ * passing the filter are rendered, while the view is visible.
  */
 class RawLog : public ChatWindow
 {
@@ -35,8 +42,30 @@ class RawLog : public ChatWindow
     protected:
         /** Called from ChatWindow adjustFocus */
         void childAdjustFocus() override;
+        void showEvent(QShowEvent* event) override;
+
+    private Q_SLOTS:
+        void updateFilter();
+        void toggleCapture(bool capture);
+
+    private:
+        void appendRecord(const Konversation::RawLogRecord& record);
+        /// Renders the most recent lines passing the filter anew.
+        void render();
 
     private:
+        /// At most this many lines are rendered at once.
+        static const int RenderLimit = 500;
+
+        Konversation::RawLogBuffer m_buffer;
+        Konversation::RawLogFilter m_filter;
+        /// Lines were recorded or the filter changed while hidden.
+        bool m_renderPending;
+
+        QLineEdit* m_commandFilter;
+        QLineEdit* m_targetFilter;
+        QPushButton* m_captureButton;
+
         Q_DISABLE_COPY(RawLog)
 };
 
@@ -0,0 +1,287 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "scrollbackindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Konversation
+{
+    /// Calls @p function with the bounds of every run of letters and digits in @p text.
+    template<typename Function>
+    static void forEachWord(const QString& text, Function function)
+    {
+        qsizetype start = -1;
+
+        for (qsizetype pos = 0; pos <= text.size(); ++pos)
+        {
+            const bool isWordChar = pos < text.size() && text.at(pos).isLetterOrNumber();
+
+            if (isWordChar && start == -1)
+                start = pos;
+            else if (!isWordChar && start != -1)
+            {
+                function(start, pos);
+                start = -1;
+            }
+        }
+    }
+
+    int ScrollbackIndex::append(const QString& text, qint64 time)
+    {
+        const int lineId = endLine();
+
+        m_lines.append(text);
+        m_times.append(time);
+
+        forEachWord(text, [&](qsizetype start, qsizetype end) {
+            QList<int>& ids = wordLines(text.sliced(start, end - start).toCaseFolded());
+
+            if (ids.isEmpty() || ids.last() != lineId)
+                ids.append(lineId);
+        });
+
+        return lineId;
+    }
+
+    int ScrollbackIndex::prepend(const QString& text, qint64 time)
+    {
+        // the ids of evicted lines are about to be reused
+        if (m_evictedLines > 0)
+            compact();
+
+        const int lineId = --m_firstLine;
+
+        m_lines.prepend(text);
+        m_times.prepend(time);
+
+        forEachWord(text, [&](qsizetype start, qsizetype end) {
+            QList<int>& ids = wordLines(text.sliced(start, end - start).toCaseFolded());
+
+            if (ids.isEmpty() || ids.first() != lineId)
+                ids.prepend(lineId);
+        });
+
+        return lineId;
+    }
+
+    QList<int>& ScrollbackIndex::wordLines(const QString& word)
+    {
+        auto it = m_words.find(word);
+
+        if (it == m_words.end())
+        {
+            it = m_words.insert(word, QList<int>());
+
+            for (qsizetype i = 0; i < word.size(); ++i)
+                m_suffixes.insert(word.sliced(i), word);
+        }
+
+        return it.value();
+    }
+
+    void ScrollbackIndex::removeLinesBefore(int lineId)
+    {
+        const int count = qMin(lineId - m_firstLine, static_cast<int>(m_lines.count()));
+
+        if (count <= 0)
+            return;
+
+        m_lines.remove(0, count);
+        m_times.remove(0, count);
+        m_firstLine += count;
+        m_evictedLines += count;
+
+        // Drop the stale ids once there are as many of them as live ones.
+        if (m_evictedLines > qMax<qsizetype>(m_lines.count(), 1024))
+            compact();
+    }
+
+    void ScrollbackIndex::clear()
+    {
+        m_firstLine = endLine();
+        m_lines.clear();
+        m_times.clear();
+        m_words.clear();
+        m_suffixes.clear();
+        m_evictedLines = 0;
+    }
+
+    QString ScrollbackIndex::lineText(int lineId) const
+    {
+        if (lineId < m_firstLine || lineId >= endLine())
+            return QString();
+
+        return m_lines.at(lineId - m_firstLine);
+    }
+
+    qint64 ScrollbackIndex::lineTime(int lineId) const
+    {
+        if (lineId < m_firstLine || lineId >= endLine())
+            return 0;
+
+        return m_times.at(lineId - m_firstLine);
+    }
+
+    void ScrollbackIndex::compact()
+    {
+        for (auto it = m_words.begin(); it != m_words.end();)
+        {
+            QList<int>& ids = it.value();
+
+            ids.erase(ids.begin(), std::lower_bound(ids.begin(), ids.end(), m_firstLine));
+
+            if (ids.isEmpty())
+            {
+                const QString& word = it.key();
+
+                for (qsizetype i = 0; i < word.size(); ++i)
+                    m_suffixes.remove(word.sliced(i), word);
+
+                it = m_words.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        m_evictedLines = 0;
+    }
+
+    QList<int> ScrollbackIndex::candidates(const QString& pattern, qsizetype start, qsizetype end) const
+    {
+        const QString word = pattern.sliced(start, end - start).toCaseFolded();
+
+        // Next to a non-word character of the pattern a word of the line has to
+        // start or end just like the pattern word, only at the edges of the
+        // pattern it can be part of a longer word.
+        const bool startsWord = start > 0;
+        const bool endsWord = end < pattern.size();
+
+        if (startsWord && endsWord)
+            return m_words.value(word);
+
+        QList<int> result;
+        int matchingWords = 0;
+
+        // The words ending like the pattern word have it as a suffix, the ones
+        // containing it have a suffix starting with it.
+        auto it = endsWord ? m_suffixes.constFind(word) : m_suffixes.lowerBound(word);
+        const auto last = endsWord ? m_suffixes.upperBound(word) : m_suffixes.cend();
+
+        for (; it != last && it.key().startsWith(word); ++it)
+        {
+            const QString& key = it.value();
+
+            // the whole word is the suffix starting at its beginning
+            if (startsWord && it.key().size() != key.size())
+                continue;
+
+            // a word containing the pattern word twice comes up twice, see below
+            result.append(m_words.value(key));
+            ++matchingWords;
+        }
+
+        if (matchingWords > 1)
+        {
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+        }
+
+        return result;
+    }
+
+    QList<int> ScrollbackIndex::search(const QString& pattern, QTextDocument::FindFlags flags, int fromLine, const std::atomic_bool* cancel) const
+    {
+        QList<int> result;
+
+        if (pattern.isEmpty() || m_lines.isEmpty())
+            return result;
+
+        flags &= ~QTextDocument::FindBackward;
+
+        QList<int> lines;
+        bool hasWords = false;
+
+        forEachWord(pattern, [&](qsizetype start, qsizetype end) {
+            if (hasWords && lines.isEmpty())
+                return;
+
+            const QList<int> ids = candidates(pattern, start, end);
+
+            if (!hasWords)
+                lines = ids;
+            else
+            {
+                QList<int> both;
+                std::set_intersection(lines.cbegin(), lines.cend(), ids.cbegin(), ids.cend(), std::back_inserter(both));
+                lines = both;
+            }
+
+            hasWords = true;
+        });
+
+        const int first = qMax(fromLine, m_firstLine);
+        const int end = endLine();
+
+        auto check = [&](int lineId) {
+            if (indexIn(m_lines.at(lineId - m_firstLine), pattern, flags, 0) != -1)
+                result.append(lineId);
+        };
+
+        if (hasWords)
+        {
+            for (auto it = std::lower_bound(lines.cbegin(), lines.cend(), first); it != lines.cend() && *it < end; ++it)
+            {
+                if (cancel && cancel->load(std::memory_order_relaxed))
+                    break;
+
+                check(*it);
+            }
+        }
+        else
+        {
+            // a pattern of only punctuation or spaces, every line is a candidate
+            for (int lineId = first; lineId < end; ++lineId)
+            {
+                if (cancel && cancel->load(std::memory_order_relaxed))
+                    break;
+
+                check(lineId);
+            }
+        }
+
+        return result;
+    }
+
+    qsizetype ScrollbackIndex::indexIn(const QString& text, const QString& pattern, QTextDocument::FindFlags flags, qsizetype from)
+    {
+        const Qt::CaseSensitivity cs = flags.testFlag(QTextDocument::FindCaseSensitively) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        const bool backward = flags.testFlag(QTextDocument::FindBackward);
+
+        if (pattern.isEmpty() || (backward && from <= 0))
+            return -1;
+
+        qsizetype pos = backward ? text.lastIndexOf(pattern, from - 1, cs) : text.indexOf(pattern, from, cs);
+
+        while (pos != -1)
+        {
+            const qsizetype end = pos + pattern.size();
+
+            if (!flags.testFlag(QTextDocument::FindWholeWords)
+                || ((pos == 0 || !text.at(pos - 1).isLetterOrNumber())
+                    && (end == text.size() || !text.at(end).isLetterOrNumber())))
+                return pos;
+
+            if (backward)
+                pos = (pos > 0) ? text.lastIndexOf(pattern, pos - 1, cs) : -1;
+            else
+                pos = text.indexOf(pattern, pos + 1, cs);
+        }
+
+        return -1;
+    }
+}
@@ -0,0 +1,100 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef SCROLLBACKINDEX_H
+#define SCROLLBACKINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMultiMap>
+#include <QString>
+#include <QTextDocument>
+
+#include <atomic>
+
+namespace Konversation
+{
+    /**
+     * An inverted index over the plain text of the lines of a view.
+     *
+     * Lines get ascending ids as they are appended, and descending ones as
+     * older lines are prepended, so the ids follow the order of the lines.
+     * Lines are evicted from the front as the scrollback is culled. Every word, folded to lower
+     * case, maps to the ids of the lines containing it, so a search only
+     * has to look at the lines containing the words of the pattern. The
+     * suffixes of the words are kept sorted, so the words containing a part
+     * of a word are found by looking up a range of them.
+     *
+     * The containers are implicitly shared: a copy taken on the GUI thread
+     * is a cheap snapshot that a worker thread can search while the view
+     * goes on appending.
+     */
+    class ScrollbackIndex
+    {
+        public:
+            /// Indexes @p text, sent at @p time in ms since the epoch, and returns its line id.
+            int append(const QString& text, qint64 time = 0);
+
+            /// Indexes @p text as the line before the first one and returns its line id.
+            int prepend(const QString& text, qint64 time = 0);
+
+            /// Forgets the lines with an id below @p lineId.
+            void removeLinesBefore(int lineId);
+
+            /// Forgets all lines, the ids keep counting up.
+            void clear();
+
+            bool isEmpty() const { return m_lines.isEmpty(); }
+
+            /// Id of the oldest line still indexed.
+            int firstLine() const { return m_firstLine; }
+
+            /// Id the next appended line will get.
+            int endLine() const { return m_firstLine + static_cast<int>(m_lines.count()); }
+
+            QString lineText(int lineId) const;
+            /// When the line was sent, 0 if unknown.
+            qint64 lineTime(int lineId) const;
+
+            /**
+             * Returns the ids of the lines from @p fromLine on that contain
+             * @p pattern, ascending. Understands the FindCaseSensitively and
+             * FindWholeWords flags the way QTextDocument::find() does.
+             * Returns early once @p cancel is set, if given.
+             */
+            QList<int> search(const QString& pattern, QTextDocument::FindFlags flags,
+                              int fromLine = 0, const std::atomic_bool* cancel = nullptr) const;
+
+            /**
+             * Returns the position of the first match of @p pattern in @p text
+             * starting at or after @p from, or with FindBackward of the last one
+             * starting before @p from, or -1.
+             */
+            static qsizetype indexIn(const QString& text, const QString& pattern, QTextDocument::FindFlags flags, qsizetype from);
+
+        private:
+            /// Ids of the lines possibly containing the pattern word at [start, end).
+            QList<int> candidates(const QString& pattern, qsizetype start, qsizetype end) const;
+            /// The ids of the lines containing @p word, which is added if it is new.
+            QList<int>& wordLines(const QString& word);
+            void compact();
+
+        private:
+            /// Leaves room for the ids of prepended lines, which are never negative.
+            int m_firstLine = 1 << 30;
+            QList<QString> m_lines;
+            QList<qint64> m_times;
+
+            /// Folded word -> ascending ids of the lines containing it.
+            /// Ids of evicted lines are only dropped by compact().
+            QHash<QString, QList<int>> m_words;
+            /// Every suffix of the words of m_words -> the word.
+            QMultiMap<QString, QString> m_suffixes;
+            int m_evictedLines = 0;
+    };
+}
+
+#endif
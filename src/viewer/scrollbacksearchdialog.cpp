@@ -0,0 +1,203 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "scrollbacksearchdialog.h"
+
+#include "chatwindow.h"
+#include "ircview.h"
+#include "viewcontainer.h"
+
+#include <KLocalizedString>
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QThread>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace Konversation
+{
+    enum ResultRoles
+    {
+        SnapshotRole = Qt::UserRole,
+        LineRole
+    };
+
+    ScrollbackSearchDialog::ScrollbackSearchDialog(ViewContainer* viewContainer, QWidget* parent)
+        : QDialog(parent)
+        , m_viewContainer(viewContainer)
+        , m_searchThread(nullptr)
+        , m_cancelSearch(false)
+    {
+        setWindowTitle(i18n("Find in All Tabs"));
+        setModal(false);
+
+        auto* mainLayout = new QVBoxLayout(this);
+
+        auto* searchLayout = new QHBoxLayout;
+        m_searchEdit = new QLineEdit(this);
+        m_searchEdit->setClearButtonEnabled(true);
+        m_searchEdit->setPlaceholderText(i18n("Search the scrollback of all tabs"));
+        searchLayout->addWidget(m_searchEdit);
+        m_matchCase = new QCheckBox(i18n("Match case"), this);
+        searchLayout->addWidget(m_matchCase);
+        m_wholeWords = new QCheckBox(i18n("Whole words only"), this);
+        searchLayout->addWidget(m_wholeWords);
+        mainLayout->addLayout(searchLayout);
+
+        m_results = new QTreeWidget(this);
+        m_results->setHeaderLabels({ i18n("Tab"), i18n("Line") });
+        m_results->setRootIsDecorated(false);
+        m_results->setUniformRowHeights(true);
+        m_results->setAllColumnsShowFocus(true);
+        m_results->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+        mainLayout->addWidget(m_results);
+
+        m_statusLabel = new QLabel(this);
+        mainLayout->addWidget(m_statusLabel);
+
+        auto* buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+        connect(buttonBox, &QDialogButtonBox::rejected, this, &ScrollbackSearchDialog::reject);
+        mainLayout->addWidget(buttonBox);
+
+        m_timer = new QTimer(this);
+        m_timer->setSingleShot(true);
+        m_timer->setInterval(300);
+
+        connect(m_timer, &QTimer::timeout, this, &ScrollbackSearchDialog::startSearch);
+        connect(m_searchEdit, &QLineEdit::textChanged, m_timer, QOverload<>::of(&QTimer::start));
+        connect(m_searchEdit, &QLineEdit::returnPressed, this, &ScrollbackSearchDialog::startSearch);
+        connect(m_matchCase, &QCheckBox::toggled, this, &ScrollbackSearchDialog::startSearch);
+        connect(m_wholeWords, &QCheckBox::toggled, this, &ScrollbackSearchDialog::startSearch);
+        connect(m_results, &QTreeWidget::itemActivated, this, &ScrollbackSearchDialog::showResult);
+
+        resize(700, 400);
+    }
+
+    ScrollbackSearchDialog::~ScrollbackSearchDialog()
+    {
+        cancelSearch();
+    }
+
+    void ScrollbackSearchDialog::startSearch()
+    {
+        m_timer->stop();
+        cancelSearch();
+
+        m_results->clear();
+        m_snapshots.clear();
+        m_statusLabel->clear();
+
+        m_pattern = m_searchEdit->text();
+        m_flags = {};
+
+        if (m_matchCase->isChecked())
+            m_flags |= QTextDocument::FindCaseSensitively;
+        if (m_wholeWords->isChecked())
+            m_flags |= QTextDocument::FindWholeWords;
+
+        if (m_pattern.isEmpty())
+            return;
+
+        const QList<ChatWindow*> views = m_viewContainer->getViews();
+
+        for (ChatWindow* view : views)
+        {
+            if (view->searchView() && view->getTextView())
+                m_snapshots.append(ViewSnapshot { view, view->getName(), view->getTextView()->scrollbackIndex(), {} });
+        }
+
+        m_statusLabel->setText(i18n("Searching..."));
+
+        // The snapshots are only touched by the thread until it is finished
+        // or cancelled and waited for.
+        m_searchThread = QThread::create([this]() {
+            for (ViewSnapshot& snapshot : m_snapshots)
+            {
+                if (m_cancelSearch)
+                    break;
+
+                snapshot.matches = snapshot.index.search(m_pattern, m_flags, 0, &m_cancelSearch);
+            }
+        });
+
+        connect(m_searchThread, &QThread::finished, this, &ScrollbackSearchDialog::searchFinished);
+
+        m_searchThread->start(QThread::LowPriority);
+    }
+
+    void ScrollbackSearchDialog::searchFinished()
+    {
+        m_searchThread->deleteLater();
+        m_searchThread = nullptr;
+
+        QList<QTreeWidgetItem*> items;
+        int matches = 0;
+
+        for (int i = 0; i < m_snapshots.count(); ++i)
+        {
+            const ViewSnapshot& snapshot = m_snapshots.at(i);
+
+            matches += snapshot.matches.count();
+
+            // the most recent lines first
+            for (auto it = snapshot.matches.crbegin(); it != snapshot.matches.crend() && items.count() < MaxResults; ++it)
+            {
+                auto* item = new QTreeWidgetItem({ snapshot.name, snapshot.index.lineText(*it) });
+                item->setData(0, SnapshotRole, i);
+                item->setData(0, LineRole, *it);
+                items.append(item);
+            }
+        }
+
+        m_results->addTopLevelItems(items);
+
+        if (matches == 0)
+            m_statusLabel->setText(i18n("No matches"));
+        else if (matches > items.count())
+            m_statusLabel->setText(i18n("Showing %1 of %2 matches", items.count(), matches));
+        else
+            m_statusLabel->setText(i18np("1 match", "%1 matches", matches));
+    }
+
+    void ScrollbackSearchDialog::showResult(QTreeWidgetItem* item)
+    {
+        const ViewSnapshot& snapshot = m_snapshots.at(item->data(0, SnapshotRole).toInt());
+
+        if (!snapshot.view)
+        {
+            m_statusLabel->setText(i18n("The tab has been closed."));
+            return;
+        }
+
+        m_viewContainer->showView(snapshot.view);
+
+        if (!snapshot.view->getTextView()->showLine(item->data(0, LineRole).toInt(), m_pattern, m_flags))
+            m_statusLabel->setText(i18n("The line is no longer in the scrollback."));
+    }
+
+    void ScrollbackSearchDialog::cancelSearch()
+    {
+        if (m_searchThread)
+        {
+            disconnect(m_searchThread, nullptr, this, nullptr);
+
+            m_cancelSearch = true;
+            m_searchThread->wait();
+
+            delete m_searchThread;
+            m_searchThread = nullptr;
+        }
+
+        m_cancelSearch = false;
+    }
+}
+
+#include "moc_scrollbacksearchdialog.cpp"
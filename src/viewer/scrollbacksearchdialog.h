@@ -0,0 +1,84 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef SCROLLBACKSEARCHDIALOG_H
+#define SCROLLBACKSEARCHDIALOG_H
+
+#include "scrollbackindex.h"
+
+#include <QDialog>
+#include <QPointer>
+
+#include <atomic>
+
+class ChatWindow;
+class ViewContainer;
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QThread;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Konversation
+{
+    /**
+     * Searches the scrollback of all open tabs at once.
+     *
+     * The scrollback indexes of the views are copied, which is cheap as
+     * they are implicitly shared, and searched on a worker thread. Activating
+     * a result shows its tab and jumps to the line.
+     */
+    class ScrollbackSearchDialog : public QDialog
+    {
+        Q_OBJECT
+
+        public:
+            explicit ScrollbackSearchDialog(ViewContainer* viewContainer, QWidget* parent = nullptr);
+            ~ScrollbackSearchDialog() override;
+
+        private Q_SLOTS:
+            void startSearch();
+            void searchFinished();
+            void showResult(QTreeWidgetItem* item);
+
+        private:
+            void cancelSearch();
+
+        private:
+            /// Only this many results are listed.
+            static const int MaxResults = 1000;
+
+            struct ViewSnapshot
+            {
+                QPointer<ChatWindow> view;
+                QString name;
+                ScrollbackIndex index;
+                QList<int> matches;
+            };
+
+            ViewContainer* m_viewContainer;
+
+            QLineEdit* m_searchEdit;
+            QCheckBox* m_matchCase;
+            QCheckBox* m_wholeWords;
+            QTreeWidget* m_results;
+            QLabel* m_statusLabel;
+            QTimer* m_timer;
+
+            QThread* m_searchThread;
+            std::atomic_bool m_cancelSearch;
+            QList<ViewSnapshot> m_snapshots;
+            QString m_pattern;
+            QTextDocument::FindFlags m_flags;
+
+            Q_DISABLE_COPY(ScrollbackSearchDialog)
+    };
+}
+
+#endif
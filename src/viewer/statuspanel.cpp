@@ -195,8 +195,10 @@ void StatusPanel::indicateAway(bool show)
 }
 
 // fix Qt's broken behavior on hidden QListView pages
-void StatusPanel::showEvent(QShowEvent*)
+void StatusPanel::showEvent(QShowEvent* event)
 {
+    ChatWindow::showEvent(event);
+
     if(awayChanged)
     {
         awayChanged=false;
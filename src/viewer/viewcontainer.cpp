@@ -27,6 +27,7 @@
 #include "channellistpanel.h"
 #include "nicksonline.h"
 #include "insertchardialog.h"
+#include "scrollbacksearchdialog.h"
 #include "irccolorchooser.h"
 #include "joinchanneldialog.h"
 #include "servergroupsettings.h"
@@ -118,6 +119,7 @@ ViewContainer::ViewContainer(MainWindow* window) : QAbstractItemModel(window)
 , m_nicksOnlinePanel(nullptr)
 , m_dccPanel(nullptr)
 , m_insertCharDialog(nullptr)
+, m_scrollbackSearchDialog(nullptr)
 , m_queryViewCount(0)
 {
     // move existing entries to their new location
@@ -1761,6 +1763,21 @@ void ViewContainer::viewSwitched(int newIndex)
         Q_EMIT setWindowCaption(QString());
 }
 
+QList<ChatWindow*> ViewContainer::getViews() const
+{
+    QList<ChatWindow*> views;
+
+    if (!m_tabWidget)
+        return views;
+
+    views.reserve(m_tabWidget->count());
+
+    for (int i = 0; i < m_tabWidget->count(); ++i)
+        views.append(static_cast<ChatWindow*>(m_tabWidget->widget(i)));
+
+    return views;
+}
+
 void ViewContainer::showView(ChatWindow* view)
 {
     // Don't bring Tab to front if TabWidget is hidden. Otherwise QT gets confused
@@ -2395,6 +2412,16 @@ void ViewContainer::findPrevText()
     }
 }
 
+void ViewContainer::findTextInAllViews()
+{
+    if (!m_scrollbackSearchDialog)
+        m_scrollbackSearchDialog = new Konversation::ScrollbackSearchDialog(this, m_window);
+
+    m_scrollbackSearchDialog->show();
+    m_scrollbackSearchDialog->raise();
+    m_scrollbackSearchDialog->activateWindow();
+}
+
 void ViewContainer::appendToFrontmost(const QString& type, const QString& message, ChatWindow* serverView, const QHash<QString, QString> &messageTags, bool parseURL)
 {
     if (!m_tabWidget) return;
@@ -33,6 +33,7 @@ class ViewSpringLoader;
 namespace Konversation
 {
     class InsertCharDialog;
+    class ScrollbackSearchDialog;
     class ServerGroupSettings;
 
     namespace DCC
@@ -96,6 +97,8 @@ class ViewContainer : public QAbstractItemModel
         KActionCollection* actionCollection() const { return m_window->actionCollection(); }
 
         QPointer<ChatWindow> getFrontView() const { return m_frontView; }
+        /// All views, in tab order.
+        QList<ChatWindow*> getViews() const;
         Server* getFrontServer() const { return m_frontServer; }
 
         void prepareShutdown();
@@ -175,6 +178,7 @@ class ViewContainer : public QAbstractItemModel
         void findText();
         void findNextText();
         void findPrevText();
+        void findTextInAllViews();
 
         void insertCharacter();
         void insertChar(char32_t chr);
@@ -305,6 +309,7 @@ class ViewContainer : public QAbstractItemModel
         bool m_dccPanelOpen;
 
         Konversation::InsertCharDialog* m_insertCharDialog;
+        Konversation::ScrollbackSearchDialog* m_scrollbackSearchDialog;
 
         int m_popupViewIndex;
         int m_queryViewCount;
@@ -7,6 +7,7 @@
 #ifndef PREFERENCES_H
 #define PREFERENCES_H
 
+#include <QString>
 #include <QUrl>
 
 // mock class
@@ -20,6 +21,8 @@ public:
     static Preferences *self() { return &s_instance; }
 
     bool disableExpansion() const { return false; }
+    uint encryptionType() const { return 0; }
+    QString prefixCharacter() const { return QString(); }
 
 private:
     static Preferences s_instance;
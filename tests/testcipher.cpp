@@ -0,0 +1,183 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testcipher.h"
+
+#include "cipher.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestCipher);
+
+using namespace Konversation;
+
+/// What decrypt() makes of @p line: padded to whole blocks, marked and terminated.
+static QByteArray decrypted(const QByteArray& line)
+{
+    QByteArray padded = line;
+    padded.resize((line.size() + 7) / 8 * 8, '\0');
+
+    return "(e) " + padded + " \n";
+}
+
+void TestCipher::initTestCase()
+{
+    QCA::Initializer init;
+
+    if (!QCA::isSupported("blowfish-ecb") || !QCA::isSupported("blowfish-cbc"))
+        QSKIP("No QCA provider with Blowfish support installed.");
+}
+
+void TestCipher::testKnownLines()
+{
+    // made with openssl enc -bf-ecb and -bf-cbc with an all zero IV
+    Cipher ecb(QByteArray("ecb:0123456789abcdef"));
+    QByteArray line("hello world");
+
+    QVERIFY(ecb.encrypt(line));
+    QCOMPARE(line, QByteArray("+OK eM3Kz/9HrhjYgyGdVYFLKM6Z"));
+    QCOMPARE(ecb.decrypt(line), decrypted("hello world"));
+
+    // FiSH style topics
+    QCOMPARE(ecb.decryptTopic(line), QByteArray("(e) hello world\0\0\0\0\0", 20));
+
+    Cipher cbc(QByteArray("cbc:0123456789abcdef"));
+
+    QCOMPARE(cbc.decrypt("+OK *PvyBWCxSn8wU/BSUsOZTFjKWjhiwZfjd"), decrypted("hello world"));
+
+    // malformed lines are left alone
+    QCOMPARE(ecb.decrypt("+OK abc"), QByteArray("ERROR: abc \n"));
+    QCOMPARE(ecb.decrypt("hello"), QByteArray("hello"));
+}
+
+void TestCipher::testRoundTrip_data()
+{
+    QTest::addColumn<QByteArray>("key");
+
+    QTest::newRow("ecb") << QByteArray("ecb:0123456789abcdef");
+    QTest::newRow("cbc") << QByteArray("cbc:0123456789abcdef");
+    QTest::newRow("shortkey") << QByteArray("cbc:shortkey");
+}
+
+void TestCipher::testRoundTrip()
+{
+    QFETCH(QByteArray, key);
+
+    const QList<QByteArray> lines {
+        "a",
+        "exactly 16 bytes",
+        "\x01" "ACTION waves\x01",
+        "caf\xc3\xa9 and a longer line that goes on over a few more blocks than the others",
+    };
+
+    // one cipher for each side, as they are kept for a channel
+    Cipher sender(key);
+    Cipher receiver(key);
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (const QByteArray& line : lines)
+        {
+            QByteArray encrypted = line;
+
+            QVERIFY(sender.encrypt(encrypted));
+            QVERIFY(encrypted.startsWith("+OK "));
+            QVERIFY(sender.setKey(key));
+
+            QByteArray result = receiver.decrypt(encrypted);
+
+            // CTCPs go without the (e) marker
+            if (line.startsWith('\x01'))
+                QCOMPARE(result, decrypted(line).mid(4));
+            else
+                QCOMPARE(result, decrypted(line));
+        }
+    }
+}
+
+void TestCipher::testKeyChange()
+{
+    Cipher sender(QByteArray("ecb:first key"));
+    QByteArray line("hello world");
+
+    QVERIFY(sender.encrypt(line));
+    QVERIFY(sender.setKey("ecb:second key"));
+    QCOMPARE(sender.key(), QByteArray("second key"));
+
+    QByteArray second("hello world");
+    QVERIFY(sender.encrypt(second));
+    QVERIFY(line != second);
+
+    Cipher receiver(QByteArray("ecb:second key"));
+    QCOMPARE(receiver.decrypt(second), decrypted("hello world"));
+
+    // a change of mode keeps the key
+    QVERIFY(receiver.setKey("cbc:second key"));
+    QByteArray third("hello world");
+    QVERIFY(receiver.encrypt(third));
+    QVERIFY(third.startsWith("+OK *"));
+    QVERIFY(sender.setKey("cbc:second key"));
+    QCOMPARE(sender.decrypt(third), decrypted("hello world"));
+}
+
+static void addBenchmarkRows()
+{
+    QTest::addColumn<QByteArray>("key");
+
+    QTest::newRow("ecb") << QByteArray("ecb:some longer key used in a channel");
+    QTest::newRow("cbc") << QByteArray("cbc:some longer key used in a channel");
+}
+
+/**
+ * The cost of a line as Server::_send_internal() has it, setting the key
+ * of the recipient's cipher before encrypting.
+ */
+void TestCipher::benchmarkEncrypt_data()
+{
+    addBenchmarkRows();
+}
+
+void TestCipher::benchmarkEncrypt()
+{
+    QFETCH(QByteArray, key);
+
+    Cipher cipher(key);
+    const QByteArray line("so I tried that yesterday and it did not work, but restarting it did");
+    QByteArray encrypted;
+
+    QBENCHMARK {
+        encrypted = line;
+        cipher.setKey(key);
+        cipher.encrypt(encrypted);
+    }
+
+    QVERIFY(encrypted.startsWith("+OK "));
+}
+
+/// The cost of a line as Server::incoming() has it.
+void TestCipher::benchmarkDecrypt_data()
+{
+    addBenchmarkRows();
+}
+
+void TestCipher::benchmarkDecrypt()
+{
+    QFETCH(QByteArray, key);
+
+    Cipher cipher(key);
+    QByteArray encrypted("so I tried that yesterday and it did not work, but restarting it did");
+    QVERIFY(cipher.encrypt(encrypted));
+    QByteArray result;
+
+    QBENCHMARK {
+        cipher.setKey(key);
+        result = cipher.decrypt(encrypted);
+    }
+
+    QVERIFY(result.startsWith("(e) so I tried"));
+}
+
+#include "moc_testcipher.cpp"
@@ -0,0 +1,28 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTCIPHER_H
+#define TESTCIPHER_H
+
+#include <QObject>
+
+class TestCipher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testKnownLines();
+    void testRoundTrip_data();
+    void testRoundTrip();
+    void testKeyChange();
+    void benchmarkEncrypt_data();
+    void benchmarkEncrypt();
+    void benchmarkDecrypt_data();
+    void benchmarkDecrypt();
+};
+
+#endif
@@ -8,10 +8,79 @@
 
 #include "common.h"
 
+#include <QRandomGenerator>
+#include <QRegularExpression>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestCommon);
 
+// The regular expressions the URL and channel scanners replaced, as reference.
+static const QRegularExpression referenceUrlPattern(QStringLiteral("\\b((?:(?:([a-z][\\w\\.-]+:/{1,3})|www\\d{0,3}[.]|[a-z0-9.\\-]+[.][a-z]{2,4}/)(?:[^\\s()<>]+|\\(([^\\s()<>]+|(\\([^\\s()<>]+\\)))*\\))+(?:\\(([^\\s()<>]+|(\\([^\\s()<>]+\\)))*\\)|\\}\\]|[^\\s`!()\\[\\]{};:'\".,<>?%1%2%3%4%5%6])|[a-z0-9.\\-+_]+@[a-z0-9.\\-]+[.][a-z]{1,5}[^\\s/`!()\\[\\]{};:'\".,<>?%1%2%3%4%5%6]))").arg(QChar(0x00AB)).arg(QChar(0x00BB)).arg(QChar(0x201C)).arg(QChar(0x201D)).arg(QChar(0x2018)).arg(QChar(0x2019)), QRegularExpression::CaseInsensitiveOption);
+
+static const QRegularExpression referenceChanExp(QStringLiteral("(^|\\s|^\"|\\s\"|,|'|\\(|\\:|!|@|%|\\+)(#[^,\\s;\\)\\:\\/\\(\\<\\>]*[^.,\\s;\\)\\:\\/\\(\"\''\\<\\>?%1%2%3%4%5%6])").arg(QChar(0x00AB)).arg(QChar(0x00BB)).arg(QChar(0x201C)).arg(QChar(0x201D)).arg(QChar(0x2018)).arg(QChar(0x2019)));
+
+/// Lines from channels, with and without links.
+static void addLinkCorpus()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("plain")          << QStringLiteral("hello, how is everyone doing today?");
+    QTest::newRow("sentence")       << QStringLiteral("It works. Really: no problems so far.");
+    QTest::newRow("https")          << QStringLiteral("see https://kde.org now");
+    QTest::newRow("trailingdot")    << QStringLiteral("read https://docs.kde.org/index.html.");
+    QTest::newRow("parentheses")    << QStringLiteral("(see http://en.wikipedia.org/wiki/Foo_(bar)) ok");
+    QTest::newRow("nestedparens")   << QStringLiteral("http://x.org/a(b(c)d)e (http://x.org/(a)) x");
+    QTest::newRow("brackets")       << QStringLiteral("[http://example.com/page?id=1&x=2] and http://a.b/{x}]");
+    QTest::newRow("www")            << QStringLiteral("www.kde.org and WWW3.example.com, www1234.bad");
+    QTest::newRow("hostslash")      << QStringLiteral("go to invent.kde.org/network/konversation!");
+    QTest::newRow("ftp")            << QStringLiteral("ftp.kde.org/pub and ftp://ftp.kde.org/");
+    QTest::newRow("email")          << QStringLiteral("mail me at first.last+irc@example.co.uk, or admin@localhost");
+    QTest::newRow("quotes")         << QStringLiteral("\"http://quoted.example\" \u00ABhttps://kde.org\u00BB \u201Chttp://x.y/z\u201D");
+    QTest::newRow("schemes")        << QStringLiteral("irc://irc.libera.chat/#kde file:///tmp/a mailto:a@b.c ssh+git://x");
+    QTest::newRow("slashes")        << QStringLiteral("http:// http:/// http://x a:/b");
+    QTest::newRow("wordboundary")   << QStringLiteral("xhttp://a.b _www.kde.org .kde.org/x -a.bc/d");
+    QTest::newRow("unicode")        << QStringLiteral("\u00E9t\u00E9 http://ex\u00E4mple.com/\u00FC\u00F1 ok");
+    QTest::newRow("kelvin")         << QStringLiteral("\u212Ade.org/x \u017Fome.de/ me@\u212Ade.org.");
+    QTest::newRow("channels")       << QStringLiteral("join #konversation, #kde-devel and (#kde)");
+    QTest::newRow("channelquotes")  << QStringLiteral("\"#quoted\" 'x' #a.b. #c? @#op +#voice %#half !#bang :#colon");
+    QTest::newRow("channelstart")   << QStringLiteral("#start of line, a#b #a,#b ##double");
+    QTest::newRow("channelurl")     << QStringLiteral("#www.kde.org http://kde.org/#anchor");
+    QTest::newRow("tabs")           << QStringLiteral("\thttp://kde.org\t#kde\t");
+    QTest::newRow("mixed")          << QStringLiteral("\x02<nick>\x02 check http://bugs.kde.org/show_bug.cgi?id=12345 in #konversation :)");
+}
+
+static QList<QPair<int, int>> referenceUrlRanges(const QString& text, QStringList* protocols)
+{
+    QList<QPair<int, int>> ranges;
+    qsizetype pos = 0;
+    QRegularExpressionMatch match;
+
+    while ((pos = text.indexOf(referenceUrlPattern, pos, &match)) >= 0)
+    {
+        ranges << QPair<int, int>(pos, match.capturedLength(0));
+        *protocols << match.captured(2);
+        pos += match.capturedLength(0);
+    }
+
+    return ranges;
+}
+
+static QList<QPair<int, int>> referenceChannelRanges(const QString& text)
+{
+    QList<QPair<int, int>> ranges;
+    qsizetype pos = 0;
+    QRegularExpressionMatch match;
+
+    while ((pos = text.indexOf(referenceChanExp, pos, &match)) >= 0)
+    {
+        pos = match.capturedStart(2);
+        ranges << QPair<int, int>(pos, match.capturedLength(2));
+        pos += match.capturedLength(2);
+    }
+
+    return ranges;
+}
+
 void TestCommon::testExtractColorCodes_data()
 {
     QTest::addColumn<QString>("ircText");
@@ -78,7 +147,7 @@ void TestCommon::testMatchLength_data()
     QTest::newRow("biu")             << QStringLiteral("\x02\x1d\x1fhello")    << 1;
 }
 
-/// Simulates usage of Konversation::colorRegExp in IRCView::adjustUrlRanges()
+/// Checks the length of an anchored Konversation::colorRegExp match
 void TestCommon::testMatchLength()
 {
     QFETCH(QString, ircText);
@@ -92,4 +161,251 @@ void TestCommon::testMatchLength()
     QCOMPARE(length, expectedLength);
 }
 
+void TestCommon::testExtractUrlData_data()
+{
+    addLinkCorpus();
+}
+
+void TestCommon::testExtractUrlData()
+{
+    QFETCH(QString, text);
+
+    QStringList protocols;
+    const QList<QPair<int, int>> expectedRanges = referenceUrlRanges(text, &protocols);
+
+    const Konversation::TextUrlData data = Konversation::extractUrlData(text);
+    QCOMPARE(data.urlRanges, expectedRanges);
+    QCOMPARE(data.fixedUrls.count(), expectedRanges.count());
+
+    for (qsizetype i = 0; i < expectedRanges.count(); ++i)
+    {
+        const QString url = text.mid(expectedRanges.at(i).first, expectedRanges.at(i).second);
+
+        // only URLs without a scheme get one added
+        if (protocols.at(i).isEmpty())
+            QVERIFY(data.fixedUrls.at(i).endsWith(url) && data.fixedUrls.at(i).length() > url.length());
+        else
+            QCOMPARE(data.fixedUrls.at(i), url);
+    }
+}
+
+void TestCommon::testExtractChannelData_data()
+{
+    addLinkCorpus();
+}
+
+void TestCommon::testExtractChannelData()
+{
+    QFETCH(QString, text);
+
+    const Konversation::TextChannelData data = Konversation::extractChannelData(text);
+    QCOMPARE(data.channelRanges, referenceChannelRanges(text));
+}
+
+void TestCommon::testIsUrl_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("expectedIsUrl");
+
+    QTest::newRow("empty")         << QString()                                   << false;
+    QTest::newRow("word")          << QStringLiteral("konversation")              << false;
+    QTest::newRow("https")         << QStringLiteral("https://kde.org")           << true;
+    QTest::newRow("trailingdot")   << QStringLiteral("https://kde.org.")          << false;
+    QTest::newRow("trailingtext")  << QStringLiteral("https://kde.org rocks")     << false;
+    QTest::newRow("www")           << QStringLiteral("www.kde.org")               << true;
+    QTest::newRow("host")          << QStringLiteral("kde.org/")                  << false;
+    QTest::newRow("hostpath")      << QStringLiteral("kde.org/ab")                << true;
+    QTest::newRow("email")         << QStringLiteral("me@example.com")            << true;
+    QTest::newRow("emailshort")    << QStringLiteral("me@example.c")              << false;
+    QTest::newRow("parens")        << QStringLiteral("http://x.org/a_(b)")        << true;
+    QTest::newRow("leadingspace")  << QStringLiteral(" http://x.org")             << false;
+}
+
+void TestCommon::testIsUrl()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, expectedIsUrl);
+
+    QCOMPARE(Konversation::isUrl(text), expectedIsUrl);
+
+    QRegularExpression anchored(referenceUrlPattern);
+    anchored.setPattern(QRegularExpression::anchoredPattern(referenceUrlPattern.pattern()));
+    QCOMPARE(anchored.match(text).hasMatch(), expectedIsUrl);
+}
+
+void TestCommon::benchmarkExtractLinks_data()
+{
+    QTest::addColumn<bool>("useScanner");
+
+    QTest::newRow("scanner") << true;
+    QTest::newRow("regexp")  << false;
+}
+
+void TestCommon::benchmarkExtractLinks()
+{
+    QFETCH(bool, useScanner);
+
+    // mostly lines without any link, as in a typical channel
+    QStringList lines;
+    for (int i = 0; i < 20; ++i)
+    {
+        lines << QStringLiteral("so I tried that yesterday and it did not work, any idea why? maybe the config is wrong")
+              << QStringLiteral("yes, restart it and check the output again. It should print the version first.");
+    }
+    lines << QStringLiteral("the report is at https://bugs.kde.org/show_bug.cgi?id=123456 and discussed in #konversation");
+
+    if (useScanner)
+    {
+        QBENCHMARK {
+            for (const QString& line : std::as_const(lines))
+            {
+                Konversation::extractUrlData(line, false);
+                Konversation::extractChannelData(line, false);
+            }
+        }
+    }
+    else
+    {
+        QStringList protocols;
+
+        QBENCHMARK {
+            for (const QString& line : std::as_const(lines))
+            {
+                referenceUrlRanges(line, &protocols);
+                referenceChannelRanges(line);
+            }
+        }
+    }
+}
+
+// What the receive path did before decodeUtf8Line(), as reference.
+static bool referenceDecodeUtf8Line(const QByteArray& line, QString& text)
+{
+    if (!Konversation::isUtf8(line))
+        return false;
+
+    text = Konversation::sterilizeUnicode(QString::fromUtf8(line));
+    return true;
+}
+
+static void compareDecodeUtf8Line(const QByteArray& line)
+{
+    QString text(QStringLiteral("untouched"));
+    QString expectedText(QStringLiteral("untouched"));
+
+    const bool isUtf8 = Konversation::decodeUtf8Line(line, text);
+    const bool expectedIsUtf8 = referenceDecodeUtf8Line(line, expectedText);
+
+    QCOMPARE(isUtf8, expectedIsUtf8);
+    QCOMPARE(text, expectedText);
+}
+
+void TestCommon::testDecodeUtf8Line_data()
+{
+    QTest::addColumn<QByteArray>("line");
+
+    // long enough for the vectorized ASCII scan to find the first other byte in a later block
+    const QByteArray prefix(":nick!user@host PRIVMSG #konversation :a long line of plain text first, ");
+
+    QTest::newRow("empty")          << QByteArray();
+    QTest::newRow("ascii")          << QByteArray(":nick!user@host PRIVMSG #kde :hello");
+    QTest::newRow("controls")       << QByteArray(":n PRIVMSG #kde :\x02" "bold\x02 \x03" "4red\x0f\x7f");
+    QTest::newRow("latin1")         << QByteArray(":n PRIVMSG #kde :caf\xe9");
+    QTest::newRow("utf8")           << QByteArray(":n PRIVMSG #kde :caf\xc3\xa9 \xe2\x82\xac");
+    QTest::newRow("utf8late")       << prefix + QByteArray("\xc3\xa9t\xc3\xa9");
+    QTest::newRow("latin1late")     << prefix + QByteArray("\xe9t\xe9");
+    QTest::newRow("fourbytes")      << QByteArray("emoji \xf0\x9f\x98\x80 and \xf0\x90\x80\x80");
+    QTest::newRow("noncharacters")  << QByteArray("\xef\xb7\x90 \xef\xb7\x91 \xef\xbf\xbe \xef\xbf\xbf \xf0\x9f\xbf\xbe");
+    QTest::newRow("unassigned")     << QByteArray("\xcd\xb8 \xe0\xb8\x80 \xf3\xa0\x80\x80");
+    QTest::newRow("surrogate")      << QByteArray("\xed\xa0\x80\xed\xb0\x80");
+    QTest::newRow("overlong")       << QByteArray("\xc0\xaf \xe0\x80\xaf \xf0\x80\x80\xaf");
+    QTest::newRow("truncated")      << prefix + QByteArray("\xe2\x82");
+    QTest::newRow("badtrail")       << QByteArray("\xc3\x28");
+    QTest::newRow("beyondunicode")  << QByteArray("\xf4\x90\x80\x80");
+    QTest::newRow("fivebytes")      << QByteArray("\xf8\x88\x80\x80\x80 \xfc\x84\x80\x80\x80\x80");
+    QTest::newRow("jis")            << QByteArray("\x1b$B$3$s$K$A$O\x1b(B");
+    QTest::newRow("jislate")        << prefix + QByteArray("\x1b(B");
+    QTest::newRow("escape")         << QByteArray("\x1b[1mbold\x1b[0m");
+    QTest::newRow("escapeend")      << QByteArray("trailing \x1b");
+    QTest::newRow("sjis")           << QByteArray("\x82\xb1\x82\xf1\x82\xc9\x82\xbf\x82\xcd");
+    QTest::newRow("eucjp")          << QByteArray("\xa4\xb3\xa4\xf3\xa4\xcb\xa4\xc1\xa4\xcf");
+    QTest::newRow("utf8japanese")   << QByteArray("\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf");
+}
+
+void TestCommon::testDecodeUtf8Line()
+{
+    QFETCH(QByteArray, line);
+
+    compareDecodeUtf8Line(line);
+}
+
+void TestCommon::testDecodeUtf8LineRandom()
+{
+    // bytes that start, continue or break sequences, between plain text
+    static const char specialBytes[] = "\x1b$(\x80\x8e\x90\xa0\xbf\xc0\xc3\xe0\xe3\xed\xef\xf0\xf4\xf8\xfc\xfe";
+
+    QRandomGenerator generator(42);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        QByteArray line;
+        const int length = generator.bounded(100);
+
+        for (int j = 0; j < length; ++j)
+        {
+            if (generator.bounded(100) < 60)
+                line += char('a' + generator.bounded(26));
+            else
+                line += specialBytes[generator.bounded(int(sizeof(specialBytes)) - 1)];
+        }
+
+        compareDecodeUtf8Line(line);
+
+        if (QTest::currentTestFailed())
+        {
+            qWarning() << "line:" << line.toHex(' ');
+            return;
+        }
+    }
+}
+
+void TestCommon::benchmarkDecodeUtf8Line_data()
+{
+    QTest::addColumn<bool>("useDecoder");
+
+    QTest::newRow("decoder")   << true;
+    QTest::newRow("reference") << false;
+}
+
+void TestCommon::benchmarkDecodeUtf8Line()
+{
+    QFETCH(bool, useDecoder);
+
+    // mostly plain ASCII, as on a typical connection
+    QList<QByteArray> lines;
+    for (int i = 0; i < 20; ++i)
+    {
+        lines << QByteArray(":someone!~someone@example.org PRIVMSG #konversation :so I tried that yesterday and it did not work")
+              << QByteArray(":other!~other@192.0.2.1 PRIVMSG #konversation :yes, restart it and check the output again");
+    }
+    lines << QByteArray(":third!~third@example.org PRIVMSG #konversation :\xc3\xa7" "a marche tr\xc3\xa8s bien \xe2\x9c\x94");
+
+    QString text;
+
+    if (useDecoder)
+    {
+        QBENCHMARK {
+            for (const QByteArray& line : std::as_const(lines))
+                Konversation::decodeUtf8Line(line, text);
+        }
+    }
+    else
+    {
+        QBENCHMARK {
+            for (const QByteArray& line : std::as_const(lines))
+                referenceDecodeUtf8Line(line, text);
+        }
+    }
+}
+
 #include "moc_testcommon.cpp"
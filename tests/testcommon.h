@@ -20,6 +20,19 @@ private Q_SLOTS:
     void testRemoveIrcMarkup();
     void testMatchLength_data();
     void testMatchLength();
+    void testExtractUrlData_data();
+    void testExtractUrlData();
+    void testExtractChannelData_data();
+    void testExtractChannelData();
+    void testIsUrl_data();
+    void testIsUrl();
+    void benchmarkExtractLinks_data();
+    void benchmarkExtractLinks();
+    void testDecodeUtf8Line_data();
+    void testDecodeUtf8Line();
+    void testDecodeUtf8LineRandom();
+    void benchmarkDecodeUtf8Line_data();
+    void benchmarkDecodeUtf8Line();
 };
 
 #endif
@@ -0,0 +1,165 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testircformatting.h"
+
+#include "common.h"
+#include "irc/ircformatting.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestIrcFormatting);
+
+using namespace Konversation;
+
+/// Describes the runs as "start+length:flags/fg/bg" separated by spaces.
+static QString describeRuns(const IrcFormattedText& formatted)
+{
+    QStringList runs;
+
+    for (const IrcTextRun& run : formatted.runs)
+    {
+        runs << QStringLiteral("%1+%2:%3/%4/%5").arg(run.start).arg(run.length)
+                    .arg(run.style.flags, 0, 16).arg(run.style.foreground).arg(run.style.background);
+    }
+
+    return runs.join(QLatin1Char(' '));
+}
+
+/// Describes the links as "start+length:target" separated by spaces.
+static QString describeLinks(const IrcFormattedText& formatted)
+{
+    QStringList links;
+
+    for (const IrcTextLink& link : formatted.links)
+        links << QStringLiteral("%1+%2:%3").arg(link.start).arg(link.length).arg(link.target);
+
+    return links.join(QLatin1Char(' '));
+}
+
+/// Typical line of a channel with colorful bots.
+static QString colorHeavyLine()
+{
+    return QStringLiteral("\x03""04,01[\x03""08News\x03""04,01]\x0f \x02\x03""12Headline:\x02\x03 some \x1dtext\x1d with "
+                          "\x03""03green\x03, \x03""05red\x03 and \x1fmore\x1f \x16reversed\x16 words, see "
+                          "\x03""11https://example.org/article?id=42\x03 or #konversation \x0f""for details");
+}
+
+void TestIrcFormatting::testRuns_data()
+{
+    QTest::addColumn<QString>("ircText");
+    QTest::addColumn<bool>("allowColors");
+    QTest::addColumn<QString>("expectedText");
+    QTest::addColumn<QString>("expectedRuns");
+
+    QTest::newRow("empty")          << QString()                                   << true  << QString()             << QString();
+    QTest::newRow("plain")          << QStringLiteral("hello")                     << true  << QStringLiteral("hello") << QStringLiteral("0+5:0/-1/-1");
+    QTest::newRow("bbmiddle")       << QStringLiteral("he\x02ll\x02o")             << true  << QStringLiteral("hello") << QStringLiteral("0+2:0/-1/-1 2+2:1/-1/-1 4+1:0/-1/-1");
+    QTest::newRow("biu")            << QStringLiteral("\x02he\x1dllo\x1f")         << true  << QStringLiteral("hello") << QStringLiteral("0+2:1/-1/-1 2+3:3/-1/-1");
+    QTest::newRow("emptytoggle")    << QStringLiteral("a\x02\x02""b")              << true  << QStringLiteral("ab")    << QStringLiteral("0+2:0/-1/-1");
+    QTest::newRow("strikemono")     << QStringLiteral("\x1e""a\x13\x11""b")        << true  << QStringLiteral("ab")    << QStringLiteral("0+1:8/-1/-1 1+1:10/-1/-1");
+    QTest::newRow("colorfg1")       << QStringLiteral("\x03""1hello")              << true  << QStringLiteral("hello") << QStringLiteral("0+5:0/1/-1");
+    QTest::newRow("colorfg2")       << QStringLiteral("\x03""15hello")             << true  << QStringLiteral("hello") << QStringLiteral("0+5:0/15/-1");
+    QTest::newRow("colorfgthree")   << QStringLiteral("\x03""123")                 << true  << QStringLiteral("3")     << QStringLiteral("0+1:0/12/-1");
+    QTest::newRow("colorfgcomma")   << QStringLiteral("\x03""15,hello")            << true  << QStringLiteral(",hello") << QStringLiteral("0+6:0/15/-1");
+    QTest::newRow("colorfgbg")      << QStringLiteral("\x03""15,12hello")          << true  << QStringLiteral("hello") << QStringLiteral("0+5:0/15/12");
+    QTest::newRow("colorkeepbg")    << QStringLiteral("\x03""1,2a\x03""3b")        << true  << QStringLiteral("ab")    << QStringLiteral("0+1:0/1/2 1+1:0/3/2");
+    QTest::newRow("colorreset")     << QStringLiteral("\x03""4a\x03""b")           << true  << QStringLiteral("ab")    << QStringLiteral("0+1:0/4/-1 1+1:0/-1/-1");
+    QTest::newRow("colorextended")  << QStringLiteral("\x03""42hello")             << true  << QStringLiteral("hello") << QStringLiteral("0+5:0/-1/-1");
+    QTest::newRow("reset")          << QStringLiteral("\x02\x03""4a\x0f""b")       << true  << QStringLiteral("ab")    << QStringLiteral("0+1:1/4/-1 1+1:0/-1/-1");
+    QTest::newRow("reverse")        << QStringLiteral("a\x16""b\x16""c")           << true  << QStringLiteral("abc")   << QStringLiteral("0+1:0/-1/-1 1+1:20/-1/-1 2+1:0/-1/-1");
+    QTest::newRow("nocolors")       << QStringLiteral("\x03""4,5a\x16""b")         << false << QStringLiteral("ab")    << QStringLiteral("0+2:0/-1/-1");
+    QTest::newRow("nocolorsbold")   << QStringLiteral("\x03""4\x02""a")            << false << QStringLiteral("a")     << QStringLiteral("0+1:1/-1/-1");
+    QTest::newRow("tabkept")        << QStringLiteral("a\tb")                      << true  << QStringLiteral("a\tb")  << QStringLiteral("0+3:0/-1/-1");
+}
+
+void TestIrcFormatting::testRuns()
+{
+    QFETCH(QString, ircText);
+    QFETCH(bool, allowColors);
+    QFETCH(QString, expectedText);
+    QFETCH(QString, expectedRuns);
+
+    const IrcFormattedText formatted = parseIrcFormatting(ircText, allowColors, false);
+    QCOMPARE(formatted.text, expectedText);
+    QCOMPARE(describeRuns(formatted), expectedRuns);
+    QVERIFY(formatted.links.isEmpty());
+}
+
+void TestIrcFormatting::testLinks_data()
+{
+    QTest::addColumn<QString>("ircText");
+    QTest::addColumn<QString>("expectedLinks");
+
+    QTest::newRow("none")           << QStringLiteral("hello world")                      << QString();
+    QTest::newRow("url")            << QStringLiteral("see https://kde.org now")          << QStringLiteral("4+15:https://kde.org");
+    QTest::newRow("www")            << QStringLiteral("www.kde.org")                      << QStringLiteral("0+11:http://www.kde.org");
+    QTest::newRow("formattedurl")   << QStringLiteral("\x02www.\x03""4kde\x03"".org\x02") << QStringLiteral("0+11:http://www.kde.org");
+    QTest::newRow("channel")        << QStringLiteral("join #konversation")               << QStringLiteral("5+13:%23konversation");
+    QTest::newRow("urlandchannel")  << QStringLiteral("#kde and https://kde.org")         << QStringLiteral("0+4:%23kde 9+15:https://kde.org");
+    QTest::newRow("channelfirst")   << QStringLiteral("#www.kde.org")                     << QStringLiteral("0+12:%23www.kde.org");
+    QTest::newRow("colorheavy")     << colorHeavyLine()
+                                    << QStringLiteral("72+33:https://example.org/article?id=42 109+13:%23konversation");
+}
+
+void TestIrcFormatting::testLinks()
+{
+    QFETCH(QString, ircText);
+    QFETCH(QString, expectedLinks);
+
+    const IrcFormattedText formatted = parseIrcFormatting(ircText, true, true);
+    QCOMPARE(describeLinks(formatted), expectedLinks);
+
+    // links are reported on the plain text
+    for (const IrcTextLink& link : formatted.links)
+        QVERIFY(link.start >= 0 && link.start + link.length <= formatted.text.size());
+}
+
+void TestIrcFormatting::testDirection()
+{
+    QCOMPARE(parseIrcFormatting(QStringLiteral("hello"), true, false).direction, QChar::DirL);
+    QCOMPARE(parseIrcFormatting(QStringLiteral("123 !?"), true, false).direction, QChar::DirL);
+    QCOMPARE(parseIrcFormatting(QStringLiteral("\x02שלום\x02 hi"), true, false).direction, QChar::DirR);
+    QCOMPARE(parseIrcFormatting(QStringLiteral("שלום hello"), true, false).direction, QChar::DirL);
+}
+
+void TestIrcFormatting::benchmarkTokenizer()
+{
+    const QString line = colorHeavyLine();
+
+    QBENCHMARK {
+        const IrcFormattedText formatted = parseIrcFormatting(line, true, true);
+        Q_UNUSED(formatted)
+    }
+}
+
+/// The passes IRCView::ircTextToHtml() ran before the tokenizer, without
+/// the string splicing that turned their results into HTML.
+void TestIrcFormatting::benchmarkRegExpPasses()
+{
+    static const QRegularExpression ircColorRegExp(QStringLiteral("(\003([0-9]{2}|[0-9]|)(,([0-9]{2}|[0-9]|)|,|)|\017)"));
+
+    const QString line = colorHeavyLine();
+
+    QBENCHMARK {
+        const QString strippedText = removeIrcMarkup(line);
+        const TextUrlData urlData = extractUrlData(strippedText);
+        const TextChannelData channelData = extractChannelData(strippedText);
+
+        int colorCodes = 0;
+        for (qsizetype pos = line.indexOf(QLatin1Char('\x03')); pos != -1; pos = line.indexOf(QLatin1Char('\x03'), pos + 1))
+        {
+            if (ircColorRegExp.match(line, pos).hasMatch())
+                ++colorCodes;
+        }
+
+        Q_UNUSED(urlData)
+        Q_UNUSED(channelData)
+        Q_UNUSED(colorCodes)
+    }
+}
+
+#include "moc_testircformatting.cpp"
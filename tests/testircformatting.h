@@ -0,0 +1,26 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTIRCFORMATTING_H
+#define TESTIRCFORMATTING_H
+
+#include <QObject>
+
+class TestIrcFormatting : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRuns_data();
+    void testRuns();
+    void testLinks_data();
+    void testLinks();
+    void testDirection();
+    void benchmarkTokenizer();
+    void benchmarkRegExpPasses();
+};
+
+#endif
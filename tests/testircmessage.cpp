@@ -0,0 +1,80 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testircmessage.h"
+
+#include "irc/ircmessage.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestIrcMessage);
+
+using namespace Konversation;
+
+void TestIrcMessage::testFromLine_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<QString>("prefix");
+    QTest::addColumn<QString>("command");
+    QTest::addColumn<QStringList>("parameters");
+
+    QTest::newRow("privmsg")        << QStringLiteral(":nick!user@host PRIVMSG #konversation :hello there")
+                                    << QStringLiteral("nick!user@host") << QStringLiteral("privmsg")
+                                    << QStringList { QStringLiteral("#konversation"), QStringLiteral("hello there") };
+    QTest::newRow("noprefix")       << QStringLiteral("PING :irc.libera.chat")
+                                    << QString() << QStringLiteral("ping")
+                                    << QStringList { QStringLiteral("irc.libera.chat") };
+    QTest::newRow("commandonly")    << QStringLiteral("PING")
+                                    << QString() << QStringLiteral("ping") << QStringList();
+    QTest::newRow("notrailing")     << QStringLiteral(":server 005 nick CHANTYPES=# NICKLEN=16")
+                                    << QStringLiteral("server") << QStringLiteral("005")
+                                    << QStringList { QStringLiteral("nick"), QStringLiteral("CHANTYPES=#"), QStringLiteral("NICKLEN=16") };
+    QTest::newRow("emptytrailing")  << QStringLiteral(":nick!user@host TOPIC #konversation :")
+                                    << QStringLiteral("nick!user@host") << QStringLiteral("topic")
+                                    << QStringList { QStringLiteral("#konversation"), QString() };
+    QTest::newRow("colontrailing")  << QStringLiteral(":nick!user@host PRIVMSG #konversation :a :b")
+                                    << QStringLiteral("nick!user@host") << QStringLiteral("privmsg")
+                                    << QStringList { QStringLiteral("#konversation"), QStringLiteral("a :b") };
+    QTest::newRow("extraspaces")    << QStringLiteral(":server 001  nick   :Welcome")
+                                    << QStringLiteral("server") << QStringLiteral("001")
+                                    << QStringList { QStringLiteral("nick"), QStringLiteral("Welcome") };
+    QTest::newRow("tags")           << QStringLiteral("@time=2026-01-01T00:00:00.000Z :nick!user@host JOIN #konversation")
+                                    << QStringLiteral("nick!user@host") << QStringLiteral("join")
+                                    << QStringList { QStringLiteral("#konversation") };
+    QTest::newRow("tagsnoprefix")   << QStringLiteral("@batch=1 PRIVMSG #konversation :hi")
+                                    << QString() << QStringLiteral("privmsg")
+                                    << QStringList { QStringLiteral("#konversation"), QStringLiteral("hi") };
+}
+
+void TestIrcMessage::testFromLine()
+{
+    QFETCH(QString, line);
+    QFETCH(QString, prefix);
+    QFETCH(QString, command);
+    QFETCH(QStringList, parameters);
+
+    const IrcMessage message = IrcMessage::fromLine(line);
+
+    QCOMPARE(message.prefix, prefix);
+    QCOMPARE(message.command, command);
+    QCOMPARE(message.parameters, parameters);
+}
+
+void TestIrcMessage::testTags()
+{
+    const IrcMessage message = IrcMessage::fromLine(
+        QStringLiteral("@time=2026-01-01T00:00:00.000Z;msgid=abc;account=nick :nick!user@host PRIVMSG #konversation :hi"));
+
+    QCOMPARE(message.tags.size(), 3);
+    QCOMPARE(message.tags.value(QStringLiteral("time")), QStringLiteral("2026-01-01T00:00:00.000Z"));
+    QCOMPARE(message.tags.value(QStringLiteral("msgid")), QStringLiteral("abc"));
+    QCOMPARE(message.tags.value(QStringLiteral("account")), QStringLiteral("nick"));
+    QCOMPARE(message.prefix, QStringLiteral("nick!user@host"));
+
+    QVERIFY(IrcMessage::fromLine(QStringLiteral(":server 001 nick :Welcome")).tags.isEmpty());
+}
+
+#include "moc_testircmessage.cpp"
@@ -0,0 +1,22 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTIRCMESSAGE_H
+#define TESTIRCMESSAGE_H
+
+#include <QObject>
+
+class TestIrcMessage : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFromLine_data();
+    void testFromLine();
+    void testTags();
+};
+
+#endif
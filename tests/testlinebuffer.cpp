@@ -0,0 +1,146 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testlinebuffer.h"
+
+#include "irc/linebuffer.h"
+
+#include <QBuffer>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestLineBuffer);
+
+using namespace Konversation;
+
+/// All complete lines buffered, as copies.
+static QList<QByteArray> takeLines(LineBuffer& buffer)
+{
+    QList<QByteArray> lines;
+    QByteArrayView line;
+
+    while (buffer.nextLine(line))
+        lines.append(line.toByteArray());
+
+    return lines;
+}
+
+void TestLineBuffer::testTerminators_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QList<QByteArray>>("expectedLines");
+    QTest::addColumn<qsizetype>("expectedPending");
+
+    QTest::newRow("crlf")       << QByteArray("PING :a\r\nPING :b\r\n")
+                                << QList<QByteArray> { "PING :a", "PING :b" } << qsizetype(0);
+    QTest::newRow("lf")         << QByteArray("one\ntwo\n")
+                                << QList<QByteArray> { "one", "two" } << qsizetype(0);
+    QTest::newRow("cr")         << QByteArray("one\rtwo\r")
+                                << QList<QByteArray> { "one", "two" } << qsizetype(0);
+    QTest::newRow("lfcr")       << QByteArray("one\n\rtwo\n\r")
+                                << QList<QByteArray> { "one", "two" } << qsizetype(0);
+    QTest::newRow("emptylines") << QByteArray("\r\n\r\none\r\n\r\n")
+                                << QList<QByteArray> { "one" } << qsizetype(0);
+    QTest::newRow("unfinished") << QByteArray("one\r\ntw")
+                                << QList<QByteArray> { "one" } << qsizetype(2);
+}
+
+void TestLineBuffer::testTerminators()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QList<QByteArray>, expectedLines);
+    QFETCH(qsizetype, expectedPending);
+
+    LineBuffer buffer;
+    buffer.append(data);
+
+    QCOMPARE(takeLines(buffer), expectedLines);
+    QCOMPARE(buffer.pendingSize(), expectedPending);
+}
+
+void TestLineBuffer::testPartialLines()
+{
+    const QByteArray data(":nick!user@host PRIVMSG #konversation :hello there\r\n:server 001 nick :Welcome\r\n");
+
+    // every split of the data, including one between \r and \n
+    for (qsizetype split = 0; split <= data.size(); ++split)
+    {
+        LineBuffer buffer;
+        QList<QByteArray> lines;
+
+        buffer.append(QByteArrayView(data).first(split));
+        lines += takeLines(buffer);
+        buffer.append(QByteArrayView(data).sliced(split));
+        lines += takeLines(buffer);
+
+        QCOMPARE(lines, (QList<QByteArray> { ":nick!user@host PRIVMSG #konversation :hello there", ":server 001 nick :Welcome" }));
+    }
+
+    // byte by byte
+    LineBuffer buffer;
+    QList<QByteArray> lines;
+
+    for (char c : data)
+    {
+        buffer.append(QByteArrayView(&c, 1));
+        lines += takeLines(buffer);
+    }
+
+    QCOMPARE(lines.size(), 2);
+    QCOMPARE(lines.last(), QByteArray(":server 001 nick :Welcome"));
+}
+
+void TestLineBuffer::testCompaction()
+{
+    // The lines handed out are dropped from the front on the next append, the
+    // partial line moves there and is completed by the data appended after it.
+    LineBuffer buffer;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const QByteArray line = "line " + QByteArray::number(i);
+
+        buffer.append(line.first(3));
+        QVERIFY(takeLines(buffer).isEmpty());
+        QCOMPARE(buffer.pendingSize(), qsizetype(3));
+
+        buffer.append(line.sliced(3) + "\r\n");
+        QCOMPARE(takeLines(buffer), QList<QByteArray> { line });
+    }
+
+    QCOMPARE(buffer.pendingSize(), qsizetype(0));
+}
+
+void TestLineBuffer::testReadFrom()
+{
+    QByteArray data("first\r\nsecond\r\nthi");
+    QBuffer device(&data);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    LineBuffer buffer;
+
+    QCOMPARE(buffer.readFrom(&device), qint64(data.size()));
+    QCOMPARE(takeLines(buffer), (QList<QByteArray> { "first", "second" }));
+    QCOMPARE(buffer.readFrom(&device), qint64(0));
+
+    buffer.append("rd\n");
+
+    QCOMPARE(takeLines(buffer), QList<QByteArray> { "third" });
+}
+
+void TestLineBuffer::testClear()
+{
+    LineBuffer buffer;
+    buffer.append("partial");
+    buffer.clear();
+
+    QCOMPARE(buffer.pendingSize(), qsizetype(0));
+
+    buffer.append("line\n");
+
+    QCOMPARE(takeLines(buffer), QList<QByteArray> { "line" });
+}
+
+#include "moc_testlinebuffer.cpp"
@@ -0,0 +1,25 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTLINEBUFFER_H
+#define TESTLINEBUFFER_H
+
+#include <QObject>
+
+class TestLineBuffer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testTerminators_data();
+    void testTerminators();
+    void testPartialLines();
+    void testCompaction();
+    void testReadFrom();
+    void testClear();
+};
+
+#endif
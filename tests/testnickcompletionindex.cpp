@@ -0,0 +1,99 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testnickcompletionindex.h"
+
+#include "irc/nickcompletionindex.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+QTEST_GUILESS_MAIN(TestNickCompletionIndex);
+
+// the index only tells the nicks apart, it never looks into them
+static Nick* nick(quintptr id)
+{
+    return reinterpret_cast<Nick*>(id * 16);
+}
+
+static QList<Nick*> sorted(QList<Nick*> nicks)
+{
+    std::sort(nicks.begin(), nicks.end());
+
+    return nicks;
+}
+
+static void fill(NickCompletionIndex& index)
+{
+    index.insert(nick(1), QStringLiteral("argonel"));
+    index.insert(nick(2), QStringLiteral("Arthur"));
+    index.insert(nick(3), QStringLiteral("hein"));
+    index.insert(nick(4), QStringLiteral("[kde]bot"));
+    index.insert(nick(5), QStringLiteral("__ar"));
+}
+
+void TestNickCompletionIndex::testPrefix()
+{
+    NickCompletionIndex index;
+    fill(index);
+
+    QCOMPARE(sorted(index.nicksStartingWith(QStringLiteral("ar"), false, false)), (QList<Nick*> { nick(1), nick(2) }));
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("he"), false, false), QList<Nick*> { nick(3) });
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("[k"), false, false), QList<Nick*> { nick(4) });
+    QVERIFY(index.nicksStartingWith(QStringLiteral("x"), false, false).isEmpty());
+    QCOMPARE(index.nicksStartingWith(QString(), false, false).size(), 5);
+}
+
+void TestNickCompletionIndex::testCaseSensitive()
+{
+    NickCompletionIndex index;
+    fill(index);
+
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("Ar"), false, true), QList<Nick*> { nick(2) });
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("ar"), false, true), QList<Nick*> { nick(1) });
+}
+
+void TestNickCompletionIndex::testSkipNonAlfaNum()
+{
+    NickCompletionIndex index;
+    fill(index);
+
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("kde"), true, false), QList<Nick*> { nick(4) });
+    QCOMPARE(sorted(index.nicksStartingWith(QStringLiteral("ar"), true, false)), (QList<Nick*> { nick(1), nick(2), nick(5) }));
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("_a"), true, false), QList<Nick*> { nick(5) });
+    QVERIFY(index.nicksStartingWith(QStringLiteral("kde"), false, false).isEmpty());
+}
+
+void TestNickCompletionIndex::testRemove()
+{
+    NickCompletionIndex index;
+    fill(index);
+
+    index.remove(nick(1));
+
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("ar"), false, false), QList<Nick*> { nick(2) });
+
+    index.clear();
+
+    QVERIFY(index.nicksStartingWith(QString(), false, false).isEmpty());
+}
+
+void TestNickCompletionIndex::testRename()
+{
+    NickCompletionIndex index;
+    fill(index);
+
+    index.insert(nick(1), QStringLiteral("Eike"));
+
+    // the old name leads nowhere, the new one to the nick
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("arg"), false, false), QList<Nick*>());
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("ar"), false, false), QList<Nick*> { nick(2) });
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("ei"), false, false), QList<Nick*> { nick(1) });
+    QCOMPARE(index.nicksStartingWith(QStringLiteral("ei"), true, false), QList<Nick*> { nick(1) });
+}
+
+#include "moc_testnickcompletionindex.cpp"
@@ -0,0 +1,24 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTNICKCOMPLETIONINDEX_H
+#define TESTNICKCOMPLETIONINDEX_H
+
+#include <QObject>
+
+class TestNickCompletionIndex : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testPrefix();
+    void testCaseSensitive();
+    void testSkipNonAlfaNum();
+    void testRemove();
+    void testRename();
+};
+
+#endif
@@ -0,0 +1,217 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testrawlogbuffer.h"
+
+#include "common.h"
+#include "irc/rawlogbuffer.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestRawLogBuffer);
+
+using namespace Konversation;
+
+void TestRawLogBuffer::testFilter_data()
+{
+    QTest::addColumn<QString>("commands");
+    QTest::addColumn<QString>("target");
+    QTest::addColumn<QByteArray>("line");
+    QTest::addColumn<bool>("expectedMatch");
+
+    const QByteArray privmsg(":nick!user@host PRIVMSG #Konversation :hello there");
+
+    QTest::newRow("empty")          << QString() << QString() << privmsg << true;
+    QTest::newRow("command")        << QStringLiteral("privmsg") << QString() << privmsg << true;
+    QTest::newRow("othercommand")   << QStringLiteral("NOTICE") << QString() << privmsg << false;
+    QTest::newRow("commandlist")    << QStringLiteral("NOTICE, PRIVMSG") << QString() << privmsg << true;
+    QTest::newRow("target")         << QString() << QStringLiteral("#konversation") << privmsg << true;
+    QTest::newRow("othertarget")    << QString() << QStringLiteral("#kde") << privmsg << false;
+    QTest::newRow("both")           << QStringLiteral("PRIVMSG") << QStringLiteral("#konversation") << privmsg << true;
+    QTest::newRow("tags")           << QStringLiteral("PRIVMSG") << QStringLiteral("#konversation")
+                                    << QByteArray("@time=2026-01-01T00:00:00.000Z :n!u@h PRIVMSG #konversation :hi") << true;
+    QTest::newRow("outbound")       << QStringLiteral("PRIVMSG") << QStringLiteral("#konversation")
+                                    << QByteArray("PRIVMSG #konversation :hi") << true;
+    QTest::newRow("trailingtarget") << QStringLiteral("JOIN") << QStringLiteral("#kde")
+                                    << QByteArray(":n!u@h JOIN :#kde") << true;
+    QTest::newRow("numeric")        << QStringLiteral("001") << QString()
+                                    << QByteArray(":server 001 nick :Welcome") << true;
+    QTest::newRow("notarget")       << QString() << QStringLiteral("#kde")
+                                    << QByteArray("PING") << false;
+    QTest::newRow("prefixonly")     << QStringLiteral("PING") << QString()
+                                    << QByteArray(":server") << false;
+}
+
+void TestRawLogBuffer::testFilter()
+{
+    QFETCH(QString, commands);
+    QFETCH(QString, target);
+    QFETCH(QByteArray, line);
+    QFETCH(bool, expectedMatch);
+
+    RawLogFilter filter;
+    filter.setCommands(commands);
+    filter.setTarget(target);
+
+    QCOMPARE(filter.matches(line), expectedMatch);
+}
+
+void TestRawLogBuffer::testRing()
+{
+    RawLogBuffer buffer;
+
+    for (int i = 0; i < RawLogBuffer::MaxRecords + 10; ++i)
+        buffer.append(RawLogRecord { i, (i % 2) == 1, QByteArray::number(i) });
+
+    QCOMPARE(buffer.count(), int(RawLogBuffer::MaxRecords));
+    QCOMPARE(buffer.at(0).time, qint64(10));
+    QCOMPARE(buffer.at(0).message, QByteArray("10"));
+    QCOMPARE(buffer.at(buffer.count() - 1).message, QByteArray::number(RawLogBuffer::MaxRecords + 9));
+    QCOMPARE(buffer.at(buffer.count() - 1).outbound, true);
+
+    // long lines are limited by their size
+    const QByteArray longLine(64 * 1024, 'x');
+
+    for (int i = 0; i < 100; ++i)
+        buffer.append(false, longLine);
+
+    QCOMPARE(buffer.count(), int(RawLogBuffer::MaxBytes / longLine.size()));
+    QCOMPARE(buffer.at(0).message, longLine);
+
+    buffer.clear();
+    QCOMPARE(buffer.count(), 0);
+
+    buffer.append(true, QByteArray("QUIT"));
+    QCOMPARE(buffer.count(), 1);
+    QCOMPARE(buffer.at(0).message, QByteArray("QUIT"));
+}
+
+void TestRawLogBuffer::testCapture()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("capture"));
+
+    const QList<RawLogRecord> records {
+        { 1000, false, QByteArray(":server 001 nick :Welcome") },
+        { 2000, true, QByteArray("JOIN #konversation") },
+        { 3000, false, QByteArray(":n!u@h PRIVMSG #konversation :caf\xc3\xa9") },
+    };
+
+    RawLogBuffer buffer;
+    QString errorString;
+
+    buffer.append(records.at(0));
+    QVERIFY2(buffer.startCapture(fileName, errorString), qPrintable(errorString));
+    QVERIFY(buffer.isCapturing());
+    buffer.append(records.at(1));
+    buffer.append(records.at(2));
+    buffer.stopCapture();
+    QVERIFY(!buffer.isCapturing());
+    buffer.append(records.at(0));
+
+    QList<RawLogRecord> read;
+    QVERIFY2(RawLogBuffer::readCapture(fileName, read, errorString), qPrintable(errorString));
+
+    // only what was recorded while capturing
+    QCOMPARE(read.count(), 2);
+
+    for (int i = 0; i < read.count(); ++i)
+    {
+        QCOMPARE(read.at(i).time, records.at(i + 1).time);
+        QCOMPARE(read.at(i).outbound, records.at(i + 1).outbound);
+        QCOMPARE(read.at(i).message, records.at(i + 1).message);
+    }
+
+    // a capture cut short keeps its complete records
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 3));
+    file.close();
+
+    read.clear();
+    QVERIFY(RawLogBuffer::readCapture(fileName, read, errorString));
+    QCOMPARE(read.count(), 1);
+    QCOMPARE(read.at(0).message, records.at(1).message);
+}
+
+void TestRawLogBuffer::testInvalidCapture()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("notacapture"));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("PRIVMSG #konversation :hello\r\n");
+    file.close();
+
+    QList<RawLogRecord> records;
+    QString errorString;
+
+    QVERIFY(!RawLogBuffer::readCapture(fileName, records, errorString));
+    QVERIFY(!errorString.isEmpty());
+    QVERIFY(!RawLogBuffer::readCapture(dir.filePath(QStringLiteral("missing")), records, errorString));
+    QVERIFY(records.isEmpty());
+}
+
+/**
+ * Replays the received lines of a capture through the decoding of the
+ * receive path and the raw log filter. The capture is taken from the file
+ * named by KONVERSATION_RAWLOG_CAPTURE, or made up of typical traffic.
+ */
+void TestRawLogBuffer::benchmarkReplay()
+{
+    QString fileName = qEnvironmentVariable("KONVERSATION_RAWLOG_CAPTURE");
+    QTemporaryDir dir;
+    QString errorString;
+
+    if (fileName.isEmpty())
+    {
+        QVERIFY(dir.isValid());
+        fileName = dir.filePath(QStringLiteral("capture"));
+
+        RawLogBuffer buffer;
+        QVERIFY2(buffer.startCapture(fileName, errorString), qPrintable(errorString));
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            buffer.append(false, QByteArray(":someone!~someone@example.org PRIVMSG #konversation :so I tried that yesterday and it did not work"));
+            buffer.append(false, QByteArray("@time=2026-01-01T00:00:00.000Z :other!~other@192.0.2.1 NOTICE #kde :r\xc3\xa9" "demarrage pr\xc3\xa9vu"));
+            buffer.append(true, QByteArray("PRIVMSG #konversation :yes, restart it and check the output again"));
+        }
+
+        buffer.stopCapture();
+    }
+
+    QList<RawLogRecord> records;
+    QVERIFY2(RawLogBuffer::readCapture(fileName, records, errorString), qPrintable(errorString));
+
+    RawLogFilter filter;
+    filter.setCommands(QStringLiteral("PRIVMSG"));
+    filter.setTarget(QStringLiteral("#konversation"));
+
+    QString text;
+    int matches = 0;
+
+    QBENCHMARK {
+        for (const RawLogRecord& record : std::as_const(records))
+        {
+            if (record.outbound)
+                continue;
+
+            decodeUtf8Line(record.message, text);
+
+            if (filter.matches(record.message))
+                ++matches;
+        }
+    }
+
+    QVERIFY(matches > 0 || records.isEmpty());
+}
+
+#include "moc_testrawlogbuffer.cpp"
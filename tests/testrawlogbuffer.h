@@ -0,0 +1,25 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTRAWLOGBUFFER_H
+#define TESTRAWLOGBUFFER_H
+
+#include <QObject>
+
+class TestRawLogBuffer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFilter_data();
+    void testFilter();
+    void testRing();
+    void testCapture();
+    void testInvalidCapture();
+    void benchmarkReplay();
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#include "testspscqueue.h"
+
+#include "irc/spscqueue.h"
+
+#include <QByteArray>
+#include <QTest>
+#include <QThread>
+
+#include <memory>
+
+QTEST_GUILESS_MAIN(TestSpscQueue);
+
+using namespace Konversation;
+
+void TestSpscQueue::testOrder()
+{
+    SpscQueue<QByteArray> queue;
+    QByteArray value;
+
+    QVERIFY(!queue.pop(value));
+
+    queue.push(QByteArrayLiteral("first"));
+    queue.push(QByteArrayLiteral("second"));
+
+    QVERIFY(queue.pop(value));
+    QCOMPARE(value, QByteArrayLiteral("first"));
+
+    queue.push(QByteArrayLiteral("third"));
+
+    QVERIFY(queue.pop(value));
+    QCOMPARE(value, QByteArrayLiteral("second"));
+    QVERIFY(queue.pop(value));
+    QCOMPARE(value, QByteArrayLiteral("third"));
+    QVERIFY(!queue.pop(value));
+}
+
+void TestSpscQueue::testLeftOver()
+{
+    auto counted = std::make_shared<int>(0);
+
+    {
+        SpscQueue<std::shared_ptr<int>> queue;
+
+        for (int i = 0; i < 3; ++i)
+            queue.push(counted);
+
+        QCOMPARE(counted.use_count(), 4);
+    }
+
+    // values not taken go with the queue
+    QCOMPARE(counted.use_count(), 1);
+}
+
+void TestSpscQueue::testTwoThreads_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("few")  << 100;
+    QTest::newRow("many") << 1000000;
+}
+
+void TestSpscQueue::testTwoThreads()
+{
+    QFETCH(int, count);
+
+    SpscQueue<int> queue;
+
+    QThread* producer = QThread::create([&queue, count]() {
+        for (int i = 0; i < count; ++i)
+        {
+            queue.push(i);
+
+            // lets the consumer catch up with an empty queue now and then
+            if (i % 4096 == 0)
+                QThread::yieldCurrentThread();
+        }
+    });
+    producer->start();
+
+    int expected = 0;
+    bool inOrder = true;
+
+    while (expected < count)
+    {
+        int value;
+
+        if (!queue.pop(value))
+        {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        // a QCOMPARE here would return with the producer still running
+        if (value != expected)
+            inOrder = false;
+
+        ++expected;
+    }
+
+    QVERIFY(producer->wait());
+    delete producer;
+
+    QVERIFY(inOrder);
+    int value;
+    QVERIFY(!queue.pop(value));
+}
+
+#include "moc_testspscqueue.cpp"
@@ -0,0 +1,23 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+
+    SPDX-FileCopyrightText: 2026 Konversation authors
+*/
+
+#ifndef TESTSPSCQUEUE_H
+#define TESTSPSCQUEUE_H
+
+#include <QObject>
+
+class TestSpscQueue : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testOrder();
+    void testLeftOver();
+    void testTwoThreads_data();
+    void testTwoThreads();
+};
+
+#endif